@@ -0,0 +1,124 @@
+﻿//
+// arena.h — linear (bump) allocator with block reuse.
+//
+// Allocations are carved out of large blocks and released all at once with
+// arena_reset, which keeps the blocks for the next round. After a warm-up
+// frame the same workload allocates nothing from the heap.
+//
+// An arena is not thread-safe; give each thread its own.
+//
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_DEFAULT_BLOCK (1u << 20)
+
+typedef struct arena_block {
+    struct arena_block* next;
+    size_t              cap;
+    size_t              used;
+} arena_block;
+
+typedef struct {
+    arena_block* head;
+    arena_block* cur;
+    size_t       block_size; // minimum size of newly reserved blocks
+    size_t       reserved;   // bytes obtained from the heap
+    size_t       used;       // bytes handed out since the last reset
+    size_t       peak;       // high-water mark of `used`
+} arena;
+
+static inline void arena_init(arena* a, size_t block_size)
+{
+    memset(a, 0, sizeof(*a));
+    a->block_size = block_size ? block_size : ARENA_DEFAULT_BLOCK;
+}
+
+static inline unsigned char* arena_block_data(arena_block* b)
+{
+    return (unsigned char*)b + ((sizeof(arena_block) + 15) & ~(size_t)15);
+}
+
+/**
+ * @brief Allocate `size` bytes aligned to `align` (a power of two, <= 16).
+ *
+ * @param a     Arena.
+ * @param size  Byte count.
+ * @param align Alignment (0 means 16).
+ * @return Pointer into the arena, or NULL on heap exhaustion.
+ */
+static inline void* arena_alloc(arena* a, size_t size, size_t align)
+{
+    if (align == 0) align = 16;
+    for (;;) {
+        arena_block* b = a->cur;
+        if (b) {
+            size_t off = (b->used + (align - 1)) & ~(align - 1);
+            if (off + size <= b->cap) {
+                a->used += off + size - b->used;
+                if (a->used > a->peak) a->peak = a->used;
+                b->used = off + size;
+                return arena_block_data(b) + off;
+            }
+            // Reuse the next kept block if it is large enough.
+            if (b->next && b->next->cap >= size) {
+                a->cur = b->next;
+                a->cur->used = 0;
+                continue;
+            }
+        }
+
+        size_t cap = size > a->block_size ? size : a->block_size;
+        arena_block* nb = (arena_block*)malloc(((sizeof(arena_block) + 15) & ~(size_t)15) + cap);
+        if (!nb) return NULL;
+        nb->cap = cap;
+        nb->used = 0;
+        a->reserved += cap;
+        if (b) { nb->next = b->next; b->next = nb; }
+        else   { nb->next = a->head; a->head = nb; }
+        a->cur = nb;
+    }
+}
+
+/**
+ * @brief Typed, zero-initialized array allocation helper.
+ */
+#define ARENA_ARRAY(a, type, count) \
+    ((type*)arena_zalloc((a), sizeof(type) * (size_t)(count), _Alignof(type)))
+
+static inline void* arena_zalloc(arena* a, size_t size, size_t align)
+{
+    void* p = arena_alloc(a, size, align);
+    if (p) memset(p, 0, size);
+    return p;
+}
+
+/**
+ * @brief Release every allocation but keep the blocks for reuse.
+ */
+static inline void arena_reset(arena* a)
+{
+    a->cur = a->head;
+    if (a->cur) a->cur->used = 0;
+    a->used = 0;
+}
+
+static inline void arena_free(arena* a)
+{
+    arena_block* b = a->head;
+    while (b) {
+        arena_block* n = b->next;
+        free(b);
+        b = n;
+    }
+    size_t bs = a->block_size;
+    memset(a, 0, sizeof(*a));
+    a->block_size = bs;
+}
+
+#endif // ARENA_H
@@ -0,0 +1,628 @@
+﻿//
+// bench.h — benchmark runner, result files and regression comparison.
+//
+// A suite is a table of bench_case. bench_run_suite runs every case once to
+// warm up, then `rounds` times round-robin (case 1, case 2, ..., case 1, ...)
+// so slow drifts of the machine (thermal, turbo, background load) spread over
+// all cases instead of biasing the last one. Each run is one sample.
+//
+// Results are stored as JSON together with a machine fingerprint (CPU, OS,
+// architecture, compiler, build flags, worker count). bench_compare matches
+// cases by name and decides per case with a one-sided Mann–Whitney U test on
+// the samples (normal approximation with tie correction, fine from about 8
+// samples per side): a case regressed if the current samples are larger with
+// p < alpha and the median grew by more than the threshold. A baseline case
+// missing from the current run fails as well, so a case that stops running
+// (its setup fails) cannot hide a regression. Comparisons
+// between different fingerprints are refused unless forced, since they
+// measure the machines rather than the code.
+//
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parallel.h"
+#include "timer.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+#define BENCH_NAME_MAX 64
+
+// ------------------------------ Machine fingerprint --------------------------
+
+typedef struct {
+    char id[17];        // hash of everything below, hex
+    char cpu[64];
+    char os[16];
+    char arch[16];
+    char compiler[48];
+    char flags[64];
+    int  workers;
+} bench_machine;
+
+static inline void bench_cpu_brand(char* out, size_t cap)
+{
+    snprintf(out, cap, "unknown");
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int r[12];
+    __cpuid(r, 0x80000000);
+    if ((unsigned)r[0] < 0x80000004u) return;
+    for (int i = 0; i < 3; ++i) __cpuid(r + 4 * i, 0x80000002 + i);
+    char brand[49];
+    memcpy(brand, r, 48);
+    brand[48] = '\0';
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    unsigned r[12];
+    if (__get_cpuid_max(0x80000000u, NULL) < 0x80000004u) return;
+    for (unsigned i = 0; i < 3; ++i) __get_cpuid(0x80000002u + i, &r[4 * i], &r[4 * i + 1], &r[4 * i + 2], &r[4 * i + 3]);
+    char brand[49];
+    memcpy(brand, r, 48);
+    brand[48] = '\0';
+#else
+    return;
+#endif
+    // Trim and collapse the padding spaces some vendors use.
+    size_t n = 0;
+    for (const char* s = brand; *s && n + 1 < cap; ++s) {
+        if (*s == ' ' && (n == 0 || out[n - 1] == ' ')) continue;
+        out[n++] = *s;
+    }
+    while (n > 0 && out[n - 1] == ' ') n--;
+    out[n] = '\0';
+}
+
+static inline uint64_t bench_fnv1a(uint64_t h, const char* s)
+{
+    for (; *s; ++s) { h ^= (unsigned char)*s; h *= 0x100000001b3ull; }
+    return h ^ 0xFF; // field separator
+}
+
+static inline void bench_machine_detect(bench_machine* m)
+{
+    memset(m, 0, sizeof(*m));
+    bench_cpu_brand(m->cpu, sizeof(m->cpu));
+#if defined(_WIN32)
+    snprintf(m->os, sizeof(m->os), "windows");
+#elif defined(__APPLE__)
+    snprintf(m->os, sizeof(m->os), "macos");
+#elif defined(__linux__)
+    snprintf(m->os, sizeof(m->os), "linux");
+#else
+    snprintf(m->os, sizeof(m->os), "unknown");
+#endif
+#if defined(__x86_64__) || defined(_M_X64)
+    snprintf(m->arch, sizeof(m->arch), "x86_64");
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    snprintf(m->arch, sizeof(m->arch), "arm64");
+#elif defined(__i386__) || defined(_M_IX86)
+    snprintf(m->arch, sizeof(m->arch), "x86");
+#else
+    snprintf(m->arch, sizeof(m->arch), "unknown");
+#endif
+#if defined(__clang__)
+    snprintf(m->compiler, sizeof(m->compiler), "clang %d.%d", __clang_major__, __clang_minor__);
+#elif defined(__GNUC__)
+    snprintf(m->compiler, sizeof(m->compiler), "gcc %d.%d", __GNUC__, __GNUC_MINOR__);
+#elif defined(_MSC_VER)
+    snprintf(m->compiler, sizeof(m->compiler), "msvc %d", _MSC_VER);
+#else
+    snprintf(m->compiler, sizeof(m->compiler), "unknown");
+#endif
+    snprintf(m->flags, sizeof(m->flags), "%s%s%s%s",
+#if defined(__OPTIMIZE__) || defined(NDEBUG)
+             "opt",
+#else
+             "noopt",
+#endif
+#if defined(__AVX2__)
+             " avx2",
+#else
+             "",
+#endif
+#if defined(__FMA__)
+             " fma",
+#else
+             "",
+#endif
+#ifdef PROFILE_ENABLED
+             " profile"
+#else
+             ""
+#endif
+    );
+    m->workers = parallel_worker_count();
+
+    char workers[16];
+    snprintf(workers, sizeof(workers), "%d", m->workers);
+    uint64_t h = 0xcbf29ce484222325ull;
+    h = bench_fnv1a(h, m->cpu);
+    h = bench_fnv1a(h, m->os);
+    h = bench_fnv1a(h, m->arch);
+    h = bench_fnv1a(h, m->compiler);
+    h = bench_fnv1a(h, m->flags);
+    h = bench_fnv1a(h, workers);
+    snprintf(m->id, sizeof(m->id), "%016llx", (unsigned long long)h);
+}
+
+// ------------------------------ Results --------------------------------------
+
+typedef struct {
+    char    name[BENCH_NAME_MAX];
+    double* samples_ms;
+    size_t  count, cap;
+} bench_result;
+
+typedef struct {
+    bench_machine machine;
+    bench_result* results;
+    size_t        count, cap;
+} bench_report;
+
+static inline void bench_report_free(bench_report* r)
+{
+    for (size_t i = 0; i < r->count; ++i) free(r->results[i].samples_ms);
+    free(r->results);
+    memset(r, 0, sizeof(*r));
+}
+
+static inline bench_result* bench_report_find(const bench_report* r, const char* name)
+{
+    for (size_t i = 0; i < r->count; ++i)
+        if (strcmp(r->results[i].name, name) == 0) return &r->results[i];
+    return NULL;
+}
+
+// Result named `name`, added if missing; NULL on allocation failure.
+static inline bench_result* bench_report_add(bench_report* r, const char* name)
+{
+    bench_result* res = bench_report_find(r, name);
+    if (res) return res;
+    if (r->count == r->cap) {
+        const size_t nc = r->cap ? r->cap * 2 : 16;
+        bench_result* nr = (bench_result*)realloc(r->results, nc * sizeof(bench_result));
+        if (!nr) return NULL;
+        r->results = nr;
+        r->cap = nc;
+    }
+    res = &r->results[r->count++];
+    memset(res, 0, sizeof(*res));
+    snprintf(res->name, sizeof(res->name), "%s", name);
+    return res;
+}
+
+static inline bool bench_result_push(bench_result* r, double ms)
+{
+    if (r->count == r->cap) {
+        const size_t nc = r->cap ? r->cap * 2 : 16;
+        double* ns = (double*)realloc(r->samples_ms, nc * sizeof(double));
+        if (!ns) return false;
+        r->samples_ms = ns;
+        r->cap = nc;
+    }
+    r->samples_ms[r->count++] = ms;
+    return true;
+}
+
+static inline void bench_write_string(FILE* f, const char* s)
+{
+    fputc('"', f);
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        if ((unsigned char)*s >= 0x20) fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+/**
+ * @brief Write a report as JSON.
+ *
+ * @return false if the file cannot be written.
+ */
+static inline bool bench_report_write(const bench_report* r, const char* path)
+{
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    const bench_machine* m = &r->machine;
+    fprintf(f, "{\n  \"machine\": {\"id\": ");
+    bench_write_string(f, m->id);
+    fprintf(f, ", \"cpu\": ");
+    bench_write_string(f, m->cpu);
+    fprintf(f, ", \"os\": ");
+    bench_write_string(f, m->os);
+    fprintf(f, ", \"arch\": ");
+    bench_write_string(f, m->arch);
+    fprintf(f, ", \"compiler\": ");
+    bench_write_string(f, m->compiler);
+    fprintf(f, ", \"flags\": ");
+    bench_write_string(f, m->flags);
+    fprintf(f, ", \"workers\": %d},\n  \"benchmarks\": [", m->workers);
+    for (size_t i = 0; i < r->count; ++i) {
+        const bench_result* res = &r->results[i];
+        fprintf(f, "%s\n    {\"name\": ", i ? "," : "");
+        bench_write_string(f, res->name);
+        fprintf(f, ", \"samples_ms\": [");
+        for (size_t k = 0; k < res->count; ++k) fprintf(f, "%s%.6g", k ? ", " : "", res->samples_ms[k]);
+        fprintf(f, "]}");
+    }
+    fprintf(f, "\n  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+// Minimal JSON reader for the layout above: unknown keys are skipped.
+typedef struct {
+    const char* p;
+    bool        ok;
+} bench_json;
+
+static inline void bench_json_ws(bench_json* j)
+{
+    while (*j->p == ' ' || *j->p == '\n' || *j->p == '\r' || *j->p == '\t') j->p++;
+}
+
+static inline bool bench_json_eat(bench_json* j, char c)
+{
+    bench_json_ws(j);
+    if (*j->p != c) return false;
+    j->p++;
+    return true;
+}
+
+static inline void bench_json_string(bench_json* j, char* out, size_t cap)
+{
+    size_t n = 0;
+    if (!bench_json_eat(j, '"')) { j->ok = false; return; }
+    while (*j->p && *j->p != '"') {
+        char c = *j->p++;
+        if (c == '\\' && *j->p) c = *j->p++;
+        if (out && n + 1 < cap) out[n++] = c;
+    }
+    if (out && cap) out[n] = '\0';
+    if (*j->p != '"') { j->ok = false; return; }
+    j->p++;
+}
+
+static inline double bench_json_number(bench_json* j)
+{
+    bench_json_ws(j);
+    char* end;
+    const double v = strtod(j->p, &end);
+    if (end == j->p) j->ok = false;
+    j->p = end;
+    return v;
+}
+
+static inline void bench_json_skip(bench_json* j, int depth)
+{
+    bench_json_ws(j);
+    if (depth > 32) { j->ok = false; return; }
+    if (*j->p == '"') { bench_json_string(j, NULL, 0); return; }
+    if (*j->p == '{' || *j->p == '[') {
+        const char close = *j->p == '{' ? '}' : ']';
+        const bool object = *j->p == '{';
+        j->p++;
+        if (bench_json_eat(j, close)) return;
+        do {
+            if (object) {
+                bench_json_string(j, NULL, 0);
+                if (!bench_json_eat(j, ':')) { j->ok = false; return; }
+            }
+            bench_json_skip(j, depth + 1);
+        } while (j->ok && bench_json_eat(j, ','));
+        if (!bench_json_eat(j, close)) j->ok = false;
+        return;
+    }
+    if (strncmp(j->p, "true", 4) == 0) { j->p += 4; return; }
+    if (strncmp(j->p, "false", 5) == 0) { j->p += 5; return; }
+    if (strncmp(j->p, "null", 4) == 0) { j->p += 4; return; }
+    bench_json_number(j);
+}
+
+static inline void bench_json_machine(bench_json* j, bench_machine* m)
+{
+    if (!bench_json_eat(j, '{')) { j->ok = false; return; }
+    if (bench_json_eat(j, '}')) return;
+    do {
+        char key[32];
+        bench_json_string(j, key, sizeof(key));
+        if (!bench_json_eat(j, ':')) { j->ok = false; return; }
+        if (strcmp(key, "id") == 0) bench_json_string(j, m->id, sizeof(m->id));
+        else if (strcmp(key, "cpu") == 0) bench_json_string(j, m->cpu, sizeof(m->cpu));
+        else if (strcmp(key, "os") == 0) bench_json_string(j, m->os, sizeof(m->os));
+        else if (strcmp(key, "arch") == 0) bench_json_string(j, m->arch, sizeof(m->arch));
+        else if (strcmp(key, "compiler") == 0) bench_json_string(j, m->compiler, sizeof(m->compiler));
+        else if (strcmp(key, "flags") == 0) bench_json_string(j, m->flags, sizeof(m->flags));
+        else if (strcmp(key, "workers") == 0) m->workers = (int)bench_json_number(j);
+        else bench_json_skip(j, 1);
+    } while (j->ok && bench_json_eat(j, ','));
+    if (!bench_json_eat(j, '}')) j->ok = false;
+}
+
+static inline void bench_json_benchmark(bench_json* j, bench_report* r)
+{
+    char name[BENCH_NAME_MAX] = "";
+    bench_result tmp;
+    memset(&tmp, 0, sizeof(tmp));
+    if (!bench_json_eat(j, '{')) { j->ok = false; return; }
+    if (!bench_json_eat(j, '}')) {
+        do {
+            char key[32];
+            bench_json_string(j, key, sizeof(key));
+            if (!bench_json_eat(j, ':')) { j->ok = false; break; }
+            if (strcmp(key, "name") == 0) {
+                bench_json_string(j, name, sizeof(name));
+            } else if (strcmp(key, "samples_ms") == 0) {
+                if (!bench_json_eat(j, '[')) { j->ok = false; break; }
+                if (!bench_json_eat(j, ']')) {
+                    do {
+                        if (!bench_result_push(&tmp, bench_json_number(j))) j->ok = false;
+                    } while (j->ok && bench_json_eat(j, ','));
+                    if (!bench_json_eat(j, ']')) j->ok = false;
+                }
+            } else {
+                bench_json_skip(j, 1);
+            }
+        } while (j->ok && bench_json_eat(j, ','));
+        if (j->ok && !bench_json_eat(j, '}')) j->ok = false;
+    }
+    bench_result* res = j->ok && name[0] ? bench_report_add(r, name) : NULL;
+    if (!res) {
+        if (j->ok && name[0]) j->ok = false;
+        free(tmp.samples_ms);
+        return;
+    }
+    free(res->samples_ms);
+    res->samples_ms = tmp.samples_ms;
+    res->count = tmp.count;
+    res->cap = tmp.cap;
+}
+
+/**
+ * @brief Read a report written by bench_report_write.
+ *
+ * @return false if the file is missing or malformed (r is left empty).
+ */
+static inline bool bench_report_read(bench_report* r, const char* path)
+{
+    memset(r, 0, sizeof(*r));
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* text = size >= 0 ? (char*)malloc((size_t)size + 1) : NULL;
+    const bool read = text && fread(text, 1, (size_t)size, f) == (size_t)size;
+    fclose(f);
+    if (!read) { free(text); return false; }
+    text[size] = '\0';
+
+    bench_json j = { text, true };
+    if (!bench_json_eat(&j, '{')) j.ok = false;
+    if (j.ok && !bench_json_eat(&j, '}')) {
+        do {
+            char key[32];
+            bench_json_string(&j, key, sizeof(key));
+            if (!bench_json_eat(&j, ':')) { j.ok = false; break; }
+            if (strcmp(key, "machine") == 0) {
+                bench_json_machine(&j, &r->machine);
+            } else if (strcmp(key, "benchmarks") == 0) {
+                if (!bench_json_eat(&j, '[')) { j.ok = false; break; }
+                if (!bench_json_eat(&j, ']')) {
+                    do bench_json_benchmark(&j, r); while (j.ok && bench_json_eat(&j, ','));
+                    if (!bench_json_eat(&j, ']')) j.ok = false;
+                }
+            } else {
+                bench_json_skip(&j, 1);
+            }
+        } while (j.ok && bench_json_eat(&j, ','));
+        if (j.ok && !bench_json_eat(&j, '}')) j.ok = false;
+    }
+    free(text);
+    if (!j.ok) bench_report_free(r);
+    return j.ok;
+}
+
+// ------------------------------ Running --------------------------------------
+
+typedef struct {
+    const char* name;
+    bool (*setup)(void** state);  // untimed; false skips the case
+    void (*prepare)(void* state); // untimed, before every sample (optional)
+    void (*run)(void* state);     // one timed sample
+    void (*teardown)(void* state);
+} bench_case;
+
+/**
+ * @brief Run a suite: one warm-up run per case, then `rounds` round-robin samples.
+ *
+ * @param cases  Suite.
+ * @param count  Number of cases.
+ * @param rounds Samples per case.
+ * @param filter Only cases whose name contains this substring (NULL: all).
+ * @param log    Progress output (NULL: silent).
+ * @param out    Report to fill; its machine fingerprint is detected here.
+ * @return false on allocation failure.
+ */
+static inline bool bench_run_suite(const bench_case* cases, size_t count, int rounds, const char* filter,
+                                   FILE* log, bench_report* out)
+{
+    memset(out, 0, sizeof(*out));
+    bench_machine_detect(&out->machine);
+    void** state = (void**)calloc(count ? count : 1, sizeof(void*));
+    bool* active = (bool*)calloc(count ? count : 1, sizeof(bool));
+    bool ok = state && active;
+    for (size_t i = 0; ok && i < count; ++i) {
+        if (filter && !strstr(cases[i].name, filter)) continue;
+        active[i] = !cases[i].setup || cases[i].setup(&state[i]);
+        if (!active[i] && log) fprintf(log, "skipped %s (setup failed)\n", cases[i].name);
+        if (active[i]) {
+            if (cases[i].prepare) cases[i].prepare(state[i]);
+            cases[i].run(state[i]); // warm-up
+            ok = bench_report_add(out, cases[i].name) != NULL;
+        }
+    }
+    for (int round = 0; ok && round < rounds; ++round) {
+        for (size_t i = 0; ok && i < count; ++i) {
+            if (!active[i]) continue;
+            if (cases[i].prepare) cases[i].prepare(state[i]);
+            const double t0 = timer_now_ms();
+            cases[i].run(state[i]);
+            const double ms = timer_now_ms() - t0;
+            ok = bench_result_push(bench_report_find(out, cases[i].name), ms);
+        }
+        if (log) fprintf(log, "round %d/%d\n", round + 1, rounds);
+    }
+    for (size_t i = 0; i < count; ++i)
+        if (active && active[i] && cases[i].teardown) cases[i].teardown(state ? state[i] : NULL);
+    free(state);
+    free(active);
+    return ok;
+}
+
+// ------------------------------ Statistics -----------------------------------
+
+static inline int bench_cmp_double(const void* a, const void* b)
+{
+    const double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static inline double bench_median(const double* v, size_t n)
+{
+    if (n == 0) return 0.0;
+    double* s = (double*)malloc(n * sizeof(double));
+    if (!s) return v[0];
+    memcpy(s, v, n * sizeof(double));
+    qsort(s, n, sizeof(double), bench_cmp_double);
+    const double m = n & 1 ? s[n / 2] : 0.5 * (s[n / 2 - 1] + s[n / 2]);
+    free(s);
+    return m;
+}
+
+typedef struct {
+    double value;
+    int    group;  // 0: a, 1: b
+} bench_ranked;
+
+static inline int bench_cmp_ranked(const void* a, const void* b)
+{
+    return bench_cmp_double(&((const bench_ranked*)a)->value, &((const bench_ranked*)b)->value);
+}
+
+/**
+ * @brief One-sided Mann–Whitney U test that samples b tend to be larger than a.
+ *
+ * @return p-value (normal approximation with tie and continuity correction);
+ *         1 when either side is empty or all samples are equal.
+ */
+static inline double bench_mann_whitney_greater(const double* a, size_t na, const double* b, size_t nb)
+{
+    const size_t n = na + nb;
+    if (na == 0 || nb == 0) return 1.0;
+    bench_ranked* v = (bench_ranked*)malloc(n * sizeof(bench_ranked));
+    if (!v) return 1.0;
+    for (size_t i = 0; i < na; ++i) v[i] = (bench_ranked){ a[i], 0 };
+    for (size_t i = 0; i < nb; ++i) v[na + i] = (bench_ranked){ b[i], 1 };
+    qsort(v, n, sizeof(bench_ranked), bench_cmp_ranked);
+
+    // Rank sum of b with ties at their average rank, and the tie term.
+    double rank_b = 0.0, ties = 0.0;
+    for (size_t i = 0; i < n;) {
+        size_t k = i;
+        while (k < n && v[k].value == v[i].value) k++;
+        const double t = (double)(k - i), rank = 0.5 * (double)(i + 1 + k);
+        for (size_t q = i; q < k; ++q) if (v[q].group) rank_b += rank;
+        ties += t * t * t - t;
+        i = k;
+    }
+    free(v);
+
+    const double fa = (double)na, fb = (double)nb, fn = (double)n;
+    const double u = rank_b - fb * (fb + 1.0) * 0.5;
+    const double mean = fa * fb * 0.5;
+    const double var = fa * fb / 12.0 * ((fn + 1.0) - ties / (fn * (fn - 1.0)));
+    if (var <= 0.0) return 1.0;
+    const double z = (u - mean - 0.5) / sqrt(var);
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+// ------------------------------ Comparison -----------------------------------
+
+typedef enum {
+    BENCH_SAME,
+    BENCH_FASTER,
+    BENCH_SLOWER,
+    BENCH_ONLY_BASE,     // in the baseline but not run: renamed, removed or setup failed
+    BENCH_ONLY_CURRENT,  // new case, nothing to compare with
+} bench_verdict;
+
+static inline const char* bench_verdict_name(bench_verdict v)
+{
+    switch (v) {
+    case BENCH_FASTER:       return "faster";
+    case BENCH_SLOWER:       return "REGRESSED";
+    case BENCH_ONLY_BASE:    return "MISSING";
+    case BENCH_ONLY_CURRENT: return "new";
+    default:                 return "same";
+    }
+}
+
+/**
+ * @brief Compare two reports case by case and print a table.
+ *
+ * @param base      Baseline.
+ * @param cur       Current run.
+ * @param threshold Relative change of the median that counts (0.05 = 5 %).
+ * @param alpha     Significance level of the Mann–Whitney test.
+ * @param out       Table output (NULL: silent).
+ * @return Number of failing cases: regressed, or in the baseline but missing
+ *         from the current run (a case whose setup fails is missing).
+ */
+static inline size_t bench_compare(const bench_report* base, const bench_report* cur, double threshold,
+                                   double alpha, FILE* out)
+{
+    size_t regressions = 0;
+    if (out) fprintf(out, "%-36s %12s %12s %8s %9s  %s\n", "case", "base ms", "current ms", "change", "p", "verdict");
+    for (size_t i = 0; i < cur->count; ++i) {
+        const bench_result* c = &cur->results[i];
+        const bench_result* b = bench_report_find(base, c->name);
+        if (!b) {
+            if (out) fprintf(out, "%-36s %12s %12.4f %8s %9s  %s\n", c->name, "-",
+                             bench_median(c->samples_ms, c->count), "-", "-", bench_verdict_name(BENCH_ONLY_CURRENT));
+            continue;
+        }
+        const double mb = bench_median(b->samples_ms, b->count);
+        const double mc = bench_median(c->samples_ms, c->count);
+        const double change = mb > 0.0 ? mc / mb - 1.0 : 0.0;
+        const double p_slower = bench_mann_whitney_greater(b->samples_ms, b->count, c->samples_ms, c->count);
+        const double p_faster = bench_mann_whitney_greater(c->samples_ms, c->count, b->samples_ms, b->count);
+        bench_verdict v = BENCH_SAME;
+        if (p_slower < alpha && change > threshold) v = BENCH_SLOWER;
+        else if (p_faster < alpha && change < -threshold) v = BENCH_FASTER;
+        if (v == BENCH_SLOWER) regressions++;
+        if (out) {
+            fprintf(out, "%-36s %12.4f %12.4f %+7.1f%% %9.2g  %s\n", c->name, mb, mc, 100.0 * change,
+                    v == BENCH_FASTER ? p_faster : p_slower, bench_verdict_name(v));
+        }
+    }
+    for (size_t i = 0; i < base->count; ++i) {
+        if (bench_report_find(cur, base->results[i].name)) continue;
+        regressions++;
+        if (out) fprintf(out, "%-36s %12.4f %12s %8s %9s  %s\n", base->results[i].name,
+                         bench_median(base->results[i].samples_ms, base->results[i].count), "-", "-", "-",
+                         bench_verdict_name(BENCH_ONLY_BASE));
+    }
+    return regressions;
+}
+
+#endif // BENCH_H
@@ -0,0 +1,390 @@
+﻿//
+// cluster.h — k-means (k-means++ seeding, Hamerly bounds) and DBSCAN over vec2.
+//
+// Hamerly's algorithm keeps, per point, an upper bound on the distance to its
+// assigned center and a lower bound on the distance to every other center.
+// When the upper bound is below max(lower bound, half the gap from the
+// assigned center to its nearest other center) the point provably keeps its
+// assignment and no distance is computed at all. Points that fail the test
+// are reassigned with a full scan over the centers, 8 centers per lane loop.
+//
+
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+#include "rng.h"
+#include "spatial_grid.h"
+
+#define CLUSTER_GRAIN 8192
+#define CLUSTER_LANES 8
+
+typedef struct {
+    int      iterations;
+    bool     converged;        // no assignment changed in the last iteration
+    uint64_t dist_evals;       // point-center distances actually computed
+    uint64_t dist_naive;       // what plain Lloyd iterations would compute
+    double   pruned_fraction;  // 1 - dist_evals / dist_naive
+    double   inertia;          // sum of squared distances to assigned centers
+} kmeans_stats;
+
+// ------------------------------ Shared kernels -------------------------------
+
+// Nearest and second-nearest center (squared distances) over SoA centers.
+static inline void cluster_nearest2(float px, float py, const float* cx, const float* cy, int k,
+                                    int* best, float* d_best, float* d_second)
+{
+    float b1 = INFINITY, b2 = INFINITY;
+    int bi = 0;
+    for (int j0 = 0; j0 < k; j0 += CLUSTER_LANES) {
+        float d[CLUSTER_LANES];
+        const int cnt = k - j0 < CLUSTER_LANES ? k - j0 : CLUSTER_LANES;
+        for (int l = 0; l < CLUSTER_LANES; ++l) {
+            const int j = j0 + (l < cnt ? l : 0);
+            const float dx = px - cx[j], dy = py - cy[j];
+            d[l] = l < cnt ? dx * dx + dy * dy : INFINITY;
+        }
+        for (int l = 0; l < cnt; ++l) {
+            if (d[l] < b1) { b2 = b1; b1 = d[l]; bi = j0 + l; }
+            else if (d[l] < b2) b2 = d[l];
+        }
+    }
+    *best = bi;
+    *d_best = b1;
+    *d_second = b2;
+}
+
+// ------------------------------ k-means++ ------------------------------------
+
+typedef struct {
+    const vec2* pts;
+    float*      d2;      // per point: squared distance to the nearest chosen center
+    vec2        c;       // newest center
+    double*     partial; // per worker sums of d2
+} cluster_seed_job;
+
+static inline void cluster_seed_range(void* user, size_t begin, size_t end, int worker)
+{
+    cluster_seed_job* j = (cluster_seed_job*)user;
+    double sum = 0.0;
+    for (size_t i = begin; i < end; ++i) {
+        const float dx = j->pts[i].x - j->c.x, dy = j->pts[i].y - j->c.y;
+        const float d = dx * dx + dy * dy;
+        if (d < j->d2[i]) j->d2[i] = d;
+        sum += j->d2[i];
+    }
+    j->partial[worker] += sum;
+}
+
+static inline bool cluster_kmeanspp(const vec2* pts, size_t n, int k, rng* rg, vec2* centers)
+{
+    float* d2 = (float*)malloc(n * sizeof(float));
+    if (!d2) return false;
+    for (size_t i = 0; i < n; ++i) d2[i] = INFINITY;
+
+    double partial[PARALLEL_MAX_WORKERS];
+    cluster_seed_job job = { pts, d2, pts[rng_below(rg, (uint32_t)n)], partial };
+    centers[0] = job.c;
+    for (int c = 1; c < k; ++c) {
+        memset(partial, 0, sizeof(partial));
+        parallel_for(n, CLUSTER_GRAIN, cluster_seed_range, &job);
+        double total = 0.0;
+        for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) total += partial[w];
+
+        // D^2 sampling: pick i with probability d2[i] / total.
+        size_t pick = n - 1;
+        if (total > 0.0) {
+            double target = (double)rng_float(rg) * total, acc = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                acc += d2[i];
+                if (acc > target) { pick = i; break; }
+            }
+        } else {
+            pick = rng_below(rg, (uint32_t)n);
+        }
+        job.c = pts[pick];
+        centers[c] = job.c;
+    }
+    free(d2);
+    return true;
+}
+
+// ------------------------------ Hamerly --------------------------------------
+
+typedef struct {
+    const vec2* pts;
+    size_t      n;
+    int         k;
+    uint32_t*   labels;
+    float*      upper;   // per point, distance (not squared)
+    float*      lower;
+    const float* cx;
+    const float* cy;
+    const float* s;      // per center: half distance to nearest other center
+    // Per-worker accumulators, PARALLEL_MAX_WORKERS rows.
+    double*     sum_x;   // rows of k
+    double*     sum_y;
+    uint32_t*   count;
+    uint64_t    evals[PARALLEL_MAX_WORKERS];
+    uint64_t    changed[PARALLEL_MAX_WORKERS];
+} cluster_hamerly_job;
+
+static inline void cluster_hamerly_range(void* user, size_t begin, size_t end, int worker)
+{
+    cluster_hamerly_job* j = (cluster_hamerly_job*)user;
+    const int k = j->k;
+    double* sx = j->sum_x + (size_t)worker * k;
+    double* sy = j->sum_y + (size_t)worker * k;
+    uint32_t* cnt = j->count + (size_t)worker * k;
+    uint64_t evals = 0, changed = 0;
+
+    for (size_t i = begin; i < end; ++i) {
+        const vec2 p = j->pts[i];
+        uint32_t a = j->labels[i];
+        const float m = fmaxf(j->s[a], j->lower[i]);
+        if (j->upper[i] > m) {
+            // Tighten the upper bound with one exact distance first.
+            const float dx = p.x - j->cx[a], dy = p.y - j->cy[a];
+            j->upper[i] = sqrtf(dx * dx + dy * dy);
+            evals++;
+            if (j->upper[i] > m) {
+                int best;
+                float d1, d2;
+                cluster_nearest2(p.x, p.y, j->cx, j->cy, k, &best, &d1, &d2);
+                evals += (uint64_t)k;
+                if ((uint32_t)best != a) { a = (uint32_t)best; j->labels[i] = a; changed++; }
+                j->upper[i] = sqrtf(d1);
+                j->lower[i] = sqrtf(d2);
+            }
+        }
+        sx[a] += p.x;
+        sy[a] += p.y;
+        cnt[a]++;
+    }
+    j->evals[worker] += evals;
+    j->changed[worker] += changed;
+}
+
+typedef struct {
+    float*       upper;
+    float*       lower;
+    const uint32_t* labels;
+    const float* move;    // per center displacement
+    float        max_move;
+    float        max_move2; // second-largest, for points whose own center moved most
+    int          argmax;
+} cluster_bounds_job;
+
+static inline void cluster_bounds_range(void* user, size_t begin, size_t end, int worker)
+{
+    (void)worker;
+    cluster_bounds_job* j = (cluster_bounds_job*)user;
+    for (size_t i = begin; i < end; ++i) {
+        const uint32_t a = j->labels[i];
+        j->upper[i] += j->move[a];
+        j->lower[i] -= ((int)a == j->argmax) ? j->max_move2 : j->max_move;
+    }
+}
+
+/**
+ * @brief k-means clustering with k-means++ seeding and Hamerly pruning.
+ *
+ * Assignment runs in parallel over points. Distance evaluations and the
+ * pruned fraction are reported in st.
+ *
+ * @param pts      Points.
+ * @param n        Number of points (1 .. 2^32-1).
+ * @param k        Number of clusters (1 .. n).
+ * @param max_iter Iteration cap.
+ * @param seed     Seed for k-means++.
+ * @param centers  Output: k centers.
+ * @param labels   Output: n cluster indices.
+ * @param st       Optional statistics (may be NULL).
+ * @return false on invalid input or allocation failure.
+ */
+static inline bool kmeans(const vec2* pts, size_t n, int k, int max_iter, uint64_t seed,
+                          vec2* centers, uint32_t* labels, kmeans_stats* st)
+{
+    kmeans_stats local;
+    if (!st) st = &local;
+    memset(st, 0, sizeof(*st));
+    if (n == 0 || n >= UINT32_MAX || k <= 0 || (size_t)k > n) return false;
+
+    rng rg;
+    rng_seed(&rg, seed, 0);
+    const size_t wk = (size_t)PARALLEL_MAX_WORKERS * (size_t)k;
+    float* upper = (float*)malloc(n * sizeof(float));
+    float* lower = (float*)malloc(n * sizeof(float));
+    float* cbuf  = (float*)malloc((size_t)k * 4 * sizeof(float)); // cx, cy, s, move
+    double* sums = (double*)malloc(wk * 2 * sizeof(double));
+    uint32_t* counts = (uint32_t*)malloc(wk * sizeof(uint32_t));
+    bool ok = upper && lower && cbuf && sums && counts && cluster_kmeanspp(pts, n, k, &rg, centers);
+
+    if (ok) {
+        float* cx = cbuf;
+        float* cy = cbuf + k;
+        float* s = cbuf + 2 * k;
+        float* move = cbuf + 3 * k;
+        for (int c = 0; c < k; ++c) { cx[c] = centers[c].x; cy[c] = centers[c].y; }
+
+        // Start with bounds that force a full scan for every point.
+        for (size_t i = 0; i < n; ++i) { labels[i] = 0; upper[i] = INFINITY; lower[i] = 0.0f; }
+
+        cluster_hamerly_job job;
+        memset(&job, 0, sizeof(job));
+        job.pts = pts; job.n = n; job.k = k; job.labels = labels;
+        job.upper = upper; job.lower = lower; job.cx = cx; job.cy = cy; job.s = s;
+        job.sum_x = sums; job.sum_y = sums + wk; job.count = counts;
+
+        for (int it = 0; it < max_iter; ++it) {
+            // s(j) = half the distance from center j to its nearest other center.
+            for (int a = 0; a < k; ++a) {
+                float best = INFINITY;
+                for (int b = 0; b < k; ++b) {
+                    if (a == b) continue;
+                    const float dx = cx[a] - cx[b], dy = cy[a] - cy[b];
+                    const float d = dx * dx + dy * dy;
+                    if (d < best) best = d;
+                }
+                s[a] = k > 1 ? 0.5f * sqrtf(best) : INFINITY;
+            }
+
+            memset(sums, 0, wk * 2 * sizeof(double));
+            memset(counts, 0, wk * sizeof(uint32_t));
+            memset(job.changed, 0, sizeof(job.changed));
+            parallel_for(n, CLUSTER_GRAIN, cluster_hamerly_range, &job);
+
+            uint64_t changed = 0;
+            for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) changed += job.changed[w];
+            st->iterations = it + 1;
+            st->dist_naive += (uint64_t)n * (uint64_t)k;
+            if (it > 0 && changed == 0) { st->converged = true; break; }
+
+            // Recompute centers and how far each one moved.
+            float max1 = 0.0f, max2 = 0.0f;
+            int argmax = -1;
+            for (int c = 0; c < k; ++c) {
+                double x = 0.0, y = 0.0;
+                uint64_t m = 0;
+                for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) {
+                    x += job.sum_x[(size_t)w * k + c];
+                    y += job.sum_y[(size_t)w * k + c];
+                    m += job.count[(size_t)w * k + c];
+                }
+                float nx = cx[c], ny = cy[c];
+                if (m > 0) { nx = (float)(x / (double)m); ny = (float)(y / (double)m); }
+                const float dx = nx - cx[c], dy = ny - cy[c];
+                move[c] = sqrtf(dx * dx + dy * dy);
+                cx[c] = nx; cy[c] = ny;
+                if (move[c] > max1) { max2 = max1; max1 = move[c]; argmax = c; }
+                else if (move[c] > max2) max2 = move[c];
+            }
+
+            cluster_bounds_job bj = { upper, lower, labels, move, max1, max2, argmax };
+            parallel_for(n, CLUSTER_GRAIN, cluster_bounds_range, &bj);
+        }
+
+        for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) st->dist_evals += job.evals[w];
+        st->pruned_fraction = st->dist_naive ? 1.0 - (double)st->dist_evals / (double)st->dist_naive : 0.0;
+        for (int c = 0; c < k; ++c) centers[c] = (vec2){ cx[c], cy[c] };
+        for (size_t i = 0; i < n; ++i) {
+            vec2 p = pts[i], c = centers[labels[i]];
+            st->inertia += vec2_dist2(&p, &c);
+        }
+    }
+
+    free(upper); free(lower); free(cbuf); free(sums); free(counts);
+    return ok;
+}
+
+// ------------------------------ DBSCAN ---------------------------------------
+
+#define DBSCAN_NOISE (-1)
+
+typedef struct {
+    const spatial_grid* g;
+    const vec2*         pts;
+    float               eps;
+    int                 min_pts;
+    uint8_t*            core;
+} cluster_core_job;
+
+static inline void cluster_core_range(void* user, size_t begin, size_t end, int worker)
+{
+    (void)worker;
+    cluster_core_job* j = (cluster_core_job*)user;
+    for (size_t i = begin; i < end; ++i)
+        j->core[i] = spatial_grid_query(j->g, j->pts, j->pts[i], j->eps, NULL, 0) >= (size_t)j->min_pts;
+}
+
+/**
+ * @brief DBSCAN density clustering backed by a spatial grid with cell = eps.
+ *
+ * Core points (at least min_pts points, itself included, within eps) are
+ * found in parallel; clusters are then grown from cores breadth-first.
+ * Border points join the first cluster that reaches them.
+ *
+ * @param pts     Points.
+ * @param n       Number of points.
+ * @param eps     Neighborhood radius.
+ * @param min_pts Density threshold.
+ * @param labels  Output: cluster index per point, or DBSCAN_NOISE.
+ * @return Number of clusters, or -1 on invalid input / allocation failure.
+ */
+static inline int dbscan(const vec2* pts, size_t n, float eps, int min_pts, int32_t* labels)
+{
+    spatial_grid g;
+    if (!spatial_grid_build(&g, pts, n, eps)) return -1;
+
+    uint8_t* core = (uint8_t*)malloc(n ? n : 1);
+    uint32_t* queue = (uint32_t*)malloc((n ? n : 1) * sizeof(uint32_t));
+    size_t nb_cap = 256;
+    uint32_t* nb = (uint32_t*)malloc(nb_cap * sizeof(uint32_t));
+    if (!core || !queue || !nb) {
+        free(core); free(queue); free(nb); spatial_grid_free(&g);
+        return -1;
+    }
+
+    cluster_core_job cj = { &g, pts, eps, min_pts, core };
+    parallel_for(n, CLUSTER_GRAIN / 4, cluster_core_range, &cj);
+
+    for (size_t i = 0; i < n; ++i) labels[i] = DBSCAN_NOISE;
+    int clusters = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!core[i] || labels[i] != DBSCAN_NOISE) continue;
+        const int32_t id = clusters++;
+        size_t head = 0, tail = 0;
+        labels[i] = id;
+        queue[tail++] = (uint32_t)i;
+        while (head < tail) {
+            const uint32_t q = queue[head++];
+            size_t m = spatial_grid_query(&g, pts, pts[q], eps, nb, nb_cap);
+            if (m > nb_cap) {
+                uint32_t* grown = (uint32_t*)realloc(nb, m * sizeof(uint32_t));
+                if (!grown) { clusters = -1; goto out; }
+                nb = grown;
+                nb_cap = m;
+                m = spatial_grid_query(&g, pts, pts[q], eps, nb, nb_cap);
+            }
+            for (size_t t = 0; t < m; ++t) {
+                const uint32_t r = nb[t];
+                if (labels[r] != DBSCAN_NOISE) continue;
+                labels[r] = id;
+                if (core[r]) queue[tail++] = r; // only cores expand the cluster
+            }
+        }
+    }
+
+out:
+    free(core); free(queue); free(nb);
+    spatial_grid_free(&g);
+    return clusters;
+}
+
+#endif // CLUSTER_H
@@ -0,0 +1,405 @@
+﻿//
+// contour.h — marching squares isolines over a scalar grid.
+//
+// The grid is split into bands of cell rows that are processed in parallel.
+// Every band emits its segments, stitches them into chains through the grid
+// edges they share, and leaves chains that leave the band open. A short
+// serial pass then joins those open ends across band boundaries and writes
+// the final polylines into an arena.
+//
+// Segment endpoints are identified by the grid edge they lie on:
+//   horizontal edge (x,y)-(x+1,y) -> 2*(y*w + x)
+//   vertical   edge (x,y)-(x,y+1) -> 2*(y*w + x) + 1
+// and positioned by linear interpolation of the two node values.
+//
+
+#ifndef CONTOUR_H
+#define CONTOUR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+#include "arena.h"
+
+#define CONTOUR_MIN_BAND_ROWS 16
+
+typedef struct {
+    vec2*     verts;       // all polyline vertices, back to back
+    uint32_t* line_start;  // line_count+1 offsets into verts
+    uint8_t*  line_closed; // 1 if the polyline is a closed loop (last vertex not repeated)
+    uint32_t  line_count;
+    uint32_t  vert_count;
+} contour_set;
+
+typedef struct {
+    const float* field; // w*h node values, row-major, node (x,y) at origin + (x,y)*cell
+    int          w, h;
+    vec2         origin;
+    float        cell;
+    float        iso;
+} contour_grid;
+
+// ------------------------------ Cell cases -----------------------------------
+
+// Cell edges: 0 bottom (n0-n1), 1 right (n1-n2), 2 top (n3-n2), 3 left (n0-n3),
+// with n0=(x,y), n1=(x+1,y), n2=(x+1,y+1), n3=(x,y+1). Bit i of the case is
+// set when node i is >= iso. Saddles (5, 10) are resolved by the cell center.
+static const int8_t g_contour_cases[16][4] = {
+    {-1,-1,-1,-1}, { 3, 0,-1,-1}, { 0, 1,-1,-1}, { 3, 1,-1,-1},
+    { 1, 2,-1,-1}, {-1,-1,-1,-1}, { 0, 2,-1,-1}, { 3, 2,-1,-1},
+    { 2, 3,-1,-1}, { 0, 2,-1,-1}, {-1,-1,-1,-1}, { 1, 2,-1,-1},
+    { 1, 3,-1,-1}, { 0, 1,-1,-1}, { 3, 0,-1,-1}, {-1,-1,-1,-1},
+};
+
+static inline uint64_t contour_cell_edge(int w, int x, int y, int e)
+{
+    switch (e) {
+    case 0:  return 2u * ((uint64_t)y * w + x);
+    case 1:  return 2u * ((uint64_t)y * w + x + 1) + 1u;
+    case 2:  return 2u * ((uint64_t)(y + 1) * w + x);
+    default: return 2u * ((uint64_t)y * w + x) + 1u;
+    }
+}
+
+static inline vec2 contour_edge_point(const contour_grid* g, uint64_t id)
+{
+    const uint64_t node = id >> 1;
+    const int x = (int)(node % (uint64_t)g->w);
+    const int y = (int)(node / (uint64_t)g->w);
+    const int x1 = (id & 1u) ? x : x + 1;
+    const int y1 = (id & 1u) ? y + 1 : y;
+    const float v0 = g->field[(size_t)y * g->w + x];
+    const float v1 = g->field[(size_t)y1 * g->w + x1];
+    const float t = (g->iso - v0) / (v1 - v0);
+    return (vec2){ g->origin.x + ((float)x + (float)(x1 - x) * t) * g->cell,
+                   g->origin.y + ((float)y + (float)(y1 - y) * t) * g->cell };
+}
+
+// ------------------------------ Band pass ------------------------------------
+
+typedef struct {
+    uint32_t start, count; // range in the band's edge list
+    bool     closed;
+} contour_chain;
+
+typedef struct {
+    uint64_t*      edges;   // chain vertices as edge ids
+    size_t         edge_len, edge_cap;
+    contour_chain* chains;
+    size_t         chain_len, chain_cap;
+    bool           failed;
+} contour_band;
+
+typedef struct {
+    const contour_grid* g;
+    contour_band*       bands;
+    int                 band_rows;
+    int32_t**           scratch;   // per worker: 2 slots per local edge, -1 = empty
+    size_t              scratch_len;
+} contour_job;
+
+static inline bool contour_grow(void** p, size_t* cap, size_t want, size_t elem)
+{
+    if (want <= *cap) return true;
+    size_t nc = *cap ? *cap * 2 : 256;
+    while (nc < want) nc *= 2;
+    void* np = realloc(*p, nc * elem);
+    if (!np) return false;
+    *p = np;
+    *cap = nc;
+    return true;
+}
+
+static inline void contour_band_run(const contour_job* job, contour_band* band, int r0, int r1, int32_t* slot)
+{
+    const contour_grid* g = job->g;
+    const int w = g->w;
+    const uint64_t base = 2u * (uint64_t)r0 * w;
+
+    // Segments as pairs of edge ids, kept in a temporary list.
+    uint64_t* seg = NULL;
+    size_t seg_len = 0, seg_cap = 0;
+
+    for (int y = r0; y < r1; ++y) {
+        const float* row0 = g->field + (size_t)y * w;
+        const float* row1 = row0 + w;
+        for (int x = 0; x + 1 < w; ++x) {
+            const int c = (row0[x] >= g->iso) | ((row0[x + 1] >= g->iso) << 1) |
+                          ((row1[x + 1] >= g->iso) << 2) | ((row1[x] >= g->iso) << 3);
+            if (c == 0 || c == 15) continue;
+            int8_t e[4];
+            memcpy(e, g_contour_cases[c], sizeof(e));
+            if (c == 5 || c == 10) {
+                const bool center = 0.25f * (row0[x] + row0[x + 1] + row1[x] + row1[x + 1]) >= g->iso;
+                const bool cut_odd = (c == 5) == center; // cut around n1 and n3
+                if (cut_odd) { e[0] = 0; e[1] = 1; e[2] = 2; e[3] = 3; }
+                else         { e[0] = 3; e[1] = 0; e[2] = 1; e[3] = 2; }
+            }
+            for (int s = 0; s < 4 && e[s] >= 0; s += 2) {
+                if (!contour_grow((void**)&seg, &seg_cap, seg_len + 2, sizeof(uint64_t))) {
+                    band->failed = true; free(seg); return;
+                }
+                seg[seg_len++] = contour_cell_edge(w, x, y, e[s]);
+                seg[seg_len++] = contour_cell_edge(w, x, y, e[s + 1]);
+            }
+        }
+    }
+
+    const size_t nseg = seg_len / 2;
+    for (size_t s = 0; s < seg_len; ++s) {
+        int32_t* sl = &slot[2 * (seg[s] - base)];
+        sl[sl[0] < 0 ? 0 : 1] = (int32_t)(s / 2);
+    }
+
+    uint8_t* used = (uint8_t*)calloc(nseg ? nseg : 1, 1);
+    if (!used) { band->failed = true; goto done; }
+
+    for (size_t s0 = 0; s0 < nseg; ++s0) {
+        if (used[s0]) continue;
+
+        // Walk backwards through edge seg[2*s0] to find an open end (or loop).
+        size_t s = s0;
+        uint64_t end = seg[2 * s0];
+        bool closed = false;
+        for (;;) {
+            const int32_t* sl = &slot[2 * (end - base)];
+            const int32_t other = sl[0] == (int32_t)s ? sl[1] : sl[0];
+            if (other < 0) break;
+            s = (size_t)other;
+            if (s == s0) { closed = true; break; }
+            end = seg[2 * s] == end ? seg[2 * s + 1] : seg[2 * s];
+        }
+
+        // Walk forwards from there, emitting edge ids.
+        contour_chain ch = { (uint32_t)band->edge_len, 0, closed };
+        if (closed) { s = s0; end = seg[2 * s0]; }
+        uint64_t cur = end;
+        for (;;) {
+            if (!contour_grow((void**)&band->edges, &band->edge_cap, band->edge_len + 1, sizeof(uint64_t))) {
+                band->failed = true; goto done;
+            }
+            band->edges[band->edge_len++] = cur;
+            used[s] = 1;
+            cur = seg[2 * s] == cur ? seg[2 * s + 1] : seg[2 * s];
+            const int32_t* sl = &slot[2 * (cur - base)];
+            const int32_t other = sl[0] == (int32_t)s ? sl[1] : sl[0];
+            if (other < 0 || used[other]) {
+                if (!closed) {
+                    if (!contour_grow((void**)&band->edges, &band->edge_cap, band->edge_len + 1, sizeof(uint64_t))) {
+                        band->failed = true; goto done;
+                    }
+                    band->edges[band->edge_len++] = cur;
+                }
+                break;
+            }
+            s = (size_t)other;
+        }
+        ch.count = (uint32_t)(band->edge_len - ch.start);
+        if (!contour_grow((void**)&band->chains, &band->chain_cap, band->chain_len + 1, sizeof(contour_chain))) {
+            band->failed = true; goto done;
+        }
+        band->chains[band->chain_len++] = ch;
+    }
+
+done:
+    for (size_t s = 0; s < seg_len; ++s) {
+        int32_t* sl = &slot[2 * (seg[s] - base)];
+        sl[0] = sl[1] = -1;
+    }
+    free(used);
+    free(seg);
+}
+
+static inline void contour_bands(void* user, size_t begin, size_t end, int worker)
+{
+    const contour_job* job = (const contour_job*)user;
+    const int cell_rows = job->g->h - 1;
+    for (size_t b = begin; b < end; ++b) {
+        const int r0 = (int)b * job->band_rows;
+        const int r1 = r0 + job->band_rows > cell_rows ? cell_rows : r0 + job->band_rows;
+        contour_band_run(job, &job->bands[b], r0, r1, job->scratch[worker]);
+    }
+}
+
+// ------------------------------ Merge ----------------------------------------
+
+typedef struct {
+    uint32_t band, chain;
+} contour_ref;
+
+// Chain end lying on a band boundary row, if any (returns boundary slot).
+static inline int64_t contour_boundary_slot(const contour_grid* g, int band_rows, uint64_t id)
+{
+    if (id & 1u) return -1;
+    const uint64_t node = id >> 1;
+    const int y = (int)(node / (uint64_t)g->w);
+    const int x = (int)(node % (uint64_t)g->w);
+    if (y == 0 || y >= g->h - 1 || y % band_rows != 0) return -1;
+    return (int64_t)(y / band_rows - 1) * g->w + x;
+}
+
+/**
+ * @brief Extract isolines of a scalar grid at the given iso value.
+ *
+ * Nodes with value >= iso count as inside. Polylines are stitched across the
+ * whole grid; loops are reported closed, contours leaving the grid open.
+ * The result lives in `a` until the arena is reset.
+ *
+ * @param g   Field, size, placement and iso value.
+ * @param a   Arena receiving the output arrays.
+ * @param out Resulting polylines.
+ * @return false on invalid input or allocation failure.
+ */
+static inline bool contour_extract(const contour_grid* g, arena* a, contour_set* out)
+{
+    memset(out, 0, sizeof(*out));
+    if (!g->field || g->w < 2 || g->h < 2) return false;
+
+    const int cell_rows = g->h - 1;
+    const int workers = parallel_worker_count();
+    int band_rows = cell_rows / (workers * 4);
+    if (band_rows < CONTOUR_MIN_BAND_ROWS) band_rows = CONTOUR_MIN_BAND_ROWS;
+    const int nbands = (cell_rows + band_rows - 1) / band_rows;
+
+    contour_job job = { g, NULL, band_rows, NULL, 2u * (size_t)g->w * (size_t)(band_rows + 1) * 2u };
+    job.bands = (contour_band*)calloc((size_t)nbands, sizeof(contour_band));
+    job.scratch = (int32_t**)calloc((size_t)workers, sizeof(int32_t*));
+    bool ok = job.bands && job.scratch;
+    for (int i = 0; ok && i < workers; ++i) {
+        job.scratch[i] = (int32_t*)malloc(job.scratch_len * sizeof(int32_t));
+        if (!job.scratch[i]) ok = false;
+        else memset(job.scratch[i], 0xFF, job.scratch_len * sizeof(int32_t));
+    }
+    if (ok) parallel_for((size_t)nbands, 1, contour_bands, &job);
+
+    size_t total_chains = 0;
+    for (int b = 0; ok && b < nbands; ++b) {
+        if (job.bands[b].failed) ok = false;
+        total_chains += job.bands[b].chain_len;
+    }
+
+    // Boundary table: two chain-end slots per horizontal edge on each inner
+    // band boundary. An end is encoded as (global chain index << 1) | is_last.
+    const size_t nslots = (size_t)(nbands > 1 ? nbands - 1 : 0) * (size_t)g->w;
+    int64_t* link = NULL;      // per chain end: linked chain end or -1
+    int64_t* bslot = NULL;
+    uint32_t* chain_base = NULL;
+    uint8_t* done = NULL;
+    if (ok) {
+        link = (int64_t*)malloc((total_chains * 2 + 1) * sizeof(int64_t));
+        bslot = (int64_t*)malloc((nslots * 2 + 1) * sizeof(int64_t));
+        chain_base = (uint32_t*)malloc(((size_t)nbands + 1) * sizeof(uint32_t));
+        done = (uint8_t*)calloc(total_chains + 1, 1);
+        ok = link && bslot && chain_base && done;
+    }
+
+    if (ok) {
+        memset(link, 0xFF, total_chains * 2 * sizeof(int64_t));
+        memset(bslot, 0xFF, nslots * 2 * sizeof(int64_t));
+        chain_base[0] = 0;
+        for (int b = 0; b < nbands; ++b) chain_base[b + 1] = chain_base[b] + (uint32_t)job.bands[b].chain_len;
+
+        for (int b = 0; b < nbands; ++b) {
+            const contour_band* bd = &job.bands[b];
+            for (size_t c = 0; c < bd->chain_len; ++c) {
+                const contour_chain* ch = &bd->chains[c];
+                if (ch->closed) continue;
+                for (int last = 0; last < 2; ++last) {
+                    const uint64_t id = bd->edges[ch->start + (last ? ch->count - 1 : 0)];
+                    const int64_t s = contour_boundary_slot(g, band_rows, id);
+                    if (s < 0) continue;
+                    const int64_t end = ((int64_t)(chain_base[b] + c) << 1) | last;
+                    int64_t* sl = &bslot[2 * s];
+                    if (sl[0] < 0) sl[0] = end;
+                    else { sl[1] = end; link[sl[0]] = end; link[end] = sl[0]; }
+                }
+            }
+        }
+    }
+
+    // Count output, then emit. Each pass walks linked chains from an unlinked
+    // end (open polyline) or, for what remains, around a loop.
+    size_t nverts = 0, nlines = 0;
+    for (int pass = 0; ok && pass < 2; ++pass) {
+        if (pass == 1) {
+            // +1: a loop writes its repeated start vertex before dropping it.
+            out->verts = ARENA_ARRAY(a, vec2, nverts + 1);
+            out->line_start = ARENA_ARRAY(a, uint32_t, nlines + 1);
+            out->line_closed = ARENA_ARRAY(a, uint8_t, nlines ? nlines : 1);
+            if (!out->verts || !out->line_start || !out->line_closed || nverts > UINT32_MAX) { ok = false; break; }
+            memset(done, 0, total_chains);
+        }
+        size_t v = 0, l = 0;
+        for (int round = 0; round < 2; ++round) {
+            for (size_t gc = 0; gc < total_chains; ++gc) {
+                if (done[gc]) continue;
+                int64_t start_end;
+                if (round == 0) {
+                    if (link[gc << 1] < 0)            start_end = (int64_t)(gc << 1);
+                    else if (link[(gc << 1) | 1] < 0) start_end = (int64_t)((gc << 1) | 1);
+                    else continue;
+                } else {
+                    start_end = (int64_t)(gc << 1);
+                }
+
+                bool closed = false;
+                if (pass == 1) out->line_start[l] = (uint32_t)v;
+                int64_t e = start_end;
+                for (;;) {
+                    const size_t ci = (size_t)(e >> 1);
+                    int lo = 0, hi = nbands - 1; // band owning chain ci
+                    while (lo < hi) {
+                        const int mid = (lo + hi + 1) / 2;
+                        if (chain_base[mid] <= ci) lo = mid; else hi = mid - 1;
+                    }
+                    const int b = lo;
+                    const contour_band* bd = &job.bands[b];
+                    const contour_chain* ch = &bd->chains[ci - chain_base[b]];
+                    done[ci] = 1;
+                    // Skip the first vertex when continuing a linked chain: it
+                    // duplicates the previous chain's last one.
+                    const uint32_t skip = (e != start_end) ? 1u : 0u;
+                    for (uint32_t k = skip; k < ch->count; ++k) {
+                        if (pass == 1) {
+                            const uint32_t idx = (e & 1) ? ch->count - 1 - k : k;
+                            out->verts[v] = contour_edge_point(g, bd->edges[ch->start + idx]);
+                        }
+                        v++;
+                    }
+                    if (ch->closed) { closed = true; break; }
+                    const int64_t far_end = e ^ 1;
+                    const int64_t next = link[far_end];
+                    if (next < 0) break;
+                    if (done[next >> 1]) { closed = true; v--; break; } // loop: drop repeated start
+                    e = next;
+                }
+                if (pass == 1) out->line_closed[l] = closed ? 1 : 0;
+                l++;
+            }
+        }
+        nverts = v;
+        nlines = l;
+        if (pass == 1) {
+            out->line_start[l] = (uint32_t)v;
+            out->line_count = (uint32_t)l;
+            out->vert_count = (uint32_t)v;
+        }
+    }
+
+    for (int b = 0; job.bands && b < nbands; ++b) {
+        free(job.bands[b].edges);
+        free(job.bands[b].chains);
+    }
+    for (int i = 0; job.scratch && i < workers; ++i) free(job.scratch[i]);
+    free(job.scratch);
+    free(job.bands);
+    free(link); free(bslot); free(chain_base); free(done);
+    if (!ok) memset(out, 0, sizeof(*out));
+    return ok;
+}
+
+#endif // CONTOUR_H
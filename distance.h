@@ -0,0 +1,296 @@
+﻿//
+// distance.h — pairwise distance matrices, Hausdorff and discrete Fréchet
+// distance between point sets / polylines.
+//
+// The matrix kernels work on DIST_TILE_ROWS x DIST_TILE_COLS tiles: the tile's
+// b points are copied to SoA once and stay in L1 while every row of the tile
+// streams over them, DIST_LANES columns per lane loop. Tiles are distributed
+// over workers; the streaming variant hands each finished tile to a callback
+// from a per-worker buffer, so an na x nb matrix never has to exist in memory.
+//
+// Hausdorff uses the early-break scan of Taha & Hanbury: for each point of a,
+// the scan over b stops as soon as some distance drops below the running
+// maximum, since that point can no longer raise it. Visiting a and b in a
+// scrambled order makes the break happen early on typical shapes.
+//
+
+#ifndef DISTANCE_H
+#define DISTANCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+
+#define DIST_LANES      8
+#define DIST_TILE_ROWS  64
+#define DIST_TILE_COLS  512
+#define DIST_HAUSDORFF_GRAIN 256
+
+// ------------------------------ Distance matrix ------------------------------
+
+/**
+ * @brief Callback receiving one finished tile of squared distances.
+ *
+ * Called concurrently from several workers; tile is only valid during the call.
+ *
+ * @param user   Opaque pointer passed through.
+ * @param i0     First row (index into a).
+ * @param j0     First column (index into b).
+ * @param rows   Rows in the tile.
+ * @param cols   Columns in the tile.
+ * @param tile   rows x cols values, row r at tile + r * DIST_TILE_COLS.
+ * @param worker Worker index, for per-thread accumulators.
+ */
+typedef void (*dist_tile_fn)(void* user, size_t i0, size_t j0, size_t rows, size_t cols,
+                             const float* tile, int worker);
+
+typedef struct {
+    const vec2*  a;
+    size_t       na;
+    const vec2*  b;
+    size_t       nb;
+    size_t       tiles_x;
+    float*       out;      // full matrix, or NULL when streaming
+    dist_tile_fn fn;
+    void*        user;
+    float*       scratch;  // per worker: DIST_TILE_ROWS * DIST_TILE_COLS + 2 * DIST_TILE_COLS
+} dist_matrix_job;
+
+// Squared distances from each of rows points in a to cols SoA points.
+static inline void dist_tile_kernel(const vec2* a, size_t rows, const float* bx, const float* by,
+                                    size_t cols, float* dst, size_t stride)
+{
+    for (size_t r = 0; r < rows; ++r) {
+        const float px = a[r].x, py = a[r].y;
+        float* row = dst + r * stride;
+        size_t c = 0;
+        for (; c + DIST_LANES <= cols; c += DIST_LANES) {
+            for (size_t l = 0; l < DIST_LANES; ++l) {
+                const float dx = px - bx[c + l], dy = py - by[c + l];
+                row[c + l] = dx * dx + dy * dy;
+            }
+        }
+        for (; c < cols; ++c) {
+            const float dx = px - bx[c], dy = py - by[c];
+            row[c] = dx * dx + dy * dy;
+        }
+    }
+}
+
+static inline void dist_matrix_range(void* user, size_t begin, size_t end, int worker)
+{
+    dist_matrix_job* j = (dist_matrix_job*)user;
+    float* scratch = j->scratch + (size_t)worker * (DIST_TILE_ROWS * DIST_TILE_COLS + 2 * DIST_TILE_COLS);
+    float* bx = scratch + DIST_TILE_ROWS * DIST_TILE_COLS;
+    float* by = bx + DIST_TILE_COLS;
+    for (size_t t = begin; t < end; ++t) {
+        const size_t i0 = (t / j->tiles_x) * DIST_TILE_ROWS, j0 = (t % j->tiles_x) * DIST_TILE_COLS;
+        const size_t rows = j->na - i0 < DIST_TILE_ROWS ? j->na - i0 : DIST_TILE_ROWS;
+        const size_t cols = j->nb - j0 < DIST_TILE_COLS ? j->nb - j0 : DIST_TILE_COLS;
+        for (size_t c = 0; c < cols; ++c) { bx[c] = j->b[j0 + c].x; by[c] = j->b[j0 + c].y; }
+        if (j->out) {
+            dist_tile_kernel(j->a + i0, rows, bx, by, cols, j->out + i0 * j->nb + j0, j->nb);
+        } else {
+            dist_tile_kernel(j->a + i0, rows, bx, by, cols, scratch, DIST_TILE_COLS);
+            j->fn(j->user, i0, j0, rows, cols, scratch, worker);
+        }
+    }
+}
+
+static inline bool dist_matrix_run(dist_matrix_job* j)
+{
+    if (j->na == 0 || j->nb == 0) return true;
+    j->tiles_x = (j->nb + DIST_TILE_COLS - 1) / DIST_TILE_COLS;
+    const size_t tiles = ((j->na + DIST_TILE_ROWS - 1) / DIST_TILE_ROWS) * j->tiles_x;
+    const int workers = parallel_worker_count();
+    j->scratch = (float*)malloc((size_t)workers * (DIST_TILE_ROWS * DIST_TILE_COLS + 2 * DIST_TILE_COLS)
+                                * sizeof(float));
+    if (!j->scratch) return false;
+    parallel_for(tiles, 1, dist_matrix_range, j);
+    free(j->scratch);
+    return true;
+}
+
+/**
+ * @brief Full na x nb matrix of squared distances (vec2_dist2), row-major.
+ *
+ * @param a   First point set (rows).
+ * @param na  Number of rows.
+ * @param b   Second point set (columns).
+ * @param nb  Number of columns.
+ * @param out Output, na * nb floats; out[i * nb + j] = |a[i] - b[j]|^2.
+ * @return false on allocation failure.
+ */
+static inline bool dist_matrix(const vec2* a, size_t na, const vec2* b, size_t nb, float* out)
+{
+    dist_matrix_job j = { a, na, b, nb, 0, out, NULL, NULL, NULL };
+    return dist_matrix_run(&j);
+}
+
+/**
+ * @brief Stream the squared distance matrix tile by tile without storing it.
+ *
+ * @param a    First point set (rows).
+ * @param na   Number of rows.
+ * @param b    Second point set (columns).
+ * @param nb   Number of columns.
+ * @param fn   Called once per tile, concurrently from several workers.
+ * @param user Passed to fn.
+ * @return false on allocation failure.
+ */
+static inline bool dist_matrix_stream(const vec2* a, size_t na, const vec2* b, size_t nb,
+                                      dist_tile_fn fn, void* user)
+{
+    dist_matrix_job j = { a, na, b, nb, 0, NULL, fn, user, NULL };
+    return dist_matrix_run(&j);
+}
+
+// ------------------------------ Hausdorff ------------------------------------
+
+typedef struct {
+    const vec2* a;
+    const float* bx;      // b in scrambled order, SoA
+    const float* by;
+    size_t      na, nb;
+    uint64_t    stride;   // a visiting order: i -> (i * stride) mod na
+    float       cmax[PARALLEL_MAX_WORKERS]; // per-worker running max (squared)
+} dist_hausdorff_job;
+
+static inline void dist_hausdorff_range(void* user, size_t begin, size_t end, int worker)
+{
+    dist_hausdorff_job* j = (dist_hausdorff_job*)user;
+    float cmax = j->cmax[worker];
+    for (size_t k = begin; k < end; ++k) {
+        const vec2 p = j->a[(size_t)(((uint64_t)k * j->stride) % j->na)];
+        float cmin = INFINITY;
+        for (size_t c = 0; c < j->nb; c += DIST_LANES) {
+            const size_t cnt = j->nb - c < DIST_LANES ? j->nb - c : DIST_LANES;
+            float d[DIST_LANES];
+            for (size_t l = 0; l < DIST_LANES; ++l) {
+                const size_t i = c + (l < cnt ? l : 0);
+                const float dx = p.x - j->bx[i], dy = p.y - j->by[i];
+                d[l] = dx * dx + dy * dy;
+            }
+            for (size_t l = 0; l < cnt; ++l) cmin = fminf(cmin, d[l]);
+            if (cmin < cmax) break; // p cannot raise the maximum
+        }
+        if (cmin > cmax) cmax = cmin;
+    }
+    j->cmax[worker] = cmax;
+}
+
+static inline uint64_t dist_gcd(uint64_t a, uint64_t b)
+{
+    while (b) { const uint64_t t = a % b; a = b; b = t; }
+    return a;
+}
+
+// A stride coprime to n near n * golden ratio: visits 0..n-1 in a scattered order.
+static inline uint64_t dist_scramble_stride(size_t n)
+{
+    uint64_t s = (uint64_t)((double)n * 0.6180339887) | 1u;
+    while (n > 1 && dist_gcd(s, n) != 1) s += 2;
+    return s;
+}
+
+/**
+ * @brief Directed Hausdorff distance max_{p in a} min_{q in b} |p - q|.
+ *
+ * Exact; the early break only skips work that cannot change the result.
+ *
+ * @param a  Source set.
+ * @param na Number of points in a.
+ * @param b  Target set.
+ * @param nb Number of points in b.
+ * @return Distance, INFINITY if b is empty and a is not, 0 if a is empty;
+ *         NAN on allocation failure.
+ */
+static inline float hausdorff_directed(const vec2* a, size_t na, const vec2* b, size_t nb)
+{
+    if (na == 0) return 0.0f;
+    if (nb == 0) return INFINITY;
+    float* bx = (float*)malloc(nb * sizeof(float));
+    float* by = (float*)malloc(nb * sizeof(float));
+    if (!bx || !by) { free(bx); free(by); return NAN; }
+    const uint64_t sb = dist_scramble_stride(nb);
+    for (size_t i = 0; i < nb; ++i) {
+        const vec2 q = b[(size_t)(((uint64_t)i * sb) % nb)];
+        bx[i] = q.x;
+        by[i] = q.y;
+    }
+
+    dist_hausdorff_job j;
+    j.a = a; j.bx = bx; j.by = by; j.na = na; j.nb = nb;
+    j.stride = dist_scramble_stride(na);
+    for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) j.cmax[w] = 0.0f;
+    parallel_for(na, DIST_HAUSDORFF_GRAIN, dist_hausdorff_range, &j);
+
+    float cmax = 0.0f;
+    for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) cmax = fmaxf(cmax, j.cmax[w]);
+    free(bx);
+    free(by);
+    return sqrtf(cmax);
+}
+
+/**
+ * @brief Symmetric Hausdorff distance, max of both directed distances.
+ */
+static inline float hausdorff(const vec2* a, size_t na, const vec2* b, size_t nb)
+{
+    const float ab = hausdorff_directed(a, na, b, nb);
+    const float ba = hausdorff_directed(b, nb, a, na);
+    return isnan(ab) || isnan(ba) ? NAN : fmaxf(ab, ba);
+}
+
+// ------------------------------ Fréchet --------------------------------------
+
+/**
+ * @brief Discrete Fréchet distance between two polylines.
+ *
+ * Dynamic program over the np x nq coupling grid, kept in one row of nq
+ * values: row i depends only on row i - 1 and the cell to its left. Each row's
+ * point distances are computed up front in a lane loop, the max/min recurrence
+ * then runs over them.
+ *
+ * @param p  First polyline.
+ * @param np Number of vertices in p.
+ * @param q  Second polyline.
+ * @param nq Number of vertices in q.
+ * @return Distance, INFINITY if either polyline is empty, NAN on allocation
+ *         failure.
+ */
+static inline float frechet_discrete(const vec2* p, size_t np, const vec2* q, size_t nq)
+{
+    if (np == 0 || nq == 0) return INFINITY;
+    float* row = (float*)malloc(nq * sizeof(float));
+    float* d = (float*)malloc(nq * sizeof(float));
+    float* qx = (float*)malloc(nq * sizeof(float));
+    float* qy = (float*)malloc(nq * sizeof(float));
+    if (!row || !d || !qx || !qy) { free(row); free(d); free(qx); free(qy); return NAN; }
+    for (size_t j = 0; j < nq; ++j) { qx[j] = q[j].x; qy[j] = q[j].y; }
+
+    for (size_t i = 0; i < np; ++i) {
+        dist_tile_kernel(&p[i], 1, qx, qy, nq, d, nq);
+        if (i == 0) {
+            row[0] = d[0];
+            for (size_t j = 1; j < nq; ++j) row[j] = fmaxf(row[j - 1], d[j]);
+            continue;
+        }
+        float diag = row[0];           // row[i-1][j-1] for the next column
+        row[0] = fmaxf(row[0], d[0]);
+        for (size_t j = 1; j < nq; ++j) {
+            const float up = row[j];
+            row[j] = fmaxf(fminf(fminf(up, diag), row[j - 1]), d[j]);
+            diag = up;
+        }
+    }
+    const float result = sqrtf(row[nq - 1]);
+    free(row); free(d); free(qx); free(qy);
+    return result;
+}
+
+#endif // DISTANCE_H
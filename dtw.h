@@ -0,0 +1,299 @@
+﻿//
+// dtw.h — dynamic time warping over vec2 sequences and top-k trajectory search.
+//
+// DTW cost is the sum of squared point distances along the best monotone
+// alignment, restricted to a Sakoe–Chiba band of half-width `band` around the
+// (scaled) diagonal; distances are reported as its square root.
+//
+// A DP row is computed in two passes: a lane loop forms
+//   cur[j] = cost[j] + min(prev[j - 1], prev[j])
+// for the whole band, then a short serial scan folds in the left neighbor
+//   cur[j] = min(cur[j], cost[j] + cur[j - 1]).
+// Only two rows are kept, and a row whose minimum already exceeds the
+// current k-th best abandons the alignment.
+//
+// The search prunes candidates before running DTW with LB_Kim (first and last
+// points must be aligned) and, for equal lengths, LB_Keogh: every candidate
+// point is aligned to some query point within the band, so its squared
+// distance to the bounding box of that query window is a lower bound.
+//
+
+#ifndef DTW_H
+#define DTW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+#include "trajectory.h"
+
+#define DTW_LANES        8
+#define DTW_SEARCH_GRAIN 64
+#define DTW_MAX_K        256
+
+typedef struct {
+    uint64_t candidates;
+    uint64_t pruned_kim;       // rejected by LB_Kim
+    uint64_t pruned_keogh;     // rejected by LB_Keogh
+    uint64_t abandoned;        // DTW stopped early
+    uint64_t full;             // DTW run to the end
+} dtw_search_stats;
+
+// Columns of row i inside the band (inclusive).
+static inline void dtw_band(size_t i, size_t n, size_t m, size_t band, size_t* j0, size_t* j1)
+{
+    if (n == 1) { *j0 = 0; *j1 = m - 1; return; }
+    const double slope = (double)(m - 1) / (double)(n - 1);
+    // Consecutive rows must overlap or touch diagonally, which needs a
+    // half-width of slope - 1 when b is longer; band 0 is the diagonal itself.
+    const double w = (double)band > slope - 1.0 ? (double)band : slope - 1.0;
+    const double c = (double)i * slope;
+    const double lo = floor(c - w), hi = ceil(c + w);
+    *j0 = lo < 0.0 ? 0 : (size_t)lo;
+    *j1 = hi > (double)(m - 1) ? m - 1 : (size_t)hi;
+}
+
+/**
+ * @brief Banded DTW with early abandoning, using caller scratch.
+ *
+ * @param a       First sequence (rows).
+ * @param n       Its length (> 0).
+ * @param b       Second sequence (columns).
+ * @param m       Its length (> 0).
+ * @param band    Sakoe–Chiba half-width in columns (0: the diagonal only).
+ * @param limit   Squared cost above which the alignment is abandoned (INFINITY: never).
+ * @param scratch 3 * (m + 1) floats.
+ * @return Squared DTW cost, or INFINITY if abandoned.
+ */
+static inline float dtw_cost(const vec2* a, size_t n, const vec2* b, size_t m, size_t band,
+                             float limit, float* scratch)
+{
+    // Column j is stored at index j + 1; index 0 is the "column -1" sentinel.
+    float* prev = scratch;
+    float* cur = scratch + (m + 1);
+    float* cost = scratch + 2 * (m + 1);
+    for (size_t j = 0; j <= m; ++j) { prev[j] = INFINITY; cur[j] = INFINITY; }
+    prev[0] = 0.0f; // D[-1][-1]: the alignment starts at (0, 0)
+
+    size_t j0, j1;
+    dtw_band(0, n, m, band, &j0, &j1);
+    for (size_t i = 0; i < n; ++i) {
+        const vec2 p = a[i];
+        const size_t cnt = j1 - j0 + 1;
+        for (size_t c = 0; c < cnt; c += DTW_LANES) {
+            float tmp[DTW_LANES], d[DTW_LANES];
+            for (size_t l = 0; l < DTW_LANES; ++l) {
+                const size_t j = j0 + (c + l < cnt ? c + l : 0);
+                const float dx = p.x - b[j].x, dy = p.y - b[j].y;
+                d[l] = dx * dx + dy * dy;
+                tmp[l] = d[l] + fminf(prev[j], prev[j + 1]);
+            }
+            const size_t lim = cnt - c < DTW_LANES ? cnt - c : DTW_LANES;
+            for (size_t l = 0; l < lim; ++l) {
+                cost[j0 + c + l] = d[l];
+                cur[j0 + c + l + 1] = tmp[l];
+            }
+        }
+        cur[j0] = INFINITY;
+        float row_min = INFINITY;
+        for (size_t j = j0; j <= j1; ++j) {
+            const float left = cost[j] + cur[j];
+            if (left < cur[j + 1]) cur[j + 1] = left;
+            row_min = fminf(row_min, cur[j + 1]);
+        }
+        if (row_min > limit) return INFINITY;
+        if (i == 0) prev[0] = INFINITY; // the start cell is only reachable from row 0
+
+        if (i + 1 < n) {
+            size_t n0, n1;
+            dtw_band(i + 1, n, m, band, &n0, &n1);
+            // Columns the next row reads beyond this row's band must read as unreachable.
+            for (size_t j = j1 + 1; j <= n1; ++j) cur[j + 1] = INFINITY;
+            j0 = n0;
+            j1 = n1;
+        }
+        float* t = prev; prev = cur; cur = t;
+    }
+    return prev[m];
+}
+
+/**
+ * @brief DTW distance (square root of the banded squared cost).
+ *
+ * @return Distance, INFINITY if a sequence is empty, NAN on allocation failure.
+ */
+static inline float dtw_distance(const vec2* a, size_t n, const vec2* b, size_t m, size_t band)
+{
+    if (n == 0 || m == 0) return INFINITY;
+    float* scratch = (float*)malloc(3 * (m + 1) * sizeof(float));
+    if (!scratch) return NAN;
+    const float c = dtw_cost(a, n, b, m, band, INFINITY, scratch);
+    free(scratch);
+    return sqrtf(c);
+}
+
+// ------------------------------ Lower bounds ---------------------------------
+
+static inline float dtw_lb_kim(const vec2* q, size_t n, const vec2* c, size_t m)
+{
+    vec2 q0 = q[0], c0 = c[0], q1 = q[n - 1], c1 = c[m - 1];
+    const float first = vec2_dist2(&q0, &c0);
+    return n == 1 && m == 1 ? first : first + vec2_dist2(&q1, &c1);
+}
+
+// Per-position bounding boxes of the query over [i - band, i + band], SoA.
+static inline void dtw_envelope(const vec2* q, size_t n, size_t band,
+                                float* lx, float* ux, float* ly, float* uy)
+{
+    for (size_t i = 0; i < n; ++i) {
+        const size_t a = i > band ? i - band : 0, b = i + band < n - 1 ? i + band : n - 1;
+        float x0 = INFINITY, x1 = -INFINITY, y0 = INFINITY, y1 = -INFINITY;
+        for (size_t j = a; j <= b; ++j) {
+            x0 = fminf(x0, q[j].x); x1 = fmaxf(x1, q[j].x);
+            y0 = fminf(y0, q[j].y); y1 = fmaxf(y1, q[j].y);
+        }
+        lx[i] = x0; ux[i] = x1; ly[i] = y0; uy[i] = y1;
+    }
+}
+
+// LB_Keogh of candidate c (same length as the envelope), abandoning above limit.
+static inline float dtw_lb_keogh(const vec2* c, size_t n, const float* lx, const float* ux,
+                                 const float* ly, const float* uy, float limit)
+{
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i += DTW_LANES) {
+        const size_t cnt = n - i < DTW_LANES ? n - i : DTW_LANES;
+        float d[DTW_LANES];
+        for (size_t l = 0; l < DTW_LANES; ++l) {
+            const size_t k = i + (l < cnt ? l : 0);
+            const float dx = fmaxf(fmaxf(lx[k] - c[k].x, c[k].x - ux[k]), 0.0f);
+            const float dy = fmaxf(fmaxf(ly[k] - c[k].y, c[k].y - uy[k]), 0.0f);
+            d[l] = l < cnt ? dx * dx + dy * dy : 0.0f;
+        }
+        for (size_t l = 0; l < DTW_LANES; ++l) sum += d[l];
+        if (sum > limit) return sum;
+    }
+    return sum;
+}
+
+// ------------------------------ Top-k search ---------------------------------
+
+typedef struct {
+    const traj_corpus* corpus;
+    const vec2*        q;
+    size_t             qn;
+    size_t             band;
+    size_t             k;
+    const float*       env;       // lx, ux, ly, uy, qn each
+    float*             scratch;   // per worker: 3 * (qn + 1)
+    uint64_t*          top_idx;   // per worker: k
+    float*             top_cost;  // per worker: k, ascending
+    size_t             top_n[PARALLEL_MAX_WORKERS];
+    dtw_search_stats   st[PARALLEL_MAX_WORKERS];
+} dtw_search_job;
+
+static inline void dtw_top_insert(uint64_t* idx, float* cost, size_t* n, size_t k, uint64_t i, float c)
+{
+    if (*n == k && !(c < cost[k - 1] || (c == cost[k - 1] && i < idx[k - 1]))) return;
+    size_t p = *n < k ? (*n)++ : k - 1;
+    while (p > 0 && (cost[p - 1] > c || (cost[p - 1] == c && idx[p - 1] > i))) {
+        cost[p] = cost[p - 1];
+        idx[p] = idx[p - 1];
+        p--;
+    }
+    cost[p] = c;
+    idx[p] = i;
+}
+
+static inline void dtw_search_range(void* user, size_t begin, size_t end, int worker)
+{
+    dtw_search_job* j = (dtw_search_job*)user;
+    float* scratch = j->scratch + (size_t)worker * 3 * (j->qn + 1);
+    uint64_t* idx = j->top_idx + (size_t)worker * j->k;
+    float* cost = j->top_cost + (size_t)worker * j->k;
+    size_t* n = &j->top_n[worker];
+    dtw_search_stats* st = &j->st[worker];
+    const size_t qn = j->qn;
+
+    for (size_t i = begin; i < end; ++i) {
+        size_t m;
+        const vec2* c = traj_corpus_get(j->corpus, i, &m);
+        if (m == 0) continue;
+        st->candidates++;
+        // Ties with the current k-th best still have to be evaluated (index order).
+        const float limit = *n == j->k ? cost[j->k - 1] : INFINITY;
+        if (dtw_lb_kim(j->q, qn, c, m) > limit) { st->pruned_kim++; continue; }
+        if (m == qn && dtw_lb_keogh(c, m, j->env, j->env + qn, j->env + 2 * qn, j->env + 3 * qn, limit) > limit) {
+            st->pruned_keogh++;
+            continue;
+        }
+        // Candidate along the rows, query along the columns (scratch sized by qn).
+        const float d = dtw_cost(c, m, j->q, qn, j->band, limit, scratch);
+        if (d == INFINITY) { st->abandoned++; continue; }
+        st->full++;
+        dtw_top_insert(idx, cost, n, j->k, i, d);
+    }
+}
+
+/**
+ * @brief The k corpus trajectories closest to q under banded DTW.
+ *
+ * Runs over the corpus on all workers; each keeps its own top-k and prunes
+ * against its own k-th best, and the lists are merged at the end. The result
+ * is exact and independent of the worker count (ties go to the lower index).
+ *
+ * @param corpus   Mapped corpus.
+ * @param q        Query trajectory.
+ * @param qn       Query length (> 0).
+ * @param band     Sakoe–Chiba half-width.
+ * @param k        Number of results (1..DTW_MAX_K).
+ * @param out_idx  Output: corpus indices, closest first.
+ * @param out_dist Output: DTW distances.
+ * @param st       Optional pruning statistics.
+ * @return Number of results (< k if the corpus has fewer non-empty
+ *         trajectories), or -1 on invalid input or allocation failure.
+ */
+static inline int dtw_search(const traj_corpus* corpus, const vec2* q, size_t qn, size_t band, size_t k,
+                             uint64_t* out_idx, float* out_dist, dtw_search_stats* st)
+{
+    if (st) memset(st, 0, sizeof(*st));
+    if (qn == 0 || k == 0 || k > DTW_MAX_K) return -1;
+
+    const size_t workers = (size_t)parallel_worker_count();
+
+    dtw_search_job* j = (dtw_search_job*)calloc(1, sizeof(dtw_search_job));
+    float* env = (float*)malloc(4 * qn * sizeof(float));
+    float* scratch = (float*)malloc(workers * 3 * (qn + 1) * sizeof(float));
+    uint64_t* top_idx = (uint64_t*)malloc(workers * k * sizeof(uint64_t));
+    float* top_cost = (float*)malloc(workers * k * sizeof(float));
+    int result = -1;
+    if (j && env && scratch && top_idx && top_cost) {
+        dtw_envelope(q, qn, band, env, env + qn, env + 2 * qn, env + 3 * qn);
+        j->corpus = corpus; j->q = q; j->qn = qn; j->band = band; j->k = k;
+        j->env = env; j->scratch = scratch; j->top_idx = top_idx; j->top_cost = top_cost;
+        parallel_for(corpus->count, DTW_SEARCH_GRAIN, dtw_search_range, j);
+
+        // Merge the per-worker lists.
+        size_t n = 0;
+        for (size_t w = 0; w < workers; ++w) {
+            for (size_t e = 0; e < j->top_n[w]; ++e)
+                dtw_top_insert(out_idx, out_dist, &n, k, top_idx[w * k + e], top_cost[w * k + e]);
+            if (st) {
+                st->candidates += j->st[w].candidates;
+                st->pruned_kim += j->st[w].pruned_kim;
+                st->pruned_keogh += j->st[w].pruned_keogh;
+                st->abandoned += j->st[w].abandoned;
+                st->full += j->st[w].full;
+            }
+        }
+        for (size_t e = 0; e < n; ++e) out_dist[e] = sqrtf(out_dist[e]);
+        result = (int)n;
+    }
+    free(j); free(env); free(scratch); free(top_idx); free(top_cost);
+    return result;
+}
+
+#endif // DTW_H
@@ -0,0 +1,421 @@
+﻿//
+// fit.h — least-squares and RANSAC fitting of lines and circles to 2D points.
+//
+// RANSAC draws hypotheses in batches of FIT_RANSAC_BATCH from a seeded rng
+// (same seed, same result for any worker count) and scores a whole batch in
+// parallel, one hypothesis per task, against points stored SoA. Residuals are
+// computed FIT_LANES points at a time: a line is kept as its unit direction d
+// and offset c = cross(d, a), so the point-to-line distance is
+// |cross(d, p) - c|; a circle as center and radius.
+//
+// Scoring stops early in two ways: a hypothesis is abandoned as soon as its
+// remaining points can no longer beat the best count of the previous batches,
+// and the run ends once enough hypotheses were drawn to have found an
+// all-inlier sample with the requested confidence (the standard adaptive
+// bound, re-evaluated after each batch). The winner is then refined by least
+// squares on its inliers.
+//
+
+#ifndef FIT_H
+#define FIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+#include "rng.h"
+
+#define FIT_LANES          8
+#define FIT_BLOCK          256  // points scored between early-termination checks
+#define FIT_RANSAC_BATCH   64
+#define FIT_REFINE_ITERS   3
+#define FIT_CIRCLE_GN_ITERS 10
+
+typedef struct {
+    vec2 point; // a point on the line
+    vec2 dir;   // unit direction
+} fit_line;
+
+typedef struct {
+    vec2  center;
+    float radius;
+} fit_circle;
+
+typedef struct {
+    float    threshold;      // inlier distance
+    float    confidence;     // e.g. 0.99; stop once an all-inlier sample is this likely
+    int      max_hypotheses; // hard cap on drawn hypotheses
+    uint64_t seed;
+} ransac_params;
+
+typedef struct {
+    int      hypotheses;  // hypotheses drawn (including degenerate samples)
+    int      abandoned;   // hypotheses whose scoring stopped early
+    uint64_t point_tests; // point-model residuals computed
+    size_t   inliers;     // inliers of the returned model
+} ransac_stats;
+
+// ------------------------------ Least squares --------------------------------
+
+static inline bool fit_solve3(double a[3][3], const double b[3], double x[3])
+{
+    const double det = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1])
+                     - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+                     + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+    double scale = 0.0;
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j) scale = fmax(scale, fabs(a[i][j]));
+    if (!(fabs(det) > 1e-12 * scale * scale * scale)) return false;
+    for (int c = 0; c < 3; ++c) {
+        double m[3][3];
+        memcpy(m, a, sizeof(m));
+        for (int r = 0; r < 3; ++r) m[r][c] = b[r];
+        x[c] = (m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+              - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+              + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0])) / det;
+    }
+    return true;
+}
+
+/**
+ * @brief Total least-squares line (minimizes perpendicular distances).
+ *
+ * @param pts  Points.
+ * @param n    Number of points.
+ * @param mask Optional; only points with mask[i] != 0 are used.
+ * @param out  Fitted line.
+ * @return false when fewer than two distinct points are used.
+ */
+static inline bool fit_line_lsq(const vec2* pts, size_t n, const uint8_t* mask, fit_line* out)
+{
+    double mx = 0.0, my = 0.0;
+    size_t m = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (mask && !mask[i]) continue;
+        mx += pts[i].x; my += pts[i].y; m++;
+    }
+    if (m < 2) return false;
+    mx /= (double)m; my /= (double)m;
+
+    double sxx = 0.0, sxy = 0.0, syy = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        if (mask && !mask[i]) continue;
+        const double dx = pts[i].x - mx, dy = pts[i].y - my;
+        sxx += dx * dx; sxy += dx * dy; syy += dy * dy;
+    }
+    if (!(sxx + syy > 0.0)) return false;
+    // Principal axis of the covariance.
+    const double theta = 0.5 * atan2(2.0 * sxy, sxx - syy);
+    out->point = (vec2){ (float)mx, (float)my };
+    out->dir = (vec2){ (float)cos(theta), (float)sin(theta) };
+    return true;
+}
+
+/**
+ * @brief Geometric least-squares circle.
+ *
+ * Starts from the algebraic (Kåsa) fit and refines the sum of squared
+ * distances |p - center| - radius with Gauss-Newton steps.
+ *
+ * @param pts  Points.
+ * @param n    Number of points.
+ * @param mask Optional; only points with mask[i] != 0 are used.
+ * @param out  Fitted circle.
+ * @return false when fewer than three points are used or they are collinear.
+ */
+static inline bool fit_circle_lsq(const vec2* pts, size_t n, const uint8_t* mask, fit_circle* out)
+{
+    double mx = 0.0, my = 0.0;
+    size_t m = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (mask && !mask[i]) continue;
+        mx += pts[i].x; my += pts[i].y; m++;
+    }
+    if (m < 3) return false;
+    mx /= (double)m; my /= (double)m;
+
+    // Kåsa: u^2 + v^2 + D u + E v + F = 0 in coordinates centered at the mean.
+    double a[3][3] = { { 0 } }, b[3] = { 0 }, x[3];
+    for (size_t i = 0; i < n; ++i) {
+        if (mask && !mask[i]) continue;
+        const double u = pts[i].x - mx, v = pts[i].y - my, z = u * u + v * v;
+        a[0][0] += u * u; a[0][1] += u * v; a[1][1] += v * v;
+        b[0] -= u * z; b[1] -= v * z; b[2] -= z;
+    }
+    a[1][0] = a[0][1];
+    a[2][2] = (double)m;
+    if (!fit_solve3(a, b, x)) return false;
+    double cx = -0.5 * x[0], cy = -0.5 * x[1];
+    double r2 = cx * cx + cy * cy - x[2];
+    if (!(r2 > 0.0)) return false;
+    double r = sqrt(r2);
+
+    for (int it = 0; it < FIT_CIRCLE_GN_ITERS; ++it) {
+        double jtj[3][3] = { { 0 } }, jtr[3] = { 0 }, step[3];
+        for (size_t i = 0; i < n; ++i) {
+            if (mask && !mask[i]) continue;
+            const double dx = pts[i].x - mx - cx, dy = pts[i].y - my - cy;
+            const double d = sqrt(dx * dx + dy * dy);
+            if (d == 0.0) continue;
+            const double j[3] = { -dx / d, -dy / d, -1.0 }, res = d - r;
+            for (int p = 0; p < 3; ++p) {
+                jtr[p] -= j[p] * res;
+                for (int q = 0; q < 3; ++q) jtj[p][q] += j[p] * j[q];
+            }
+        }
+        if (!fit_solve3(jtj, jtr, step)) break;
+        cx += step[0]; cy += step[1]; r += step[2];
+        if (fabs(step[0]) + fabs(step[1]) + fabs(step[2]) <= 1e-9 * (fabs(r) + 1.0)) break;
+    }
+    if (!(r > 0.0) || !isfinite(r)) return false;
+    out->center = (vec2){ (float)(cx + mx), (float)(cy + my) };
+    out->radius = (float)r;
+    return true;
+}
+
+// ------------------------------ RANSAC ---------------------------------------
+
+typedef enum { FIT_MODEL_LINE, FIT_MODEL_CIRCLE } fit_model_kind;
+
+// Line: { d.x, d.y, c = cross(d, a) }; circle: { center.x, center.y, radius }.
+typedef struct {
+    float h[3];
+    bool  valid;
+} fit_hypothesis;
+
+// Inliers of one model over points [begin, end); writes mask and the truncated
+// squared residual sum (sum of min(d^2, t^2)) when non-NULL.
+static inline size_t fit_count_inliers(fit_model_kind kind, const float h[3],
+                                       const float* xs, const float* ys,
+                                       size_t begin, size_t end, float t, uint8_t* mask,
+                                       double* cost)
+{
+    size_t count = 0;
+    double sum = 0.0;
+    for (size_t b = begin; b < end; b += FIT_LANES) {
+        const size_t cnt = end - b < FIT_LANES ? end - b : FIT_LANES;
+        float d[FIT_LANES];
+        for (size_t l = 0; l < FIT_LANES; ++l) {
+            const size_t i = b + (l < cnt ? l : 0);
+            if (kind == FIT_MODEL_LINE) {
+                d[l] = fabsf(h[0] * ys[i] - h[1] * xs[i] - h[2]);
+            } else {
+                const float dx = xs[i] - h[0], dy = ys[i] - h[1];
+                d[l] = fabsf(sqrtf(dx * dx + dy * dy) - h[2]);
+            }
+        }
+        for (size_t l = 0; l < cnt; ++l) {
+            const bool in = d[l] <= t;
+            if (mask) mask[b + l] = (uint8_t)in;
+            count += in;
+            sum += in ? d[l] * d[l] : t * t;
+        }
+    }
+    if (cost) *cost = sum;
+    return count;
+}
+
+static inline fit_hypothesis fit_make_hypothesis(fit_model_kind kind, const vec2* pts, size_t n, rng* rg)
+{
+    fit_hypothesis hy = { { 0.0f, 0.0f, 0.0f }, false };
+    const uint32_t i0 = rng_below(rg, (uint32_t)n);
+    uint32_t i1 = rng_below(rg, (uint32_t)n - 1);
+    if (i1 >= i0) i1++;
+    vec2 a = pts[i0], b = pts[i1];
+
+    if (kind == FIT_MODEL_LINE) {
+        vec2 ab = vec2_sub(&b, &a);
+        if (!(vec2_length2(&ab) > 0.0f)) return hy;
+        vec2 d = vec2_normalize(&ab);
+        hy.h[0] = d.x; hy.h[1] = d.y; hy.h[2] = vec2_cross(&d, &a);
+        hy.valid = true;
+        return hy;
+    }
+
+    if (n < 3) return hy;
+    uint32_t i2 = rng_below(rg, (uint32_t)n - 2);
+    const uint32_t lo = i0 < i1 ? i0 : i1, hi = i0 < i1 ? i1 : i0;
+    if (i2 >= lo) i2++;
+    if (i2 >= hi) i2++;
+    vec2 c = pts[i2];
+    // Circumcircle, relative to a.
+    vec2 ab = vec2_sub(&b, &a), ac = vec2_sub(&c, &a);
+    const float den = 2.0f * vec2_cross(&ab, &ac);
+    const float lab = vec2_length2(&ab), lac = vec2_length2(&ac);
+    if (!(fabsf(den) > 1e-6f * (lab + lac))) return hy; // (near) collinear
+    const float ux = (ac.y * lab - ab.y * lac) / den;
+    const float uy = (ab.x * lac - ac.x * lab) / den;
+    hy.h[0] = a.x + ux; hy.h[1] = a.y + uy; hy.h[2] = sqrtf(ux * ux + uy * uy);
+    hy.valid = isfinite(hy.h[2]) != 0;
+    return hy;
+}
+
+typedef struct {
+    fit_model_kind        kind;
+    const float*          xs;
+    const float*          ys;
+    size_t                n;
+    float                 t;
+    size_t                best_prev; // best count of earlier batches
+    const fit_hypothesis* hyps;
+    size_t*               counts;    // per hypothesis, SIZE_MAX when abandoned/invalid
+    uint64_t              tests[PARALLEL_MAX_WORKERS];
+} fit_score_job;
+
+static inline void fit_score_range(void* user, size_t begin, size_t end, int worker)
+{
+    fit_score_job* j = (fit_score_job*)user;
+    for (size_t k = begin; k < end; ++k) {
+        j->counts[k] = SIZE_MAX;
+        if (!j->hyps[k].valid) continue;
+        size_t count = 0, p = 0;
+        bool abandoned = false;
+        while (p < j->n) {
+            const size_t e = j->n - p < FIT_BLOCK ? j->n : p + FIT_BLOCK;
+            count += fit_count_inliers(j->kind, j->hyps[k].h, j->xs, j->ys, p, e, j->t, NULL, NULL);
+            p = e;
+            // Ties go to the earlier hypothesis, so matching best_prev is not enough.
+            if (p < j->n && j->best_prev > 0 && count + (j->n - p) <= j->best_prev) {
+                abandoned = true;
+                break;
+            }
+        }
+        j->tests[worker] += p;
+        if (!abandoned) j->counts[k] = count;
+    }
+}
+
+static inline bool fit_ransac(fit_model_kind kind, const vec2* pts, size_t n, const ransac_params* prm,
+                              float out[3], uint8_t* inliers, ransac_stats* st)
+{
+    const size_t min_sample = kind == FIT_MODEL_LINE ? 2 : 3;
+    ransac_stats s = { 0, 0, 0, 0 };
+    if (st) *st = s;
+    if (n < min_sample || n >= UINT32_MAX || !(prm->threshold >= 0.0f)) return false;
+
+    float* xs = (float*)malloc(n * sizeof(float));
+    float* ys = (float*)malloc(n * sizeof(float));
+    uint8_t* mask = (uint8_t*)malloc(n);
+    if (!xs || !ys || !mask) { free(xs); free(ys); free(mask); return false; }
+    for (size_t i = 0; i < n; ++i) { xs[i] = pts[i].x; ys[i] = pts[i].y; }
+
+    rng rg;
+    rng_seed(&rg, prm->seed, 0x7A11u);
+    fit_hypothesis hyps[FIT_RANSAC_BATCH], best = { { 0.0f, 0.0f, 0.0f }, false };
+    size_t counts[FIT_RANSAC_BATCH];
+    fit_score_job job;
+    memset(&job, 0, sizeof(job));
+    job.kind = kind; job.xs = xs; job.ys = ys; job.n = n; job.t = prm->threshold;
+    job.hyps = hyps; job.counts = counts;
+
+    const int cap = prm->max_hypotheses > 0 ? prm->max_hypotheses : 1000;
+    const double conf = prm->confidence > 0.0f && prm->confidence < 1.0f ? prm->confidence : 0.99;
+    double needed = (double)cap;
+    while ((double)s.hypotheses < needed && s.hypotheses < cap) {
+        int batch = cap - s.hypotheses;
+        if (batch > FIT_RANSAC_BATCH) batch = FIT_RANSAC_BATCH;
+        for (int k = 0; k < batch; ++k) hyps[k] = fit_make_hypothesis(kind, pts, n, &rg);
+
+        // Small problems stay on one worker; each chunk is at least ~64k residuals.
+        size_t grain = 65536 / n;
+        if (grain < 1) grain = 1;
+        parallel_for((size_t)batch, grain, fit_score_range, &job);
+
+        for (int k = 0; k < batch; ++k) {
+            if (counts[k] == SIZE_MAX) { s.abandoned += hyps[k].valid; continue; }
+            if (counts[k] > job.best_prev) { job.best_prev = counts[k]; best = hyps[k]; }
+        }
+        s.hypotheses += batch;
+
+        if (job.best_prev > 0) {
+            const double w = (double)job.best_prev / (double)n;
+            const double p_all = pow(w, (double)min_sample);
+            needed = p_all >= 1.0 ? 0.0 : p_all <= 0.0 ? (double)cap
+                   : ceil(log(1.0 - conf) / log1p(-p_all));
+        }
+    }
+    for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) s.point_tests += job.tests[w];
+
+    bool ok = best.valid;
+    if (ok) {
+        // Least-squares refinement on the inliers, kept while it lowers the
+        // truncated squared error (the count alone would reject a better fit
+        // that happens to lose one borderline point).
+        float h[3] = { best.h[0], best.h[1], best.h[2] };
+        double cost;
+        size_t count = fit_count_inliers(kind, h, xs, ys, 0, n, prm->threshold, mask, &cost);
+        for (int it = 0; it < FIT_REFINE_ITERS; ++it) {
+            float r[3];
+            if (kind == FIT_MODEL_LINE) {
+                fit_line l;
+                if (!fit_line_lsq(pts, n, mask, &l)) break;
+                r[0] = l.dir.x; r[1] = l.dir.y; r[2] = vec2_cross(&l.dir, &l.point);
+            } else {
+                fit_circle c;
+                if (!fit_circle_lsq(pts, n, mask, &c)) break;
+                r[0] = c.center.x; r[1] = c.center.y; r[2] = c.radius;
+            }
+            double rcost;
+            fit_count_inliers(kind, r, xs, ys, 0, n, prm->threshold, NULL, &rcost);
+            s.point_tests += n;
+            if (!(rcost < cost)) break;
+            memcpy(h, r, sizeof(h));
+            count = fit_count_inliers(kind, h, xs, ys, 0, n, prm->threshold, mask, &cost);
+            s.point_tests += n;
+        }
+        memcpy(out, h, sizeof(h));
+        s.inliers = count;
+        if (inliers) memcpy(inliers, mask, n);
+    }
+    if (st) *st = s;
+    free(xs); free(ys); free(mask);
+    return ok;
+}
+
+/**
+ * @brief Robust line fit: RANSAC over point pairs, then least-squares refinement.
+ *
+ * @param pts     Points.
+ * @param n       Number of points (>= 2).
+ * @param prm     Threshold, confidence, hypothesis cap and seed.
+ * @param out     Fitted line.
+ * @param inliers Optional output mask of n bytes (1 = inlier).
+ * @param st      Optional statistics.
+ * @return false when no valid hypothesis was found or allocation failed.
+ */
+static inline bool ransac_line(const vec2* pts, size_t n, const ransac_params* prm,
+                               fit_line* out, uint8_t* inliers, ransac_stats* st)
+{
+    float h[3];
+    if (!fit_ransac(FIT_MODEL_LINE, pts, n, prm, h, inliers, st)) return false;
+    out->dir = (vec2){ h[0], h[1] };
+    // Foot of the perpendicular from the origin: cross(d, p) == c.
+    out->point = (vec2){ -h[1] * h[2], h[0] * h[2] };
+    return true;
+}
+
+/**
+ * @brief Robust circle fit: RANSAC over point triples, then least-squares refinement.
+ *
+ * @param pts     Points.
+ * @param n       Number of points (>= 3).
+ * @param prm     Threshold, confidence, hypothesis cap and seed.
+ * @param out     Fitted circle.
+ * @param inliers Optional output mask of n bytes (1 = inlier).
+ * @param st      Optional statistics.
+ * @return false when no valid hypothesis was found or allocation failed.
+ */
+static inline bool ransac_circle(const vec2* pts, size_t n, const ransac_params* prm,
+                                 fit_circle* out, uint8_t* inliers, ransac_stats* st)
+{
+    float h[3];
+    if (!fit_ransac(FIT_MODEL_CIRCLE, pts, n, prm, h, inliers, st)) return false;
+    out->center = (vec2){ h[0], h[1] };
+    out->radius = h[2];
+    return true;
+}
+
+#endif // FIT_H
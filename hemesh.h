@@ -0,0 +1,348 @@
+﻿//
+// hemesh.h — half-edge mesh over vec2 vertices with 32-bit indices.
+//
+// Every element is an index into flat SoA arrays (vertex positions and one
+// outgoing half-edge per vertex; origin, twin, next and face per half-edge; one
+// half-edge per face), grown geometrically, so adding or editing an element
+// never allocates on its own. Faces are counter-clockwise; a half-edge with no
+// twin (HE_NONE) lies on the boundary. A boundary vertex keeps a boundary
+// half-edge as its outgoing one, so a counter-clockwise walk around it
+// (hemesh_rotate) starts at the boundary and ends at HE_NONE.
+//
+// Triangle meshes are built in bulk on all workers: half-edges of triangle t
+// are 3t .. 3t + 2, and twins are found by scanning the outgoing half-edges of
+// the destination vertex (a CSR table built once). Edge flips and splits keep
+// all indices of untouched elements stable.
+//
+
+#ifndef HEMESH_H
+#define HEMESH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+
+#define HE_NONE UINT32_MAX
+
+typedef struct {
+    vec2*     verts;
+    uint32_t* vert_he;   // an outgoing half-edge (a boundary one if any), or HE_NONE
+    uint32_t  vert_count, vert_cap;
+
+    uint32_t* he_vert;   // origin
+    uint32_t* he_twin;
+    uint32_t* he_next;   // next half-edge counter-clockwise around the face
+    uint32_t* he_face;
+    uint32_t  he_count, he_cap;
+
+    uint32_t* face_he;
+    uint32_t  face_count, face_cap;
+} hemesh;
+
+static inline void hemesh_init(hemesh* m)
+{
+    memset(m, 0, sizeof(*m));
+}
+
+static inline void hemesh_free(hemesh* m)
+{
+    free(m->verts); free(m->vert_he);
+    free(m->he_vert); free(m->he_twin); free(m->he_next); free(m->he_face);
+    free(m->face_he);
+    memset(m, 0, sizeof(*m));
+}
+
+// Grows a uint32 array to cap entries; keeps it on failure.
+static inline bool hemesh_grow_u32(uint32_t** a, size_t cap)
+{
+    uint32_t* grown = (uint32_t*)realloc(*a, cap * sizeof(uint32_t));
+    if (!grown) return false;
+    *a = grown;
+    return true;
+}
+
+static inline size_t hemesh_next_cap(size_t cap, size_t need)
+{
+    cap = cap ? cap : 64;
+    while (cap < need) cap *= 2;
+    return cap;
+}
+
+/**
+ * @brief Make room for at least the given element counts.
+ *
+ * @return false on allocation failure or counts of 2^32 - 1 and above.
+ */
+static inline bool hemesh_reserve(hemesh* m, size_t verts, size_t half_edges, size_t faces)
+{
+    if (verts >= HE_NONE || half_edges >= HE_NONE || faces >= HE_NONE) return false;
+    if (verts > m->vert_cap) {
+        const size_t cap = hemesh_next_cap(m->vert_cap, verts);
+        vec2* v = (vec2*)realloc(m->verts, cap * sizeof(vec2));
+        if (v) m->verts = v;
+        if (!v || !hemesh_grow_u32(&m->vert_he, cap)) return false;
+        m->vert_cap = (uint32_t)(cap < HE_NONE ? cap : HE_NONE - 1);
+    }
+    if (half_edges > m->he_cap) {
+        const size_t cap = hemesh_next_cap(m->he_cap, half_edges);
+        if (!hemesh_grow_u32(&m->he_vert, cap) || !hemesh_grow_u32(&m->he_twin, cap)
+            || !hemesh_grow_u32(&m->he_next, cap) || !hemesh_grow_u32(&m->he_face, cap)) return false;
+        m->he_cap = (uint32_t)(cap < HE_NONE ? cap : HE_NONE - 1);
+    }
+    if (faces > m->face_cap) {
+        const size_t cap = hemesh_next_cap(m->face_cap, faces);
+        if (!hemesh_grow_u32(&m->face_he, cap)) return false;
+        m->face_cap = (uint32_t)(cap < HE_NONE ? cap : HE_NONE - 1);
+    }
+    return true;
+}
+
+// ------------------------------ Traversal ------------------------------------
+
+static inline uint32_t hemesh_dest(const hemesh* m, uint32_t h)
+{
+    return m->he_vert[m->he_next[h]];
+}
+
+/**
+ * @brief Previous half-edge around the face (two steps for a triangle).
+ */
+static inline uint32_t hemesh_prev(const hemesh* m, uint32_t h)
+{
+    uint32_t p = h;
+    while (m->he_next[p] != h) p = m->he_next[p];
+    return p;
+}
+
+/**
+ * @brief Next outgoing half-edge counter-clockwise around the origin of h,
+ *        or HE_NONE past the boundary.
+ */
+static inline uint32_t hemesh_rotate(const hemesh* m, uint32_t h)
+{
+    return m->he_twin[hemesh_prev(m, h)];
+}
+
+/**
+ * @brief Vertices of triangle f, counter-clockwise.
+ */
+static inline void hemesh_tri(const hemesh* m, uint32_t f, uint32_t v[3])
+{
+    const uint32_t h = m->face_he[f];
+    v[0] = m->he_vert[h];
+    v[1] = m->he_vert[m->he_next[h]];
+    v[2] = m->he_vert[m->he_next[m->he_next[h]]];
+}
+
+/**
+ * @brief Append an isolated vertex.
+ *
+ * @return Its index, or HE_NONE on allocation failure.
+ */
+static inline uint32_t hemesh_add_vertex(hemesh* m, vec2 p)
+{
+    if (!hemesh_reserve(m, (size_t)m->vert_count + 1, 0, 0)) return HE_NONE;
+    m->verts[m->vert_count] = p;
+    m->vert_he[m->vert_count] = HE_NONE;
+    return m->vert_count++;
+}
+
+// ------------------------------ Bulk build -----------------------------------
+
+typedef struct {
+    hemesh*         m;
+    const uint32_t* tris;
+    const uint32_t* out_start;  // CSR of outgoing half-edges per vertex
+    const uint32_t* out;
+    bool            failed[PARALLEL_MAX_WORKERS];
+} hemesh_build_job;
+
+static inline void hemesh_build_faces(void* user, size_t begin, size_t end, int worker)
+{
+    hemesh_build_job* j = (hemesh_build_job*)user;
+    hemesh* m = j->m;
+    for (size_t t = begin; t < end; ++t) {
+        const uint32_t* v = j->tris + 3 * t;
+        if (v[0] >= m->vert_count || v[1] >= m->vert_count || v[2] >= m->vert_count
+            || v[0] == v[1] || v[1] == v[2] || v[2] == v[0]) j->failed[worker] = true;
+        for (uint32_t k = 0; k < 3; ++k) {
+            const uint32_t h = (uint32_t)(3 * t + k);
+            m->he_vert[h] = v[k];
+            m->he_next[h] = (uint32_t)(3 * t + (k + 1) % 3);
+            m->he_face[h] = (uint32_t)t;
+        }
+        m->face_he[t] = (uint32_t)(3 * t);
+    }
+}
+
+static inline void hemesh_build_twins(void* user, size_t begin, size_t end, int worker)
+{
+    hemesh_build_job* j = (hemesh_build_job*)user;
+    hemesh* m = j->m;
+    for (size_t h = begin; h < end; ++h) {
+        const uint32_t a = m->he_vert[h], b = hemesh_dest(m, (uint32_t)h);
+        uint32_t twin = HE_NONE, matches = 0;
+        for (uint32_t i = j->out_start[b]; i < j->out_start[b + 1]; ++i)
+            if (hemesh_dest(m, j->out[i]) == a) { twin = j->out[i]; matches++; }
+        // Same-direction duplicates mean inconsistent winding or a non-manifold edge.
+        for (uint32_t i = j->out_start[a]; i < j->out_start[a + 1]; ++i)
+            if (j->out[i] != h && hemesh_dest(m, j->out[i]) == b) matches = 2;
+        if (matches > 1) j->failed[worker] = true;
+        m->he_twin[h] = twin;
+    }
+}
+
+static inline void hemesh_build_verts(void* user, size_t begin, size_t end, int worker)
+{
+    (void)worker;
+    hemesh_build_job* j = (hemesh_build_job*)user;
+    hemesh* m = j->m;
+    for (size_t v = begin; v < end; ++v) {
+        uint32_t pick = HE_NONE;
+        for (uint32_t i = j->out_start[v]; i < j->out_start[v + 1]; ++i) {
+            pick = j->out[i];
+            if (m->he_twin[pick] == HE_NONE) break;
+        }
+        m->vert_he[v] = pick;
+    }
+}
+
+/**
+ * @brief Replace the mesh with a triangle mesh, built on all workers.
+ *
+ * @param m         Mesh (hemesh_init).
+ * @param verts     Vertex positions (copied).
+ * @param vert_count Number of vertices.
+ * @param tris      3 vertex indices per triangle, counter-clockwise.
+ * @param tri_count Number of triangles (< 2^32 / 3).
+ * @return false on allocation failure, bad indices, or edges used by more than
+ *         two triangles or twice in the same direction; the mesh is then
+ *         partially built and must be rebuilt or freed.
+ */
+static inline bool hemesh_build(hemesh* m, const vec2* verts, size_t vert_count,
+                                const uint32_t* tris, size_t tri_count)
+{
+    if (tri_count >= HE_NONE / 3 || !hemesh_reserve(m, vert_count, 3 * tri_count, tri_count)) return false;
+    const size_t halves = 3 * tri_count;
+    memcpy(m->verts, verts, vert_count * sizeof(vec2));
+    m->vert_count = (uint32_t)vert_count;
+    m->he_count = (uint32_t)halves;
+    m->face_count = (uint32_t)tri_count;
+
+    hemesh_build_job j;
+    memset(&j, 0, sizeof(j));
+    j.m = m;
+    j.tris = tris;
+    parallel_for(tri_count, 1024, hemesh_build_faces, &j);
+    bool ok = true;
+    for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) ok = ok && !j.failed[w];
+    if (!ok) return false;
+
+    uint32_t* out_start = (uint32_t*)calloc(vert_count + 1, sizeof(uint32_t));
+    uint32_t* out = (uint32_t*)malloc((halves ? halves : 1) * sizeof(uint32_t));
+    if (!out_start || !out) { free(out_start); free(out); return false; }
+    for (size_t h = 0; h < halves; ++h) out_start[m->he_vert[h] + 1]++;
+    for (size_t v = 0; v < vert_count; ++v) out_start[v + 1] += out_start[v];
+    for (size_t h = 0; h < halves; ++h) out[out_start[m->he_vert[h]]++] = (uint32_t)h;
+    for (size_t v = vert_count; v > 0; --v) out_start[v] = out_start[v - 1]; // undo the fill shift
+    out_start[0] = 0;
+
+    j.out_start = out_start;
+    j.out = out;
+    parallel_for(halves, 4096, hemesh_build_twins, &j);
+    parallel_for(vert_count, 4096, hemesh_build_verts, &j);
+    free(out_start);
+    free(out);
+    for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) ok = ok && !j.failed[w];
+    return ok;
+}
+
+// ------------------------------ Editing --------------------------------------
+
+/**
+ * @brief Flip the diagonal shared by two triangles.
+ *
+ * Triangles (a, b, c) and (b, a, d) around h = a -> b become (d, c, a) and
+ * (c, d, b); h and its twin become d -> c and c -> d, faces keep their indices.
+ *
+ * @return false (mesh unchanged) on a boundary edge or a non-convex quad.
+ */
+static inline bool hemesh_flip(hemesh* m, uint32_t h)
+{
+    const uint32_t t = m->he_twin[h];
+    if (t == HE_NONE) return false;
+    const uint32_t h1 = m->he_next[h], h2 = m->he_next[h1];
+    const uint32_t t1 = m->he_next[t], t2 = m->he_next[t1];
+    const uint32_t a = m->he_vert[h], b = m->he_vert[t], c = m->he_vert[h2], d = m->he_vert[t2];
+    vec2 pa = m->verts[a], pb = m->verts[b], pc = m->verts[c], pd = m->verts[d];
+    // Convex iff a and b lie on opposite sides of the new diagonal d -> c.
+    vec2 dc = vec2_sub(&pc, &pd), da = vec2_sub(&pa, &pd), db = vec2_sub(&pb, &pd);
+    if (!(vec2_cross(&dc, &da) > 0.0f && vec2_cross(&dc, &db) < 0.0f)) return false;
+
+    const uint32_t f0 = m->he_face[h], f1 = m->he_face[t];
+    m->he_vert[h] = d; m->he_vert[t] = c;
+    m->he_next[h] = h2; m->he_next[h2] = t1; m->he_next[t1] = h;
+    m->he_next[t] = t2; m->he_next[t2] = h1; m->he_next[h1] = t;
+    m->he_face[t1] = f0; m->he_face[h1] = f1;
+    m->face_he[f0] = h;
+    m->face_he[f1] = t;
+    if (m->vert_he[a] == h) m->vert_he[a] = t1;
+    if (m->vert_he[b] == t) m->vert_he[b] = h1;
+    return true;
+}
+
+// Splits triangle (h: a -> v after the split) into (a, v, c) and (v, b, c);
+// returns the new half-edge v -> b. Needs two new half-edges plus e (v -> b).
+static inline uint32_t hemesh_split_face(hemesh* m, uint32_t h, uint32_t v)
+{
+    const uint32_t h1 = m->he_next[h], h2 = m->he_next[h1];
+    const uint32_t c = m->he_vert[h2];
+    const uint32_t f0 = m->he_face[h], f2 = m->face_count++;
+    const uint32_t e0 = m->he_count, e1 = e0 + 1, e2 = e0 + 2; // v -> c, v -> b, c -> v
+    m->he_count += 3;
+    m->he_vert[e0] = v; m->he_vert[e1] = v; m->he_vert[e2] = c;
+    m->he_twin[e0] = e2; m->he_twin[e2] = e0; m->he_twin[e1] = HE_NONE;
+    m->he_next[h] = e0; m->he_next[e0] = h2;                     // (a, v, c)
+    m->he_next[e1] = h1; m->he_next[h1] = e2; m->he_next[e2] = e1; // (v, b, c)
+    m->he_face[e0] = f0;
+    m->he_face[e1] = m->he_face[h1] = m->he_face[e2] = f2;
+    m->face_he[f0] = h;
+    m->face_he[f2] = e1;
+    return e1;
+}
+
+/**
+ * @brief Insert a vertex on edge h, splitting the one or two adjacent triangles.
+ *
+ * h and its twin keep their origins and now end at the new vertex; the new
+ * faces and half-edges are appended.
+ *
+ * @param m Mesh of triangles.
+ * @param h Edge to split.
+ * @param p Position of the new vertex (normally on the edge).
+ * @return New vertex index, or HE_NONE on allocation failure.
+ */
+static inline uint32_t hemesh_split(hemesh* m, uint32_t h, vec2 p)
+{
+    if (!hemesh_reserve(m, (size_t)m->vert_count + 1, (size_t)m->he_count + 6, (size_t)m->face_count + 2))
+        return HE_NONE;
+    const uint32_t t = m->he_twin[h];
+    const uint32_t v = m->vert_count++;
+    m->verts[v] = p;
+    const uint32_t vb = hemesh_split_face(m, h, v); // v -> b
+    if (t == HE_NONE) {
+        m->vert_he[v] = vb; // boundary outgoing
+        return v;
+    }
+    const uint32_t va = hemesh_split_face(m, t, v); // v -> a
+    m->he_twin[h] = va; m->he_twin[va] = h;
+    m->he_twin[t] = vb; m->he_twin[vb] = t;
+    m->vert_he[v] = vb;
+    return v;
+}
+
+#endif // HEMESH_H
@@ -0,0 +1,275 @@
+﻿//
+// icp.h — 2D iterative closest point registration.
+//
+// Aligns a source scan to a target scan: each iteration transforms the source
+// by the current estimate, finds every point's nearest target point through a
+// k-d tree (in parallel over source points), and solves for the increment in
+// closed form:
+//
+//   point-to-point  Procrustes: the rotation angle is atan2 of the summed
+//                   cross and dot products of the centered pairs, the
+//                   translation maps one centroid onto the other;
+//   point-to-line   residuals are measured along the target normals and the
+//                   small-angle linearization gives a 3x3 normal system.
+//
+// Correspondences are stored per source index and reduced serially, so the
+// result does not depend on the worker count.
+//
+
+#ifndef ICP_H
+#define ICP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+#include "kdtree.h"
+#include "fit.h"
+#include "timer.h"
+
+#define ICP_GRAIN         1024
+#define ICP_NORMAL_K      5    // neighbors used to estimate target normals
+
+typedef enum { ICP_POINT_TO_POINT, ICP_POINT_TO_LINE } icp_metric;
+
+typedef struct {
+    icp_metric metric;
+    int        max_iter;
+    float      max_dist;    // ignore pairs farther apart than this (<= 0: no limit)
+    float      tolerance;   // stop when an increment moves no point more than this
+} icp_params;
+
+typedef struct {
+    float  rms;           // residual RMS over matched pairs before the update
+    size_t matched;       // pairs used
+    float  step;          // bound on how far the increment moved any point
+    double corr_ms;       // correspondence search time
+    double solve_ms;      // reduction + closed-form solve time
+} icp_iter_stats;
+
+typedef struct {
+    int   iterations;
+    bool  converged;      // stopped on tolerance rather than max_iter
+    float rms;            // final residual RMS
+    double total_ms;
+} icp_result;
+
+typedef struct {
+    const vec2* pts;
+    vec2*       normals;  // NULL unless built for point-to-line
+    kdtree      tree;
+} icp_target;
+
+// ------------------------------ Target ---------------------------------------
+
+typedef struct {
+    icp_target* t;
+    size_t      n;
+} icp_normal_job;
+
+static inline void icp_normal_range(void* user, size_t begin, size_t end, int worker)
+{
+    (void)worker;
+    icp_normal_job* j = (icp_normal_job*)user;
+    uint32_t nb[ICP_NORMAL_K];
+    for (size_t i = begin; i < end; ++i) {
+        const int k = kdtree_knn(&j->t->tree, j->t->pts[i], ICP_NORMAL_K, nb, NULL);
+        fit_line l;
+        // Normal of the local total least-squares line through the neighbors.
+        vec2 local[ICP_NORMAL_K];
+        for (int m = 0; m < k; ++m) local[m] = j->t->pts[nb[m]];
+        if (fit_line_lsq(local, (size_t)k, NULL, &l)) j->t->normals[i] = vec2_rot90_ccw(&l.dir);
+        else j->t->normals[i] = (vec2){ 0.0f, 0.0f }; // isolated point: pairs get no weight
+    }
+}
+
+/**
+ * @brief Prepare a target scan: k-d tree, plus normals for point-to-line.
+ *
+ * @param t       Target to build (free with icp_target_free).
+ * @param pts     Target points (must outlive the target).
+ * @param n       Number of points.
+ * @param normals Estimate normals from the ICP_NORMAL_K nearest neighbors.
+ * @return false on invalid input or allocation failure.
+ */
+static inline bool icp_target_build(icp_target* t, const vec2* pts, size_t n, bool normals)
+{
+    memset(t, 0, sizeof(*t));
+    t->pts = pts;
+    if (n == 0 || !kdtree_build(&t->tree, pts, n)) return false;
+    if (normals) {
+        t->normals = (vec2*)malloc(n * sizeof(vec2));
+        if (!t->normals) { kdtree_free(&t->tree); return false; }
+        icp_normal_job job = { t, n };
+        parallel_for(n, ICP_GRAIN, icp_normal_range, &job);
+    }
+    return true;
+}
+
+static inline void icp_target_free(icp_target* t)
+{
+    kdtree_free(&t->tree);
+    free(t->normals);
+    memset(t, 0, sizeof(*t));
+}
+
+// ------------------------------ Iteration ------------------------------------
+
+typedef struct {
+    const icp_target* tgt;
+    const vec2*       src;
+    rot2              r;
+    vec2              t;
+    float             max_d2;
+    vec2*             moved;  // transformed source points
+    uint32_t*         match;  // target index or UINT32_MAX
+} icp_corr_job;
+
+static inline void icp_corr_range(void* user, size_t begin, size_t end, int worker)
+{
+    (void)worker;
+    icp_corr_job* j = (icp_corr_job*)user;
+    for (size_t i = begin; i < end; ++i) {
+        vec2 p = rot2_apply(&j->r, &j->src[i]);
+        p = vec2_add(&p, &j->t);
+        j->moved[i] = p;
+        j->match[i] = kdtree_nearest(&j->tgt->tree, p, j->max_d2, NULL);
+    }
+}
+
+// Closed-form increment (dr, dt) mapping moved[i] onto its matches.
+static inline bool icp_solve(const icp_target* tgt, icp_metric metric, const vec2* moved,
+                             const uint32_t* match, size_t n, rot2* dr, vec2* dt,
+                             size_t* matched, float* rms)
+{
+    double sum_sq = 0.0;
+    size_t m = 0;
+
+    if (metric == ICP_POINT_TO_POINT) {
+        double spx = 0.0, spy = 0.0, sqx = 0.0, sqy = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            if (match[i] == UINT32_MAX) continue;
+            const vec2 q = tgt->pts[match[i]];
+            spx += moved[i].x; spy += moved[i].y; sqx += q.x; sqy += q.y;
+            m++;
+        }
+        *matched = m;
+        if (m < 2) return false;
+        vec2 cp = { (float)(spx / m), (float)(spy / m) };
+        vec2 cq = { (float)(sqx / m), (float)(sqy / m) };
+        double sdot = 0.0, scross = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            if (match[i] == UINT32_MAX) continue;
+            vec2 q = tgt->pts[match[i]], p = moved[i];
+            vec2 a = vec2_sub(&p, &cp), b = vec2_sub(&q, &cq);
+            sdot += vec2_dot(&a, &b);
+            scross += vec2_cross(&a, &b);
+            sum_sq += vec2_dist2(&p, &q);
+        }
+        const double len = sqrt(sdot * sdot + scross * scross);
+        *dr = len > 0.0 ? (rot2){ (float)(sdot / len), (float)(scross / len) } : (rot2){ 1.0f, 0.0f };
+        const vec2 rcp = rot2_apply(dr, &cp);
+        *dt = (vec2){ cq.x - rcp.x, cq.y - rcp.y };
+    } else {
+        // Minimize sum ((R p + t - q) . n)^2 with R ~ I + theta * perp:
+        // d/dtheta (R p . n) = cross(p, n).
+        double a[3][3] = { { 0 } }, b[3] = { 0 }, x[3];
+        for (size_t i = 0; i < n; ++i) {
+            if (match[i] == UINT32_MAX) continue;
+            vec2 nrm = tgt->normals[match[i]];
+            if (nrm.x == 0.0f && nrm.y == 0.0f) continue;
+            vec2 p = moved[i], q = tgt->pts[match[i]];
+            vec2 d = vec2_sub(&p, &q);
+            const double res = vec2_dot(&d, &nrm);
+            const double jac[3] = { vec2_cross(&p, &nrm), nrm.x, nrm.y };
+            for (int r = 0; r < 3; ++r) {
+                b[r] -= jac[r] * res;
+                for (int c = 0; c < 3; ++c) a[r][c] += jac[r] * jac[c];
+            }
+            sum_sq += res * res;
+            m++;
+        }
+        *matched = m;
+        if (m < 3 || !fit_solve3(a, b, x)) return false;
+        *dr = rot2_from_angle((float)x[0]);
+        *dt = (vec2){ (float)x[1], (float)x[2] };
+    }
+    *rms = (float)sqrt(sum_sq / (double)m);
+    return true;
+}
+
+/**
+ * @brief Align src to a target: find r, t such that r * src + t ~ target.
+ *
+ * @param tgt   Target built with icp_target_build (normals required for
+ *              ICP_POINT_TO_LINE).
+ * @param src   Source points.
+ * @param n     Number of source points.
+ * @param prm   Metric, iteration cap, pair rejection distance and tolerance.
+ * @param r     In: initial rotation guess. Out: estimated rotation.
+ * @param t     In: initial translation guess. Out: estimated translation.
+ * @param iters Optional per-iteration metrics (prm->max_iter entries).
+ * @param res   Optional summary.
+ * @return false on invalid input, allocation failure, or too few pairs.
+ */
+static inline bool icp_align(const icp_target* tgt, const vec2* src, size_t n, const icp_params* prm,
+                             rot2* r, vec2* t, icp_iter_stats* iters, icp_result* res)
+{
+    const double t0 = timer_now_ms();
+    icp_result out = { 0, false, 0.0f, 0.0 };
+    if (res) *res = out;
+    if (n == 0 || (prm->metric == ICP_POINT_TO_LINE && !tgt->normals)) return false;
+
+    vec2* moved = (vec2*)malloc(n * sizeof(vec2));
+    uint32_t* match = (uint32_t*)malloc(n * sizeof(uint32_t));
+    bool ok = moved && match;
+    icp_corr_job job = { tgt, src, *r, *t, prm->max_dist > 0.0f ? prm->max_dist * prm->max_dist : INFINITY,
+                         moved, match };
+
+    for (int it = 0; ok && it < prm->max_iter; ++it) {
+        icp_iter_stats st = { 0.0f, 0, 0.0f, 0.0, 0.0 };
+        const double c0 = timer_now_ms();
+        job.r = *r;
+        job.t = *t;
+        parallel_for(n, ICP_GRAIN, icp_corr_range, &job);
+        const double c1 = timer_now_ms();
+
+        rot2 dr;
+        vec2 dt;
+        ok = icp_solve(tgt, prm->metric, moved, match, n, &dr, &dt, &st.matched, &st.rms);
+        st.corr_ms = c1 - c0;
+        st.solve_ms = timer_now_ms() - c1;
+        if (!ok) break;
+
+        // Compose: new = dr * (r * p + t) + dt.
+        *r = rot2_mul(&dr, r);
+        const vec2 rt = rot2_apply(&dr, t);
+        *t = (vec2){ rt.x + dt.x, rt.y + dt.y };
+        // Renormalize against drift from repeated composition.
+        const float len = sqrtf(r->c * r->c + r->s * r->s);
+        r->c /= len;
+        r->s /= len;
+
+        // |dr * p + dt - p| <= |dt| + |dr - I| * max |p| over the moved points.
+        float max_len2 = 0.0f;
+        for (size_t i = 0; i < n; ++i) max_len2 = fmaxf(max_len2, vec2_length2(&moved[i]));
+        const float rot_err = sqrtf((dr.c - 1.0f) * (dr.c - 1.0f) + dr.s * dr.s);
+        st.step = vec2_length(&dt) + rot_err * sqrtf(max_len2);
+
+        if (iters) iters[it] = st;
+        out.iterations = it + 1;
+        out.rms = st.rms;
+        if (st.step <= prm->tolerance) { out.converged = true; break; }
+    }
+
+    free(moved);
+    free(match);
+    out.total_ms = timer_now_ms() - t0;
+    if (res) *res = out;
+    return ok && out.iterations > 0;
+}
+
+#endif // ICP_H
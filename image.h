@@ -0,0 +1,389 @@
+﻿//
+// image.h — PPM, PNG and Y4M encoders writing into a reusable byte buffer.
+//
+// Encoders append to an image_buf, which keeps its storage between images,
+// and take their temporaries from a caller-owned arena. Once the buffer and
+// the arena have grown to the largest image, encoding allocates nothing.
+//
+// PNG is 8-bit RGB with one zlib stream in a single IDAT chunk. Each row gets
+// the filter (None, Sub or Up) with the smallest sum of absolute residuals;
+// the stream is deflated with greedy LZ77 (one hash probe per position) and
+// the fixed Huffman codes of RFC 1951, so no zlib is needed. Rendered scenes
+// are mostly flat background, where that already compresses well.
+//
+// Y4M (YUV4MPEG2) is uncompressed 4:2:0 video: a stream header, then per
+// frame "FRAME\n" and the Y, U and V planes. Colors are converted with BT.601
+// limited range; chroma is the average of each 2x2 block (C420jpeg siting).
+//
+
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "raster.h"
+
+#define IMAGE_HASH_BITS 15
+
+typedef struct {
+    unsigned char* data;
+    size_t         len;
+    size_t         cap;
+    size_t         grows;  // reallocations, to check the steady state
+} image_buf;
+
+static inline void image_buf_free(image_buf* b)
+{
+    free(b->data);
+    memset(b, 0, sizeof(*b));
+}
+
+/**
+ * @brief Make room for `extra` more bytes.
+ *
+ * @return false on allocation failure (the buffer is unchanged).
+ */
+static inline bool image_buf_reserve(image_buf* b, size_t extra)
+{
+    if (extra <= b->cap - b->len) return true;
+    if (extra > SIZE_MAX / 2 - b->len) return false;
+    size_t cap = b->cap ? b->cap : 4096;
+    while (cap - b->len < extra) cap *= 2;
+    unsigned char* p = (unsigned char*)realloc(b->data, cap);
+    if (!p) return false;
+    b->data = p;
+    b->cap = cap;
+    b->grows++;
+    return true;
+}
+
+static inline bool image_buf_append(image_buf* b, const void* src, size_t n)
+{
+    if (!image_buf_reserve(b, n)) return false;
+    memcpy(b->data + b->len, src, n);
+    b->len += n;
+    return true;
+}
+
+/**
+ * @brief Write the buffer to a file, replacing it.
+ */
+static inline bool image_buf_write_file(const image_buf* b, const char* path)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    const bool ok = fwrite(b->data, 1, b->len, f) == b->len;
+    return fclose(f) == 0 && ok;
+}
+
+// ------------------------------ PPM ------------------------------------------
+
+/**
+ * @brief Append the framebuffer as a binary PPM (P6) image.
+ */
+static inline bool image_encode_ppm(image_buf* out, const framebuffer* fb)
+{
+    char header[48];
+    const int n = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", fb->width, fb->height);
+    if (!image_buf_reserve(out, (size_t)n + (size_t)fb->width * (size_t)fb->height * 3)) return false;
+    image_buf_append(out, header, (size_t)n);
+    unsigned char* dst = out->data + out->len;
+    for (int y = 0; y < fb->height; ++y) {
+        const uint32_t* src = fb->pixels + (size_t)y * fb->stride;
+        for (int x = 0; x < fb->width; ++x) {
+            *dst++ = (unsigned char)(src[x] >> 16);
+            *dst++ = (unsigned char)(src[x] >> 8);
+            *dst++ = (unsigned char)src[x];
+        }
+    }
+    out->len = (size_t)(dst - out->data);
+    return true;
+}
+
+// ------------------------------ Deflate --------------------------------------
+
+typedef struct {
+    image_buf* out;
+    uint64_t   bits;
+    int        count;
+} image_bit_writer;
+
+// Room for the bytes flushed per call is reserved up front by the caller.
+static inline void image_put_bits(image_bit_writer* w, uint32_t value, int n)
+{
+    w->bits |= (uint64_t)value << w->count;
+    w->count += n;
+    while (w->count >= 8) {
+        w->out->data[w->out->len++] = (unsigned char)w->bits;
+        w->bits >>= 8;
+        w->count -= 8;
+    }
+}
+
+// Huffman codes are sent most significant bit first.
+static inline void image_put_code(image_bit_writer* w, uint32_t code, int n)
+{
+    uint32_t rev = 0;
+    for (int i = 0; i < n; ++i) rev |= ((code >> i) & 1u) << (n - 1 - i);
+    image_put_bits(w, rev, n);
+}
+
+static inline void image_put_literal(image_bit_writer* w, int sym)
+{
+    if (sym < 144)      image_put_code(w, 0x30u + (uint32_t)sym, 8);
+    else if (sym < 256) image_put_code(w, 0x190u + (uint32_t)(sym - 144), 9);
+    else if (sym < 280) image_put_code(w, (uint32_t)(sym - 256), 7);
+    else                image_put_code(w, 0xC0u + (uint32_t)(sym - 280), 8);
+}
+
+static inline void image_put_match(image_bit_writer* w, int len, int dist)
+{
+    static const uint16_t len_base[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t len_extra[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t dist_base[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t dist_extra[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    int l = 28;
+    while (len_base[l] > len) l--;
+    image_put_literal(w, 257 + l);
+    image_put_bits(w, (uint32_t)(len - len_base[l]), len_extra[l]);
+    int d = 29;
+    while (dist_base[d] > dist) d--;
+    image_put_code(w, (uint32_t)d, 5);
+    image_put_bits(w, (uint32_t)(dist - dist_base[d]), dist_extra[d]);
+}
+
+static inline uint32_t image_hash4(const unsigned char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return (v * 2654435761u) >> (32 - IMAGE_HASH_BITS);
+}
+
+/**
+ * @brief Append `src` as a zlib stream (one fixed-Huffman deflate block).
+ *
+ * @param scratch Arena for the match table.
+ */
+static inline bool image_zlib_compress(image_buf* out, const unsigned char* src, size_t n, arena* scratch)
+{
+    uint32_t* table = ARENA_ARRAY(scratch, uint32_t, (size_t)1 << IMAGE_HASH_BITS);
+    // Worst case 9 bits per byte, plus header, end of block and checksum.
+    if (!table || !image_buf_reserve(out, n + n / 8 + 16)) return false;
+    const unsigned char zlib_header[2] = { 0x78, 0x01 };
+    image_buf_append(out, zlib_header, 2);
+
+    image_bit_writer w = { out, 0, 0 };
+    image_put_bits(&w, 1, 1); // BFINAL
+    image_put_bits(&w, 1, 2); // BTYPE = fixed Huffman
+    size_t i = 0;
+    while (i < n) {
+        int len = 0;
+        size_t cand = 0;
+        if (i + 4 <= n) {
+            const uint32_t h = image_hash4(src + i);
+            cand = table[h];
+            table[h] = (uint32_t)(i + 1); // 0 marks an empty slot
+            if (cand && i + 1 - cand <= 32768 && memcmp(src + cand - 1, src + i, 4) == 0) {
+                cand--;
+                const size_t max = n - i < 258 ? n - i : 258;
+                len = 4;
+                while ((size_t)len < max && src[cand + (size_t)len] == src[i + (size_t)len]) len++;
+            }
+        }
+        if (!len) {
+            image_put_literal(&w, src[i++]);
+            continue;
+        }
+        image_put_match(&w, len, (int)(i - cand));
+        const size_t end = i + (size_t)len;
+        for (++i; i < end && i + 4 <= n; ++i) table[image_hash4(src + i)] = (uint32_t)(i + 1);
+        i = end;
+    }
+    image_put_literal(&w, 256);
+    if (w.count) image_put_bits(&w, 0, 8 - w.count);
+
+    uint32_t a = 1, b = 0;
+    for (size_t k = 0; k < n;) {
+        // 5552 bytes keep b below 2^32 between reductions.
+        const size_t end = n - k < 5552 ? n : k + 5552;
+        for (; k < end; ++k) { a += src[k]; b += a; }
+        a %= 65521u;
+        b %= 65521u;
+    }
+    const uint32_t adler = (b << 16) | a;
+    const unsigned char tail[4] = { (unsigned char)(adler >> 24), (unsigned char)(adler >> 16),
+                                    (unsigned char)(adler >> 8), (unsigned char)adler };
+    image_buf_append(out, tail, 4);
+    return true;
+}
+
+// ------------------------------ PNG ------------------------------------------
+
+static inline uint32_t image_crc32(uint32_t crc, const unsigned char* p, size_t n)
+{
+    static const uint32_t nibble[16] = {
+        0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+        0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu, 0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu };
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) {
+        crc ^= p[i];
+        crc = (crc >> 4) ^ nibble[crc & 15];
+        crc = (crc >> 4) ^ nibble[crc & 15];
+    }
+    return ~crc;
+}
+
+static inline void image_put_u32be(unsigned char* p, uint32_t v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+// Chunk data must already be at out->data + start + 8 (after length and type).
+static inline bool image_png_finish_chunk(image_buf* out, size_t start, const char type[4])
+{
+    const size_t len = out->len - start - 8;
+    image_put_u32be(out->data + start, (uint32_t)len);
+    memcpy(out->data + start + 4, type, 4);
+    unsigned char crc[4];
+    image_put_u32be(crc, image_crc32(0, out->data + start + 4, len + 4));
+    return image_buf_append(out, crc, 4);
+}
+
+static inline bool image_png_begin_chunk(image_buf* out, size_t* start)
+{
+    *start = out->len;
+    static const unsigned char blank[8] = { 0 };
+    return image_buf_append(out, blank, 8);
+}
+
+/**
+ * @brief Append the framebuffer as an RGB PNG.
+ *
+ * @param scratch Arena for the filtered rows and the match table (reset by
+ *                the caller between images).
+ */
+static inline bool image_encode_png(image_buf* out, const framebuffer* fb, arena* scratch)
+{
+    const size_t w = (size_t)fb->width, h = (size_t)fb->height;
+    const size_t row_bytes = 3 * w + 1;
+    unsigned char* filtered = (unsigned char*)arena_alloc(scratch, row_bytes * h, 16);
+    unsigned char* rgb = (unsigned char*)arena_alloc(scratch, 2 * 3 * w, 16); // this row, previous row
+    if (!filtered || !rgb) return false;
+
+    unsigned char* prev = rgb + 3 * w;
+    memset(prev, 0, 3 * w);
+    for (size_t y = 0; y < h; ++y) {
+        unsigned char* cur = rgb;
+        const uint32_t* src = fb->pixels + y * (size_t)fb->stride;
+        for (size_t x = 0; x < w; ++x) {
+            cur[3 * x + 0] = (unsigned char)(src[x] >> 16);
+            cur[3 * x + 1] = (unsigned char)(src[x] >> 8);
+            cur[3 * x + 2] = (unsigned char)src[x];
+        }
+        // Residual cost of None, Sub, Up: sum of |signed byte|.
+        uint32_t cost[3] = { 0, 0, 0 };
+        for (size_t i = 0; i < 3 * w; ++i) {
+            const unsigned char left = i >= 3 ? cur[i - 3] : 0;
+            cost[0] += (uint32_t)abs((int)(signed char)cur[i]);
+            cost[1] += (uint32_t)abs((int)(signed char)(unsigned char)(cur[i] - left));
+            cost[2] += (uint32_t)abs((int)(signed char)(unsigned char)(cur[i] - prev[i]));
+        }
+        const int f = cost[1] < cost[0] ? (cost[2] < cost[1] ? 2 : 1) : (cost[2] < cost[0] ? 2 : 0);
+        unsigned char* dst = filtered + y * row_bytes;
+        dst[0] = (unsigned char)f;
+        for (size_t i = 0; i < 3 * w; ++i) {
+            const unsigned char pred = f == 1 ? (i >= 3 ? cur[i - 3] : 0) : f == 2 ? prev[i] : 0;
+            dst[1 + i] = (unsigned char)(cur[i] - pred);
+        }
+        rgb = prev;
+        prev = cur;
+    }
+
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    unsigned char ihdr[13];
+    image_put_u32be(ihdr, (uint32_t)w);
+    image_put_u32be(ihdr + 4, (uint32_t)h);
+    ihdr[8] = 8;   // bit depth
+    ihdr[9] = 2;   // RGB
+    ihdr[10] = 0;  // deflate
+    ihdr[11] = 0;  // adaptive filtering
+    ihdr[12] = 0;  // no interlace
+    size_t start;
+    return image_buf_append(out, signature, sizeof(signature))
+        && image_png_begin_chunk(out, &start) && image_buf_append(out, ihdr, sizeof(ihdr))
+        && image_png_finish_chunk(out, start, "IHDR")
+        && image_png_begin_chunk(out, &start) && image_zlib_compress(out, filtered, row_bytes * h, scratch)
+        && image_png_finish_chunk(out, start, "IDAT")
+        && image_png_begin_chunk(out, &start) && image_png_finish_chunk(out, start, "IEND");
+}
+
+// ------------------------------ Y4M ------------------------------------------
+
+/**
+ * @brief Append a YUV4MPEG2 stream header for 4:2:0 frames of w x h.
+ */
+static inline bool image_y4m_header(image_buf* out, int w, int h, int fps)
+{
+    char header[96];
+    const int n = snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", w, h, fps);
+    return n > 0 && image_buf_append(out, header, (size_t)n);
+}
+
+/**
+ * @brief Append one frame; odd sizes round the chroma planes up.
+ */
+static inline bool image_encode_y4m_frame(image_buf* out, const framebuffer* fb)
+{
+    const size_t w = (size_t)fb->width, h = (size_t)fb->height;
+    const size_t cw = (w + 1) / 2, ch = (h + 1) / 2;
+    if (!image_buf_reserve(out, 6 + w * h + 2 * cw * ch)) return false;
+    image_buf_append(out, "FRAME\n", 6);
+    unsigned char* yp = out->data + out->len;
+    unsigned char* up = yp + w * h;
+    unsigned char* vp = up + cw * ch;
+    for (size_t y = 0; y < h; ++y) {
+        const uint32_t* src = fb->pixels + y * (size_t)fb->stride;
+        for (size_t x = 0; x < w; ++x) {
+            const int r = (int)(src[x] >> 16) & 255, g = (int)(src[x] >> 8) & 255, b = (int)src[x] & 255;
+            yp[y * w + x] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        }
+    }
+    for (size_t cy = 0; cy < ch; ++cy) {
+        for (size_t cx = 0; cx < cw; ++cx) {
+            int r = 0, g = 0, b = 0, n = 0;
+            for (size_t y = 2 * cy; y < 2 * cy + 2 && y < h; ++y) {
+                for (size_t x = 2 * cx; x < 2 * cx + 2 && x < w; ++x) {
+                    const uint32_t p = fb->pixels[y * (size_t)fb->stride + x];
+                    r += (int)(p >> 16) & 255;
+                    g += (int)(p >> 8) & 255;
+                    b += (int)p & 255;
+                    n++;
+                }
+            }
+            r /= n;
+            g /= n;
+            b /= n;
+            // +128 rounds, +128 << 8 centres on 128 and keeps the sum positive.
+            up[cy * cw + cx] = (unsigned char)((-38 * r - 74 * g + 112 * b + 32896) >> 8);
+            vp[cy * cw + cx] = (unsigned char)((112 * r - 94 * g - 18 * b + 32896) >> 8);
+        }
+    }
+    out->len += w * h + 2 * cw * ch;
+    return true;
+}
+
+#endif // IMAGE_H
@@ -0,0 +1,694 @@
+﻿// jaml_bench.c — benchmark suite with stored baselines and regression checks.
+//
+// usage: jaml_bench run [-n rounds] [-o out.json] [--filter text]
+//        jaml_bench compare <base.json> <current.json> [--threshold 0.05] [--alpha 0.01] [--force]
+//        jaml_bench check [--baselines dir] [-n rounds] [--threshold 0.05] [--alpha 0.01] [--update]
+//        jaml_bench verify
+//
+// run times every case (kernels and viewer render scenarios) and writes the
+// samples; compare tests two result files; check runs the suite and compares
+// it with <dir>/<machine id>.json, the baseline recorded on the same machine
+// and build configuration (--update writes it). compare and check exit with
+// 1 if any case regressed or a baseline case did not run, so they can gate
+// CI on a dedicated runner. verify runs only the correctness checks, which
+// check also runs first; it exits with 1 if one fails.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "hemesh.h"
+#include "kdtree.h"
+#include "nav.h"
+#include "parallel.h"
+#include "polygon.h"
+#include "raster.h"
+#include "rng.h"
+#include "shape.h"
+#include "triangulate.h"
+#include "visibility.h"
+#include "viewer_core.h"
+
+// ------------------------------ Inputs ---------------------------------------
+
+// Star-shaped (hence simple) polygons of 8..32 vertices.
+typedef struct {
+    float*    xs;
+    float*    ys;
+    uint32_t* offsets;
+    poly_soup soup;
+} star_soup;
+
+static bool star_soup_make(star_soup* s, size_t count, uint64_t seed) {
+    rng r;
+    rng_seed(&r, seed, 0);
+    memset(s, 0, sizeof(*s));
+    s->offsets = (uint32_t*)malloc((count + 1) * sizeof(uint32_t));
+    s->xs = (float*)malloc(count * 32 * sizeof(float));
+    s->ys = (float*)malloc(count * 32 * sizeof(float));
+    if (!s->offsets || !s->xs || !s->ys) return false;
+    uint32_t n = 0;
+    for (size_t i = 0; i < count; ++i) {
+        s->offsets[i] = n;
+        const uint32_t verts = 8 + rng_below(&r, 25);
+        const float cx = rng_float(&r) * 1000.0f, cy = rng_float(&r) * 1000.0f;
+        for (uint32_t k = 0; k < verts; ++k) {
+            const float a = 6.2831853f * ((float)k + 0.8f * rng_float(&r)) / (float)verts;
+            const float rad = 2.0f + 3.0f * rng_float(&r);
+            s->xs[n] = cx + rad * cosf(a);
+            s->ys[n] = cy + rad * sinf(a);
+            n++;
+        }
+    }
+    s->offsets[count] = n;
+    s->soup = (poly_soup){ s->xs, s->ys, s->offsets, count };
+    return true;
+}
+
+static void star_soup_free(star_soup* s) {
+    free(s->xs);
+    free(s->ys);
+    free(s->offsets);
+}
+
+// ------------------------------ Kernel cases ---------------------------------
+
+typedef struct {
+    star_soup   soup;
+    poly_props* props;
+    size_t*     tri_start;
+    uint32_t*   tris;
+    uint32_t*   tri_count;
+} poly_state;
+
+static void poly_teardown(void* state) {
+    poly_state* p = (poly_state*)state;
+    if (!p) return;
+    star_soup_free(&p->soup);
+    free(p->props);
+    free(p->tri_start);
+    free(p->tris);
+    free(p->tri_count);
+    free(p);
+}
+
+static bool poly_setup(void** state) {
+    const size_t count = 20000;
+    poly_state* p = (poly_state*)calloc(1, sizeof(poly_state));
+    *state = p;
+    if (!p || !star_soup_make(&p->soup, count, 11)) return false;
+    p->props = (poly_props*)malloc(count * sizeof(poly_props));
+    p->tri_start = (size_t*)malloc((count + 1) * sizeof(size_t));
+    p->tri_count = (uint32_t*)malloc(count * sizeof(uint32_t));
+    if (!p->props || !p->tri_start || !p->tri_count) return false;
+    p->tris = (uint32_t*)malloc(3 * tri_soup_layout(&p->soup.soup, p->tri_start) * sizeof(uint32_t));
+    return p->tris != NULL;
+}
+
+static void run_poly_props_float(void* state) {
+    poly_state* p = (poly_state*)state;
+    poly_props_batch(&p->soup.soup, POLY_ACCUM_FLOAT, p->props);
+}
+
+static void run_poly_props_compensated(void* state) {
+    poly_state* p = (poly_state*)state;
+    poly_props_batch(&p->soup.soup, POLY_ACCUM_COMPENSATED, p->props);
+}
+
+static void run_tri_soup_batch(void* state) {
+    poly_state* p = (poly_state*)state;
+    tri_soup_batch(&p->soup.soup, p->tri_start, p->tris, p->tri_count);
+}
+
+typedef struct {
+    vec2*     verts;
+    uint32_t* tris;
+    size_t    vert_count, tri_count;
+    hemesh    mesh;
+} hemesh_state;
+
+static void hemesh_teardown(void* state) {
+    hemesh_state* h = (hemesh_state*)state;
+    if (!h) return;
+    free(h->verts);
+    free(h->tris);
+    hemesh_free(&h->mesh);
+    free(h);
+}
+
+// 256 x 256 quad grid, two triangles per quad.
+static bool hemesh_setup(void** state) {
+    const uint32_t n = 257;
+    hemesh_state* h = (hemesh_state*)calloc(1, sizeof(hemesh_state));
+    *state = h;
+    if (!h) return false;
+    hemesh_init(&h->mesh);
+    h->vert_count = (size_t)n * n;
+    h->tri_count = 2 * (size_t)(n - 1) * (n - 1);
+    h->verts = (vec2*)malloc(h->vert_count * sizeof(vec2));
+    h->tris = (uint32_t*)malloc(3 * h->tri_count * sizeof(uint32_t));
+    if (!h->verts || !h->tris) return false;
+    for (uint32_t y = 0; y < n; ++y)
+        for (uint32_t x = 0; x < n; ++x) h->verts[y * n + x] = (vec2){ (float)x, (float)y };
+    uint32_t* t = h->tris;
+    for (uint32_t y = 0; y + 1 < n; ++y) {
+        for (uint32_t x = 0; x + 1 < n; ++x) {
+            const uint32_t a = y * n + x, b = a + 1, c = a + n, d = c + 1;
+            *t++ = a; *t++ = b; *t++ = d;
+            *t++ = a; *t++ = d; *t++ = c;
+        }
+    }
+    return true;
+}
+
+static void run_hemesh_build(void* state) {
+    hemesh_state* h = (hemesh_state*)state;
+    hemesh_build(&h->mesh, h->verts, h->vert_count, h->tris, h->tri_count);
+}
+
+typedef struct {
+    vis_segment* segs;
+    vis_scene    scene;
+    vec2*        eyes;
+    arena        polys;
+    vis_set      out;
+} vis_state;
+
+static void vis_teardown(void* state) {
+    vis_state* v = (vis_state*)state;
+    if (!v) return;
+    vis_scene_free(&v->scene);
+    arena_free(&v->polys);
+    free(v->segs);
+    free(v->eyes);
+    free(v);
+}
+
+static bool vis_setup(void** state) {
+    const size_t segs = 2000, eyes = 256;
+    vis_state* v = (vis_state*)calloc(1, sizeof(vis_state));
+    *state = v;
+    if (!v) return false;
+    arena_init(&v->polys, 0);
+    v->segs = (vis_segment*)malloc(segs * sizeof(vis_segment));
+    v->eyes = (vec2*)malloc(eyes * sizeof(vec2));
+    if (!v->segs || !v->eyes) return false;
+    rng r;
+    rng_seed(&r, 23, 0);
+    for (size_t i = 0; i < segs; ++i) {
+        const vec2 a = { rng_float(&r) * 100.0f, rng_float(&r) * 100.0f };
+        v->segs[i] = (vis_segment){ a, { a.x + rng_float(&r) * 4.0f - 2.0f, a.y + rng_float(&r) * 4.0f - 2.0f } };
+    }
+    for (size_t i = 0; i < eyes; ++i) v->eyes[i] = (vec2){ rng_float(&r) * 100.0f, rng_float(&r) * 100.0f };
+    return vis_scene_build(&v->scene, v->segs, segs);
+}
+
+// Walls long enough to cross most view squares, so the sweep clips them.
+static bool vis_walls_setup(void** state) {
+    if (!vis_setup(state)) return false;
+    vis_state* v = (vis_state*)*state;
+    rng r;
+    rng_seed(&r, 29, 0);
+    for (size_t i = 0; i < 2000; ++i) {
+        const vec2 a = { rng_float(&r) * 100.0f, rng_float(&r) * 100.0f };
+        v->segs[i] = (vis_segment){ a, { a.x + rng_float(&r) * 24.0f - 12.0f, a.y + rng_float(&r) * 24.0f - 12.0f } };
+    }
+    vis_scene_free(&v->scene);
+    return vis_scene_build(&v->scene, v->segs, 2000);
+}
+
+static void vis_prepare(void* state) {
+    arena_reset(&((vis_state*)state)->polys);
+}
+
+static void run_vis_scene_build(void* state) {
+    vis_state* v = (vis_state*)state;
+    vis_scene_free(&v->scene);
+    vis_scene_build(&v->scene, v->segs, 2000);
+}
+
+static void run_vis_polygon_batch(void* state) {
+    vis_state* v = (vis_state*)state;
+    vis_polygon_batch(&v->scene, v->eyes, 256, 10.0f, &v->polys, &v->out);
+}
+
+typedef struct {
+    vec2*          pts;
+    uint32_t*      offsets;
+    shape_metrics* out;
+} shape_state;
+
+static void shape_teardown(void* state) {
+    shape_state* s = (shape_state*)state;
+    if (!s) return;
+    free(s->pts);
+    free(s->offsets);
+    free(s->out);
+    free(s);
+}
+
+// 2000 noisy ellipses of 200 points.
+static bool shape_setup(void** state) {
+    const size_t sets = 2000, per = 200;
+    shape_state* s = (shape_state*)calloc(1, sizeof(shape_state));
+    *state = s;
+    if (!s) return false;
+    s->pts = (vec2*)malloc(sets * per * sizeof(vec2));
+    s->offsets = (uint32_t*)malloc((sets + 1) * sizeof(uint32_t));
+    s->out = (shape_metrics*)malloc(sets * sizeof(shape_metrics));
+    if (!s->pts || !s->offsets || !s->out) return false;
+    rng r;
+    rng_seed(&r, 31, 0);
+    for (size_t i = 0; i < sets; ++i) {
+        s->offsets[i] = (uint32_t)(i * per);
+        const float ax = 1.0f + 4.0f * rng_float(&r), ay = 1.0f + 4.0f * rng_float(&r);
+        for (size_t k = 0; k < per; ++k) {
+            const float a = 6.2831853f * rng_float(&r), rad = 0.9f + 0.2f * rng_float(&r);
+            s->pts[i * per + k] = (vec2){ ax * rad * cosf(a), ay * rad * sinf(a) };
+        }
+    }
+    s->offsets[sets] = (uint32_t)(sets * per);
+    return true;
+}
+
+static void run_shape_metrics_batch(void* state) {
+    shape_state* s = (shape_state*)state;
+    shape_metrics_batch(s->pts, s->offsets, 2000, 5, s->out);
+}
+
+typedef struct {
+    framebuffer fb;
+    raster_tri* tris;
+} raster_state;
+
+static void raster_teardown(void* state) {
+    raster_state* s = (raster_state*)state;
+    if (!s) return;
+    fb_free(&s->fb);
+    free(s->tris);
+    free(s);
+}
+
+static bool raster_setup(void** state) {
+    const size_t count = 20000;
+    raster_state* s = (raster_state*)calloc(1, sizeof(raster_state));
+    *state = s;
+    if (!s || !fb_init(&s->fb, 1280, 720)) return false;
+    s->tris = (raster_tri*)malloc(count * sizeof(raster_tri));
+    if (!s->tris) return false;
+    rng r;
+    rng_seed(&r, 41, 0);
+    for (size_t i = 0; i < count; ++i) {
+        const vec2 c = { rng_float(&r) * 1280.0f, rng_float(&r) * 720.0f };
+        raster_tri* t = &s->tris[i];
+        t->a = (vec2){ c.x + rng_float(&r) * 40.0f - 20.0f, c.y + rng_float(&r) * 40.0f - 20.0f };
+        t->b = (vec2){ c.x + rng_float(&r) * 40.0f - 20.0f, c.y + rng_float(&r) * 40.0f - 20.0f };
+        t->c = (vec2){ c.x + rng_float(&r) * 40.0f - 20.0f, c.y + rng_float(&r) * 40.0f - 20.0f };
+        t->color = (uint32_t)rng_below(&r, 0x1000000);
+    }
+    return true;
+}
+
+static void run_raster_triangles(void* state) {
+    raster_state* s = (raster_state*)state;
+    raster_triangles(&s->fb, s->tris, 20000);
+}
+
+typedef struct {
+    vec2*     pts;
+    vec2*     queries;
+    kdtree    tree;
+    uint32_t  idx[8];
+    float     d2[8];
+} kdtree_state;
+
+static void kdtree_teardown(void* state) {
+    kdtree_state* k = (kdtree_state*)state;
+    if (!k) return;
+    kdtree_free(&k->tree);
+    free(k->pts);
+    free(k->queries);
+    free(k);
+}
+
+static bool kdtree_setup(void** state) {
+    const size_t n = 200000, q = 10000;
+    kdtree_state* k = (kdtree_state*)calloc(1, sizeof(kdtree_state));
+    *state = k;
+    if (!k) return false;
+    k->pts = (vec2*)malloc(n * sizeof(vec2));
+    k->queries = (vec2*)malloc(q * sizeof(vec2));
+    if (!k->pts || !k->queries) return false;
+    rng r;
+    rng_seed(&r, 53, 0);
+    for (size_t i = 0; i < n; ++i) k->pts[i] = (vec2){ rng_float(&r), rng_float(&r) };
+    for (size_t i = 0; i < q; ++i) k->queries[i] = (vec2){ rng_float(&r), rng_float(&r) };
+    return kdtree_build(&k->tree, k->pts, n);
+}
+
+static void run_kdtree_build(void* state) {
+    kdtree_state* k = (kdtree_state*)state;
+    kdtree_free(&k->tree);
+    kdtree_build(&k->tree, k->pts, 200000);
+}
+
+static void run_kdtree_knn(void* state) {
+    kdtree_state* k = (kdtree_state*)state;
+    for (size_t i = 0; i < 10000; ++i) kdtree_knn(&k->tree, k->queries[i], 8, k->idx, k->d2);
+}
+
+// ------------------------------ Render scenarios -----------------------------
+
+// Every scenario owns its viewer context; rendering leaves the scene as it is,
+// so no per-sample preparation is needed.
+typedef struct {
+    viewer_ctx  view;
+    framebuffer fb;
+} render_state;
+
+static void render_teardown(void* state) {
+    render_state* s = (render_state*)state;
+    if (!s) return;
+    viewer_shutdown(&s->view);
+    fb_free(&s->fb);
+    free(s);
+}
+
+static render_state* render_open(void** state, int preset) {
+    render_state* s = (render_state*)calloc(1, sizeof(render_state));
+    *state = s;
+    if (!s) return NULL;
+    viewer_init(&s->view, 1280, 720);
+    if (!fb_init(&s->fb, 1280, 720)) return NULL;
+    preset_apply_index(&s->view, preset);
+    return s;
+}
+
+static void run_render(void* state) {
+    render_state* s = (render_state*)state;
+    viewer_render(&s->view, &s->fb);
+}
+
+static bool render_basis_setup(void** state) {
+    return render_open(state, 1) != NULL;
+}
+
+static bool render_random_hud_setup(void** state) {
+    render_state* s = render_open(state, 3);
+    if (s) s->view.hud = true;
+    return s != NULL;
+}
+
+static bool render_visibility_setup(void** state) {
+    return render_open(state, 11) != NULL;
+}
+
+// 500 vectors, zoomed out so most of them are on screen.
+static bool render_dense_setup(void** state) {
+    render_state* s = render_open(state, 0);
+    if (!s) return false;
+    rng r;
+    rng_seed(&r, 61, 0);
+    for (int i = 0; i < 500; ++i)
+        add_vec_col(&s->view, rng_float(&r) * 40.0f - 20.0f, rng_float(&r) * 24.0f - 12.0f, RASTER_RGB(120, 200, 255));
+    s->view.cam.scale = 30.0f;
+    return true;
+}
+
+// Independent scenes (presets 1..RENDER_SCENES) at 640x360, rendered one
+// after the other and then one per worker; the ratio is the scaling of
+// batch rendering with separate contexts.
+#define RENDER_SCENES 8
+
+typedef struct {
+    viewer_ctx  views[RENDER_SCENES];
+    framebuffer fbs[RENDER_SCENES];
+} scenes_state;
+
+static void scenes_teardown(void* state) {
+    scenes_state* s = (scenes_state*)state;
+    if (!s) return;
+    for (int i = 0; i < RENDER_SCENES; ++i) {
+        viewer_shutdown(&s->views[i]);
+        fb_free(&s->fbs[i]);
+    }
+    free(s);
+}
+
+static bool scenes_setup(void** state) {
+    scenes_state* s = (scenes_state*)calloc(1, sizeof(scenes_state));
+    *state = s;
+    if (!s) return false;
+    for (int i = 0; i < RENDER_SCENES; ++i) {
+        viewer_init(&s->views[i], 640, 360);
+        if (!fb_init(&s->fbs[i], 640, 360)) return false;
+        preset_apply_index(&s->views[i], 1 + i % (g_preset_count - 1));
+    }
+    return true;
+}
+
+static void run_scenes_serial(void* state) {
+    scenes_state* s = (scenes_state*)state;
+    for (int i = 0; i < RENDER_SCENES; ++i) viewer_render(&s->views[i], &s->fbs[i]);
+}
+
+static void render_scene_range(void* user, size_t begin, size_t end, int worker) {
+    (void)worker;
+    scenes_state* s = (scenes_state*)user;
+    for (size_t i = begin; i < end; ++i) viewer_render(&s->views[i], &s->fbs[i]);
+}
+
+static void run_scenes_parallel(void* state) {
+    parallel_for(RENDER_SCENES, 1, render_scene_range, state);
+}
+
+// ------------------------------ Suite ----------------------------------------
+
+static const bench_case g_cases[] = {
+    { "poly_props_batch/float",       poly_setup,   NULL,        run_poly_props_float,       poly_teardown },
+    { "poly_props_batch/compensated", poly_setup,   NULL,        run_poly_props_compensated, poly_teardown },
+    { "tri_soup_batch/stars",         poly_setup,   NULL,        run_tri_soup_batch,         poly_teardown },
+    { "hemesh_build/grid256",         hemesh_setup, NULL,        run_hemesh_build,           hemesh_teardown },
+    { "vis_scene_build/2000",         vis_setup,    NULL,        run_vis_scene_build,        vis_teardown },
+    { "vis_polygon_batch/256",        vis_setup,    vis_prepare, run_vis_polygon_batch,      vis_teardown },
+    { "vis_polygon_batch/long_walls", vis_walls_setup, vis_prepare, run_vis_polygon_batch,   vis_teardown },
+    { "shape_metrics_batch/2000",     shape_setup,  NULL,        run_shape_metrics_batch,    shape_teardown },
+    { "raster_triangles/20000",       raster_setup, NULL,        run_raster_triangles,       raster_teardown },
+    { "kdtree_build/200k",            kdtree_setup, NULL,        run_kdtree_build,           kdtree_teardown },
+    { "kdtree_knn/k8",                kdtree_setup, NULL,        run_kdtree_knn,             kdtree_teardown },
+    { "render/basis",                 render_basis_setup,      NULL, run_render,          render_teardown },
+    { "render/random_hud",            render_random_hud_setup, NULL, run_render,          render_teardown },
+    { "render/visibility",            render_visibility_setup, NULL, run_render,          render_teardown },
+    { "render/dense500",              render_dense_setup,      NULL, run_render,          render_teardown },
+    { "render/scenes8_serial",        scenes_setup,            NULL, run_scenes_serial,   scenes_teardown },
+    { "render/scenes8_parallel",      scenes_setup,            NULL, run_scenes_parallel, scenes_teardown },
+};
+static const size_t g_case_count = sizeof(g_cases) / sizeof(g_cases[0]);
+
+// ------------------------------ Checks ---------------------------------------
+
+// Known answers for kernels the suite times. They run before every check and
+// on their own with verify; a failure makes either command exit 1.
+
+// A wall crossing the whole view square bounds the polygon along its full
+// width: 8 x 6 below y = 2 for radius 4, not a chord between two corners.
+static bool check_vis_crossing_wall(void) {
+    const vis_segment wall = { { -10.0f, 2.0f }, { 10.0f, 2.0f } };
+    vis_scene s;
+    arena a;
+    arena_init(&a, 0);
+    vis_polygon p = { NULL, 0 };
+    bool ok = vis_scene_build(&s, &wall, 1) && vis_polygon_compute(&s, (vec2){ 0.0f, 0.0f }, 4.0f, &a, &p);
+    double area = 0.0;
+    for (uint32_t i = 0; ok && i < p.count; ++i) {
+        const vec2 u = p.verts[i], w = p.verts[(i + 1) % p.count];
+        area += 0.5 * ((double)u.x * w.y - (double)w.x * u.y);
+    }
+    if (ok && fabs(area - 48.0) > 1e-3) {
+        fprintf(stderr, "  area %g, expected 48\n", area);
+        ok = false;
+    }
+    vis_scene_free(&s);
+    arena_free(&a);
+    return ok;
+}
+
+// Smoothed grid path on an 8 x 8 map, cells of size 1; false if it has no
+// path or repeats a point, or does not run from start to goal.
+static bool check_nav_path(const uint8_t* blocked, vec2 start, vec2 goal, vec2* out, size_t cap, size_t* count) {
+    const nav_grid g = { blocked, 8, 8, { 0.0f, 0.0f }, 1.0f };
+    nav_scratch s;
+    if (!nav_scratch_init(&s, 64)) return false;
+    *count = nav_grid_find_path(&g, &s, start, goal, true, out, cap);
+    nav_scratch_free(&s);
+    bool ok = *count >= 2 && *count <= cap && nav_same(out[0], start) && nav_same(out[*count - 1], goal);
+    for (size_t i = 1; ok && i < *count; ++i) ok = !nav_same(out[i - 1], out[i]);
+    if (!ok) {
+        fprintf(stderr, " ");
+        for (size_t i = 0; i < *count && i < cap; ++i) fprintf(stderr, " (%g, %g)", out[i].x, out[i].y);
+        fprintf(stderr, "\n");
+    }
+    return ok;
+}
+
+// Open map: a straight path is just its two ends.
+static bool check_nav_straight(void) {
+    const uint8_t blocked[64] = { 0 };
+    vec2 out[8];
+    size_t count;
+    return check_nav_path(blocked, (vec2){ 0.5f, 0.5f }, (vec2){ 3.5f, 0.5f }, out, 8, &count) && count == 2;
+}
+
+// Around a wall in column 3, rows 0-2: its top corners appear once each.
+static bool check_nav_corner(void) {
+    uint8_t blocked[64] = { 0 };
+    for (int y = 0; y < 3; ++y) blocked[y * 8 + 3] = 1;
+    vec2 out[16];
+    size_t count;
+    if (!check_nav_path(blocked, (vec2){ 0.5f, 0.5f }, (vec2){ 6.5f, 0.5f }, out, 16, &count)) return false;
+    size_t corners = 0;
+    for (size_t i = 0; i < count; ++i)
+        corners += nav_same(out[i], (vec2){ 3.0f, 3.0f }) + nav_same(out[i], (vec2){ 4.0f, 3.0f });
+    return corners == 2;
+}
+
+typedef struct {
+    const char* name;
+    bool (*run)(void);
+} check_case;
+
+static const check_case g_checks[] = {
+    { "vis_polygon/crossing_wall", check_vis_crossing_wall },
+    { "nav_funnel/straight",       check_nav_straight },
+    { "nav_funnel/corner",         check_nav_corner },
+};
+static const size_t g_check_count = sizeof(g_checks) / sizeof(g_checks[0]);
+
+static bool run_checks(void) {
+    size_t failed = 0;
+    for (size_t i = 0; i < g_check_count; ++i) {
+        const bool ok = g_checks[i].run();
+        fprintf(stderr, "%-36s %s\n", g_checks[i].name, ok ? "ok" : "FAILED");
+        if (!ok) failed++;
+    }
+    if (failed) fprintf(stderr, "%u check%s failed\n", (unsigned)failed, failed == 1 ? "" : "s");
+    return failed == 0;
+}
+
+// ------------------------------ Commands -------------------------------------
+
+static bool run_suite(int rounds, const char* filter, bench_report* out) {
+    const bool ok = bench_run_suite(g_cases, g_case_count, rounds, filter, stderr, out);
+    if (!ok) fprintf(stderr, "out of memory\n");
+    return ok;
+}
+
+// Same machine and build, or the comparison measures the difference between them.
+static bool same_machine(const bench_machine* a, const bench_machine* b) {
+    if (strcmp(a->id, b->id) == 0) return true;
+    fprintf(stderr, "machine fingerprints differ:\n  base:    %s | %s %s | %s | %s | %d workers\n"
+                    "  current: %s | %s %s | %s | %s | %d workers\n",
+            a->cpu, a->os, a->arch, a->compiler, a->flags, a->workers,
+            b->cpu, b->os, b->arch, b->compiler, b->flags, b->workers);
+    return false;
+}
+
+static int compare_reports(const bench_report* base, const bench_report* cur, double threshold, double alpha,
+                           bool force) {
+    if (!same_machine(&base->machine, &cur->machine) && !force) {
+        fprintf(stderr, "refusing to compare (use --force)\n");
+        return 2;
+    }
+    const size_t failing = bench_compare(base, cur, threshold, alpha, stdout);
+    printf("%u failing case%s (threshold %.1f%%, alpha %g)\n", (unsigned)failing, failing == 1 ? "" : "s",
+           100.0 * threshold, alpha);
+    return failing ? 1 : 0;
+}
+
+static int usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s run [-n rounds] [-o out.json] [--filter text]\n"
+            "       %s compare <base.json> <current.json> [--threshold 0.05] [--alpha 0.01] [--force]\n"
+            "       %s check [--baselines dir] [-n rounds] [--threshold 0.05] [--alpha 0.01] [--update]\n"
+            "       %s verify\n",
+            argv0, argv0, argv0, argv0);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) return usage(argv[0]);
+    const char* cmd = argv[1];
+    const char* out = NULL;
+    const char* filter = NULL;
+    const char* baselines = "bench/baselines";
+    const char* files[2] = { NULL, NULL };
+    int file_count = 0;
+    int rounds = 15;
+    double threshold = 0.05, alpha = 0.01;
+    bool force = false, update = false, bad = false;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) rounds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out = argv[++i];
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+        else if (strcmp(argv[i], "--baselines") == 0 && i + 1 < argc) baselines = argv[++i];
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) threshold = atof(argv[++i]);
+        else if (strcmp(argv[i], "--alpha") == 0 && i + 1 < argc) alpha = atof(argv[++i]);
+        else if (strcmp(argv[i], "--force") == 0) force = true;
+        else if (strcmp(argv[i], "--update") == 0) update = true;
+        else if (argv[i][0] != '-' && file_count < 2) files[file_count++] = argv[i];
+        else bad = true;
+    }
+    if (bad || rounds < 1 || threshold < 0.0 || alpha <= 0.0 || alpha >= 1.0) return usage(argv[0]);
+
+    if (strcmp(cmd, "run") == 0 && file_count == 0) {
+        bench_report r;
+        if (!run_suite(rounds, filter, &r)) return 1;
+        bool ok = true;
+        if (out) ok = bench_report_write(&r, out);
+        for (size_t i = 0; i < r.count; ++i)
+            printf("%-36s %10.4f ms\n", r.results[i].name, bench_median(r.results[i].samples_ms, r.results[i].count));
+        printf("machine %s\n", r.machine.id);
+        bench_report_free(&r);
+        if (!ok) fprintf(stderr, "cannot write %s\n", out);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(cmd, "compare") == 0 && file_count == 2) {
+        bench_report base, cur;
+        if (!bench_report_read(&base, files[0])) { fprintf(stderr, "cannot read %s\n", files[0]); return 2; }
+        if (!bench_report_read(&cur, files[1])) {
+            fprintf(stderr, "cannot read %s\n", files[1]);
+            bench_report_free(&base);
+            return 2;
+        }
+        const int rc = compare_reports(&base, &cur, threshold, alpha, force);
+        bench_report_free(&base);
+        bench_report_free(&cur);
+        return rc;
+    }
+
+    if (strcmp(cmd, "verify") == 0 && file_count == 0) return run_checks() ? 0 : 1;
+
+    if (strcmp(cmd, "check") == 0 && file_count == 0) {
+        bench_report cur, base;
+        if (!run_checks() || !run_suite(rounds, NULL, &cur)) return 1;
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.json", baselines, cur.machine.id);
+        int rc = 0;
+        if (update) {
+            rc = bench_report_write(&cur, path) ? 0 : 1;
+            fprintf(stderr, rc ? "cannot write %s\n" : "wrote baseline %s\n", path);
+        } else if (bench_report_read(&base, path)) {
+            rc = compare_reports(&base, &cur, threshold, alpha, false);
+            bench_report_free(&base);
+        } else {
+            fprintf(stderr, "no baseline for machine %s (%s); record one with --update\n", cur.machine.id, path);
+            rc = 2;
+        }
+        bench_report_free(&cur);
+        return rc;
+    }
+
+    return usage(argv[0]);
+}
@@ -0,0 +1,452 @@
+﻿// jaml_render.c — batch renderer: thumbnails and frame sequences of vector datasets.
+//
+// usage: jaml_render -o out [-s WxH] [--scale S [--pan X,Y] | --fit-all] [--labels]
+//                    [--fps N] [-j workers] <dataset>...
+//
+// Datasets are trajectory.h corpora (one frame per trajectory) or text files
+// with one vector per line, "x y [rrggbb]", '#' comments and a blank line
+// between frames. Frames are numbered across all datasets in order and drawn
+// as the viewer draws its vector list, without the status line (and, unless
+// --labels, without labels). The camera is fitted to each frame; --fit-all
+// fits one camera to every frame (steady for video), --scale fixes it.
+//
+// `out` is an image path with one %d for the frame number (thumbs/%05d.png,
+// frames/%04d.ppm; a single frame may omit it), or a .y4m file, "-" for
+// stdout, receiving all frames as one YUV4MPEG2 stream.
+//
+// Frames are rendered in batches by parallel_for: each worker owns a viewer
+// context and a scratch arena, each batch slot a framebuffer and an output
+// buffer. All of them are reused and sized up front for the largest frame
+// (output buffers for the worst case of the encoder), so the render loop
+// allocates nothing; the summary line reports any growth after the first
+// batch. Finished batches are written in frame order.
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "image.h"
+#include "parallel.h"
+#include "raster.h"
+#include "timer.h"
+#include "trajectory.h"
+#include "viewer_core.h"
+
+#define RENDER_DEFAULT_COLOR RASTER_RGB(80, 220, 160)
+#define RENDER_SLOTS_PER_WORKER 4
+
+typedef enum { FORMAT_PNG, FORMAT_PPM, FORMAT_Y4M } render_format;
+
+// ------------------------------ Datasets -------------------------------------
+
+typedef struct {
+    const vec2*     pts;
+    const uint32_t* colors;  // NULL: RENDER_DEFAULT_COLOR
+    size_t          count;
+    size_t          text_begin;  // index into the text arrays until loading is done
+} render_frame;
+
+typedef struct {
+    traj_corpus*  corpora;
+    size_t        corpus_count;
+    vec2*         text_pts;   // vectors of every text dataset, back to back
+    uint32_t*     text_colors;
+    size_t        text_len, pts_cap, colors_cap;
+    render_frame* frames;
+    size_t        frame_count, frame_cap;
+} dataset;
+
+static bool grow(void** p, size_t* cap, size_t need, size_t elem) {
+    if (need <= *cap) return true;
+    size_t n = *cap ? *cap * 2 : 256;
+    while (n < need) n *= 2;
+    void* q = realloc(*p, n * elem);
+    if (!q) return false;
+    *p = q;
+    *cap = n;
+    return true;
+}
+
+static bool add_frame(dataset* d, render_frame f) {
+    if (!grow((void**)&d->frames, &d->frame_cap, d->frame_count + 1, sizeof(render_frame))) return false;
+    d->frames[d->frame_count++] = f;
+    return true;
+}
+
+static bool load_corpus(dataset* d, const char* path) {
+    size_t cap = d->corpus_count;  // grown one at a time; there are few
+    traj_corpus* c = (traj_corpus*)realloc(d->corpora, (cap + 1) * sizeof(traj_corpus));
+    if (!c) return false;
+    d->corpora = c;
+    if (!traj_corpus_open(&c[d->corpus_count], path)) return false;
+    const traj_corpus* corpus = &c[d->corpus_count++];
+    for (size_t i = 0; i < corpus->count; ++i) {
+        render_frame f = { NULL, NULL, 0, 0 };
+        f.pts = traj_corpus_get(corpus, i, &f.count);
+        if (!add_frame(d, f)) return false;
+    }
+    return true;
+}
+
+// Closes the text frame that started at *begin, if it has any vectors.
+static bool end_text_frame(dataset* d, size_t* begin) {
+    if (d->text_len == *begin) return true;
+    const render_frame f = { NULL, NULL, d->text_len - *begin, *begin };
+    *begin = d->text_len;
+    return add_frame(d, f);
+}
+
+static bool load_text(dataset* d, const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[512];
+    size_t begin = d->text_len, lineno = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f)) {
+        lineno++;
+        char* p = line;
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '#') continue;
+        if (*p == '\0') {
+            ok = end_text_frame(d, &begin);
+            continue;
+        }
+        char* e;
+        const float x = strtof(p, &e);
+        ok = e != p;
+        p = e;
+        const float y = ok ? strtof(p, &e) : 0.0f;
+        ok = ok && e != p && isfinite(x) && isfinite(y);
+        p = e;
+        while (ok && isspace((unsigned char)*p)) p++;
+        uint32_t color = RENDER_DEFAULT_COLOR;
+        if (ok && *p && *p != '#') {
+            const unsigned long c = strtoul(p, &e, 16);
+            ok = e - p == 6;
+            color = RASTER_RGB((c >> 16) & 255u, (c >> 8) & 255u, c & 255u);
+        }
+        if (!ok) {
+            fprintf(stderr, "%s:%u: expected \"x y [rrggbb]\"\n", path, (unsigned)lineno);
+            break;
+        }
+        if (!grow((void**)&d->text_pts, &d->pts_cap, d->text_len + 1, sizeof(vec2))
+            || !grow((void**)&d->text_colors, &d->colors_cap, d->text_len + 1, sizeof(uint32_t))) {
+            ok = false;
+            break;
+        }
+        d->text_pts[d->text_len] = (vec2){ x, y };
+        d->text_colors[d->text_len] = color;
+        d->text_len++;
+    }
+    ok = ok && !ferror(f) && end_text_frame(d, &begin);
+    fclose(f);
+    return ok;
+}
+
+static bool load_dataset(dataset* d, const char* path) {
+    unsigned char magic[4] = { 0 };
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    const size_t n = fread(magic, 1, 4, f);
+    fclose(f);
+    uint32_t m = 0;
+    for (int i = 3; i >= 0; --i) m = (m << 8) | magic[i];
+    return n == 4 && m == TRAJ_MAGIC ? load_corpus(d, path) : load_text(d, path);
+}
+
+// Text frames point into arrays that stop moving once every file is read.
+static void resolve_text_frames(dataset* d) {
+    for (size_t i = 0; i < d->frame_count; ++i) {
+        render_frame* f = &d->frames[i];
+        if (f->pts) continue;
+        f->pts = d->text_pts + f->text_begin;
+        f->colors = d->text_colors + f->text_begin;
+    }
+}
+
+static void dataset_free(dataset* d) {
+    for (size_t i = 0; i < d->corpus_count; ++i) traj_corpus_close(&d->corpora[i]);
+    free(d->corpora);
+    free(d->text_pts);
+    free(d->text_colors);
+    free(d->frames);
+    memset(d, 0, sizeof(*d));
+}
+
+// ------------------------------ Camera ---------------------------------------
+
+// Bounds of the arrows of a frame: the origin and every finite tip.
+static void frame_bounds(const render_frame* f, vec2* lo, vec2* hi) {
+    for (size_t i = 0; i < f->count; ++i) {
+        const vec2 p = f->pts[i];
+        if (!isfinite(p.x) || !isfinite(p.y)) continue;
+        if (p.x < lo->x) lo->x = p.x;
+        if (p.y < lo->y) lo->y = p.y;
+        if (p.x > hi->x) hi->x = p.x;
+        if (p.y > hi->y) hi->y = p.y;
+    }
+}
+
+static Camera fit_camera(vec2 lo, vec2 hi, int width, int height) {
+    const float margin = 16.0f;  // arrow heads
+    const float dx = hi.x - lo.x > 1e-6f ? hi.x - lo.x : 1e-6f;
+    const float dy = hi.y - lo.y > 1e-6f ? hi.y - lo.y : 1e-6f;
+    const float sx = ((float)width - 2.0f * margin) / dx;
+    const float sy = ((float)height - 2.0f * margin) / dy;
+    const float scale = clampf(sx < sy ? sx : sy, 1e-3f, 1e6f);
+    return (Camera){ scale, -0.5f * (lo.x + hi.x) * scale, 0.5f * (lo.y + hi.y) * scale };
+}
+
+// ------------------------------ Renderer -------------------------------------
+
+typedef struct {
+    framebuffer fb;
+    image_buf   out;
+    bool        ok;
+} render_slot;
+
+typedef struct {
+    const dataset* data;
+    int            width, height;
+    render_format  format;
+    bool           fit_each;
+    Camera         camera;  // unless fit_each
+    viewer_ctx     views[PARALLEL_MAX_WORKERS];
+    arena          scratch[PARALLEL_MAX_WORKERS];
+    render_slot*   slots;
+    size_t         slot_count;
+    size_t         batch_begin;  // frame rendered into slots[0]
+    size_t         arena_reserved[PARALLEL_MAX_WORKERS];
+    size_t         arena_grows;
+} renderer;
+
+static void render_range(void* user, size_t begin, size_t end, int worker) {
+    renderer* r = (renderer*)user;
+    viewer_ctx* v = &r->views[worker];
+    arena* scratch = &r->scratch[worker];
+    for (size_t i = begin; i < end; ++i) {
+        render_slot* s = &r->slots[i];
+        const render_frame* f = &r->data->frames[r->batch_begin + i];
+        reset_list_and_labels(v);
+        for (size_t k = 0; k < f->count; ++k)
+            add_vec_col(v, f->pts[k].x, f->pts[k].y, f->colors ? f->colors[k] : RENDER_DEFAULT_COLOR);
+        if (r->fit_each) {
+            vec2 lo = { 0.0f, 0.0f }, hi = { 0.0f, 0.0f };
+            frame_bounds(f, &lo, &hi);
+            v->cam = fit_camera(lo, hi, r->width, r->height);
+        } else {
+            v->cam = r->camera;
+        }
+        viewer_render(v, &s->fb);
+
+        arena_reset(scratch);
+        s->out.len = 0;
+        switch (r->format) {
+        case FORMAT_PNG: s->ok = image_encode_png(&s->out, &s->fb, scratch); break;
+        case FORMAT_PPM: s->ok = image_encode_ppm(&s->out, &s->fb); break;
+        case FORMAT_Y4M: s->ok = image_encode_y4m_frame(&s->out, &s->fb); break;
+        }
+    }
+}
+
+// Reallocations of the reused buffers so far (an arena counts once per batch it grew in).
+static size_t buffer_growth(renderer* r, int workers) {
+    size_t n = 0;
+    for (int w = 0; w < workers; ++w) {
+        n += r->views[w].vecs.reallocs;
+        if (r->arena_reserved[w] != r->scratch[w].reserved) r->arena_grows++;
+        r->arena_reserved[w] = r->scratch[w].reserved;
+    }
+    for (size_t i = 0; i < r->slot_count; ++i) n += r->slots[i].out.grows;
+    return n + r->arena_grows;
+}
+
+// ------------------------------ Output ---------------------------------------
+
+static bool ends_with(const char* s, const char* suffix) {
+    const size_t n = strlen(s), k = strlen(suffix);
+    return n >= k && strcmp(s + n - k, suffix) == 0;
+}
+
+// Number of conversions in an image path pattern; only "%%" and "%[0][width]d"
+// are accepted, anything else returns -1.
+static int pattern_conversions(const char* p) {
+    int n = 0;
+    for (; *p; ++p) {
+        if (*p != '%') continue;
+        if (p[1] == '%') { p++; continue; }
+        p++;
+        if (*p == '0') p++;
+        while (isdigit((unsigned char)*p)) p++;
+        if (*p != 'd') return -1;
+        n++;
+    }
+    return n;
+}
+
+static bool write_slot(const render_slot* s, const char* out, size_t frame, FILE* stream) {
+    if (stream) return fwrite(s->out.data, 1, s->out.len, stream) == s->out.len;
+    char path[1024];
+    const int n = snprintf(path, sizeof(path), out, (int)frame);
+    return n > 0 && (size_t)n < sizeof(path) && image_buf_write_file(&s->out, path);
+}
+
+static int usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s -o out [-s WxH] [--scale S [--pan X,Y] | --fit-all] [--labels] [--fps N] [-j workers]\n"
+            "       <dataset>...\n"
+            "  out: image pattern with %%d (frames/%%05d.png, .ppm), a .y4m file, or - (Y4M on stdout)\n",
+            argv0);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    const char* out = NULL;
+    const char** inputs = (const char**)calloc((size_t)argc, sizeof(char*));
+    size_t input_count = 0;
+    int width = 256, height = 256, fps = 30, jobs = 0;
+    float scale = 0.0f, pan_x = 0.0f, pan_y = 0.0f;
+    bool fit_all = false, labels = false, pan = false, bad = !inputs;
+    for (int i = 1; i < argc && !bad; ++i) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out = argv[++i];
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) bad = sscanf(argv[++i], "%dx%d", &width, &height) != 2;
+        else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) scale = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--pan") == 0 && i + 1 < argc) bad = !(pan = sscanf(argv[++i], "%f,%f", &pan_x, &pan_y) == 2);
+        else if (strcmp(argv[i], "--fit-all") == 0) fit_all = true;
+        else if (strcmp(argv[i], "--labels") == 0) labels = true;
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) fps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) jobs = atoi(argv[++i]);
+        else if (argv[i][0] != '-') inputs[input_count++] = argv[i];
+        else bad = true;
+    }
+    if (bad || !out || !input_count || width < 1 || height < 1 || width > RASTER_MAX_SIZE || height > RASTER_MAX_SIZE
+        || fps < 1 || jobs < 0 || (scale != 0.0f && !(scale > 0.0f)) || (pan && scale == 0.0f) || (fit_all && scale != 0.0f)) {
+        free(inputs);
+        return usage(argv[0]);
+    }
+
+    render_format format;
+    if (strcmp(out, "-") == 0 || ends_with(out, ".y4m")) format = FORMAT_Y4M;
+    else if (ends_with(out, ".png")) format = FORMAT_PNG;
+    else if (ends_with(out, ".ppm")) format = FORMAT_PPM;
+    else {
+        fprintf(stderr, "unknown output format %s (use .png, .ppm or .y4m)\n", out);
+        free(inputs);
+        return 2;
+    }
+
+    dataset data;
+    memset(&data, 0, sizeof(data));
+    for (size_t i = 0; i < input_count; ++i) {
+        if (!load_dataset(&data, inputs[i])) {
+            fprintf(stderr, "cannot read dataset %s\n", inputs[i]);
+            dataset_free(&data);
+            free(inputs);
+            return 1;
+        }
+    }
+    free(inputs);
+    resolve_text_frames(&data);
+    if (!data.frame_count) {
+        fprintf(stderr, "no frames\n");
+        dataset_free(&data);
+        return 1;
+    }
+    const int conversions = format == FORMAT_Y4M ? 0 : pattern_conversions(out);
+    if (conversions < 0 || conversions > 1 || (conversions == 0 && format != FORMAT_Y4M && data.frame_count > 1)) {
+        fprintf(stderr, "%s: image output needs exactly one %%d for %u frames\n", out, (unsigned)data.frame_count);
+        dataset_free(&data);
+        return 2;
+    }
+
+    if (jobs) parallel_set_worker_count(jobs);
+    const int workers = parallel_worker_count();
+    renderer* r = (renderer*)calloc(1, sizeof(renderer));
+    size_t slot_count = (size_t)workers * RENDER_SLOTS_PER_WORKER;
+    if (slot_count > data.frame_count) slot_count = data.frame_count;
+    bool ok = r && (r->slots = (render_slot*)calloc(slot_count, sizeof(render_slot))) != NULL;
+    if (ok) {
+        r->data = &data;
+        r->width = width;
+        r->height = height;
+        r->format = format;
+        r->slot_count = slot_count;
+        r->fit_each = !fit_all && scale == 0.0f;
+        if (fit_all) {
+            vec2 lo = { 0.0f, 0.0f }, hi = { 0.0f, 0.0f };
+            for (size_t i = 0; i < data.frame_count; ++i) frame_bounds(&data.frames[i], &lo, &hi);
+            r->camera = fit_camera(lo, hi, width, height);
+        } else {
+            r->camera = (Camera){ scale, pan_x, pan_y };
+        }
+        size_t max_count = 0;
+        for (size_t i = 0; i < data.frame_count; ++i)
+            if (data.frames[i].count > max_count) max_count = data.frames[i].count;
+        for (int w = 0; ok && w < workers; ++w) {
+            viewer_init(&r->views[w], width, height);
+            r->views[w].hide_status = true;
+            r->views[w].hide_labels = !labels;
+            veclist_reserve(&r->views[w].vecs, max_count);
+            ok = r->views[w].vecs.cap >= max_count;
+            arena_init(&r->scratch[w], 0);
+        }
+        // Filtered PNG rows deflate to at most 9/8 of their size; PPM and Y4M are smaller.
+        const size_t raw = (3 * (size_t)width + 1) * (size_t)height;
+        for (size_t i = 0; ok && i < slot_count; ++i)
+            ok = fb_init(&r->slots[i].fb, width, height) && image_buf_reserve(&r->slots[i].out, raw + raw / 8 + 256);
+    }
+    if (!ok) fprintf(stderr, "out of memory\n");
+
+    FILE* stream = NULL;
+    if (ok && format == FORMAT_Y4M) {
+        stream = strcmp(out, "-") == 0 ? stdout : fopen(out, "wb");
+        image_buf header = { NULL, 0, 0, 0 };
+        ok = stream && image_y4m_header(&header, width, height, fps)
+          && fwrite(header.data, 1, header.len, stream) == header.len;
+        image_buf_free(&header);
+        if (!ok) fprintf(stderr, "cannot write %s\n", out);
+    }
+
+    size_t growth_after_first = 0;
+    const double t0 = timer_now_ms();
+    for (size_t begin = 0; ok && begin < data.frame_count; begin += slot_count) {
+        const size_t n = data.frame_count - begin < slot_count ? data.frame_count - begin : slot_count;
+        r->batch_begin = begin;
+        parallel_for(n, 1, render_range, r);
+        const size_t growth = buffer_growth(r, workers);
+        if (begin == 0) growth_after_first = growth;
+        for (size_t i = 0; ok && i < n; ++i) {
+            ok = r->slots[i].ok;
+            if (!ok) fprintf(stderr, "frame %u: out of memory\n", (unsigned)(begin + i));
+            else if (!(ok = write_slot(&r->slots[i], out, begin + i, stream)))
+                fprintf(stderr, "cannot write frame %u\n", (unsigned)(begin + i));
+        }
+        if (ok && begin + n == data.frame_count) {
+            const double ms = timer_now_ms() - t0;
+            fprintf(stderr, "rendered %u frames (%dx%d) in %.1f ms, %.1f frames/s, %d workers; "
+                            "buffers grew %u times after the first batch\n",
+                    (unsigned)data.frame_count, width, height, ms, 1000.0 * (double)data.frame_count / ms, workers,
+                    (unsigned)(growth - growth_after_first));
+        }
+    }
+
+    if (stream && stream != stdout && fclose(stream) != 0) ok = false;
+    if (stream == stdout && fflush(stdout) != 0) ok = false;
+    if (r) {
+        for (int w = 0; w < workers; ++w) {
+            viewer_shutdown(&r->views[w]);
+            arena_free(&r->scratch[w]);
+        }
+        for (size_t i = 0; r->slots && i < slot_count; ++i) {
+            fb_free(&r->slots[i].fb);
+            image_buf_free(&r->slots[i].out);
+        }
+        free(r->slots);
+        free(r);
+    }
+    dataset_free(&data);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,444 @@
+﻿// jaml_ulp.c — accuracy (ULP) and throughput report for the float routines of vector2.h.
+//
+// usage: jaml_ulp [-s samples] [--emin e] [--emax e] [--exhaustive] [--filter text] [-o report.json]
+//
+// Every routine is evaluated on inputs stratified by binade: stratum e holds
+// vectors whose largest component lies in [2^e, 2^(e+1)), the other component
+// up to 12 binades smaller, random signs and mantissas (-s per stratum).
+// Angles are drawn from [-2pi, 2pi] except for rot2_from_angle, whose strata
+// are the binades of the angle itself, capped at 2^20; --exhaustive instead
+// sweeps it over every finite float. Results are compared with the same
+// formula evaluated in double precision; its own rounding error is about
+// 2^-29 of the float evaluation's, so it is the exact value for this purpose.
+//
+// Each output component is one result. Max ULP is dominated by cancellation
+// (dot and cross of nearly orthogonal or parallel vectors, reject, angle):
+// there the result is tiny next to the inputs and every float formula loses
+// digits. p99 shows the typical case.
+//
+// Throughput is single-threaded, over a 64k-element batch of inputs from
+// strata -8..8, with the routine inlined into the loop.
+//
+// vec2_min / _max / _abs / _perp and vec2_rot90_* only move or negate values
+// and are exact by construction; vec2_equal is a predicate. They are not
+// listed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+#include "rng.h"
+#include "timer.h"
+#include "ulp.h"
+
+#define PI_D 3.14159265358979323846
+
+typedef struct {
+    vec2  a, b;
+    float t;
+} ulp_input;
+
+typedef enum {
+    IN_V,      // a
+    IN_VV,     // a, b
+    IN_VS,     // a, scalar t (same strata as a)
+    IN_VA,     // a, angle t
+    IN_VVA,    // a, pivot b, angle t
+    IN_A,      // angle t (own strata)
+    IN_R,      // unit rotation (b.x, b.y) = (cos, sin)
+    IN_RR,     // rotations a and b
+    IN_RV,     // rotation b, vector a
+} input_kind;
+
+typedef struct {
+    const char* name;
+    input_kind  kind;
+    int         outputs;
+    void   (*eval)(const ulp_input* in, float* out);
+    void   (*ref)(const ulp_input* in, double* out);
+    double (*throughput)(const ulp_input* in, size_t n, float* out);  // returns ns per call
+} ulp_routine;
+
+// ------------------------------ Routines -------------------------------------
+
+static inline void f_add(const ulp_input* in, float* o) { vec2 a = in->a, b = in->b; vec2 r = vec2_add(&a, &b); o[0] = r.x; o[1] = r.y; }
+static inline void f_sub(const ulp_input* in, float* o) { vec2 a = in->a, b = in->b; vec2 r = vec2_sub(&a, &b); o[0] = r.x; o[1] = r.y; }
+static inline void f_mul(const ulp_input* in, float* o) { vec2 a = in->a; vec2 r = vec2_mul(&a, in->t); o[0] = r.x; o[1] = r.y; }
+static inline void f_length2(const ulp_input* in, float* o) { vec2 a = in->a; o[0] = vec2_length2(&a); }
+static inline void f_length(const ulp_input* in, float* o) { vec2 a = in->a; o[0] = vec2_length(&a); }
+static inline void f_dist2(const ulp_input* in, float* o) { vec2 a = in->a, b = in->b; o[0] = vec2_dist2(&a, &b); }
+static inline void f_dist(const ulp_input* in, float* o) { vec2 a = in->a, b = in->b; o[0] = vec2_dist(&a, &b); }
+static inline void f_normalize(const ulp_input* in, float* o) { vec2 a = in->a; vec2 r = vec2_normalize(&a); o[0] = r.x; o[1] = r.y; }
+static inline void f_dot(const ulp_input* in, float* o) { vec2 a = in->a, b = in->b; o[0] = vec2_dot(&a, &b); }
+static inline void f_cross(const ulp_input* in, float* o) { vec2 a = in->a, b = in->b; o[0] = vec2_cross(&a, &b); }
+static inline void f_angle(const ulp_input* in, float* o) { vec2 a = in->a, b = in->b; o[0] = vec2_angle(&a, &b); }
+static inline void f_project(const ulp_input* in, float* o) { vec2 a = in->a, b = in->b; vec2 r = vec2_project(&a, &b); o[0] = r.x; o[1] = r.y; }
+static inline void f_reject(const ulp_input* in, float* o) { vec2 a = in->a, b = in->b; vec2 r = vec2_reject(&a, &b); o[0] = r.x; o[1] = r.y; }
+static inline void f_reflect(const ulp_input* in, float* o) { vec2 a = in->a, b = in->b; vec2 r = vec2_reflect(&a, &b); o[0] = r.x; o[1] = r.y; }
+static inline void f_rotate(const ulp_input* in, float* o) { vec2 a = in->a; vec2 r = vec2_rotate(&a, in->t); o[0] = r.x; o[1] = r.y; }
+static inline void f_rotate_around(const ulp_input* in, float* o) { vec2 r = vec2_rotate_around(&in->a, &in->b, in->t); o[0] = r.x; o[1] = r.y; }
+static inline void f_rot2_from_angle(const ulp_input* in, float* o) { rot2 r = rot2_from_angle(in->t); o[0] = r.c; o[1] = r.s; }
+static inline void f_rot2_angle(const ulp_input* in, float* o) { rot2 r = { in->b.x, in->b.y }; o[0] = rot2_angle(&r); }
+static inline void f_rot2_mul(const ulp_input* in, float* o) {
+    rot2 p = { in->a.x, in->a.y }, q = { in->b.x, in->b.y };
+    rot2 r = rot2_mul(&p, &q);
+    o[0] = r.c; o[1] = r.s;
+}
+static inline void f_rot2_apply(const ulp_input* in, float* o) { rot2 r = { in->b.x, in->b.y }; vec2 v = rot2_apply(&r, &in->a); o[0] = v.x; o[1] = v.y; }
+
+// References: the same formulas in double.
+static void r_add(const ulp_input* in, double* o) { o[0] = (double)in->a.x + in->b.x; o[1] = (double)in->a.y + in->b.y; }
+static void r_sub(const ulp_input* in, double* o) { o[0] = (double)in->a.x - in->b.x; o[1] = (double)in->a.y - in->b.y; }
+static void r_mul(const ulp_input* in, double* o) { o[0] = (double)in->a.x * in->t; o[1] = (double)in->a.y * in->t; }
+static double d_len2(double x, double y) { return x * x + y * y; }
+static void r_length2(const ulp_input* in, double* o) { o[0] = d_len2(in->a.x, in->a.y); }
+static void r_length(const ulp_input* in, double* o) { o[0] = sqrt(d_len2(in->a.x, in->a.y)); }
+static void r_dist2(const ulp_input* in, double* o) { o[0] = d_len2((double)in->a.x - in->b.x, (double)in->a.y - in->b.y); }
+static void r_dist(const ulp_input* in, double* o) { o[0] = sqrt(d_len2((double)in->a.x - in->b.x, (double)in->a.y - in->b.y)); }
+static void r_normalize(const ulp_input* in, double* o) {
+    const double len = sqrt(d_len2(in->a.x, in->a.y));
+    o[0] = len == 0.0 ? 0.0 : in->a.x / len;
+    o[1] = len == 0.0 ? 0.0 : in->a.y / len;
+}
+static double d_dot(const ulp_input* in) { return (double)in->a.x * in->b.x + (double)in->a.y * in->b.y; }
+static double d_cross(const ulp_input* in) { return (double)in->a.x * in->b.y - (double)in->a.y * in->b.x; }
+static void r_dot(const ulp_input* in, double* o) { o[0] = d_dot(in); }
+static void r_cross(const ulp_input* in, double* o) { o[0] = d_cross(in); }
+// The true angle; atan2 of |cross| and dot stays accurate where acos does not.
+static void r_angle(const ulp_input* in, double* o) {
+    const bool zero = d_len2(in->a.x, in->a.y) == 0.0 || d_len2(in->b.x, in->b.y) == 0.0;
+    o[0] = zero ? 0.0 : atan2(fabs(d_cross(in)), d_dot(in));
+}
+static void r_project(const ulp_input* in, double* o) {
+    const double s = d_dot(in) / d_len2(in->b.x, in->b.y);
+    o[0] = in->b.x * s;
+    o[1] = in->b.y * s;
+}
+static void r_reject(const ulp_input* in, double* o) {
+    r_project(in, o);
+    o[0] = in->a.x - o[0];
+    o[1] = in->a.y - o[1];
+}
+static void r_reflect(const ulp_input* in, double* o) {
+    const double len = sqrt(d_len2(in->b.x, in->b.y));
+    const double nx = len == 0.0 ? 0.0 : in->b.x / len, ny = len == 0.0 ? 0.0 : in->b.y / len;
+    const double d = in->a.x * nx + in->a.y * ny;
+    o[0] = in->a.x - 2.0 * d * nx;
+    o[1] = in->a.y - 2.0 * d * ny;
+}
+static void r_rotate(const ulp_input* in, double* o) {
+    const double c = cos(in->t), s = sin(in->t);
+    o[0] = in->a.x * c - in->a.y * s;
+    o[1] = in->a.x * s + in->a.y * c;
+}
+static void r_rotate_around(const ulp_input* in, double* o) {
+    const double c = cos(in->t), s = sin(in->t);
+    const double dx = (double)in->a.x - in->b.x, dy = (double)in->a.y - in->b.y;
+    o[0] = dx * c - dy * s + in->b.x;
+    o[1] = dx * s + dy * c + in->b.y;
+}
+static void r_rot2_from_angle(const ulp_input* in, double* o) { o[0] = cos(in->t); o[1] = sin(in->t); }
+static void r_rot2_angle(const ulp_input* in, double* o) { o[0] = atan2(in->b.y, in->b.x); }
+static void r_rot2_mul(const ulp_input* in, double* o) {
+    o[0] = (double)in->a.x * in->b.x - (double)in->a.y * in->b.y;
+    o[1] = (double)in->a.y * in->b.x + (double)in->a.x * in->b.y;
+}
+static void r_rot2_apply(const ulp_input* in, double* o) {
+    o[0] = (double)in->b.x * in->a.x - (double)in->b.y * in->a.y;
+    o[1] = (double)in->b.y * in->a.x + (double)in->b.x * in->a.y;
+}
+
+// Batch loop with the routine inlined; ns per call. Reading one output per
+// repetition keeps the stores alive.
+static volatile float g_ulp_sink;
+
+#define ULP_THROUGHPUT(fn)                                                        \
+    static double tp_##fn(const ulp_input* in, size_t n, float* out) {           \
+        size_t reps = 0;                                                          \
+        const double t0 = timer_now_ms();                                         \
+        double t1 = t0;                                                           \
+        do {                                                                      \
+            for (size_t i = 0; i < n; ++i) fn(&in[i], &out[2 * i]);               \
+            g_ulp_sink = out[(reps * 7919u) % (2 * n)];                           \
+            reps++;                                                               \
+            t1 = timer_now_ms();                                                  \
+        } while (t1 - t0 < 50.0);                                                 \
+        return (t1 - t0) * 1e6 / ((double)reps * (double)n);                      \
+    }
+
+ULP_THROUGHPUT(f_add)
+ULP_THROUGHPUT(f_sub)
+ULP_THROUGHPUT(f_mul)
+ULP_THROUGHPUT(f_length2)
+ULP_THROUGHPUT(f_length)
+ULP_THROUGHPUT(f_dist2)
+ULP_THROUGHPUT(f_dist)
+ULP_THROUGHPUT(f_normalize)
+ULP_THROUGHPUT(f_dot)
+ULP_THROUGHPUT(f_cross)
+ULP_THROUGHPUT(f_angle)
+ULP_THROUGHPUT(f_project)
+ULP_THROUGHPUT(f_reject)
+ULP_THROUGHPUT(f_reflect)
+ULP_THROUGHPUT(f_rotate)
+ULP_THROUGHPUT(f_rotate_around)
+ULP_THROUGHPUT(f_rot2_from_angle)
+ULP_THROUGHPUT(f_rot2_angle)
+ULP_THROUGHPUT(f_rot2_mul)
+ULP_THROUGHPUT(f_rot2_apply)
+
+#define ULP_ROUTINE(name, kind, outputs, fn) { #name, kind, outputs, f_##fn, r_##fn, tp_f_##fn }
+
+static const ulp_routine g_routines[] = {
+    ULP_ROUTINE(vec2_add,           IN_VV,  2, add),
+    ULP_ROUTINE(vec2_sub,           IN_VV,  2, sub),
+    ULP_ROUTINE(vec2_mul,           IN_VS,  2, mul),
+    ULP_ROUTINE(vec2_length2,       IN_V,   1, length2),
+    ULP_ROUTINE(vec2_length,        IN_V,   1, length),
+    ULP_ROUTINE(vec2_dist2,         IN_VV,  1, dist2),
+    ULP_ROUTINE(vec2_dist,          IN_VV,  1, dist),
+    ULP_ROUTINE(vec2_normalize,     IN_V,   2, normalize),
+    ULP_ROUTINE(vec2_dot,           IN_VV,  1, dot),
+    ULP_ROUTINE(vec2_cross,         IN_VV,  1, cross),
+    ULP_ROUTINE(vec2_angle,         IN_VV,  1, angle),
+    ULP_ROUTINE(vec2_project,       IN_VV,  2, project),
+    ULP_ROUTINE(vec2_reject,        IN_VV,  2, reject),
+    ULP_ROUTINE(vec2_reflect,       IN_VV,  2, reflect),
+    ULP_ROUTINE(vec2_rotate,        IN_VA,  2, rotate),
+    ULP_ROUTINE(vec2_rotate_around, IN_VVA, 2, rotate_around),
+    ULP_ROUTINE(rot2_from_angle,    IN_A,   2, rot2_from_angle),
+    ULP_ROUTINE(rot2_angle,         IN_R,   1, rot2_angle),
+    ULP_ROUTINE(rot2_mul,           IN_RR,  2, rot2_mul),
+    ULP_ROUTINE(rot2_apply,         IN_RV,  2, rot2_apply),
+};
+static const size_t g_routine_count = sizeof(g_routines) / sizeof(g_routines[0]);
+
+// ------------------------------ Inputs ---------------------------------------
+
+#define ANGLE_EMIN (-24)
+#define ANGLE_EMAX 20
+
+static float rand_binade(rng* r, int e) {
+    const float m = ldexpf(1.0f + rng_float(r), e);
+    return rng_below(r, 2) ? -m : m;
+}
+
+// Largest component in binade e, the other up to 12 binades smaller.
+static vec2 rand_vec(rng* r, int e) {
+    const float big = rand_binade(r, e), small = rand_binade(r, e - (int)rng_below(r, 13));
+    return rng_below(r, 2) ? (vec2){ big, small } : (vec2){ small, big };
+}
+
+static vec2 rand_rot(rng* r) {
+    const float a = (float)((2.0 * rng_float(r) - 1.0) * PI_D);
+    return (vec2){ cosf(a), sinf(a) };
+}
+
+static ulp_input make_input(rng* r, input_kind kind, int e) {
+    ulp_input in = { { 0.0f, 0.0f }, { 0.0f, 0.0f }, 0.0f };
+    const float angle = (float)((2.0 * rng_float(r) - 1.0) * 2.0 * PI_D);
+    switch (kind) {
+    case IN_V:   in.a = rand_vec(r, e); break;
+    case IN_VV:  in.a = rand_vec(r, e); in.b = rand_vec(r, e); break;
+    case IN_VS:  in.a = rand_vec(r, e); in.t = rand_binade(r, e); break;
+    case IN_VA:  in.a = rand_vec(r, e); in.t = angle; break;
+    case IN_VVA: in.a = rand_vec(r, e); in.b = rand_vec(r, e); in.t = angle; break;
+    case IN_A:   in.t = rand_binade(r, e); break;
+    case IN_R:   in.b = rand_rot(r); break;
+    case IN_RR:  in.a = rand_rot(r); in.b = rand_rot(r); break;
+    case IN_RV:  in.a = rand_vec(r, e); in.b = rand_rot(r); break;
+    }
+    return in;
+}
+
+// Stratum range of a routine: vector magnitudes, or angle binades for IN_A;
+// rotation-only routines have a single stratum.
+static void strata(input_kind kind, int emin, int emax, int* lo, int* hi) {
+    if (kind == IN_A) { *lo = ANGLE_EMIN; *hi = ANGLE_EMAX; }
+    else if (kind == IN_R || kind == IN_RR) { *lo = 0; *hi = 0; }
+    else { *lo = emin; *hi = emax; }
+}
+
+static void add_errors(ulp_stats* s, const ulp_routine* rt, const ulp_input* in) {
+    float got[2];
+    double ref[2];
+    rt->eval(in, got);
+    rt->ref(in, ref);
+    const double inputs[5] = { in->a.x, in->a.y, in->b.x, in->b.y, in->t };
+    for (int k = 0; k < rt->outputs; ++k) ulp_stats_add(s, ulp_error(got[k], ref[k]), inputs, 5);
+}
+
+// ------------------------------ Sweeps ---------------------------------------
+
+typedef struct {
+    const ulp_routine* rt;
+    int                lo;
+    size_t             samples;
+    ulp_stats*         per_stratum;
+} sweep_job;
+
+static void sweep_range(void* user, size_t begin, size_t end, int worker) {
+    (void)worker;
+    sweep_job* j = (sweep_job*)user;
+    for (size_t s = begin; s < end; ++s) {
+        rng r;
+        rng_seed(&r, 0x51e7, s);
+        ulp_stats_init(&j->per_stratum[s]);
+        for (size_t i = 0; i < j->samples; ++i) {
+            const ulp_input in = make_input(&r, j->rt->kind, j->lo + (int)s);
+            add_errors(&j->per_stratum[s], j->rt, &in);
+        }
+    }
+}
+
+typedef struct {
+    const ulp_routine* rt;
+    ulp_stats          worker[PARALLEL_MAX_WORKERS];
+} exhaustive_job;
+
+static void exhaustive_range(void* user, size_t begin, size_t end, int worker) {
+    exhaustive_job* j = (exhaustive_job*)user;
+    for (size_t i = begin; i < end; ++i) {
+        const uint32_t bits = (uint32_t)i;
+        ulp_input in = { { 0.0f, 0.0f }, { 0.0f, 0.0f }, 0.0f };
+        memcpy(&in.t, &bits, sizeof(float));
+        if (!isfinite(in.t)) continue;
+        add_errors(&j->worker[worker], j->rt, &in);
+    }
+}
+
+// ------------------------------ Report ---------------------------------------
+
+typedef struct {
+    ulp_stats  total;
+    ulp_stats* per_stratum;
+    int        lo, hi;
+    bool       exhaustive;
+    double     ns_per_call;
+} routine_result;
+
+static void print_worst(FILE* f, const ulp_routine* rt, const double* w) {
+    switch (rt->kind) {
+    case IN_V:   fprintf(f, "a=(%.9g, %.9g)", w[0], w[1]); break;
+    case IN_VS:
+    case IN_VA:  fprintf(f, "a=(%.9g, %.9g) t=%.9g", w[0], w[1], w[4]); break;
+    case IN_VVA: fprintf(f, "a=(%.9g, %.9g) b=(%.9g, %.9g) t=%.9g", w[0], w[1], w[2], w[3], w[4]); break;
+    case IN_A:   fprintf(f, "t=%.9g", w[4]); break;
+    case IN_R:   fprintf(f, "r=(%.9g, %.9g)", w[2], w[3]); break;
+    default:     fprintf(f, "a=(%.9g, %.9g) b=(%.9g, %.9g)", w[0], w[1], w[2], w[3]); break;
+    }
+}
+
+static bool write_json(const char* path, const routine_result* res, size_t samples) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "{\n  \"samples_per_stratum\": %u,\n  \"routines\": [", (unsigned)samples);
+    bool first = true;
+    for (size_t i = 0; i < g_routine_count; ++i) {
+        const routine_result* r = &res[i];
+        if (!r->per_stratum && !r->exhaustive) continue;
+        fprintf(f, "%s\n    {\"name\": \"%s\", \"results\": %llu, \"max_ulp\": %.6g, \"mean_ulp\": %.6g, "
+                   "\"p99_ulp\": %.6g, \"nonfinite\": %llu, \"ns_per_call\": %.4f, \"exhaustive\": %s,\n"
+                   "     \"strata\": [",
+                first ? "" : ",", g_routines[i].name,
+                (unsigned long long)(r->total.count + r->total.nonfinite), r->total.max, ulp_stats_mean(&r->total),
+                ulp_stats_quantile(&r->total, 0.99), (unsigned long long)r->total.nonfinite, r->ns_per_call,
+                r->exhaustive ? "true" : "false");
+        first = false;
+        for (int e = r->lo; r->per_stratum && e <= r->hi; ++e) {
+            const ulp_stats* s = &r->per_stratum[e - r->lo];
+            fprintf(f, "%s{\"exp\": %d, \"max_ulp\": %.6g, \"mean_ulp\": %.6g, \"nonfinite\": %llu}",
+                    e == r->lo ? "" : ", ", e, s->max, ulp_stats_mean(s), (unsigned long long)s->nonfinite);
+        }
+        fprintf(f, "]}");
+    }
+    fprintf(f, "\n  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+int main(int argc, char** argv) {
+    size_t samples = 4096;
+    int emin = -60, emax = 60;
+    bool exhaustive = false, bad = false;
+    const char* filter = NULL;
+    const char* out = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) samples = (size_t)atol(argv[++i]);
+        else if (strcmp(argv[i], "--emin") == 0 && i + 1 < argc) emin = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--emax") == 0 && i + 1 < argc) emax = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--exhaustive") == 0) exhaustive = true;
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out = argv[++i];
+        else bad = true;
+    }
+    // Inputs must stay finite floats: 2^(e+1) < FLT_MAX, and above the subnormals.
+    if (bad || samples == 0 || emin > emax || emin < -126 || emax > 126) {
+        fprintf(stderr, "usage: %s [-s samples] [--emin e] [--emax e] [--exhaustive] [--filter text] [-o report.json]\n",
+                argv[0]);
+        return 2;
+    }
+
+    routine_result* res = (routine_result*)calloc(g_routine_count, sizeof(routine_result));
+    const size_t batch = 1u << 16;
+    ulp_input* tp_in = (ulp_input*)malloc(batch * sizeof(ulp_input));
+    float* tp_out = (float*)malloc(2 * batch * sizeof(float));
+    if (!res || !tp_in || !tp_out) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("%-20s %12s %12s %10s %8s %10s %9s  %s\n", "routine", "results", "max ulp", "mean ulp", "p99 ulp",
+           "non-finite", "ns/call", "worst input");
+    bool ok = true;
+    for (size_t i = 0; ok && i < g_routine_count; ++i) {
+        const ulp_routine* rt = &g_routines[i];
+        routine_result* r = &res[i];
+        if (filter && !strstr(rt->name, filter)) continue;
+        ulp_stats_init(&r->total);
+        if (exhaustive && rt->kind == IN_A) {
+            exhaustive_job* j = (exhaustive_job*)calloc(1, sizeof(exhaustive_job));
+            if (!j) { ok = false; break; }
+            j->rt = rt;
+            parallel_for((size_t)1 << 32, 1u << 16, exhaustive_range, j);
+            for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) ulp_stats_merge(&r->total, &j->worker[w]);
+            free(j);
+            r->exhaustive = true;
+        } else {
+            strata(rt->kind, emin, emax, &r->lo, &r->hi);
+            const size_t count = (size_t)(r->hi - r->lo + 1);
+            r->per_stratum = (ulp_stats*)malloc(count * sizeof(ulp_stats));
+            if (!r->per_stratum) { ok = false; break; }
+            sweep_job j = { rt, r->lo, samples, r->per_stratum };
+            parallel_for(count, 1, sweep_range, &j);
+            for (size_t s = 0; s < count; ++s) ulp_stats_merge(&r->total, &r->per_stratum[s]);
+        }
+
+        rng g;
+        rng_seed(&g, 0x7e57, i);
+        for (size_t k = 0; k < batch; ++k) {
+            int lo, hi;
+            strata(rt->kind, -8, 8, &lo, &hi);
+            tp_in[k] = make_input(&g, rt->kind, lo + (int)rng_below(&g, (uint32_t)(hi - lo + 1)));
+        }
+        r->ns_per_call = rt->throughput(tp_in, batch, tp_out);
+
+        printf("%-20s %12llu %12.4g %10.4g %8.4g %10llu %9.3f  ", rt->name,
+               (unsigned long long)(r->total.count + r->total.nonfinite), r->total.max, ulp_stats_mean(&r->total),
+               ulp_stats_quantile(&r->total, 0.99), (unsigned long long)r->total.nonfinite, r->ns_per_call);
+        if (r->total.count) print_worst(stdout, rt, r->total.worst);
+        printf("%s\n", r->exhaustive ? " (exhaustive)" : "");
+        fflush(stdout);
+    }
+    if (!ok) fprintf(stderr, "out of memory\n");
+    if (ok && out && !write_json(out, res, samples)) {
+        fprintf(stderr, "cannot write %s\n", out);
+        ok = false;
+    }
+    for (size_t i = 0; i < g_routine_count; ++i) free(res[i].per_stratum);
+    free(res);
+    free(tp_in);
+    free(tp_out);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+﻿//
+// kdtree.h — static 2D k-d tree for nearest-neighbor queries.
+//
+// The tree is implicit: building permutes a SoA copy of the points so that
+// every range [lo, hi) has its splitting point at mid = (lo + hi) / 2, smaller
+// coordinates on the left. Only the split axis per node is stored, and ranges
+// of at most KDTREE_LEAF points are scanned linearly.
+//
+
+#ifndef KDTREE_H
+#define KDTREE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+
+#define KDTREE_LEAF  8
+#define KDTREE_MAX_K 32
+
+typedef struct {
+    float*    xs;     // points in tree order
+    float*    ys;
+    uint32_t* idx;    // original index of each tree slot
+    uint8_t*  axis;   // split axis of the node whose split point is at that slot
+    uint32_t  count;
+} kdtree;
+
+static inline void kdtree_swap(kdtree* t, size_t a, size_t b)
+{
+    float fx = t->xs[a]; t->xs[a] = t->xs[b]; t->xs[b] = fx;
+    float fy = t->ys[a]; t->ys[a] = t->ys[b]; t->ys[b] = fy;
+    uint32_t i = t->idx[a]; t->idx[a] = t->idx[b]; t->idx[b] = i;
+}
+
+// Quickselect with Hoare partitioning (robust to many equal coordinates):
+// element k of [lo, hi) along axis ends up at k, smaller ones before it.
+static inline void kdtree_select(kdtree* t, size_t lo, size_t hi, size_t k, int axis)
+{
+    const float* c = axis ? t->ys : t->xs;
+    while (hi - lo > 1) {
+        const float pivot = c[lo + (hi - 1 - lo) / 2];
+        ptrdiff_t i = (ptrdiff_t)lo - 1, j = (ptrdiff_t)hi;
+        for (;;) {
+            do i++; while (c[i] < pivot);
+            do j--; while (c[j] > pivot);
+            if (i >= j) break;
+            kdtree_swap(t, (size_t)i, (size_t)j);
+        }
+        // [lo, j] <= pivot <= [j + 1, hi)
+        if (k <= (size_t)j) hi = (size_t)j + 1;
+        else lo = (size_t)j + 1;
+    }
+}
+
+static inline void kdtree_build_range(kdtree* t, size_t lo, size_t hi)
+{
+    while (hi - lo > KDTREE_LEAF) {
+        float x0 = INFINITY, x1 = -INFINITY, y0 = INFINITY, y1 = -INFINITY;
+        for (size_t i = lo; i < hi; ++i) {
+            x0 = fminf(x0, t->xs[i]); x1 = fmaxf(x1, t->xs[i]);
+            y0 = fminf(y0, t->ys[i]); y1 = fmaxf(y1, t->ys[i]);
+        }
+        const int axis = (y1 - y0) > (x1 - x0);
+        const size_t mid = lo + (hi - lo) / 2;
+        kdtree_select(t, lo, hi, mid, axis);
+        t->axis[mid] = (uint8_t)axis;
+        kdtree_build_range(t, lo, mid);
+        lo = mid + 1;
+    }
+}
+
+/**
+ * @brief Build a tree over a point set (the points are copied).
+ *
+ * @param t   Tree to build (free with kdtree_free).
+ * @param pts Points; must be finite.
+ * @param n   Number of points (< 2^32).
+ * @return false on invalid input or allocation failure.
+ */
+static inline bool kdtree_build(kdtree* t, const vec2* pts, size_t n)
+{
+    memset(t, 0, sizeof(*t));
+    if (n >= UINT32_MAX) return false;
+    const size_t m = n ? n : 1;
+    t->xs = (float*)malloc(m * sizeof(float));
+    t->ys = (float*)malloc(m * sizeof(float));
+    t->idx = (uint32_t*)malloc(m * sizeof(uint32_t));
+    t->axis = (uint8_t*)calloc(m, 1);
+    if (!t->xs || !t->ys || !t->idx || !t->axis) {
+        free(t->xs); free(t->ys); free(t->idx); free(t->axis);
+        memset(t, 0, sizeof(*t));
+        return false;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        t->xs[i] = pts[i].x;
+        t->ys[i] = pts[i].y;
+        t->idx[i] = (uint32_t)i;
+    }
+    t->count = (uint32_t)n;
+    kdtree_build_range(t, 0, n);
+    return true;
+}
+
+static inline void kdtree_free(kdtree* t)
+{
+    free(t->xs); free(t->ys); free(t->idx); free(t->axis);
+    memset(t, 0, sizeof(*t));
+}
+
+static inline void kdtree_nearest_range(const kdtree* t, size_t lo, size_t hi, float qx, float qy,
+                                        uint32_t* best, float* best_d2)
+{
+    while (hi - lo > KDTREE_LEAF) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const float dx = t->xs[mid] - qx, dy = t->ys[mid] - qy;
+        const float d2 = dx * dx + dy * dy;
+        if (d2 < *best_d2) { *best_d2 = d2; *best = (uint32_t)mid; }
+        const float diff = t->axis[mid] ? qy - t->ys[mid] : qx - t->xs[mid];
+        // Near side first; the far side only if the splitting line is closer than the best.
+        const size_t nlo = diff < 0.0f ? lo : mid + 1, nhi = diff < 0.0f ? mid : hi;
+        const size_t flo = diff < 0.0f ? mid + 1 : lo, fhi = diff < 0.0f ? hi : mid;
+        kdtree_nearest_range(t, nlo, nhi, qx, qy, best, best_d2);
+        if (diff * diff >= *best_d2) return;
+        lo = flo; hi = fhi;
+    }
+    for (size_t i = lo; i < hi; ++i) {
+        const float dx = t->xs[i] - qx, dy = t->ys[i] - qy;
+        const float d2 = dx * dx + dy * dy;
+        if (d2 < *best_d2) { *best_d2 = d2; *best = (uint32_t)i; }
+    }
+}
+
+/**
+ * @brief Nearest point to q.
+ *
+ * @param t      Tree.
+ * @param q      Query point.
+ * @param max_d2 Only points with squared distance below this are considered
+ *               (INFINITY for no limit); a tight limit prunes the search.
+ * @param out_d2 Optional; squared distance of the result.
+ * @return Original index of the nearest point, or UINT32_MAX if none.
+ */
+static inline uint32_t kdtree_nearest(const kdtree* t, vec2 q, float max_d2, float* out_d2)
+{
+    uint32_t best = UINT32_MAX;
+    float d2 = max_d2;
+    kdtree_nearest_range(t, 0, t->count, q.x, q.y, &best, &d2);
+    if (out_d2) *out_d2 = d2;
+    return best == UINT32_MAX ? UINT32_MAX : t->idx[best];
+}
+
+typedef struct {
+    uint32_t slot[KDTREE_MAX_K];
+    float    d2[KDTREE_MAX_K];   // ascending
+    int      n, k;
+} kdtree_heap;
+
+static inline void kdtree_knn_insert(kdtree_heap* h, uint32_t slot, float d2)
+{
+    if (h->n == h->k && d2 >= h->d2[h->n - 1]) return;
+    int i = h->n < h->k ? h->n++ : h->n - 1;
+    while (i > 0 && h->d2[i - 1] > d2) {
+        h->d2[i] = h->d2[i - 1];
+        h->slot[i] = h->slot[i - 1];
+        i--;
+    }
+    h->d2[i] = d2;
+    h->slot[i] = slot;
+}
+
+static inline void kdtree_knn_range(const kdtree* t, size_t lo, size_t hi, float qx, float qy, kdtree_heap* h)
+{
+    while (hi - lo > KDTREE_LEAF) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const float dx = t->xs[mid] - qx, dy = t->ys[mid] - qy;
+        kdtree_knn_insert(h, (uint32_t)mid, dx * dx + dy * dy);
+        const float diff = t->axis[mid] ? qy - t->ys[mid] : qx - t->xs[mid];
+        const size_t nlo = diff < 0.0f ? lo : mid + 1, nhi = diff < 0.0f ? mid : hi;
+        const size_t flo = diff < 0.0f ? mid + 1 : lo, fhi = diff < 0.0f ? hi : mid;
+        kdtree_knn_range(t, nlo, nhi, qx, qy, h);
+        if (h->n == h->k && diff * diff >= h->d2[h->n - 1]) return;
+        lo = flo; hi = fhi;
+    }
+    for (size_t i = lo; i < hi; ++i) {
+        const float dx = t->xs[i] - qx, dy = t->ys[i] - qy;
+        kdtree_knn_insert(h, (uint32_t)i, dx * dx + dy * dy);
+    }
+}
+
+/**
+ * @brief The k nearest points to q, closest first.
+ *
+ * @param t   Tree.
+ * @param q   Query point.
+ * @param k   Number of neighbors (<= KDTREE_MAX_K).
+ * @param out Output original indices (k entries).
+ * @param d2  Optional output squared distances (k entries).
+ * @return Number of neighbors found (min(k, count)).
+ */
+static inline int kdtree_knn(const kdtree* t, vec2 q, int k, uint32_t* out, float* d2)
+{
+    if (k > KDTREE_MAX_K) k = KDTREE_MAX_K;
+    if (k <= 0) return 0;
+    kdtree_heap h;
+    h.n = 0;
+    h.k = k;
+    kdtree_knn_range(t, 0, t->count, q.x, q.y, &h);
+    for (int i = 0; i < h.n; ++i) {
+        out[i] = t->idx[h.slot[i]];
+        if (d2) d2[i] = h.d2[i];
+    }
+    return h.n;
+}
+
+#endif // KDTREE_H
@@ -1,44 +1,131 @@
-﻿#include <stdio.h>
-#include <bemapiset.h>
-#include <windows.h>
-#include <windowsx.h>
-
-LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
-
-int main(void)
-{
-    HINSTANCE hInstance = GetModuleHandleA(NULL);
-
-    WNDCLASSA wc = {0};
-    wc.style         = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
-    wc.lpfnWndProc   = WndProc;
-    wc.hInstance     = hInstance;
-    wc.hCursor       = LoadCursor(NULL, IDC_ARROW);
-    wc.hbrBackground = (HBRUSH)(COLOR_WINDOW+1);
-    wc.lpszClassName = "VecViewerWin32";
-
-    if (!RegisterClassA(&wc)) return 1;
-
-    DWORD style = WS_OVERLAPPEDWINDOW;
-    RECT r = {0, 0, 1000, 800};
-    AdjustWindowRect(&r, style, FALSE);
-
-    HWND hWnd = CreateWindowA(
-        wc.lpszClassName, "JAML",
-        style,
-        CW_USEDEFAULT, CW_USEDEFAULT,
-        r.right - r.left, r.bottom - r.top,
-        NULL, NULL, hInstance, NULL
-    );
-    if (!hWnd) return 2;
-
-    ShowWindow(hWnd, SW_SHOWDEFAULT);
-    UpdateWindow(hWnd);
-
-    MSG msg;
-    while (GetMessage(&msg, NULL, 0, 0) > 0) {
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
+﻿// main.c — the viewer on any backend of platform.h.
+//
+// usage: jaml [--replay recording [--ppm last.ppm]]
+//
+// Input goes to viewer_core.h; a frame is rendered and presented once all
+// pending events are handled and one of them changed the picture. I toggles
+// recording the session to jaml_input.txt (viewer_record.h); S exports the
+// scene to jaml_scene.svg (viewer_svg.h).
+//
+// --replay plays a recording through the window instead of live input and
+// quits after its last frame, optionally saving that frame: with Xvfb this
+// runs the real backend headless (xvfb-run ./jaml --replay ...), and its PPM
+// matches jaml_replay --ppm for the same recording. The window keeps the
+// recording's initial size, so recorded resizes are skipped.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+#include "viewer_core.h"
+#include "viewer_record.h"
+#include "viewer_svg.h"
+
+#define VIEWER_KEY_RECORD 'I'
+#define VIEWER_KEY_EXPORT 'S'
+
+static viewer_ctx g_view;
+static viewer_recorder g_rec;
+
+static void render_frame(platform_window* win) {
+    PROFILE_BEGIN("frame");
+    viewer_render(&g_view, platform_framebuffer(win));
+    PROFILE_BEGIN("present");
+    platform_present(win);
+    PROFILE_END();
+    viewer_record_frame(&g_rec);
+    PROFILE_END();
+}
+
+static int run_live(void) {
+    platform_window* win = platform_open("JAML", 1000, 800);
+    if (!win) return 1;
+    viewer_init(&g_view, 1000, 800);
+
+    bool dirty = true, running = true;
+    while (running) {
+        platform_event e;
+        // Block only while there is nothing to draw.
+        while (running && platform_poll(win, &e, !dirty)) {
+            if (e.type == PLATFORM_EV_CLOSE) {
+                running = false;
+            } else if (e.type == PLATFORM_EV_PAINT) {
+                dirty = true;
+            } else if (e.input.type == VIEWER_EV_KEY && e.input.value == VIEWER_KEY_RECORD) {
+                if (g_rec.f) viewer_record_end(&g_rec);
+                else viewer_record_begin(&g_rec, &g_view, "jaml_input.txt");
+            } else if (e.input.type == VIEWER_EV_KEY && e.input.value == VIEWER_KEY_EXPORT) {
+                if (!viewer_export_svg_file(&g_view, "jaml_scene.svg")) fprintf(stderr, "cannot write jaml_scene.svg\n");
+            } else {
+                viewer_record_event(&g_rec, &e.input);
+                if (viewer_handle_event(&g_view, &e.input)) dirty = true;
+            }
+        }
+        if (!running) break;
+        render_frame(win);
+        dirty = false;
     }
+    if (g_rec.f) viewer_record_end(&g_rec);
+    viewer_shutdown(&g_view);
+    platform_close(win);
     return 0;
-}
\ No newline at end of file
+}
+
+static int run_replay(const char* recording, const char* ppm) {
+    viewer_replay r;
+    if (!viewer_replay_load(&r, recording)) {
+        fprintf(stderr, "cannot read recording %s\n", recording);
+        return 1;
+    }
+    platform_window* win = platform_open("JAML (replay)", r.width, r.height);
+    if (!win) {
+        viewer_replay_free(&r);
+        return 1;
+    }
+    viewer_init(&g_view, r.width, r.height);
+    viewer_replay_restore(&r, &g_view);
+
+    size_t skipped = 0;
+    bool closed = false;
+    for (size_t frame = 0; frame < r.frame_count && !closed; ++frame) {
+        platform_event e;
+        while (platform_poll(win, &e, false))
+            if (e.type == PLATFORM_EV_CLOSE) closed = true;
+        size_t begin, end;
+        viewer_replay_frame_events(&r, frame, &begin, &end);
+        for (size_t i = begin; i < end; ++i) {
+            if (r.events[i].type == VIEWER_EV_RESIZE) { skipped++; continue; }
+            viewer_handle_event(&g_view, &r.events[i]);
+        }
+        render_frame(win);
+    }
+    if (skipped) fprintf(stderr, "skipped %u recorded resize events\n", (unsigned)skipped);
+
+    bool ok = true;
+    if (ppm) {
+        ok = fb_write_ppm(platform_framebuffer(win), ppm);
+        if (!ok) fprintf(stderr, "cannot write %s\n", ppm);
+    }
+    viewer_shutdown(&g_view);
+    platform_close(win);
+    viewer_replay_free(&r);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    const char* recording = NULL;
+    const char* ppm = NULL;
+    bool usage = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) recording = argv[++i];
+        else if (strcmp(argv[i], "--ppm") == 0 && i + 1 < argc) ppm = argv[++i];
+        else usage = true;
+    }
+    if (usage || (ppm && !recording)) {
+        fprintf(stderr, "usage: %s [--replay recording [--ppm last.ppm]]\n", argv[0]);
+        return 2;
+    }
+    PROFILE_THREAD_NAME("ui");
+    return recording ? run_replay(recording, ppm) : run_live();
+}
@@ -0,0 +1,588 @@
+﻿//
+// nav.h — A* pathfinding on occupancy grids and triangle navmeshes, funnel
+// (string-pulling) smoothing, and batched path requests.
+//
+// Both searches run over a compact node pool: per-node cost and parent arrays
+// indexed by node id, validated by a generation stamp, so a query never clears
+// memory proportional to the map. The open list is a binary heap with lazy
+// deletion (stale entries are skipped when popped).
+//
+// Smoothing turns the chain of visited cells/triangles into portals, the
+// shared edge crossed at each step with its left and right end as seen in the
+// direction of travel, and runs the simple stupid funnel algorithm over them:
+// the funnel narrows while new portal ends stay inside it (vec2_cross sign
+// tests) and emits a corner whenever one side crosses over the other.
+//
+// Batch requests run on all workers, each with its own scratch.
+//
+
+#ifndef NAV_H
+#define NAV_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+
+#define NAV_NONE  UINT32_MAX
+#define NAV_SQRT2 1.41421356f
+
+typedef struct {
+    const uint8_t* blocked;  // w * h, row-major, nonzero = wall
+    int            w, h;
+    vec2           origin;   // lower-left corner of cell (0, 0)
+    float          cell;     // cell edge
+} nav_grid;
+
+typedef struct {
+    const vec2*     verts;
+    const uint32_t* tris;      // 3 vertex indices per triangle, counter-clockwise
+    size_t          tri_count;
+    int32_t*        adj;       // 3 per triangle: neighbor across edge (v[k], v[k+1]), or -1
+    vec2*           centroid;
+} nav_mesh;
+
+typedef struct {
+    vec2 start, goal;
+} nav_request;
+
+typedef struct {
+    float    f;
+    float    g;
+    uint32_t node;
+} nav_heap_entry;
+
+typedef struct {
+    vec2 left, right;
+} nav_portal;
+
+/**
+ * @brief Per-thread search memory, reusable across queries on the same map.
+ */
+typedef struct {
+    size_t          nodes;
+    float*          g;
+    uint32_t*       parent;
+    uint32_t*       stamp;     // == gen: reached, == gen + 1: closed
+    uint32_t        gen;
+    nav_heap_entry* heap;
+    size_t          heap_len, heap_cap;
+    uint32_t*       chain;     // node sequence of the found path
+    nav_portal*     portals;
+    size_t          chain_cap; // capacity of chain and portals
+} nav_scratch;
+
+// ------------------------------ Scratch & heap --------------------------------
+
+static inline bool nav_scratch_init(nav_scratch* s, size_t nodes)
+{
+    memset(s, 0, sizeof(*s));
+    s->nodes = nodes;
+    s->g = (float*)malloc((nodes ? nodes : 1) * sizeof(float));
+    s->parent = (uint32_t*)malloc((nodes ? nodes : 1) * sizeof(uint32_t));
+    s->stamp = (uint32_t*)calloc(nodes ? nodes : 1, sizeof(uint32_t));
+    // A grid path can double in length when diagonal steps are split for smoothing.
+    s->chain_cap = 2 * nodes + 2;
+    s->chain = (uint32_t*)malloc(s->chain_cap * sizeof(uint32_t));
+    s->portals = (nav_portal*)malloc(s->chain_cap * sizeof(nav_portal));
+    s->heap_cap = 256;
+    s->heap = (nav_heap_entry*)malloc(s->heap_cap * sizeof(nav_heap_entry));
+    s->gen = 2;
+    if (!s->g || !s->parent || !s->stamp || !s->chain || !s->portals || !s->heap) {
+        free(s->g); free(s->parent); free(s->stamp); free(s->chain); free(s->portals); free(s->heap);
+        memset(s, 0, sizeof(*s));
+        return false;
+    }
+    return true;
+}
+
+static inline void nav_scratch_free(nav_scratch* s)
+{
+    free(s->g); free(s->parent); free(s->stamp); free(s->chain); free(s->portals); free(s->heap);
+    memset(s, 0, sizeof(*s));
+}
+
+static inline void nav_begin_query(nav_scratch* s)
+{
+    s->heap_len = 0;
+    if (s->gen >= UINT32_MAX - 2) {
+        memset(s->stamp, 0, s->nodes * sizeof(uint32_t));
+        s->gen = 2;
+    } else {
+        s->gen += 2;
+    }
+}
+
+static inline bool nav_heap_push(nav_scratch* s, float f, float g, uint32_t node)
+{
+    if (s->heap_len == s->heap_cap) {
+        nav_heap_entry* grown = (nav_heap_entry*)realloc(s->heap, s->heap_cap * 2 * sizeof(nav_heap_entry));
+        if (!grown) return false;
+        s->heap = grown;
+        s->heap_cap *= 2;
+    }
+    size_t i = s->heap_len++;
+    const nav_heap_entry e = { f, g, node };
+    while (i > 0) {
+        const size_t p = (i - 1) / 2;
+        if (s->heap[p].f <= f) break;
+        s->heap[i] = s->heap[p];
+        i = p;
+    }
+    s->heap[i] = e;
+    return true;
+}
+
+static inline nav_heap_entry nav_heap_pop(nav_scratch* s)
+{
+    const nav_heap_entry top = s->heap[0];
+    const nav_heap_entry last = s->heap[--s->heap_len];
+    size_t i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= s->heap_len) break;
+        if (c + 1 < s->heap_len && s->heap[c + 1].f < s->heap[c].f) c++;
+        if (last.f <= s->heap[c].f) break;
+        s->heap[i] = s->heap[c];
+        i = c;
+    }
+    if (s->heap_len) s->heap[i] = last;
+    return top;
+}
+
+// Relax an edge into `to`; returns false only on allocation failure.
+static inline bool nav_relax(nav_scratch* s, uint32_t from, uint32_t to, float g, float h)
+{
+    if (s->stamp[to] == s->gen + 1) return true;                  // closed
+    if (s->stamp[to] == s->gen && s->g[to] <= g) return true;     // no improvement
+    s->stamp[to] = s->gen;
+    s->g[to] = g;
+    s->parent[to] = from;
+    return nav_heap_push(s, g + h, g, to);
+}
+
+// Node chain start..goal into s->chain; returns its length.
+static inline size_t nav_build_chain(nav_scratch* s, uint32_t goal)
+{
+    size_t n = 0;
+    for (uint32_t v = goal; v != NAV_NONE; v = s->parent[v]) s->chain[n++] = v;
+    for (size_t i = 0; i < n / 2; ++i) {
+        const uint32_t t = s->chain[i];
+        s->chain[i] = s->chain[n - 1 - i];
+        s->chain[n - 1 - i] = t;
+    }
+    return n;
+}
+
+// ------------------------------ Funnel ---------------------------------------
+
+static inline float nav_side(vec2 apex, vec2 a, vec2 b)
+{
+    vec2 u = vec2_sub(&a, &apex), v = vec2_sub(&b, &apex);
+    return vec2_cross(&u, &v); // > 0: b is counter-clockwise of a, seen from apex
+}
+
+static inline bool nav_same(vec2 a, vec2 b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+// Appends corner p unless it repeats the last one. Both sides of the funnel
+// collapse onto the goal at its degenerate portal, so the goal can become the
+// apex and would otherwise be emitted again by the side test that follows.
+static inline void nav_emit(vec2* out, size_t cap, size_t* count, vec2* last, vec2 p)
+{
+    if (nav_same(p, *last)) return;
+    if (*count < cap) out[*count] = p;
+    (*count)++;
+    *last = p;
+}
+
+/**
+ * @brief Simple stupid funnel algorithm over a portal sequence.
+ *
+ * The first portal is (start, start), the last (goal, goal); left/right are
+ * as seen while walking from start to goal.
+ *
+ * @param portals Portals.
+ * @param n       Number of portals (>= 2).
+ * @param out     Output corners, start and goal included.
+ * @param cap     Capacity of out.
+ * @return Number of corners; only the first cap are written.
+ */
+static inline size_t nav_funnel(const nav_portal* portals, size_t n, vec2* out, size_t cap)
+{
+    size_t count = 0;
+    vec2 apex = portals[0].left, left = portals[0].left, right = portals[0].right;
+    size_t apex_i = 0, left_i = 0, right_i = 0;
+    vec2 last = apex; // last corner emitted, even past cap
+    if (count < cap) out[count] = apex;
+    count++;
+
+    for (size_t i = 1; i < n; ++i) {
+        const vec2 l = portals[i].left, r = portals[i].right;
+
+        // Right side: tighten if r moved counter-clockwise (inwards).
+        if (nav_side(apex, right, r) >= 0.0f) {
+            if (nav_same(apex, right) || nav_side(apex, left, r) < 0.0f) {
+                right = r;
+                right_i = i;
+            } else {
+                // r crossed the left side: the left point becomes a corner.
+                apex = left;
+                apex_i = left_i;
+                nav_emit(out, cap, &count, &last, apex);
+                left = right = apex;
+                left_i = right_i = apex_i;
+                i = apex_i;
+                continue;
+            }
+        }
+        // Left side: tighten if l moved clockwise (inwards).
+        if (nav_side(apex, left, l) <= 0.0f) {
+            if (nav_same(apex, left) || nav_side(apex, right, l) > 0.0f) {
+                left = l;
+                left_i = i;
+            } else {
+                apex = right;
+                apex_i = right_i;
+                nav_emit(out, cap, &count, &last, apex);
+                left = right = apex;
+                left_i = right_i = apex_i;
+                i = apex_i;
+                continue;
+            }
+        }
+    }
+    // The goal ends the path; the funnel may already have made it the apex.
+    nav_emit(out, cap, &count, &last, portals[n - 1].left);
+    return count;
+}
+
+// ------------------------------ Grid -----------------------------------------
+
+static inline bool nav_grid_free_cell(const nav_grid* g, int x, int y)
+{
+    return x >= 0 && y >= 0 && x < g->w && y < g->h && !g->blocked[(size_t)y * g->w + x];
+}
+
+static inline vec2 nav_grid_center(const nav_grid* g, uint32_t node)
+{
+    const int x = (int)(node % (uint32_t)g->w), y = (int)(node / (uint32_t)g->w);
+    return (vec2){ g->origin.x + ((float)x + 0.5f) * g->cell, g->origin.y + ((float)y + 0.5f) * g->cell };
+}
+
+static inline uint32_t nav_grid_node_at(const nav_grid* g, vec2 p)
+{
+    const float fx = floorf((p.x - g->origin.x) / g->cell), fy = floorf((p.y - g->origin.y) / g->cell);
+    if (!(fx >= 0.0f && fy >= 0.0f && fx < (float)g->w && fy < (float)g->h)) return NAV_NONE;
+    const int x = (int)fx, y = (int)fy;
+    return nav_grid_free_cell(g, x, y) ? (uint32_t)((size_t)y * g->w + x) : NAV_NONE;
+}
+
+static inline float nav_octile(const nav_grid* g, uint32_t a, uint32_t b)
+{
+    const int w = g->w;
+    const float dx = (float)abs((int)(a % (uint32_t)w) - (int)(b % (uint32_t)w));
+    const float dy = (float)abs((int)(a / (uint32_t)w) - (int)(b / (uint32_t)w));
+    return (dx + dy + (NAV_SQRT2 - 2.0f) * fminf(dx, dy)) * g->cell;
+}
+
+/**
+ * @brief A* over a grid (8-connected, no corner cutting), optionally smoothed.
+ *
+ * @param g      Grid.
+ * @param s      Scratch built with nav_scratch_init(s, w * h).
+ * @param start  Start point (world units).
+ * @param goal   Goal point.
+ * @param smooth Funnel-smooth the cell corridor; otherwise cell centers.
+ * @param out    Output path, start and goal included.
+ * @param cap    Capacity of out.
+ * @return Number of path points (only the first cap are written), 0 if no path.
+ */
+static inline size_t nav_grid_find_path(const nav_grid* g, nav_scratch* s, vec2 start, vec2 goal,
+                                        bool smooth, vec2* out, size_t cap)
+{
+    const uint32_t a = nav_grid_node_at(g, start), b = nav_grid_node_at(g, goal);
+    if (a == NAV_NONE || b == NAV_NONE || s->nodes != (size_t)g->w * g->h) return 0;
+    nav_begin_query(s);
+    s->stamp[a] = s->gen;
+    s->g[a] = 0.0f;
+    s->parent[a] = NAV_NONE;
+    if (!nav_heap_push(s, nav_octile(g, a, b), 0.0f, a)) return 0;
+
+    static const int dx[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+    static const int dy[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+    bool found = false;
+    while (s->heap_len) {
+        const nav_heap_entry e = nav_heap_pop(s);
+        if (s->stamp[e.node] != s->gen || e.g > s->g[e.node]) continue; // stale or closed
+        if (e.node == b) { found = true; break; }
+        s->stamp[e.node] = s->gen + 1;
+        const int x = (int)(e.node % (uint32_t)g->w), y = (int)(e.node / (uint32_t)g->w);
+        for (int k = 0; k < 8; ++k) {
+            const int nx = x + dx[k], ny = y + dy[k];
+            if (!nav_grid_free_cell(g, nx, ny)) continue;
+            if (k >= 4 && (!nav_grid_free_cell(g, nx, y) || !nav_grid_free_cell(g, x, ny))) continue;
+            const uint32_t to = (uint32_t)((size_t)ny * g->w + nx);
+            const float step = (k < 4 ? 1.0f : NAV_SQRT2) * g->cell;
+            if (!nav_relax(s, e.node, to, e.g + step, nav_octile(g, to, b))) return 0;
+        }
+    }
+    if (!found) return 0;
+
+    size_t n = nav_build_chain(s, b);
+    if (!smooth) {
+        // Start, the centers of the cells in between, goal.
+        const size_t total = n < 2 ? 2 : n;
+        for (size_t i = 0; i < total && i < cap; ++i)
+            out[i] = i == 0 ? start : i == total - 1 ? goal : nav_grid_center(g, s->chain[i]);
+        return total;
+    }
+
+    // Split diagonal steps through a free orthogonal neighbor (both are free:
+    // no corner cutting), so consecutive cells share an edge.
+    for (size_t i = n; i-- > 1;) {
+        const uint32_t p = s->chain[i - 1], c = s->chain[i];
+        if (p % (uint32_t)g->w != c % (uint32_t)g->w && p / (uint32_t)g->w != c / (uint32_t)g->w) {
+            memmove(&s->chain[i + 1], &s->chain[i], (n - i) * sizeof(uint32_t));
+            s->chain[i] = (p / (uint32_t)g->w) * (uint32_t)g->w + c % (uint32_t)g->w;
+            n++;
+        }
+    }
+    size_t np = 0;
+    s->portals[np++] = (nav_portal){ start, start };
+    for (size_t i = 0; i + 1 < n; ++i) {
+        vec2 c0 = nav_grid_center(g, s->chain[i]), c1 = nav_grid_center(g, s->chain[i + 1]);
+        vec2 mid = { (c0.x + c1.x) * 0.5f, (c0.y + c1.y) * 0.5f };
+        vec2 dir = vec2_sub(&c1, &c0);
+        vec2 half = vec2_rot90_ccw(&dir); // perpendicular, one cell long
+        half = vec2_mul(&half, 0.5f);
+        s->portals[np++] = (nav_portal){ vec2_add(&mid, &half), vec2_sub(&mid, &half) };
+    }
+    s->portals[np++] = (nav_portal){ goal, goal };
+    return nav_funnel(s->portals, np, out, cap);
+}
+
+// ------------------------------ Navmesh --------------------------------------
+
+typedef struct {
+    uint64_t key;   // (min vertex << 32) | max vertex
+    uint32_t half;  // triangle * 3 + edge
+} nav_edge;
+
+static inline int nav_edge_cmp(const void* a, const void* b)
+{
+    const uint64_t x = ((const nav_edge*)a)->key, y = ((const nav_edge*)b)->key;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Build triangle adjacency and centroids for a navmesh.
+ *
+ * @param m         Mesh (free with nav_mesh_free).
+ * @param verts     Vertices (must outlive the mesh).
+ * @param tris      3 indices per triangle, counter-clockwise (must outlive the mesh).
+ * @param tri_count Number of triangles (< 2^30).
+ * @return false on allocation failure or invalid input.
+ */
+static inline bool nav_mesh_init(nav_mesh* m, const vec2* verts, const uint32_t* tris, size_t tri_count)
+{
+    memset(m, 0, sizeof(*m));
+    if (tri_count == 0 || tri_count >= (1u << 30)) return false;
+    m->verts = verts;
+    m->tris = tris;
+    m->tri_count = tri_count;
+    m->adj = (int32_t*)malloc(tri_count * 3 * sizeof(int32_t));
+    m->centroid = (vec2*)malloc(tri_count * sizeof(vec2));
+    nav_edge* e = (nav_edge*)malloc(tri_count * 3 * sizeof(nav_edge));
+    if (!m->adj || !m->centroid || !e) {
+        free(e); free(m->adj); free(m->centroid);
+        memset(m, 0, sizeof(*m));
+        return false;
+    }
+    for (size_t t = 0; t < tri_count; ++t) {
+        const vec2 a = verts[tris[3 * t]], b = verts[tris[3 * t + 1]], c = verts[tris[3 * t + 2]];
+        m->centroid[t] = (vec2){ (a.x + b.x + c.x) / 3.0f, (a.y + b.y + c.y) / 3.0f };
+        for (int k = 0; k < 3; ++k) {
+            const uint64_t u = tris[3 * t + k], v = tris[3 * t + (k + 1) % 3];
+            e[3 * t + k].key = u < v ? (u << 32) | v : (v << 32) | u;
+            e[3 * t + k].half = (uint32_t)(3 * t + k);
+            m->adj[3 * t + k] = -1;
+        }
+    }
+    qsort(e, tri_count * 3, sizeof(nav_edge), nav_edge_cmp);
+    for (size_t i = 0; i + 1 < tri_count * 3; ++i) {
+        if (e[i].key != e[i + 1].key) continue;
+        m->adj[e[i].half] = (int32_t)(e[i + 1].half / 3);
+        m->adj[e[i + 1].half] = (int32_t)(e[i].half / 3);
+        i++; // an edge is shared by at most two triangles
+    }
+    free(e);
+    return true;
+}
+
+static inline void nav_mesh_free(nav_mesh* m)
+{
+    free(m->adj);
+    free(m->centroid);
+    memset(m, 0, sizeof(*m));
+}
+
+/**
+ * @brief Triangle containing p (boundary inclusive), or NAV_NONE; linear scan.
+ */
+static inline uint32_t nav_mesh_locate(const nav_mesh* m, vec2 p)
+{
+    for (size_t t = 0; t < m->tri_count; ++t) {
+        const vec2 a = m->verts[m->tris[3 * t]], b = m->verts[m->tris[3 * t + 1]], c = m->verts[m->tris[3 * t + 2]];
+        if (nav_side(a, b, p) >= 0.0f && nav_side(b, c, p) >= 0.0f && nav_side(c, a, p) >= 0.0f)
+            return (uint32_t)t;
+    }
+    return NAV_NONE;
+}
+
+/**
+ * @brief A* over navmesh triangles (centroid distances), optionally smoothed.
+ *
+ * @param m      Mesh.
+ * @param s      Scratch built with nav_scratch_init(s, tri_count).
+ * @param start  Start point (inside the mesh).
+ * @param goal   Goal point (inside the mesh).
+ * @param smooth Funnel through the shared edges; otherwise edge midpoints.
+ * @param out    Output path, start and goal included.
+ * @param cap    Capacity of out.
+ * @return Number of path points (only the first cap are written), 0 if no path.
+ */
+static inline size_t nav_mesh_find_path(const nav_mesh* m, nav_scratch* s, vec2 start, vec2 goal,
+                                        bool smooth, vec2* out, size_t cap)
+{
+    const uint32_t a = nav_mesh_locate(m, start), b = nav_mesh_locate(m, goal);
+    if (a == NAV_NONE || b == NAV_NONE || s->nodes != m->tri_count) return 0;
+    nav_begin_query(s);
+    s->stamp[a] = s->gen;
+    s->g[a] = 0.0f;
+    s->parent[a] = NAV_NONE;
+    vec2 cb = m->centroid[b];
+    if (!nav_heap_push(s, vec2_dist(&m->centroid[a], &cb), 0.0f, a)) return 0;
+
+    bool found = false;
+    while (s->heap_len) {
+        const nav_heap_entry e = nav_heap_pop(s);
+        if (s->stamp[e.node] != s->gen || e.g > s->g[e.node]) continue;
+        if (e.node == b) { found = true; break; }
+        s->stamp[e.node] = s->gen + 1;
+        vec2 c = m->centroid[e.node];
+        for (int k = 0; k < 3; ++k) {
+            const int32_t nb = m->adj[3 * e.node + k];
+            if (nb < 0) continue;
+            vec2 cn = m->centroid[nb];
+            if (!nav_relax(s, e.node, (uint32_t)nb, e.g + vec2_dist(&c, &cn), vec2_dist(&cn, &cb))) return 0;
+        }
+    }
+    if (!found) return 0;
+
+    const size_t n = nav_build_chain(s, b);
+    size_t np = 0;
+    s->portals[np++] = (nav_portal){ start, start };
+    for (size_t i = 0; i + 1 < n; ++i) {
+        const uint32_t t = s->chain[i], u = s->chain[i + 1];
+        int k = 0;
+        while (k < 2 && m->adj[3 * t + k] != (int32_t)u) k++;
+        const vec2 v0 = m->verts[m->tris[3 * t + k]], v1 = m->verts[m->tris[3 * t + (k + 1) % 3]];
+        // Leaving a counter-clockwise triangle through (v0, v1): v1 is on the left.
+        s->portals[np++] = (nav_portal){ v1, v0 };
+    }
+    s->portals[np++] = (nav_portal){ goal, goal };
+    if (smooth) return nav_funnel(s->portals, np, out, cap);
+
+    for (size_t i = 0; i < np && i < cap; ++i)
+        out[i] = (vec2){ (s->portals[i].left.x + s->portals[i].right.x) * 0.5f,
+                         (s->portals[i].left.y + s->portals[i].right.y) * 0.5f };
+    return np;
+}
+
+// ------------------------------ Batch ----------------------------------------
+
+typedef struct {
+    const nav_grid*    grid;     // exactly one of grid / mesh
+    const nav_mesh*    mesh;
+    const nav_request* req;
+    bool               smooth;
+    vec2*              out;      // cap points per request
+    size_t             cap;
+    size_t*            count;
+    nav_scratch*       scratch;  // one per worker
+    bool               failed[PARALLEL_MAX_WORKERS];
+} nav_batch_job;
+
+static inline void nav_batch_range(void* user, size_t begin, size_t end, int worker)
+{
+    nav_batch_job* j = (nav_batch_job*)user;
+    nav_scratch* s = &j->scratch[worker];
+    if (!s->g) {
+        // Lazily sized so idle workers allocate nothing.
+        const size_t nodes = j->grid ? (size_t)j->grid->w * j->grid->h : j->mesh->tri_count;
+        if (!nav_scratch_init(s, nodes)) { j->failed[worker] = true; }
+    }
+    for (size_t i = begin; i < end; ++i) {
+        if (!s->g) { j->count[i] = 0; continue; }
+        vec2* o = j->out + i * j->cap;
+        j->count[i] = j->grid
+            ? nav_grid_find_path(j->grid, s, j->req[i].start, j->req[i].goal, j->smooth, o, j->cap)
+            : nav_mesh_find_path(j->mesh, s, j->req[i].start, j->req[i].goal, j->smooth, o, j->cap);
+    }
+}
+
+static inline bool nav_batch_run(nav_batch_job* j, size_t n)
+{
+    const int workers = parallel_worker_count();
+    j->scratch = (nav_scratch*)calloc((size_t)workers, sizeof(nav_scratch));
+    if (!j->scratch) return false;
+    parallel_for(n, 4, nav_batch_range, j);
+    bool ok = true;
+    for (int w = 0; w < workers; ++w) {
+        ok = ok && !j->failed[w];
+        nav_scratch_free(&j->scratch[w]);
+    }
+    free(j->scratch);
+    return ok;
+}
+
+/**
+ * @brief Service many grid path requests on all workers.
+ *
+ * @param g      Grid.
+ * @param req    Requests.
+ * @param n      Number of requests.
+ * @param smooth Funnel-smooth the paths.
+ * @param out    n * cap points; path i starts at out + i * cap.
+ * @param cap    Points reserved per path.
+ * @param count  Output: point count per path (0: no path; > cap: truncated).
+ * @return false on allocation failure.
+ */
+static inline bool nav_grid_batch(const nav_grid* g, const nav_request* req, size_t n, bool smooth,
+                                  vec2* out, size_t cap, size_t* count)
+{
+    nav_batch_job j;
+    memset(&j, 0, sizeof(j));
+    j.grid = g; j.req = req; j.smooth = smooth; j.out = out; j.cap = cap; j.count = count;
+    return nav_batch_run(&j, n);
+}
+
+/**
+ * @brief Service many navmesh path requests on all workers (see nav_grid_batch).
+ */
+static inline bool nav_mesh_batch(const nav_mesh* m, const nav_request* req, size_t n, bool smooth,
+                                  vec2* out, size_t cap, size_t* count)
+{
+    nav_batch_job j;
+    memset(&j, 0, sizeof(j));
+    j.mesh = m; j.req = req; j.smooth = smooth; j.out = out; j.cap = cap; j.count = count;
+    return nav_batch_run(&j, n);
+}
+
+#endif // NAV_H
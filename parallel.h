@@ -0,0 +1,216 @@
+﻿//
+// parallel.h — minimal fork/join parallel-for over Win32 threads or pthreads.
+//
+// Work is split into chunks of `grain` items that workers pull from a shared
+// atomic counter, so uneven chunks (screen tiles, row bands) balance on their
+// own. The calling thread always participates as worker 0.
+//
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "profile.h"
+
+#define PARALLEL_MAX_WORKERS 64
+
+/**
+ * @brief Range callback for parallel_for.
+ *
+ * @param user   Opaque pointer passed through from parallel_for.
+ * @param begin  First item index of the chunk.
+ * @param end    One past the last item index of the chunk.
+ * @param worker Worker index in [0, parallel_worker_count()), stable for the
+ *               whole call; use it to index per-thread scratch memory.
+ */
+typedef void (*parallel_fn)(void* user, size_t begin, size_t end, int worker);
+
+typedef struct {
+    const char*     zone;   // profiling zone name
+    parallel_fn     fn;
+    void*           user;
+    size_t          count;
+    size_t          grain;
+    volatile size_t next;
+} parallel_job;
+
+typedef struct {
+    parallel_job* job;
+    int           worker;
+} parallel_arg;
+
+static int g_parallel_workers = 0; // 0 = auto-detect
+
+static inline size_t parallel_atomic_add(volatile size_t* p, size_t v)
+{
+#ifdef _MSC_VER
+#ifdef _WIN64
+    return (size_t)InterlockedExchangeAdd64((volatile LONG64*)p, (LONG64)v);
+#else
+    return (size_t)InterlockedExchangeAdd((volatile LONG*)p, (LONG)v);
+#endif
+#else
+    return __atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+#endif
+}
+
+/**
+ * @brief Override the number of workers used by parallel_for.
+ *
+ * @param n Worker count; 0 restores auto-detection (one per logical CPU).
+ */
+static inline void parallel_set_worker_count(int n)
+{
+    if (n < 0) n = 0;
+    if (n > PARALLEL_MAX_WORKERS) n = PARALLEL_MAX_WORKERS;
+    g_parallel_workers = n;
+}
+
+/**
+ * @brief Number of workers parallel_for may use (including the caller).
+ *
+ * @return Worker count in [1, PARALLEL_MAX_WORKERS].
+ */
+static inline int parallel_worker_count(void)
+{
+    if (g_parallel_workers > 0) return g_parallel_workers;
+    int n;
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    n = (int)si.dwNumberOfProcessors;
+#else
+    n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (n < 1) n = 1;
+    if (n > PARALLEL_MAX_WORKERS) n = PARALLEL_MAX_WORKERS;
+    return n;
+}
+
+static inline void parallel_run_worker(parallel_job* job, int worker)
+{
+    for (;;) {
+        size_t begin = parallel_atomic_add(&job->next, job->grain);
+        if (begin >= job->count) break;
+        size_t end = begin + job->grain;
+        if (end > job->count) end = job->count;
+        job->fn(job->user, begin, end, worker);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI parallel_thread_main(LPVOID p)
+{
+    parallel_arg* a = (parallel_arg*)p;
+    PROFILE_BEGIN(a->job->zone);
+    parallel_run_worker(a->job, a->worker);
+    PROFILE_END();
+    PROFILE_THREAD_EXIT();
+    return 0;
+}
+#else
+static inline void* parallel_thread_main(void* p)
+{
+    parallel_arg* a = (parallel_arg*)p;
+    PROFILE_BEGIN(a->job->zone);
+    parallel_run_worker(a->job, a->worker);
+    PROFILE_END();
+    PROFILE_THREAD_EXIT();
+    return NULL;
+}
+#endif
+
+/**
+ * @brief parallel_for recorded as the profiling zone `zone`.
+ *
+ * The calling thread records the whole call, every helper thread the part it
+ * worked on. With PROFILE_ENABLED, parallel_for itself expands to this with
+ * the name of the callback as zone.
+ *
+ * @param zone  Zone name (string literal).
+ * @param count Number of items.
+ * @param grain Items per chunk (0 is treated as 1).
+ * @param fn    Range callback.
+ * @param user  Opaque pointer passed to fn.
+ */
+static inline void parallel_for_named(const char* zone, size_t count, size_t grain, parallel_fn fn,
+                                      void* user)
+{
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+
+    PROFILE_BEGIN(zone);
+    parallel_job job = { zone, fn, user, count, grain, 0 };
+    size_t chunks = (count + grain - 1) / grain;
+    int workers = parallel_worker_count();
+    if ((size_t)workers > chunks) workers = (int)chunks;
+
+    if (workers <= 1) {
+        fn(user, 0, count, 0);
+        PROFILE_END();
+        return;
+    }
+
+    parallel_arg args[PARALLEL_MAX_WORKERS];
+#ifdef _WIN32
+    HANDLE threads[PARALLEL_MAX_WORKERS];
+#else
+    pthread_t threads[PARALLEL_MAX_WORKERS];
+#endif
+    int started = 0;
+    for (int w = 1; w < workers; ++w) {
+        args[w].job = &job;
+        args[w].worker = w;
+#ifdef _WIN32
+        threads[started] = CreateThread(NULL, 0, parallel_thread_main, &args[w], 0, NULL);
+        if (!threads[started]) break;
+#else
+        if (pthread_create(&threads[started], NULL, parallel_thread_main, &args[w]) != 0) break;
+#endif
+        started++;
+    }
+
+    parallel_run_worker(&job, 0);
+
+    for (int i = 0; i < started; ++i) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+    PROFILE_END();
+}
+
+/**
+ * @brief Run fn over [0, count) in chunks of `grain` items on all workers.
+ *
+ * Blocks until every chunk has been processed. Falls back to running inline
+ * when there is only one chunk or threads cannot be created.
+ *
+ * @param count Number of items.
+ * @param grain Items per chunk (0 is treated as 1).
+ * @param fn    Range callback.
+ * @param user  Opaque pointer passed to fn.
+ */
+static inline void parallel_for(size_t count, size_t grain, parallel_fn fn, void* user)
+{
+    parallel_for_named("parallel_for", count, grain, fn, user);
+}
+
+#ifdef PROFILE_ENABLED
+// Name every kernel's zone after its range callback.
+#define parallel_for(count, grain, fn, user) parallel_for_named(#fn, count, grain, fn, user)
+#endif
+
+#endif // PARALLEL_H
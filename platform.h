@@ -0,0 +1,70 @@
+﻿//
+// platform.h — window, input and presentation backends for the viewer.
+//
+// A backend opens one window, owns the framebuffer the viewer renders into,
+// and turns native input into viewer_event values with Win32 semantics
+// (client coordinates, wheel deltas in multiples of 120, key codes as Win32
+// virtual keys), so viewer_core.h and recordings behave the same everywhere.
+//
+// Backends: platform_win32.c (GDI, SetDIBitsToDevice) and platform_x11.c
+// (Xlib; with MIT-SHM the X server reads the framebuffer straight from
+// shared memory, otherwise XPutImage sends it over the socket).
+//
+// The backend resizes its framebuffer before it reports VIEWER_EV_RESIZE; if
+// the resize fails the event is dropped and the old size stays valid.
+// Resizes that arrive together may be reported as one, with the final size.
+//
+
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdbool.h>
+
+#include "raster.h"
+#include "viewer_core.h"
+
+typedef enum {
+    PLATFORM_EV_INPUT,  // `input` is valid
+    PLATFORM_EV_PAINT,  // window contents were lost; present again
+    PLATFORM_EV_CLOSE,
+} platform_event_type;
+
+typedef struct {
+    platform_event_type type;
+    viewer_event        input;
+} platform_event;
+
+typedef struct platform_window platform_window;
+
+/**
+ * @brief Open a window with a client area of width x height.
+ *
+ * @return NULL if the window system is unavailable.
+ */
+platform_window* platform_open(const char* title, int width, int height);
+
+/**
+ * @brief Next event.
+ *
+ * @param wait Block until an event arrives.
+ * @return false if there is none (only when !wait).
+ */
+bool platform_poll(platform_window* w, platform_event* e, bool wait);
+
+/**
+ * @brief Framebuffer to render the next frame into.
+ *
+ * Waits until the window system has finished reading the previous frame
+ * from it, so the pointer is only valid until the next platform_poll or
+ * platform_present.
+ */
+framebuffer* platform_framebuffer(platform_window* w);
+
+/**
+ * @brief Show the framebuffer.
+ */
+void platform_present(platform_window* w);
+
+void platform_close(platform_window* w);
+
+#endif // PLATFORM_H
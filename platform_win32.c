@@ -0,0 +1,224 @@
+﻿// platform_win32.c — Win32 backend of platform.h.
+//
+// WndProc turns messages into platform events in a small queue that
+// platform_poll drains, pumping messages while it is empty. The modal
+// move/size loop dispatches messages without platform_poll returning, so
+// the queue coalesces: a resize and a close are kept as pending state that
+// platform_poll reports first, and repeated paints and mouse moves merge
+// into the last queued entry. The framebuffer
+// is plain memory presented with SetDIBitsToDevice, which has copied it by
+// the time it returns.
+
+#include <windows.h>
+#include <windowsx.h> // GET_X_LPARAM, GET_Y_LPARAM, GET_WHEEL_DELTA_WPARAM
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifndef GET_X_LPARAM
+#define GET_X_LPARAM(lp)  ((int)(short)LOWORD(lp))
+#endif
+#ifndef GET_Y_LPARAM
+#define GET_Y_LPARAM(lp)  ((int)(short)HIWORD(lp))
+#endif
+#ifndef GET_WHEEL_DELTA_WPARAM
+#define GET_WHEEL_DELTA_WPARAM(wp) ((short)HIWORD(wp))
+#endif
+
+#define PLATFORM_QUEUE 256
+
+struct platform_window {
+    HWND           hwnd;
+    framebuffer    fb;
+    platform_event queue[PLATFORM_QUEUE];
+    size_t         head, count;
+    int            resize_w, resize_h;  // last WM_SIZE not yet reported
+    bool           resize_pending, close_pending;
+};
+
+// WndProc has no user pointer to go through; there is one window.
+static platform_window* g_window = NULL;
+
+static void push_event(platform_event_type type, viewer_event_type input, int x, int y, int value) {
+    platform_window* w = g_window;
+    if (!w) return;
+    if (w->count) {
+        platform_event* last = &w->queue[(w->head + w->count - 1) % PLATFORM_QUEUE];
+        if (type == PLATFORM_EV_PAINT && last->type == PLATFORM_EV_PAINT) return;
+        if (type == PLATFORM_EV_INPUT && input == VIEWER_EV_MOUSE_MOVE
+            && last->type == PLATFORM_EV_INPUT && last->input.type == VIEWER_EV_MOUSE_MOVE) {
+            last->input.x = x;
+            last->input.y = y;
+            return;
+        }
+    }
+    if (w->count == PLATFORM_QUEUE) return; // only discrete input is left to lose
+    platform_event* e = &w->queue[(w->head + w->count++) % PLATFORM_QUEUE];
+    e->type = type;
+    e->input = (viewer_event){ input, x, y, value };
+}
+
+static void push_input(viewer_event_type type, int x, int y, int value) {
+    push_event(PLATFORM_EV_INPUT, type, x, y, value);
+}
+
+// ------------------------------ Window proc ----------------------------------
+
+LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    switch (msg) {
+    case WM_SIZE: {
+        int w = LOWORD(lParam), h = HIWORD(lParam);
+        if (g_window && w > 0 && h > 0 && fb_resize(&g_window->fb, w, h)) {
+            g_window->resize_w = w;
+            g_window->resize_h = h;
+            g_window->resize_pending = true;
+        }
+        return 0;
+    }
+
+    case WM_LBUTTONDOWN:
+        push_input(VIEWER_EV_LBUTTON_DOWN, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), 0);
+        return 0;
+
+    case WM_RBUTTONDOWN:
+        SetCapture(hWnd);
+        push_input(VIEWER_EV_RBUTTON_DOWN, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), 0);
+        return 0;
+
+    case WM_MOUSEMOVE:
+        push_input(VIEWER_EV_MOUSE_MOVE, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), 0);
+        return 0;
+
+    case WM_RBUTTONUP:
+        ReleaseCapture();
+        push_input(VIEWER_EV_RBUTTON_UP, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), 0);
+        return 0;
+
+    case WM_MOUSEWHEEL: {
+        short delta = GET_WHEEL_DELTA_WPARAM(wParam);
+        POINT scr = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
+        ScreenToClient(hWnd, &scr);
+        push_input(VIEWER_EV_WHEEL, scr.x, scr.y, delta);
+        return 0;
+    }
+
+    case WM_KEYDOWN:
+        push_input(VIEWER_EV_KEY, 0, 0, (int)wParam);
+        return 0;
+
+    case WM_PAINT: {
+        PAINTSTRUCT ps;
+        BeginPaint(hWnd, &ps);
+        EndPaint(hWnd, &ps);
+        push_event(PLATFORM_EV_PAINT, VIEWER_EV_COUNT, 0, 0, 0);
+        return 0;
+    }
+
+    case WM_CLOSE:
+        if (g_window) g_window->close_pending = true;
+        return 0;
+    }
+    return DefWindowProc(hWnd, msg, wParam, lParam);
+}
+
+// ------------------------------ platform.h -----------------------------------
+
+platform_window* platform_open(const char* title, int width, int height) {
+    if (g_window) return NULL;
+    platform_window* w = (platform_window*)calloc(1, sizeof(platform_window));
+    if (!w || !fb_init(&w->fb, width, height)) {
+        free(w);
+        return NULL;
+    }
+    g_window = w;
+
+    HINSTANCE hInstance = GetModuleHandleA(NULL);
+    WNDCLASSA wc = {0};
+    wc.style         = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
+    wc.lpfnWndProc   = WndProc;
+    wc.hInstance     = hInstance;
+    wc.hCursor       = LoadCursor(NULL, IDC_ARROW);
+    wc.hbrBackground = (HBRUSH)(COLOR_WINDOW+1);
+    wc.lpszClassName = "VecViewerWin32";
+    RegisterClassA(&wc);
+
+    DWORD style = WS_OVERLAPPEDWINDOW;
+    RECT r = {0, 0, width, height};
+    AdjustWindowRect(&r, style, FALSE);
+
+    w->hwnd = CreateWindowA(
+        wc.lpszClassName, title,
+        style,
+        CW_USEDEFAULT, CW_USEDEFAULT,
+        r.right - r.left, r.bottom - r.top,
+        NULL, NULL, hInstance, NULL
+    );
+    if (!w->hwnd) {
+        platform_close(w);
+        return NULL;
+    }
+    ShowWindow(w->hwnd, SW_SHOWDEFAULT);
+    UpdateWindow(w->hwnd);
+    return w;
+}
+
+bool platform_poll(platform_window* w, platform_event* e, bool wait) {
+    while (!w->count && !w->resize_pending && !w->close_pending) {
+        MSG msg;
+        if (wait) {
+            if (GetMessage(&msg, NULL, 0, 0) <= 0) {
+                w->close_pending = true;
+                break;
+            }
+        } else if (!PeekMessageA(&msg, NULL, 0, 0, PM_REMOVE)) {
+            return false;
+        }
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+    if (w->close_pending) {
+        w->close_pending = false;
+        e->type = PLATFORM_EV_CLOSE;
+        e->input = (viewer_event){ VIEWER_EV_COUNT, 0, 0, 0 };
+        return true;
+    }
+    if (w->resize_pending) {
+        w->resize_pending = false;
+        e->type = PLATFORM_EV_INPUT;
+        e->input = (viewer_event){ VIEWER_EV_RESIZE, w->resize_w, w->resize_h, 0 };
+        return true;
+    }
+    *e = w->queue[w->head];
+    w->head = (w->head + 1) % PLATFORM_QUEUE;
+    w->count--;
+    return true;
+}
+
+framebuffer* platform_framebuffer(platform_window* w) {
+    return &w->fb;
+}
+
+void platform_present(platform_window* w) {
+    BITMAPINFO bmi;
+    memset(&bmi, 0, sizeof(bmi));
+    bmi.bmiHeader.biSize        = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth       = w->fb.stride;
+    bmi.bmiHeader.biHeight      = -w->fb.height; // top-down, like the framebuffer
+    bmi.bmiHeader.biPlanes      = 1;
+    bmi.bmiHeader.biBitCount    = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    HDC hdc = GetDC(w->hwnd); // CS_OWNDC: the window's own DC, nothing to release
+    SetDIBitsToDevice(hdc, 0, 0, (DWORD)w->fb.width, (DWORD)w->fb.height, 0, 0, 0, (UINT)w->fb.height,
+                      w->fb.pixels, &bmi, DIB_RGB_COLORS);
+}
+
+void platform_close(platform_window* w) {
+    if (!w) return;
+    if (w->hwnd) DestroyWindow(w->hwnd);
+    fb_free(&w->fb);
+    if (g_window == w) g_window = NULL;
+    free(w);
+}
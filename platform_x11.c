@@ -0,0 +1,339 @@
+﻿// platform_x11.c — Xlib backend of platform.h.
+//
+// With the MIT-SHM extension the framebuffer lives in a shared memory segment
+// that is also the XImage data: the viewer renders into it and XShmPutImage
+// has the server read it from there, with no copy on the client. The server
+// reads asynchronously, so the next frame waits for its ShmCompletion event
+// (platform_framebuffer) before drawing over the pixels. Without MIT-SHM
+// (remote displays) the framebuffer is an ordinary XImage sent with
+// XPutImage.
+//
+// Input is translated to Win32 semantics, as WndProc in platform_win32.c
+// reports it: buttons 1 and 3 are the left and right button (the server's
+// implicit grab while a button is held does what SetCapture does there),
+// buttons 4 and 5 are wheel steps of +-120, and keys are reported as Win32
+// virtual-key codes of the unshifted keysym.
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.h"
+
+struct platform_window {
+    Display*        dpy;
+    Window          win;
+    Visual*         visual;
+    int             depth;
+    GC              gc;
+    Atom            wm_delete;
+    bool            use_shm;
+    int             shm_completion;  // event type of ShmCompletion
+    bool            shm_pending;     // the server may still read the pixels
+    XImage*         image;
+    XShmSegmentInfo shm;
+    framebuffer     fb;              // pixels are image->data
+};
+
+// ------------------------------ Input mapping --------------------------------
+
+// Win32 virtual-key code of a keysym; 0 for keys the viewer never sees.
+static int x11_key_to_vk(KeySym k) {
+    if (k >= XK_a && k <= XK_z) return 'A' + (int)(k - XK_a);
+    if (k >= XK_A && k <= XK_Z) return 'A' + (int)(k - XK_A);
+    if (k >= XK_0 && k <= XK_9) return '0' + (int)(k - XK_0);
+    if (k >= XK_KP_0 && k <= XK_KP_9) return 0x60 + (int)(k - XK_KP_0);  // VK_NUMPAD0..9
+    if (k >= XK_F1 && k <= XK_F12) return 0x70 + (int)(k - XK_F1);       // VK_F1..F12
+    switch (k) {
+    case XK_BackSpace: return 0x08;
+    case XK_Tab:       return 0x09;
+    case XK_Return:
+    case XK_KP_Enter:  return 0x0D;
+    case XK_Shift_L:
+    case XK_Shift_R:   return 0x10;
+    case XK_Control_L:
+    case XK_Control_R: return 0x11;
+    case XK_Alt_L:
+    case XK_Alt_R:     return 0x12;
+    case XK_Escape:    return 0x1B;
+    case XK_space:     return 0x20;
+    case XK_Prior:     return 0x21;
+    case XK_Next:      return 0x22;
+    case XK_End:       return 0x23;
+    case XK_Home:      return 0x24;
+    case XK_Left:      return 0x25;
+    case XK_Up:        return 0x26;
+    case XK_Right:     return 0x27;
+    case XK_Down:      return 0x28;
+    case XK_Insert:    return 0x2D;
+    case XK_Delete:
+    case XK_KP_Delete: return VIEWER_KEY_DELETE;
+    default:           return 0;
+    }
+}
+
+// Button and key events in viewer terms; false for events the viewer ignores.
+// `keysym` is the unshifted keysym of a KeyPress.
+static bool x11_translate_input(const XEvent* ev, KeySym keysym, viewer_event* out) {
+    switch (ev->type) {
+    case ButtonPress:
+        out->x = ev->xbutton.x;
+        out->y = ev->xbutton.y;
+        out->value = 0;
+        switch (ev->xbutton.button) {
+        case Button1: out->type = VIEWER_EV_LBUTTON_DOWN; return true;
+        case Button3: out->type = VIEWER_EV_RBUTTON_DOWN; return true;
+        case Button4: out->type = VIEWER_EV_WHEEL; out->value = 120; return true;
+        case Button5: out->type = VIEWER_EV_WHEEL; out->value = -120; return true;
+        default:      return false;
+        }
+    case ButtonRelease:
+        if (ev->xbutton.button != Button3) return false;
+        *out = (viewer_event){ VIEWER_EV_RBUTTON_UP, ev->xbutton.x, ev->xbutton.y, 0 };
+        return true;
+    case MotionNotify:
+        *out = (viewer_event){ VIEWER_EV_MOUSE_MOVE, ev->xmotion.x, ev->xmotion.y, 0 };
+        return true;
+    case KeyPress: {
+        const int vk = x11_key_to_vk(keysym);
+        if (!vk) return false;
+        *out = (viewer_event){ VIEWER_EV_KEY, 0, 0, vk };
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// ------------------------------ Images ---------------------------------------
+
+static bool g_x11_error = false;
+
+static int x11_error_handler(Display* dpy, XErrorEvent* e) {
+    (void)dpy; (void)e;
+    g_x11_error = true;
+    return 0;
+}
+
+static bool x11_host_lsb(void) {
+    const uint32_t one = 1;
+    return *(const unsigned char*)&one == 1;
+}
+
+static void x11_destroy_image(platform_window* w, XImage* image, XShmSegmentInfo* shm) {
+    if (!image) return;
+    if (shm->shmaddr) {
+        XShmDetach(w->dpy, shm);
+        XSync(w->dpy, False);
+        image->data = NULL;  // not malloc'd; XDestroyImage would free it
+        shmdt(shm->shmaddr);
+        shm->shmaddr = NULL;
+    }
+    XDestroyImage(image);
+}
+
+// A width x height image whose rows are framebuffer rows (32-bit 0x00RRGGBB).
+static XImage* x11_create_image(platform_window* w, int width, int height, XShmSegmentInfo* shm) {
+    memset(shm, 0, sizeof(*shm));
+    shm->shmid = -1;
+    if (w->use_shm) {
+        XImage* image = XShmCreateImage(w->dpy, w->visual, (unsigned)w->depth, ZPixmap, NULL, shm,
+                                        (unsigned)width, (unsigned)height);
+        if (image && image->bits_per_pixel == 32) {
+            shm->shmid = shmget(IPC_PRIVATE, (size_t)image->bytes_per_line * (size_t)height, IPC_CREAT | 0600);
+            void* addr = shm->shmid >= 0 ? shmat(shm->shmid, NULL, 0) : (void*)-1;
+            if (addr != (void*)-1) {
+                shm->shmaddr = image->data = (char*)addr;
+                shm->readOnly = False;
+                g_x11_error = false;
+                XErrorHandler old = XSetErrorHandler(x11_error_handler);
+                XShmAttach(w->dpy, shm);
+                XSync(w->dpy, False);
+                XSetErrorHandler(old);
+                // Marked for removal now, so it disappears with the last detach.
+                shmctl(shm->shmid, IPC_RMID, NULL);
+                if (!g_x11_error) return image;
+                shmdt(addr);
+                shm->shmaddr = NULL;
+                image->data = NULL;
+            } else if (shm->shmid >= 0) {
+                shmctl(shm->shmid, IPC_RMID, NULL);
+            }
+        }
+        if (image) XDestroyImage(image);
+        // Attaching fails on remote displays even when the extension is listed.
+        w->use_shm = false;
+    }
+
+    const size_t stride = (size_t)width * 4;
+    char* data = (char*)malloc(stride * (size_t)height);
+    if (!data) return NULL;
+    XImage* image = XCreateImage(w->dpy, w->visual, (unsigned)w->depth, ZPixmap, 0, data,
+                                 (unsigned)width, (unsigned)height, 32, (int)stride);
+    if (!image) { free(data); return NULL; }
+    // Our pixels are host-order words; Xlib swaps if the server differs.
+    image->byte_order = x11_host_lsb() ? LSBFirst : MSBFirst;
+    return image;
+}
+
+static Bool x11_is_completion(Display* dpy, XEvent* ev, XPointer arg) {
+    (void)dpy;
+    return ev->type == ((platform_window*)arg)->shm_completion;
+}
+
+// Block until the server has read the last XShmPutImage.
+static void x11_wait_present(platform_window* w) {
+    if (!w->shm_pending) return;
+    XEvent ev;
+    XIfEvent(w->dpy, &ev, x11_is_completion, (XPointer)w);
+    w->shm_pending = false;
+}
+
+static bool x11_resize(platform_window* w, int width, int height) {
+    XShmSegmentInfo shm;
+    x11_wait_present(w);
+    XImage* image = x11_create_image(w, width, height, &shm);
+    if (!image) return false;
+    x11_destroy_image(w, w->image, &w->shm);
+    w->image = image;
+    w->shm = shm;
+    w->fb.pixels = (uint32_t*)image->data;
+    w->fb.width = width;
+    w->fb.height = height;
+    w->fb.stride = image->bytes_per_line / 4;
+    return true;
+}
+
+// ------------------------------ platform.h -----------------------------------
+
+platform_window* platform_open(const char* title, int width, int height) {
+    platform_window* w = (platform_window*)calloc(1, sizeof(platform_window));
+    if (!w) return NULL;
+    w->dpy = XOpenDisplay(NULL);
+    if (!w->dpy) {
+        fprintf(stderr, "cannot open X display (is DISPLAY set?)\n");
+        free(w);
+        return NULL;
+    }
+    const int screen = DefaultScreen(w->dpy);
+    XVisualInfo vi;
+    if (!XMatchVisualInfo(w->dpy, screen, 24, TrueColor, &vi) ||
+        vi.red_mask != 0xFF0000 || vi.green_mask != 0x00FF00 || vi.blue_mask != 0x0000FF) {
+        fprintf(stderr, "no 24-bit TrueColor visual with 0xRRGGBB layout\n");
+        XCloseDisplay(w->dpy);
+        free(w);
+        return NULL;
+    }
+    w->visual = vi.visual;
+    w->depth = vi.depth;
+
+    XSetWindowAttributes attrs;
+    memset(&attrs, 0, sizeof(attrs));
+    attrs.colormap = XCreateColormap(w->dpy, RootWindow(w->dpy, screen), w->visual, AllocNone);
+    attrs.background_pixel = 0;
+    attrs.border_pixel = 0;
+    attrs.event_mask = ExposureMask | KeyPressMask | ButtonPressMask | ButtonReleaseMask | PointerMotionMask |
+                       StructureNotifyMask;
+    w->win = XCreateWindow(w->dpy, RootWindow(w->dpy, screen), 0, 0, (unsigned)width, (unsigned)height, 0,
+                           w->depth, InputOutput, w->visual,
+                           CWColormap | CWBackPixel | CWBorderPixel | CWEventMask, &attrs);
+    XStoreName(w->dpy, w->win, title);
+    w->wm_delete = XInternAtom(w->dpy, "WM_DELETE_WINDOW", False);
+    XSetWMProtocols(w->dpy, w->win, &w->wm_delete, 1);
+    w->gc = XCreateGC(w->dpy, w->win, 0, NULL);
+
+    int major, minor;
+    Bool pixmaps;
+    w->use_shm = XShmQueryVersion(w->dpy, &major, &minor, &pixmaps) && !getenv("JAML_NO_SHM");
+    w->shm_completion = XShmGetEventBase(w->dpy) + ShmCompletion;
+    if (!x11_resize(w, width, height)) {
+        fprintf(stderr, "cannot allocate the framebuffer\n");
+        platform_close(w);
+        return NULL;
+    }
+    XMapWindow(w->dpy, w->win);
+    XFlush(w->dpy);
+    return w;
+}
+
+bool platform_poll(platform_window* w, platform_event* e, bool wait) {
+    for (;;) {
+        if (!wait && !XPending(w->dpy)) return false;
+        XEvent ev;
+        XNextEvent(w->dpy, &ev);
+        if (ev.type == w->shm_completion) {
+            w->shm_pending = false;
+            continue;
+        }
+        switch (ev.type) {
+        case Expose:
+            if (ev.xexpose.count != 0) continue;
+            e->type = PLATFORM_EV_PAINT;
+            return true;
+        case ConfigureNotify: {
+            const int width = ev.xconfigure.width, height = ev.xconfigure.height;
+            if (width <= 0 || height <= 0 || (width == w->fb.width && height == w->fb.height)) continue;
+            if (!x11_resize(w, width, height)) continue;
+            e->type = PLATFORM_EV_INPUT;
+            e->input = (viewer_event){ VIEWER_EV_RESIZE, width, height, 0 };
+            return true;
+        }
+        case ClientMessage:
+            if ((Atom)ev.xclient.data.l[0] != w->wm_delete) continue;
+            e->type = PLATFORM_EV_CLOSE;
+            return true;
+        case DestroyNotify:
+            e->type = PLATFORM_EV_CLOSE;
+            return true;
+        case MotionNotify:
+            // Only the latest position of a run of motion events matters.
+            while (XPending(w->dpy)) {
+                XEvent next;
+                XPeekEvent(w->dpy, &next);
+                if (next.type != MotionNotify) break;
+                XNextEvent(w->dpy, &ev);
+            }
+            break;
+        default:
+            break;
+        }
+        const KeySym keysym = ev.type == KeyPress ? XLookupKeysym(&ev.xkey, 0) : NoSymbol;
+        if (x11_translate_input(&ev, keysym, &e->input)) {
+            e->type = PLATFORM_EV_INPUT;
+            return true;
+        }
+    }
+}
+
+framebuffer* platform_framebuffer(platform_window* w) {
+    x11_wait_present(w);
+    return &w->fb;
+}
+
+void platform_present(platform_window* w) {
+    const unsigned width = (unsigned)w->fb.width, height = (unsigned)w->fb.height;
+    if (w->shm.shmaddr) {
+        XShmPutImage(w->dpy, w->win, w->gc, w->image, 0, 0, 0, 0, width, height, True);
+        w->shm_pending = true;
+    } else {
+        XPutImage(w->dpy, w->win, w->gc, w->image, 0, 0, 0, 0, width, height);
+    }
+    XFlush(w->dpy);
+}
+
+void platform_close(platform_window* w) {
+    if (!w) return;
+    x11_wait_present(w);
+    x11_destroy_image(w, w->image, &w->shm);
+    if (w->gc) XFreeGC(w->dpy, w->gc);
+    XDestroyWindow(w->dpy, w->win);
+    XCloseDisplay(w->dpy);
+    free(w);
+}
@@ -0,0 +1,187 @@
+﻿//
+// polygon.h — area, centroid and second moments of many simple polygons.
+//
+// Polygons are stored as a soup: vertex coordinates SoA (xs, ys) and count + 1
+// offsets, polygon i being vertices [offsets[i], offsets[i + 1]) with an
+// implicit closing edge. All quantities are shoelace sums of cross(p_k, p_k+1)
+// times a per-edge polynomial, taken relative to each polygon's first vertex
+// so distant coordinates (GIS) do not cancel.
+//
+// The kernel runs POLY_LANES polygons side by side, one per lane: step k adds
+// edge k of every lane, lanes whose polygon has fewer edges add zero. The sums
+// are plain floats or, with POLY_ACCUM_COMPENSATED, Neumaier-compensated
+// (twice the adds, error independent of the vertex count). Batch mode splits
+// the polygons across workers.
+//
+
+#ifndef POLYGON_H
+#define POLYGON_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "vector2.h"
+#include "parallel.h"
+
+#define POLY_LANES 8
+#define POLY_SUMS  6
+
+typedef enum {
+    POLY_ACCUM_FLOAT,
+    POLY_ACCUM_COMPENSATED,
+} poly_accum;
+
+typedef struct {
+    const float*    xs;
+    const float*    ys;
+    const uint32_t* offsets;  // count + 1 entries
+    size_t          count;
+} poly_soup;
+
+typedef struct {
+    float area;      // signed: positive for counter-clockwise vertices
+    vec2  centroid;
+    float ixx;       // ∫ y² dA about the centroid
+    float iyy;       // ∫ x² dA about the centroid
+    float ixy;       // ∫ x y dA about the centroid
+} poly_props;
+
+// Shoelace terms of edge a-b (relative coordinates), scaled by c = cross(a, b).
+static inline void poly_edge_terms(vec2 a, vec2 b, float t[POLY_SUMS])
+{
+    const float c = vec2_cross(&a, &b);
+    t[0] = c;
+    t[1] = (a.x + b.x) * c;
+    t[2] = (a.y + b.y) * c;
+    t[3] = (a.x * a.x + a.x * b.x + b.x * b.x) * c;
+    t[4] = (a.y * a.y + a.y * b.y + b.y * b.y) * c;
+    t[5] = (a.x * (2.0f * a.y + b.y) + b.x * (a.y + 2.0f * b.y)) * c;
+}
+
+static inline poly_props poly_finish(const float s[POLY_SUMS], float x0, float y0)
+{
+    poly_props p;
+    p.area = 0.5f * s[0];
+    p.centroid = (vec2){ x0, y0 };
+    p.ixx = p.iyy = p.ixy = 0.0f;
+    if (p.area == 0.0f) return p; // degenerate: no meaningful centroid
+    const float cx = s[1] / (3.0f * s[0]), cy = s[2] / (3.0f * s[0]);
+    p.centroid = (vec2){ x0 + cx, y0 + cy };
+    // Parallel axis theorem from the first vertex to the centroid; moments are
+    // reported positive for either winding.
+    const float sign = p.area < 0.0f ? -1.0f : 1.0f;
+    p.iyy = sign * (s[3] / 12.0f - p.area * cx * cx);
+    p.ixx = sign * (s[4] / 12.0f - p.area * cy * cy);
+    p.ixy = sign * (s[5] / 24.0f - p.area * cx * cy);
+    return p;
+}
+
+/**
+ * @brief Properties of polygons [begin, end) of a soup, POLY_LANES at a time.
+ *
+ * @param soup  Polygons.
+ * @param begin First polygon.
+ * @param end   One past the last polygon.
+ * @param accum Summation mode.
+ * @param out   Properties, indexed by polygon (out[begin .. end)).
+ */
+static inline void poly_props_range(const poly_soup* soup, size_t begin, size_t end, poly_accum accum,
+                                    poly_props* out)
+{
+    const float* xs = soup->xs;
+    const float* ys = soup->ys;
+    for (size_t b = begin; b < end; b += POLY_LANES) {
+        const size_t cnt = end - b < POLY_LANES ? end - b : POLY_LANES;
+        uint32_t first[POLY_LANES], n[POLY_LANES];
+        float x0[POLY_LANES], y0[POLY_LANES];
+        float sum[POLY_SUMS][POLY_LANES], comp[POLY_SUMS][POLY_LANES];
+        uint32_t steps = 0;
+        for (size_t l = 0; l < POLY_LANES; ++l) {
+            const size_t i = b + (l < cnt ? l : 0);
+            first[l] = soup->offsets[i];
+            n[l] = l < cnt ? soup->offsets[i + 1] - first[l] : 0;
+            if (n[l] < 3) n[l] = 0; // no area
+            x0[l] = n[l] ? xs[first[l]] : 0.0f;
+            y0[l] = n[l] ? ys[first[l]] : 0.0f;
+            if (n[l] > steps) steps = n[l];
+            for (int q = 0; q < POLY_SUMS; ++q) sum[q][l] = comp[q][l] = 0.0f;
+        }
+        // Lanes without area still load (and discard) a vertex every step;
+        // point them at one that exists, since first[l] of an empty polygon
+        // at the end of the soup is one past the arrays. With no lane
+        // active, steps < 3 and nothing is loaded.
+        for (size_t l = 0; l < POLY_LANES; ++l) {
+            if (!n[l]) continue;
+            for (size_t e = 0; e < POLY_LANES; ++e) if (!n[e]) first[e] = first[l];
+            break;
+        }
+        // In the frame of vertex 0 the edges touching it have cross = 0, so
+        // only edges (k, k + 1) for k = 1 .. n - 2 contribute.
+        for (uint32_t k = 1; k + 1 < steps; ++k) {
+            float t[POLY_SUMS][POLY_LANES];
+            for (size_t l = 0; l < POLY_LANES; ++l) {
+                const bool active = k + 1 < n[l];
+                const uint32_t i = first[l] + (active ? k : 0);
+                const uint32_t j = first[l] + (active ? k + 1 : 0);
+                vec2 a = { xs[i] - x0[l], ys[i] - y0[l] };
+                vec2 c = { xs[j] - x0[l], ys[j] - y0[l] };
+                float e[POLY_SUMS];
+                poly_edge_terms(a, c, e);
+                for (int q = 0; q < POLY_SUMS; ++q) t[q][l] = active ? e[q] : 0.0f;
+            }
+            if (accum == POLY_ACCUM_COMPENSATED) {
+                for (int q = 0; q < POLY_SUMS; ++q) {
+                    for (size_t l = 0; l < POLY_LANES; ++l) {
+                        const float s = sum[q][l] + t[q][l];
+                        comp[q][l] += fabsf(sum[q][l]) >= fabsf(t[q][l])
+                                    ? (sum[q][l] - s) + t[q][l]
+                                    : (t[q][l] - s) + sum[q][l];
+                        sum[q][l] = s;
+                    }
+                }
+            } else {
+                for (int q = 0; q < POLY_SUMS; ++q)
+                    for (size_t l = 0; l < POLY_LANES; ++l) sum[q][l] += t[q][l];
+            }
+        }
+        for (size_t l = 0; l < cnt; ++l) {
+            float s[POLY_SUMS];
+            for (int q = 0; q < POLY_SUMS; ++q) s[q] = sum[q][l] + comp[q][l];
+            const uint32_t i = soup->offsets[b + l];
+            const bool has_vertex = soup->offsets[b + l + 1] > i;
+            out[b + l] = poly_finish(s, has_vertex ? xs[i] : 0.0f, has_vertex ? ys[i] : 0.0f);
+        }
+    }
+}
+
+typedef struct {
+    const poly_soup* soup;
+    poly_accum       accum;
+    poly_props*      out;
+} poly_batch_job;
+
+static inline void poly_batch_range(void* user, size_t begin, size_t end, int worker)
+{
+    (void)worker;
+    const poly_batch_job* j = (const poly_batch_job*)user;
+    poly_props_range(j->soup, begin, end, j->accum, j->out);
+}
+
+/**
+ * @brief Area, centroid and second moments of every polygon, on all workers.
+ *
+ * Polygons with fewer than 3 vertices get zero area and moments and their
+ * first vertex (or the origin) as centroid.
+ *
+ * @param soup  Polygons.
+ * @param accum Summation mode.
+ * @param out   soup->count properties.
+ */
+static inline void poly_props_batch(const poly_soup* soup, poly_accum accum, poly_props* out)
+{
+    poly_batch_job j = { soup, accum, out };
+    parallel_for(soup->count, 64 * POLY_LANES, poly_batch_range, &j);
+}
+
+#endif // POLYGON_H
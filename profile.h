@@ -0,0 +1,319 @@
+﻿//
+// profile.h — nested profiling zones per thread, exported as Chrome trace JSON.
+//
+// Zones are recorded only when PROFILE_ENABLED is defined (CMake option
+// JAML_PROFILE); otherwise PROFILE_BEGIN / PROFILE_END expand to nothing.
+//
+// Each thread writes begin/end events into its own fixed-size buffer, found
+// through a thread-local pointer, so recording takes no lock and shares no
+// cache line. Buffers live in a global table of PROFILE_MAX_THREADS slots that
+// threads claim with a compare-and-swap; parallel_for workers release their
+// slot on exit and the next worker reuses it, so a slot is a stable timeline
+// row no matter how many short-lived threads ran. When a buffer is full new
+// zones are dropped whole (with their end events), never half.
+//
+// Each thread also keeps the last and total duration of every zone name it
+// closed (up to PROFILE_ZONES names), updated even once its buffer is full,
+// which is what live displays such as the viewer HUD read.
+//
+// profile_write_chrome_trace writes the events as a Chrome trace ("B"/"E"
+// duration events, microseconds), which chrome://tracing and the Perfetto UI
+// open directly. Call it, like profile_reset, while no zone is being recorded.
+//
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "timer.h"
+
+#define PROFILE_MAX_THREADS 128
+#define PROFILE_EVENTS      (1u << 17)  // per thread
+#define PROFILE_ZONES       32          // zone names with statistics, per thread
+#define PROFILE_DEPTH       64          // nesting tracked for statistics
+
+#ifdef _MSC_VER
+#define PROFILE_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILE_THREAD_LOCAL _Thread_local
+#endif
+
+typedef struct {
+    const char* name;   // string literal (only the pointer is stored)
+    double      t_ms;
+    char        phase;  // 'B' or 'E'
+} profile_event;
+
+typedef struct {
+    const char* name;
+    double      last_ms;   // duration of the most recent zone
+    double      total_ms;
+    uint64_t    calls;
+} profile_zone;
+
+typedef struct {
+    volatile long    busy;     // owned by a running thread
+    profile_event*   events;   // PROFILE_EVENTS, allocated on first claim
+    volatile size_t  count;    // published events
+    size_t           open;     // recorded zones not yet ended
+    size_t           dropped;  // open zones that were not recorded
+    const char*      name;
+    size_t           depth;    // open zones, recorded or not
+    const char*      stack_name[PROFILE_DEPTH];
+    double           stack_t[PROFILE_DEPTH];
+    profile_zone     zones[PROFILE_ZONES];
+    size_t           zone_count;
+} profile_thread;
+
+static profile_thread g_profile_threads[PROFILE_MAX_THREADS];
+static volatile long g_profile_slots_used = 0;  // high-water mark of claimed slots
+static PROFILE_THREAD_LOCAL profile_thread* g_profile_self = NULL;
+
+static inline bool profile_atomic_cas(volatile long* p, long expected, long desired)
+{
+#ifdef _MSC_VER
+    return InterlockedCompareExchange(p, desired, expected) == expected;
+#else
+    return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+#endif
+}
+
+static inline void profile_atomic_store(volatile long* p, long v)
+{
+#ifdef _MSC_VER
+    InterlockedExchange(p, v);
+#else
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+#endif
+}
+
+static inline void profile_publish(volatile size_t* p, size_t v)
+{
+#ifdef _MSC_VER
+    MemoryBarrier();
+    *p = v;
+#else
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+#endif
+}
+
+static inline size_t profile_published(const volatile size_t* p)
+{
+#ifdef _MSC_VER
+    const size_t v = *p;
+    MemoryBarrier();
+    return v;
+#else
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#endif
+}
+
+// Slot of the calling thread, claimed on first use; NULL if none is free.
+static inline profile_thread* profile_self(void)
+{
+    if (g_profile_self) return g_profile_self;
+    for (int i = 0; i < PROFILE_MAX_THREADS; ++i) {
+        profile_thread* t = &g_profile_threads[i];
+        if (t->busy || !profile_atomic_cas(&t->busy, 0, 1)) continue;
+        if (!t->events) {
+            t->events = (profile_event*)malloc(PROFILE_EVENTS * sizeof(profile_event));
+            if (!t->events) { profile_atomic_store(&t->busy, 0); return NULL; }
+        }
+        for (long seen = g_profile_slots_used; seen <= i; seen = g_profile_slots_used)
+            profile_atomic_cas(&g_profile_slots_used, seen, i + 1);
+        g_profile_self = t;
+        return t;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Open a zone on the calling thread.
+ *
+ * @param name String literal; shown as the zone name.
+ */
+static inline void profile_begin(const char* name)
+{
+    profile_thread* t = profile_self();
+    if (!t) return;
+    const double now = timer_now_ms();
+    if (t->depth < PROFILE_DEPTH) {
+        t->stack_name[t->depth] = name;
+        t->stack_t[t->depth] = now;
+    }
+    t->depth++;
+    // Keep room for the end events of every open zone.
+    if (t->dropped || t->count + t->open + 2 > PROFILE_EVENTS) { t->dropped++; return; }
+    t->events[t->count] = (profile_event){ name, now, 'B' };
+    t->open++;
+    profile_publish(&t->count, t->count + 1);
+}
+
+static inline profile_zone* profile_zone_find(profile_thread* t, const char* name, bool add)
+{
+    for (size_t i = 0; i < t->zone_count; ++i)
+        if (t->zones[i].name == name) return &t->zones[i];
+    // The same literal may have several addresses across translation units.
+    for (size_t i = 0; i < t->zone_count; ++i)
+        if (strcmp(t->zones[i].name, name) == 0) return &t->zones[i];
+    if (!add || t->zone_count == PROFILE_ZONES) return NULL;
+    profile_zone* z = &t->zones[t->zone_count++];
+    memset(z, 0, sizeof(*z));
+    z->name = name;
+    return z;
+}
+
+/**
+ * @brief Close the innermost open zone of the calling thread.
+ */
+static inline void profile_end(void)
+{
+    profile_thread* t = g_profile_self;
+    if (!t || !t->depth) return;
+    const double now = timer_now_ms();
+    if (--t->depth < PROFILE_DEPTH) {
+        profile_zone* z = profile_zone_find(t, t->stack_name[t->depth], true);
+        if (z) {
+            z->last_ms = now - t->stack_t[t->depth];
+            z->total_ms += z->last_ms;
+            z->calls++;
+        }
+    }
+    if (t->dropped) { t->dropped--; return; }
+    if (!t->open) return;
+    t->events[t->count] = (profile_event){ NULL, now, 'E' };
+    t->open--;
+    profile_publish(&t->count, t->count + 1);
+}
+
+/**
+ * @brief Name the calling thread's timeline row (string literal).
+ */
+static inline void profile_thread_name(const char* name)
+{
+    profile_thread* t = profile_self();
+    if (t) t->name = name;
+}
+
+/**
+ * @brief Give the calling thread's slot back for reuse; its events stay.
+ */
+static inline void profile_thread_release(void)
+{
+    profile_thread* t = g_profile_self;
+    if (!t) return;
+    g_profile_self = NULL;
+    profile_atomic_store(&t->busy, 0);
+}
+
+/**
+ * @brief Statistics of a zone name closed on the calling thread.
+ *
+ * @param name Zone name.
+ * @param out  Last and total duration and number of calls.
+ * @return false if the thread has not closed such a zone.
+ */
+static inline bool profile_zone_stats(const char* name, profile_zone* out)
+{
+    profile_thread* t = g_profile_self;
+    const profile_zone* z = t ? profile_zone_find(t, name, false) : NULL;
+    if (!z) return false;
+    *out = *z;
+    return true;
+}
+
+/**
+ * @brief Drop all recorded events (buffers and slots are kept).
+ *
+ * Zone statistics are kept; only the event timeline starts over.
+ */
+static inline void profile_reset(void)
+{
+    for (long i = 0; i < g_profile_slots_used; ++i) {
+        profile_thread* t = &g_profile_threads[i];
+        profile_publish(&t->count, 0);
+        t->open = 0;
+        t->dropped = 0;
+    }
+}
+
+static inline void profile_write_json_string(FILE* f, const char* s)
+{
+    fputc('"', f);
+    for (; *s; ++s) {
+        const unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(f, "\\%c", c);
+        else if (c < 0x20) fprintf(f, "\\u%04x", c);
+        else fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+/**
+ * @brief Write every recorded event as Chrome trace JSON.
+ *
+ * Zones still open are closed at the time of the export. Timestamps are
+ * microseconds since the earliest event.
+ *
+ * @param path Output file (overwritten).
+ * @return false if the file cannot be written.
+ */
+static inline bool profile_write_chrome_trace(const char* path)
+{
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    const long slots = g_profile_slots_used;
+    double t0 = timer_now_ms();
+    for (long i = 0; i < slots; ++i) {
+        const profile_thread* t = &g_profile_threads[i];
+        if (profile_published(&t->count) && t->events[0].t_ms < t0) t0 = t->events[0].t_ms;
+    }
+    const double t_end = timer_now_ms();
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"jaml\"}}");
+    for (long i = 0; i < slots; ++i) {
+        const profile_thread* t = &g_profile_threads[i];
+        const size_t n = profile_published(&t->count);
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%ld,\"args\":{\"name\":", i);
+        if (t->name) profile_write_json_string(f, t->name);
+        else fprintf(f, "\"%s %ld\"", i == 0 ? "main" : "worker", i);
+        fprintf(f, "}}");
+        size_t depth = 0;
+        for (size_t k = 0; k < n; ++k) {
+            const profile_event* e = &t->events[k];
+            fprintf(f, ",\n{\"ph\":\"%c\",\"pid\":1,\"tid\":%ld,\"ts\":%.3f", e->phase, i, (e->t_ms - t0) * 1000.0);
+            if (e->phase == 'B') {
+                fprintf(f, ",\"name\":");
+                profile_write_json_string(f, e->name);
+                depth++;
+            } else if (depth) {
+                depth--;
+            }
+            fputc('}', f);
+        }
+        for (; depth > 0; --depth)
+            fprintf(f, ",\n{\"ph\":\"E\",\"pid\":1,\"tid\":%ld,\"ts\":%.3f}", i, (t_end - t0) * 1000.0);
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
+}
+
+#ifdef PROFILE_ENABLED
+#define PROFILE_BEGIN(name)       profile_begin(name)
+#define PROFILE_END()             profile_end()
+#define PROFILE_THREAD_NAME(name) profile_thread_name(name)
+#define PROFILE_THREAD_EXIT()     profile_thread_release()
+#else
+#define PROFILE_BEGIN(name)       ((void)0)
+#define PROFILE_END()             ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#define PROFILE_THREAD_EXIT()     ((void)0)
+#endif
+
+#endif // PROFILE_H
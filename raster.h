@@ -0,0 +1,567 @@
+﻿//
+// raster.h — software framebuffer and edge-function triangle rasterizer.
+//
+// Triangles are snapped to a 28.4 fixed-point grid (1/16 pixel), tested with
+// the three edge functions E(p) = cross(b - a, p - a) and walked in 8x8 pixel
+// blocks: blocks entirely outside any edge are skipped, blocks entirely inside
+// all edges are filled without per-pixel tests, and only the remaining blocks
+// are evaluated 8 pixels at a time. The top-left fill rule makes shared edges
+// owned by exactly one triangle, so meshes have neither gaps nor double hits.
+//
+// Anti-aliased lines and arrows are drawn from signed distance fields instead:
+// coverage of a pixel is clamp(0.5 - sd(center), 0, 1).
+//
+
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+#include "sdf.h"
+
+#define RASTER_SUBPIXEL_BITS 4
+#define RASTER_SUBPIXEL_ONE  (1 << RASTER_SUBPIXEL_BITS)
+#define RASTER_BLOCK         8    // block edge in pixels, also the lane width
+#define RASTER_TILE          64   // screen tile edge for threading, multiple of RASTER_BLOCK
+#define RASTER_GUARD_BAND    4096 // pixels outside the framebuffer before clipping kicks in
+#define RASTER_MAX_SIZE      8192 // largest supported framebuffer edge
+
+// 0xAARRGGBB, matches a 32-bpp top-down DIB / XImage in memory.
+#define RASTER_RGB(r, g, b) \
+    ((uint32_t)0xFF000000u | ((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b))
+
+typedef struct {
+    uint32_t* pixels; // row-major, `stride` pixels per row
+    int width, height;
+    int stride;
+} framebuffer;
+
+typedef struct {
+    vec2     a, b, c; // pixel coordinates, any winding
+    uint32_t color;
+} raster_tri;
+
+/**
+ * @brief Allocate a framebuffer.
+ *
+ * @param fb Framebuffer to initialize.
+ * @param w  Width in pixels, 1..RASTER_MAX_SIZE.
+ * @param h  Height in pixels, 1..RASTER_MAX_SIZE.
+ * @return false on invalid size or allocation failure (fb is left empty).
+ */
+static inline bool fb_init(framebuffer* fb, int w, int h)
+{
+    memset(fb, 0, sizeof(*fb));
+    if (w <= 0 || h <= 0 || w > RASTER_MAX_SIZE || h > RASTER_MAX_SIZE) return false;
+    fb->pixels = (uint32_t*)malloc((size_t)w * (size_t)h * sizeof(uint32_t));
+    if (!fb->pixels) return false;
+    fb->width = w;
+    fb->height = h;
+    fb->stride = w;
+    return true;
+}
+
+/**
+ * @brief Resize a framebuffer, reusing its storage when it is large enough.
+ *
+ * @return false on invalid size or allocation failure (old contents kept).
+ */
+static inline bool fb_resize(framebuffer* fb, int w, int h)
+{
+    if (w <= 0 || h <= 0 || w > RASTER_MAX_SIZE || h > RASTER_MAX_SIZE) return false;
+    size_t want = (size_t)w * (size_t)h;
+    if (want > (size_t)fb->stride * (size_t)fb->height || !fb->pixels) {
+        uint32_t* np = (uint32_t*)realloc(fb->pixels, want * sizeof(uint32_t));
+        if (!np) return false;
+        fb->pixels = np;
+    }
+    fb->width = w;
+    fb->height = h;
+    fb->stride = w;
+    return true;
+}
+
+static inline void fb_free(framebuffer* fb)
+{
+    free(fb->pixels);
+    memset(fb, 0, sizeof(*fb));
+}
+
+static inline void fb_clear(framebuffer* fb, uint32_t color)
+{
+    for (int y = 0; y < fb->height; ++y) {
+        uint32_t* row = fb->pixels + (size_t)y * fb->stride;
+        for (int x = 0; x < fb->width; ++x) row[x] = color;
+    }
+}
+
+/**
+ * @brief Write the framebuffer as a binary PPM (P6) image.
+ *
+ * @return false if the file cannot be written.
+ */
+static inline bool fb_write_ppm(const framebuffer* fb, const char* path)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    unsigned char* row = (unsigned char*)malloc((size_t)fb->width * 3);
+    bool ok = row != NULL;
+    fprintf(f, "P6\n%d %d\n255\n", fb->width, fb->height);
+    for (int y = 0; ok && y < fb->height; ++y) {
+        const uint32_t* src = fb->pixels + (size_t)y * fb->stride;
+        for (int x = 0; x < fb->width; ++x) {
+            row[3 * x + 0] = (unsigned char)(src[x] >> 16);
+            row[3 * x + 1] = (unsigned char)(src[x] >> 8);
+            row[3 * x + 2] = (unsigned char)src[x];
+        }
+        ok = fwrite(row, 3, (size_t)fb->width, f) == (size_t)fb->width;
+    }
+    free(row);
+    return fclose(f) == 0 && ok;
+}
+
+// ------------------------------ Edge setup -----------------------------------
+
+typedef struct {
+    int64_t a, b, c; // E(x,y) = a*x + b*y + c over 28.4 coordinates, fill rule folded into c
+} raster_edge;
+
+static inline int64_t raster_fix(float v)
+{
+    return (int64_t)llrintf(v * (float)RASTER_SUBPIXEL_ONE);
+}
+
+// Edge function of a->b, i.e. cross(b - a, p - a), with the top-left bias.
+// Expects the triangle to have positive area under this convention.
+static inline raster_edge raster_edge_setup(int64_t ax, int64_t ay, int64_t bx, int64_t by)
+{
+    raster_edge e;
+    e.a = ay - by;
+    e.b = bx - ax;
+    e.c = (by - ay) * ax - (bx - ax) * ay;
+    // Screen space is y-down: a "top" edge runs in +x with dy == 0, a "left"
+    // edge runs upwards (dy < 0). Other edges only own pixels strictly inside.
+    const bool top_left = (by == ay && bx > ax) || (by < ay);
+    if (!top_left) e.c -= 1;
+    return e;
+}
+
+// ------------------------------ Block walk -----------------------------------
+
+static inline void raster_fill_span(uint32_t* row, int x0, int x1, uint32_t color)
+{
+    for (int x = x0; x < x1; ++x) row[x] = color;
+}
+
+// Rasterize one triangle (already within the guard band) into the clip rect
+// [cx0,cx1) x [cy0,cy1).
+static inline void raster_triangle_rect(framebuffer* fb, const raster_tri* t,
+                                        int cx0, int cy0, int cx1, int cy1)
+{
+    int64_t x0 = raster_fix(t->a.x), y0 = raster_fix(t->a.y);
+    int64_t x1 = raster_fix(t->b.x), y1 = raster_fix(t->b.y);
+    int64_t x2 = raster_fix(t->c.x), y2 = raster_fix(t->c.y);
+
+    int64_t area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+    if (area == 0) return;
+    if (area < 0) { // flip to positive winding
+        int64_t tx = x1, ty = y1;
+        x1 = x2; y1 = y2;
+        x2 = tx; y2 = ty;
+    }
+
+    raster_edge e[3] = {
+        raster_edge_setup(x0, y0, x1, y1),
+        raster_edge_setup(x1, y1, x2, y2),
+        raster_edge_setup(x2, y2, x0, y0),
+    };
+
+    // Pixel bbox: covered centers satisfy min <= x*16+8 <= max.
+    int64_t minx = x0 < x1 ? (x0 < x2 ? x0 : x2) : (x1 < x2 ? x1 : x2);
+    int64_t maxx = x0 > x1 ? (x0 > x2 ? x0 : x2) : (x1 > x2 ? x1 : x2);
+    int64_t miny = y0 < y1 ? (y0 < y2 ? y0 : y2) : (y1 < y2 ? y1 : y2);
+    int64_t maxy = y0 > y1 ? (y0 > y2 ? y0 : y2) : (y1 > y2 ? y1 : y2);
+    const int64_t half = RASTER_SUBPIXEL_ONE / 2;
+    int px0 = (int)((minx - half + RASTER_SUBPIXEL_ONE - 1) >> RASTER_SUBPIXEL_BITS);
+    int px1 = (int)((maxx - half) >> RASTER_SUBPIXEL_BITS) + 1;
+    int py0 = (int)((miny - half + RASTER_SUBPIXEL_ONE - 1) >> RASTER_SUBPIXEL_BITS);
+    int py1 = (int)((maxy - half) >> RASTER_SUBPIXEL_BITS) + 1;
+    if (px0 < cx0) px0 = cx0;
+    if (py0 < cy0) py0 = cy0;
+    if (px1 > cx1) px1 = cx1;
+    if (py1 > cy1) py1 = cy1;
+    if (px0 >= px1 || py0 >= py1) return;
+
+    // Per-pixel steps and the block-corner offsets of every edge.
+    int64_t step_x[3], step_y[3], blk_max[3], blk_min[3];
+    for (int k = 0; k < 3; ++k) {
+        step_x[k] = e[k].a * RASTER_SUBPIXEL_ONE;
+        step_y[k] = e[k].b * RASTER_SUBPIXEL_ONE;
+        const int64_t ox = step_x[k] * (RASTER_BLOCK - 1);
+        const int64_t oy = step_y[k] * (RASTER_BLOCK - 1);
+        blk_max[k] = (ox > 0 ? ox : 0) + (oy > 0 ? oy : 0);
+        blk_min[k] = (ox < 0 ? ox : 0) + (oy < 0 ? oy : 0);
+    }
+
+    const uint32_t color = t->color;
+    const int bx0 = px0 & ~(RASTER_BLOCK - 1);
+    const int by0 = py0 & ~(RASTER_BLOCK - 1);
+
+    for (int by = by0; by < py1; by += RASTER_BLOCK) {
+        const int ry0 = by < py0 ? py0 : by;
+        const int ry1 = by + RASTER_BLOCK > py1 ? py1 : by + RASTER_BLOCK;
+        const int64_t cy = (int64_t)by * RASTER_SUBPIXEL_ONE + half;
+
+        for (int bx = bx0; bx < px1; bx += RASTER_BLOCK) {
+            const int rx0 = bx < px0 ? px0 : bx;
+            const int rx1 = bx + RASTER_BLOCK > px1 ? px1 : bx + RASTER_BLOCK;
+            const int64_t cx = (int64_t)bx * RASTER_SUBPIXEL_ONE + half;
+
+            // Classify the block against each edge using its extreme corners.
+            int partial[3], np = 0;
+            int64_t origin[3];
+            bool outside = false;
+            for (int k = 0; k < 3; ++k) {
+                origin[k] = e[k].a * cx + e[k].b * cy + e[k].c;
+                if (origin[k] + blk_max[k] < 0) { outside = true; break; }
+                if (origin[k] + blk_min[k] < 0) partial[np++] = k;
+            }
+            if (outside) continue;
+
+            if (np == 0) { // trivially inside
+                for (int y = ry0; y < ry1; ++y)
+                    raster_fill_span(fb->pixels + (size_t)y * fb->stride, rx0, rx1, color);
+                continue;
+            }
+
+            // Edges crossing this block stay within a few block extents of
+            // zero, so 32-bit lanes are enough from here on.
+            int32_t row_e[3], sx[3], sy[3];
+            for (int i = 0; i < np; ++i) {
+                const int k = partial[i];
+                row_e[i] = (int32_t)origin[k];
+                sx[i] = (int32_t)step_x[k];
+                sy[i] = (int32_t)step_y[k];
+            }
+
+            for (int y = by; y < by + RASTER_BLOCK; ++y) {
+                if (y >= ry0 && y < ry1) {
+                    uint8_t mask[RASTER_BLOCK];
+                    for (int l = 0; l < RASTER_BLOCK; ++l) mask[l] = 1;
+                    for (int i = 0; i < np; ++i) {
+                        const int32_t base = row_e[i], s = sx[i];
+                        for (int l = 0; l < RASTER_BLOCK; ++l)
+                            mask[l] &= (uint8_t)((base + l * s) >= 0);
+                    }
+                    uint32_t* row = fb->pixels + (size_t)y * fb->stride + bx;
+                    for (int l = rx0 - bx; l < rx1 - bx; ++l)
+                        if (mask[l]) row[l] = color;
+                }
+                for (int i = 0; i < np; ++i) row_e[i] += sy[i];
+            }
+        }
+    }
+}
+
+// ------------------------------ Guard band -----------------------------------
+
+static inline bool raster_in_guard(const framebuffer* fb, vec2 p)
+{
+    return p.x >= -RASTER_GUARD_BAND && p.x <= fb->width + RASTER_GUARD_BAND &&
+           p.y >= -RASTER_GUARD_BAND && p.y <= fb->height + RASTER_GUARD_BAND;
+}
+
+// Clip the polygon against one axis-aligned plane (Sutherland–Hodgman).
+static inline int raster_clip_plane(const vec2* in, int n, vec2* out, int axis, float bound, float sign)
+{
+    int m = 0;
+    for (int i = 0; i < n; ++i) {
+        const vec2 p = in[i];
+        const vec2 q = in[(i + 1) % n];
+        const float dp = sign * ((axis ? p.y : p.x) - bound);
+        const float dq = sign * ((axis ? q.y : q.x) - bound);
+        if (dp <= 0.0f) out[m++] = p;
+        if ((dp < 0.0f && dq > 0.0f) || (dp > 0.0f && dq < 0.0f)) {
+            const float s = dp / (dp - dq);
+            out[m++] = (vec2){ p.x + (q.x - p.x) * s, p.y + (q.y - p.y) * s };
+        }
+    }
+    return m;
+}
+
+// Rasterize a triangle into a clip rect, clipping to the guard band first if
+// any vertex would overflow the fixed-point range.
+static inline void raster_triangle_clipped(framebuffer* fb, const raster_tri* t,
+                                           int cx0, int cy0, int cx1, int cy1)
+{
+    if (raster_in_guard(fb, t->a) && raster_in_guard(fb, t->b) && raster_in_guard(fb, t->c)) {
+        raster_triangle_rect(fb, t, cx0, cy0, cx1, cy1);
+        return;
+    }
+
+    vec2 poly[16], tmp[16];
+    int n = 3;
+    poly[0] = t->a; poly[1] = t->b; poly[2] = t->c;
+    const float g = (float)RASTER_GUARD_BAND;
+    n = raster_clip_plane(poly, n, tmp, 0, -g, -1.0f);
+    n = raster_clip_plane(tmp,  n, poly, 0, (float)fb->width + g, 1.0f);
+    n = raster_clip_plane(poly, n, tmp, 1, -g, -1.0f);
+    n = raster_clip_plane(tmp,  n, poly, 1, (float)fb->height + g, 1.0f);
+
+    for (int i = 1; i + 1 < n; ++i) {
+        raster_tri f = { poly[0], poly[i], poly[i + 1], t->color };
+        raster_triangle_rect(fb, &f, cx0, cy0, cx1, cy1);
+    }
+}
+
+// ------------------------------ Public API -----------------------------------
+
+/**
+ * @brief Fill one triangle on the calling thread.
+ *
+ * @param fb Target framebuffer.
+ * @param t  Triangle in pixel coordinates (either winding); degenerate
+ *           triangles draw nothing.
+ */
+static inline void raster_triangle(framebuffer* fb, const raster_tri* t)
+{
+    raster_triangle_clipped(fb, t, 0, 0, fb->width, fb->height);
+}
+
+typedef struct {
+    framebuffer*      fb;
+    const raster_tri* tris;
+    const uint32_t*   bin_start; // tiles+1 prefix offsets into bin_items
+    const uint32_t*   bin_items; // triangle indices, in submission order per tile
+    int               tiles_x;
+} raster_batch_job;
+
+static inline void raster_batch_tiles(void* user, size_t begin, size_t end, int worker)
+{
+    (void)worker;
+    raster_batch_job* job = (raster_batch_job*)user;
+    framebuffer* fb = job->fb;
+    for (size_t tile = begin; tile < end; ++tile) {
+        const int tx = (int)(tile % (size_t)job->tiles_x);
+        const int ty = (int)(tile / (size_t)job->tiles_x);
+        const int x0 = tx * RASTER_TILE, y0 = ty * RASTER_TILE;
+        const int x1 = x0 + RASTER_TILE > fb->width  ? fb->width  : x0 + RASTER_TILE;
+        const int y1 = y0 + RASTER_TILE > fb->height ? fb->height : y0 + RASTER_TILE;
+        for (uint32_t i = job->bin_start[tile]; i < job->bin_start[tile + 1]; ++i)
+            raster_triangle_clipped(fb, &job->tris[job->bin_items[i]], x0, y0, x1, y1);
+    }
+}
+
+// Inclusive tile range overlapped by a triangle; false if fully off-screen.
+static inline bool raster_tile_range(const framebuffer* fb, const raster_tri* t, int tiles_x, int tiles_y,
+                                     int* tx0, int* ty0, int* tx1, int* ty1)
+{
+    float minx = fminf(t->a.x, fminf(t->b.x, t->c.x));
+    float maxx = fmaxf(t->a.x, fmaxf(t->b.x, t->c.x));
+    float miny = fminf(t->a.y, fminf(t->b.y, t->c.y));
+    float maxy = fmaxf(t->a.y, fmaxf(t->b.y, t->c.y));
+    if (!(maxx >= 0.0f && maxy >= 0.0f && minx < (float)fb->width && miny < (float)fb->height)) return false;
+    *tx0 = minx <= 0.0f ? 0 : (int)minx / RASTER_TILE;
+    *ty0 = miny <= 0.0f ? 0 : (int)miny / RASTER_TILE;
+    *tx1 = maxx >= (float)fb->width  ? tiles_x - 1 : (int)maxx / RASTER_TILE;
+    *ty1 = maxy >= (float)fb->height ? tiles_y - 1 : (int)maxy / RASTER_TILE;
+    return true;
+}
+
+/**
+ * @brief Fill many triangles, in order, using all workers.
+ *
+ * Triangles are binned into RASTER_TILE-sized screen tiles and tiles are
+ * rasterized in parallel. Each tile keeps submission order, so the result is
+ * identical to drawing the triangles one by one with raster_triangle.
+ *
+ * @param fb    Target framebuffer.
+ * @param tris  Triangles in pixel coordinates.
+ * @param count Number of triangles.
+ */
+static inline void raster_triangles(framebuffer* fb, const raster_tri* tris, size_t count)
+{
+    if (count == 0 || fb->width <= 0 || fb->height <= 0) return;
+
+    const int tiles_x = (fb->width  + RASTER_TILE - 1) / RASTER_TILE;
+    const int tiles_y = (fb->height + RASTER_TILE - 1) / RASTER_TILE;
+    const size_t tiles = (size_t)tiles_x * (size_t)tiles_y;
+
+    uint32_t* bin_start = (uint32_t*)calloc(tiles + 1, sizeof(uint32_t));
+    if (!bin_start) {
+        for (size_t i = 0; i < count; ++i) raster_triangle(fb, &tris[i]);
+        return;
+    }
+
+    // Pass 1: count triangles per tile.
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        int tx0, ty0, tx1, ty1;
+        if (!raster_tile_range(fb, &tris[i], tiles_x, tiles_y, &tx0, &ty0, &tx1, &ty1)) continue;
+        for (int ty = ty0; ty <= ty1; ++ty)
+            for (int tx = tx0; tx <= tx1; ++tx)
+                bin_start[(size_t)ty * tiles_x + tx + 1]++;
+        total += (size_t)(tx1 - tx0 + 1) * (size_t)(ty1 - ty0 + 1);
+    }
+    for (size_t t = 0; t < tiles; ++t) bin_start[t + 1] += bin_start[t];
+
+    uint32_t* bin_items = (uint32_t*)malloc((total ? total : 1) * sizeof(uint32_t));
+    uint32_t* cursor = (uint32_t*)malloc(tiles * sizeof(uint32_t));
+    if (!bin_items || !cursor || total > UINT32_MAX) {
+        free(bin_items); free(cursor); free(bin_start);
+        for (size_t i = 0; i < count; ++i) raster_triangle(fb, &tris[i]);
+        return;
+    }
+    memcpy(cursor, bin_start, tiles * sizeof(uint32_t));
+
+    // Pass 2: scatter indices; iterating triangles in order keeps bins ordered.
+    for (size_t i = 0; i < count; ++i) {
+        int tx0, ty0, tx1, ty1;
+        if (!raster_tile_range(fb, &tris[i], tiles_x, tiles_y, &tx0, &ty0, &tx1, &ty1)) continue;
+        for (int ty = ty0; ty <= ty1; ++ty)
+            for (int tx = tx0; tx <= tx1; ++tx)
+                bin_items[cursor[(size_t)ty * tiles_x + tx]++] = (uint32_t)i;
+    }
+
+    raster_batch_job job = { fb, tris, bin_start, bin_items, tiles_x };
+    parallel_for(tiles, 1, raster_batch_tiles, &job);
+
+    free(cursor);
+    free(bin_items);
+    free(bin_start);
+}
+
+// ------------------------------ SDF coverage ---------------------------------
+
+/**
+ * @brief Blend src over dst with the given coverage (src alpha also applies).
+ */
+static inline uint32_t raster_blend(uint32_t dst, uint32_t src, float cov)
+{
+    const uint32_t a = (uint32_t)(cov * (float)(src >> 24) + 0.5f); // 0..255
+    const uint32_t ia = 255u - a;
+    const uint32_t rb = (((src & 0x00FF00FFu) * a + (dst & 0x00FF00FFu) * ia + 0x00800080u) >> 8) & 0x00FF00FFu;
+    const uint32_t g  = (((src & 0x0000FF00u) * a + (dst & 0x0000FF00u) * ia + 0x00008000u) >> 8) & 0x0000FF00u;
+    return 0xFF000000u | rb | g;
+}
+
+typedef struct {
+    vec2  a, b;      // shaft
+    float radius;    // shaft half-width
+    vec2  head[3];   // tip, left, right
+    bool  has_head;
+} raster_arrow_shape;
+
+static inline float raster_arrow_sd(const raster_arrow_shape* s, vec2 p)
+{
+    float d = sdf_capsule(p, s->a, s->b, s->radius);
+    if (s->has_head) {
+        const float h = sdf_polygon(p, s->head, 3);
+        if (h < d) d = h;
+    }
+    return d;
+}
+
+static inline void raster_arrow_shape_fill(framebuffer* fb, const raster_arrow_shape* s, uint32_t color)
+{
+    vec2 lo = vec2_min((vec2*)&s->a, (vec2*)&s->b);
+    vec2 hi = vec2_max((vec2*)&s->a, (vec2*)&s->b);
+    if (s->has_head) {
+        for (int i = 0; i < 3; ++i) {
+            lo = vec2_min(&lo, (vec2*)&s->head[i]);
+            hi = vec2_max(&hi, (vec2*)&s->head[i]);
+        }
+    }
+    const float pad = s->radius + 1.0f;
+    const float fx0 = fmaxf(lo.x - pad, 0.0f), fy0 = fmaxf(lo.y - pad, 0.0f);
+    const float fx1 = fminf(hi.x + pad + 1.0f, (float)fb->width);
+    const float fy1 = fminf(hi.y + pad + 1.0f, (float)fb->height);
+    if (!(fx0 < fx1 && fy0 < fy1)) return;
+    const int x0 = (int)fx0, y0 = (int)fy0, x1 = (int)fx1, y1 = (int)fy1;
+
+    // One distance at each block center bounds the whole block: blocks farther
+    // than the block radius plus the AA ramp are skipped or filled outright.
+    const float reach = (float)RASTER_BLOCK * 0.70711f + 0.5f;
+    for (int by = y0 & ~(RASTER_BLOCK - 1); by < y1; by += RASTER_BLOCK) {
+        for (int bx = x0 & ~(RASTER_BLOCK - 1); bx < x1; bx += RASTER_BLOCK) {
+            const vec2 c = { (float)bx + RASTER_BLOCK * 0.5f, (float)by + RASTER_BLOCK * 0.5f };
+            const float dc = raster_arrow_sd(s, c);
+            if (dc > reach) continue;
+            const int ry0 = by < y0 ? y0 : by, ry1 = by + RASTER_BLOCK > y1 ? y1 : by + RASTER_BLOCK;
+            const int rx0 = bx < x0 ? x0 : bx, rx1 = bx + RASTER_BLOCK > x1 ? x1 : bx + RASTER_BLOCK;
+            for (int y = ry0; y < ry1; ++y) {
+                uint32_t* row = fb->pixels + (size_t)y * fb->stride;
+                for (int x = rx0; x < rx1; ++x) {
+                    float cov = 1.0f;
+                    if (dc > -reach) {
+                        const float d = raster_arrow_sd(s, (vec2){ (float)x + 0.5f, (float)y + 0.5f });
+                        cov = fminf(fmaxf(0.5f - d, 0.0f), 1.0f);
+                    }
+                    if (cov > 0.0f) row[x] = raster_blend(row[x], color, cov);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Anti-aliased line of the given half-width (SDF coverage).
+ *
+ * @param fb         Target framebuffer.
+ * @param a          Start in pixel coordinates.
+ * @param b          End in pixel coordinates.
+ * @param half_width Half the stroke width in pixels.
+ * @param color      Line color; its alpha scales coverage.
+ */
+static inline void raster_line_aa(framebuffer* fb, vec2 a, vec2 b, float half_width, uint32_t color)
+{
+    raster_arrow_shape s = { a, b, half_width, { {0,0}, {0,0}, {0,0} }, false };
+    raster_arrow_shape_fill(fb, &s, color);
+}
+
+/**
+ * @brief Anti-aliased arrow with a filled triangular head (SDF coverage).
+ *
+ * Shaft and head are combined as one distance field (min of both), so the
+ * overlap is blended once and the silhouette stays smooth.
+ *
+ * @param fb          Target framebuffer.
+ * @param from        Tail in pixel coordinates.
+ * @param to          Tip in pixel coordinates.
+ * @param half_width  Shaft half-width in pixels.
+ * @param head_len    Head length in pixels (clamped to the arrow length).
+ * @param head_half_w Head half-width in pixels.
+ * @param color       Arrow color; its alpha scales coverage.
+ */
+static inline void raster_arrow_aa(framebuffer* fb, vec2 from, vec2 to, float half_width,
+                                   float head_len, float head_half_w, uint32_t color)
+{
+    vec2 v = vec2_sub(&to, &from);
+    const float len = vec2_length(&v);
+    if (len < 1e-6f) return;
+    if (head_len > len) head_len = len;
+
+    vec2 dir  = vec2_mul(&v, 1.0f / len);
+    vec2 perp = vec2_perp(&dir);
+    vec2 back = vec2_mul(&dir, head_len);
+    vec2 side = vec2_mul(&perp, head_half_w);
+    vec2 base = vec2_sub(&to, &back);
+
+    raster_arrow_shape s;
+    s.a = from;
+    s.b = base;
+    s.radius = half_width;
+    s.head[0] = to;
+    s.head[1] = vec2_add(&base, &side);
+    s.head[2] = vec2_sub(&base, &side);
+    s.has_head = head_len > 0.0f && head_half_w > 0.0f;
+    raster_arrow_shape_fill(fb, &s, color);
+}
+
+#endif // RASTER_H
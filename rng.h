@@ -0,0 +1,61 @@
+﻿//
+// rng.h — small deterministic PCG32 random number generator.
+//
+// Same seed, same sequence on every platform, unlike rand().
+//
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint64_t state;
+    uint64_t inc;
+} rng;
+
+/**
+ * @brief Next 32 random bits.
+ */
+static inline uint32_t rng_next(rng* r)
+{
+    const uint64_t old = r->state;
+    r->state = old * 6364136223846793005ULL + r->inc;
+    const uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    const uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31u));
+}
+
+/**
+ * @brief Seed a generator; `stream` selects one of 2^63 independent sequences.
+ */
+static inline void rng_seed(rng* r, uint64_t seed, uint64_t stream)
+{
+    r->state = 0u;
+    r->inc = (stream << 1u) | 1u;
+    rng_next(r);
+    r->state += seed;
+    rng_next(r);
+}
+
+/**
+ * @brief Uniform float in [0, 1) with 24 random bits.
+ */
+static inline float rng_float(rng* r)
+{
+    return (float)(rng_next(r) >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ * @brief Uniform integer in [0, n), unbiased (n > 0).
+ */
+static inline uint32_t rng_below(rng* r, uint32_t n)
+{
+    const uint32_t threshold = (0u - n) % n;
+    for (;;) {
+        const uint32_t x = rng_next(r);
+        if (x >= threshold) return x % n;
+    }
+}
+
+#endif // RNG_H
@@ -0,0 +1,352 @@
+﻿//
+// sampling.h — blue-noise (Poisson-disk) and low-discrepancy point sets.
+//
+// Poisson-disk sampling follows Bridson (2007): a background grid with cells of
+// r/sqrt(2) holds at most one sample each, so a candidate is checked against
+// the 5x5 cells around it. The tiled variant runs Bridson per tile in four
+// phases (tile parity in x and y); tiles of the same phase are at least one
+// tile apart, so they never read or write each other's cells concurrently.
+//
+// Halton (bases 2, 3), Sobol (first two dimensions) and R2 (Roberts) points
+// are generated in batches with fixed-width lane loops.
+//
+
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+#include "rng.h"
+
+#define SAMPLING_POISSON_K    30 // candidates per active sample
+#define SAMPLING_TILE_CELLS   64 // tile edge in background-grid cells (tiled variant)
+#define SAMPLING_LANES        8
+
+// ------------------------------ Poisson disk ---------------------------------
+
+typedef struct {
+    vec2* cells;     // one sample per cell, x = NAN when empty
+    int   gw, gh;
+    vec2  lo, hi;
+    float r, cell, inv_cell;
+} sampling_grid;
+
+static inline bool sampling_grid_init(sampling_grid* g, vec2 lo, vec2 hi, float r)
+{
+    memset(g, 0, sizeof(*g));
+    if (!(r > 0.0f) || !(hi.x > lo.x) || !(hi.y > lo.y)) return false;
+    g->lo = lo; g->hi = hi; g->r = r;
+    g->cell = r / 1.41421356f;
+    g->inv_cell = 1.0f / g->cell;
+    const double gw = ceil((double)(hi.x - lo.x) * g->inv_cell);
+    const double gh = ceil((double)(hi.y - lo.y) * g->inv_cell);
+    if (gw * gh > (double)(SIZE_MAX / sizeof(vec2)) || gw > INT32_MAX || gh > INT32_MAX) return false;
+    g->gw = (int)gw; g->gh = (int)gh;
+    g->cells = (vec2*)malloc((size_t)g->gw * (size_t)g->gh * sizeof(vec2));
+    if (!g->cells) return false;
+    for (size_t i = 0; i < (size_t)g->gw * (size_t)g->gh; ++i) g->cells[i] = (vec2){ NAN, NAN };
+    return true;
+}
+
+static inline void sampling_cell_of(const sampling_grid* g, vec2 p, int* cx, int* cy)
+{
+    const int x = (int)((p.x - g->lo.x) * g->inv_cell);
+    const int y = (int)((p.y - g->lo.y) * g->inv_cell);
+    *cx = x < 0 ? 0 : (x >= g->gw ? g->gw - 1 : x); // guards float rounding at the far edge
+    *cy = y < 0 ? 0 : (y >= g->gh ? g->gh - 1 : y);
+}
+
+static inline bool sampling_grid_free_at(const sampling_grid* g, vec2 p)
+{
+    int cx, cy;
+    sampling_cell_of(g, p, &cx, &cy);
+    const float r2 = g->r * g->r;
+    for (int y = cy - 2; y <= cy + 2; ++y) {
+        if (y < 0 || y >= g->gh) continue;
+        for (int x = cx - 2; x <= cx + 2; ++x) {
+            if (x < 0 || x >= g->gw) continue;
+            vec2 q = g->cells[(size_t)y * g->gw + x];
+            if (q.x == q.x && vec2_dist2(&p, &q) < r2) return false;
+        }
+    }
+    return true;
+}
+
+static inline void sampling_grid_put(sampling_grid* g, vec2 p)
+{
+    int cx, cy;
+    sampling_cell_of(g, p, &cx, &cy);
+    g->cells[(size_t)cy * g->gw + cx] = p;
+}
+
+// Bridson within the cell rectangle [cx0,cx1) x [cy0,cy1); `active` must hold
+// one entry per cell of the rectangle.
+static inline void sampling_poisson_region(sampling_grid* g, int cx0, int cy0, int cx1, int cy1,
+                                           rng* rg, vec2* active)
+{
+    const float x0 = g->lo.x + (float)cx0 * g->cell;
+    const float y0 = g->lo.y + (float)cy0 * g->cell;
+    const float x1 = fminf(g->lo.x + (float)cx1 * g->cell, g->hi.x);
+    const float y1 = fminf(g->lo.y + (float)cy1 * g->cell, g->hi.y);
+    if (!(x1 > x0) || !(y1 > y0)) return;
+
+    size_t n_active = 0;
+    vec2 first = { x0 + rng_float(rg) * (x1 - x0), y0 + rng_float(rg) * (y1 - y0) };
+    if (sampling_grid_free_at(g, first)) {
+        sampling_grid_put(g, first);
+        active[n_active++] = first;
+    } else {
+        // Region already crowded by neighbours: seed from any free cell center.
+        for (int cy = cy0; cy < cy1 && n_active == 0; ++cy) {
+            for (int cx = cx0; cx < cx1; ++cx) {
+                vec2 c = { g->lo.x + ((float)cx + 0.5f) * g->cell, g->lo.y + ((float)cy + 0.5f) * g->cell };
+                if (c.x < x1 && c.y < y1 && sampling_grid_free_at(g, c)) {
+                    sampling_grid_put(g, c);
+                    active[n_active++] = c;
+                    break;
+                }
+            }
+        }
+    }
+
+    const float r = g->r;
+    while (n_active > 0) {
+        const uint32_t idx = rng_below(rg, (uint32_t)n_active);
+        const vec2 s = active[idx];
+        bool placed = false;
+        for (int k = 0; k < SAMPLING_POISSON_K; ++k) {
+            // Uniform in the annulus [r, 2r).
+            const float ang = rng_float(rg) * 6.28318531f;
+            const float rad = sqrtf(r * r * (1.0f + 3.0f * rng_float(rg)));
+            const vec2 c = { s.x + cosf(ang) * rad, s.y + sinf(ang) * rad };
+            if (!(c.x >= x0 && c.x < x1 && c.y >= y0 && c.y < y1)) continue;
+            if (!sampling_grid_free_at(g, c)) continue;
+            sampling_grid_put(g, c);
+            active[n_active++] = c;
+            placed = true;
+            break;
+        }
+        if (!placed) active[idx] = active[--n_active];
+    }
+}
+
+static inline size_t sampling_grid_gather(const sampling_grid* g, vec2* out, size_t cap)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < (size_t)g->gw * (size_t)g->gh; ++i) {
+        const vec2 p = g->cells[i];
+        if (p.x != p.x) continue;
+        if (n < cap) out[n] = p;
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Bridson Poisson-disk sampling of the rectangle [lo, hi).
+ *
+ * No two samples are closer than r and no point of the rectangle is farther
+ * than 2r from a sample. Output is in background-grid (row-major) order.
+ *
+ * @param lo   Lower-left corner.
+ * @param hi   Upper-right corner.
+ * @param r    Minimum distance between samples.
+ * @param seed RNG seed; same seed, same points.
+ * @param out  Output buffer (may be NULL when cap is 0).
+ * @param cap  Capacity of out.
+ * @return Number of samples generated; only the first cap are written.
+ */
+static inline size_t sample_poisson(vec2 lo, vec2 hi, float r, uint64_t seed, vec2* out, size_t cap)
+{
+    sampling_grid g;
+    if (!sampling_grid_init(&g, lo, hi, r)) return 0;
+    vec2* active = (vec2*)malloc((size_t)g.gw * (size_t)g.gh * sizeof(vec2));
+    size_t n = 0;
+    if (active) {
+        rng rg;
+        rng_seed(&rg, seed, 0);
+        sampling_poisson_region(&g, 0, 0, g.gw, g.gh, &rg, active);
+        n = sampling_grid_gather(&g, out, cap);
+    }
+    free(active);
+    free(g.cells);
+    return n;
+}
+
+typedef struct {
+    sampling_grid* g;
+    int            tiles_x, tiles_y;
+    int            phase;    // 0..3: (tx & 1) | (ty & 1) << 1
+    uint64_t       seed;
+    vec2**         active;   // per-worker scratch, one tile of cells each
+} sampling_tiled_job;
+
+static inline void sampling_tiled_range(void* user, size_t begin, size_t end, int worker)
+{
+    sampling_tiled_job* j = (sampling_tiled_job*)user;
+    const int px = j->phase & 1, py = j->phase >> 1;
+    const int per_row = (j->tiles_x - px + 1) / 2;
+    for (size_t i = begin; i < end; ++i) {
+        const int tx = px + 2 * (int)(i % (size_t)per_row);
+        const int ty = py + 2 * (int)(i / (size_t)per_row);
+        rng rg;
+        rng_seed(&rg, j->seed, (uint64_t)ty * (uint64_t)j->tiles_x + (uint64_t)tx);
+        const int cx0 = tx * SAMPLING_TILE_CELLS, cy0 = ty * SAMPLING_TILE_CELLS;
+        const int cx1 = cx0 + SAMPLING_TILE_CELLS > j->g->gw ? j->g->gw : cx0 + SAMPLING_TILE_CELLS;
+        const int cy1 = cy0 + SAMPLING_TILE_CELLS > j->g->gh ? j->g->gh : cy0 + SAMPLING_TILE_CELLS;
+        sampling_poisson_region(j->g, cx0, cy0, cx1, cy1, &rg, j->active[worker]);
+    }
+}
+
+/**
+ * @brief Parallel tiled Poisson-disk sampling for very large domains.
+ *
+ * Same guarantees as sample_poisson. The result depends only on the seed,
+ * not on the number of workers.
+ *
+ * @return Number of samples generated; only the first cap are written.
+ */
+static inline size_t sample_poisson_tiled(vec2 lo, vec2 hi, float r, uint64_t seed, vec2* out, size_t cap)
+{
+    sampling_grid g;
+    if (!sampling_grid_init(&g, lo, hi, r)) return 0;
+
+    const int workers = parallel_worker_count();
+    sampling_tiled_job job = { &g, (g.gw + SAMPLING_TILE_CELLS - 1) / SAMPLING_TILE_CELLS,
+                               (g.gh + SAMPLING_TILE_CELLS - 1) / SAMPLING_TILE_CELLS, 0, seed, NULL };
+    job.active = (vec2**)calloc((size_t)workers, sizeof(vec2*));
+    bool ok = job.active != NULL;
+    for (int w = 0; ok && w < workers; ++w) {
+        job.active[w] = (vec2*)malloc((size_t)SAMPLING_TILE_CELLS * SAMPLING_TILE_CELLS * sizeof(vec2));
+        ok = job.active[w] != NULL;
+    }
+
+    size_t n = 0;
+    if (ok) {
+        for (job.phase = 0; job.phase < 4; ++job.phase) {
+            const size_t nx = (size_t)((job.tiles_x - (job.phase & 1) + 1) / 2);
+            const size_t ny = (size_t)((job.tiles_y - (job.phase >> 1) + 1) / 2);
+            parallel_for(nx * ny, 1, sampling_tiled_range, &job);
+        }
+        n = sampling_grid_gather(&g, out, cap);
+    }
+
+    for (int w = 0; job.active && w < workers; ++w) free(job.active[w]);
+    free(job.active);
+    free(g.cells);
+    return n;
+}
+
+// ------------------------------ Low discrepancy ------------------------------
+
+static inline uint32_t sampling_reverse_bits(uint32_t v)
+{
+    v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+    v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+    v = ((v >> 4) & 0x0F0F0F0Fu) | ((v & 0x0F0F0F0Fu) << 4);
+    v = ((v >> 8) & 0x00FF00FFu) | ((v & 0x00FF00FFu) << 8);
+    return (v >> 16) | (v << 16);
+}
+
+static inline float sampling_u32_to_unit(uint32_t v)
+{
+    return (float)(v >> 8) * (1.0f / 16777216.0f);
+}
+
+static inline float sampling_radical_inverse3(uint32_t i)
+{
+    // A 32-bit index has up to 21 base-3 digits and 3^21 > 2^32, so the
+    // reversed digits need 64 bits; 3^21 < 2^53 keeps the scale exact.
+    uint64_t rev = 0;
+    double scale = 1.0;
+    while (i) {
+        rev = rev * 3u + i % 3u;
+        scale *= 3.0;
+        i /= 3u;
+    }
+    // Rounding to float can reach 1 for long indices; stay in [0, 1).
+    return fminf((float)((double)rev / scale), 1.0f - 1.0f / 16777216.0f);
+}
+
+/**
+ * @brief Halton points (bases 2 and 3) with indices [first, first + n),
+ *        scaled into [lo, hi).
+ */
+static inline void sample_halton(uint32_t first, size_t n, vec2 lo, vec2 hi, vec2* out)
+{
+    const float sx = hi.x - lo.x, sy = hi.y - lo.y;
+    for (size_t b = 0; b < n; b += SAMPLING_LANES) {
+        const size_t cnt = n - b < SAMPLING_LANES ? n - b : SAMPLING_LANES;
+        float u[SAMPLING_LANES], v[SAMPLING_LANES];
+        for (size_t l = 0; l < SAMPLING_LANES; ++l)
+            u[l] = sampling_u32_to_unit(sampling_reverse_bits(first + (uint32_t)(b + l)));
+        for (size_t l = 0; l < cnt; ++l)
+            v[l] = sampling_radical_inverse3(first + (uint32_t)(b + l));
+        for (size_t l = 0; l < cnt; ++l)
+            out[b + l] = (vec2){ lo.x + u[l] * sx, lo.y + v[l] * sy };
+    }
+}
+
+/**
+ * @brief Sobol points (first two dimensions) with indices [first, first + n),
+ *        scaled into [lo, hi).
+ *
+ * Dimension 2 uses the primitive polynomial x + 1, whose direction numbers
+ * are v_k = v_{k-1} ^ (v_{k-1} >> 1).
+ */
+static inline void sample_sobol(uint32_t first, size_t n, vec2 lo, vec2 hi, vec2* out)
+{
+    uint32_t dir[32];
+    dir[0] = 1u << 31;
+    for (int k = 1; k < 32; ++k) dir[k] = dir[k - 1] ^ (dir[k - 1] >> 1);
+
+    const float sx = hi.x - lo.x, sy = hi.y - lo.y;
+    for (size_t b = 0; b < n; b += SAMPLING_LANES) {
+        const size_t cnt = n - b < SAMPLING_LANES ? n - b : SAMPLING_LANES;
+        uint32_t x[SAMPLING_LANES], y[SAMPLING_LANES];
+        for (size_t l = 0; l < SAMPLING_LANES; ++l) {
+            const uint32_t i = first + (uint32_t)(b + l);
+            x[l] = sampling_reverse_bits(i);
+            y[l] = 0;
+        }
+        for (int k = 0; k < 32; ++k)
+            for (size_t l = 0; l < SAMPLING_LANES; ++l)
+                y[l] ^= dir[k] & (0u - (((first + (uint32_t)(b + l)) >> k) & 1u));
+        for (size_t l = 0; l < cnt; ++l)
+            out[b + l] = (vec2){ lo.x + sampling_u32_to_unit(x[l]) * sx,
+                                 lo.y + sampling_u32_to_unit(y[l]) * sy };
+    }
+}
+
+/**
+ * @brief R2 (Roberts) points with indices [first, first + n), scaled into [lo, hi).
+ *
+ * x_i = frac(0.5 + i / g), y_i = frac(0.5 + i / g^2) with g the plastic
+ * number; the index product is taken in double to stay exact for large i.
+ */
+static inline void sample_r2(uint32_t first, size_t n, vec2 lo, vec2 hi, vec2* out)
+{
+    const double g  = 1.32471795724474602596;
+    const double a1 = 1.0 / g, a2 = 1.0 / (g * g);
+    const float sx = hi.x - lo.x, sy = hi.y - lo.y;
+    for (size_t b = 0; b < n; b += SAMPLING_LANES) {
+        const size_t cnt = n - b < SAMPLING_LANES ? n - b : SAMPLING_LANES;
+        double u[SAMPLING_LANES], v[SAMPLING_LANES];
+        for (size_t l = 0; l < SAMPLING_LANES; ++l) {
+            const double i = (double)first + (double)(b + l);
+            u[l] = 0.5 + a1 * i;
+            v[l] = 0.5 + a2 * i;
+            u[l] -= floor(u[l]);
+            v[l] -= floor(v[l]);
+        }
+        for (size_t l = 0; l < cnt; ++l)
+            out[b + l] = (vec2){ lo.x + (float)u[l] * sx, lo.y + (float)v[l] * sy };
+    }
+}
+
+#endif // SAMPLING_H
@@ -0,0 +1,392 @@
+﻿//
+// sdf.h — signed distance kernels for segments, polylines and polygons, plus
+//         a jump-flooding grid baker.
+//
+// Convention: negative inside, positive outside, distances in world units.
+//
+
+#ifndef SDF_H
+#define SDF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+
+#define SDF_BLOCK 256   // points per cache block in the batch kernels
+#define SDF_GRAIN 4096  // points per parallel chunk
+
+// ------------------------------ Scalar kernels -------------------------------
+
+/**
+ * @brief Closest point to p on segment [a, b].
+ *
+ * This is vec2_project of (p - a) onto (b - a) with the projection parameter
+ * clamped to the segment; a zero-length segment yields a.
+ *
+ * @param p Query point.
+ * @param a Segment start.
+ * @param b Segment end.
+ * @return Closest point on the segment.
+ */
+static inline vec2 sdf_closest_on_segment(vec2 p, vec2 a, vec2 b)
+{
+    vec2 pa = vec2_sub(&p, &a);
+    vec2 ba = vec2_sub(&b, &a);
+    const float len2 = vec2_length2(&ba);
+    float h = len2 > 0.0f ? vec2_dot(&pa, &ba) / len2 : 0.0f;
+    h = h < 0.0f ? 0.0f : (h > 1.0f ? 1.0f : h);
+    return (vec2){ a.x + ba.x * h, a.y + ba.y * h };
+}
+
+/**
+ * @brief Unsigned distance from p to segment [a, b].
+ */
+static inline float sdf_segment(vec2 p, vec2 a, vec2 b)
+{
+    vec2 q = sdf_closest_on_segment(p, a, b);
+    return vec2_dist(&p, &q);
+}
+
+/**
+ * @brief Signed distance to a stroked segment (capsule) of half-width r.
+ */
+static inline float sdf_capsule(vec2 p, vec2 a, vec2 b, float r)
+{
+    return sdf_segment(p, a, b) - r;
+}
+
+/**
+ * @brief Signed distance to a simple polygon (even-odd inside test).
+ *
+ * @param p    Query point.
+ * @param poly Polygon vertices, either winding, implicitly closed.
+ * @param n    Vertex count (>= 3).
+ * @return Negative inside, positive outside.
+ */
+static inline float sdf_polygon(vec2 p, const vec2* poly, size_t n)
+{
+    float d2 = INFINITY;
+    bool inside = false;
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        vec2 a = poly[j], b = poly[i];
+        vec2 q = sdf_closest_on_segment(p, a, b);
+        const float dd = vec2_dist2(&p, &q);
+        if (dd < d2) d2 = dd;
+        // Crossing test: p.y within the edge's y-span and p left of the edge.
+        if ((a.y > p.y) != (b.y > p.y)) {
+            vec2 e  = vec2_sub(&b, &a);
+            vec2 pa = vec2_sub(&p, &a);
+            if ((vec2_cross(&e, &pa) > 0.0f) == (b.y > a.y)) inside = !inside;
+        }
+    }
+    const float d = sqrtf(d2);
+    return inside ? -d : d;
+}
+
+// ------------------------------ Batch kernels --------------------------------
+
+// Squared distance from (px,py) to segment a + ba*t, branch-free so the lane
+// loops below vectorize.
+static inline float sdf_seg_dist2(float px, float py, float ax, float ay,
+                                  float bax, float bay, float inv_len2)
+{
+    const float pax = px - ax, pay = py - ay;
+    float h = (pax * bax + pay * bay) * inv_len2;
+    h = fminf(fmaxf(h, 0.0f), 1.0f);
+    const float dx = pax - bax * h, dy = pay - bay * h;
+    return dx * dx + dy * dy;
+}
+
+typedef struct {
+    const vec2* pts;
+    const vec2* shape;
+    size_t      shape_n;
+    float       radius;
+    bool        closed; // polygon: signed via crossing parity
+    float*      out;
+} sdf_batch_job;
+
+static inline void sdf_batch_range(void* user, size_t begin, size_t end, int worker)
+{
+    (void)worker;
+    const sdf_batch_job* job = (const sdf_batch_job*)user;
+    const vec2* s = job->shape;
+    const size_t m = job->shape_n;
+    const size_t segs = job->closed ? m : (m > 0 ? m - 1 : 0);
+
+    float d2[SDF_BLOCK];
+    uint8_t par[SDF_BLOCK];
+
+    for (size_t b0 = begin; b0 < end; b0 += SDF_BLOCK) {
+        const size_t cnt = (end - b0) < SDF_BLOCK ? (end - b0) : SDF_BLOCK;
+        const vec2* p = job->pts + b0;
+        for (size_t l = 0; l < cnt; ++l) { d2[l] = INFINITY; par[l] = 0; }
+
+        if (m == 1) {
+            for (size_t l = 0; l < cnt; ++l) {
+                vec2 pl = p[l], s0 = s[0];
+                d2[l] = vec2_dist2(&pl, &s0);
+            }
+        }
+
+        // Segments outer, points inner: each segment is set up once per block.
+        for (size_t k = 0; k < segs; ++k) {
+            const vec2 a = s[k], b = s[(k + 1) % m];
+            const float bax = b.x - a.x, bay = b.y - a.y;
+            const float len2 = bax * bax + bay * bay;
+            const float inv = len2 > 0.0f ? 1.0f / len2 : 0.0f;
+            for (size_t l = 0; l < cnt; ++l)
+                d2[l] = fminf(d2[l], sdf_seg_dist2(p[l].x, p[l].y, a.x, a.y, bax, bay, inv));
+            if (job->closed) {
+                const bool up = b.y > a.y;
+                for (size_t l = 0; l < cnt; ++l) {
+                    const bool span  = (a.y > p[l].y) != (b.y > p[l].y);
+                    const bool left  = (bax * (p[l].y - a.y) - bay * (p[l].x - a.x)) > 0.0f;
+                    par[l] ^= (uint8_t)(span & (left == up));
+                }
+            }
+        }
+
+        float* o = job->out + b0;
+        for (size_t l = 0; l < cnt; ++l) {
+            const float d = sqrtf(d2[l]) - job->radius;
+            o[l] = par[l] ? -d : d;
+        }
+    }
+}
+
+/**
+ * @brief Distance from many points to one segment.
+ *
+ * @param pts Query points.
+ * @param n   Number of query points.
+ * @param a   Segment start.
+ * @param b   Segment end.
+ * @param out Output distances (n floats).
+ */
+static inline void sdf_segment_batch(const vec2* pts, size_t n, vec2 a, vec2 b, float* out)
+{
+    vec2 seg[2] = { a, b };
+    sdf_batch_job job = { pts, seg, 2, 0.0f, false, out };
+    parallel_for(n, SDF_GRAIN, sdf_batch_range, &job);
+}
+
+/**
+ * @brief Signed distance from many points to a polyline stroked with half-width radius.
+ *
+ * With radius 0 this is the plain unsigned point-to-polyline distance.
+ *
+ * @param pts    Query points.
+ * @param n      Number of query points.
+ * @param line   Polyline vertices (open).
+ * @param m      Polyline vertex count (>= 1).
+ * @param radius Stroke half-width.
+ * @param out    Output distances (n floats).
+ */
+static inline void sdf_polyline_batch(const vec2* pts, size_t n, const vec2* line, size_t m,
+                                      float radius, float* out)
+{
+    if (m == 0) return;
+    sdf_batch_job job = { pts, line, m, radius, false, out };
+    parallel_for(n, SDF_GRAIN, sdf_batch_range, &job);
+}
+
+/**
+ * @brief Signed distance from many points to a simple polygon.
+ *
+ * @param pts  Query points.
+ * @param n    Number of query points.
+ * @param poly Polygon vertices, implicitly closed.
+ * @param m    Polygon vertex count (>= 3).
+ * @param out  Output signed distances (n floats, negative inside).
+ */
+static inline void sdf_polygon_batch(const vec2* pts, size_t n, const vec2* poly, size_t m, float* out)
+{
+    if (m < 3) return;
+    sdf_batch_job job = { pts, poly, m, 0.0f, true, out };
+    parallel_for(n, SDF_GRAIN, sdf_batch_range, &job);
+}
+
+// ------------------------------ Grid baker -----------------------------------
+
+typedef struct {
+    float* values; // w*h distances, row-major, sampled at cell centers
+    int    w, h;
+    vec2   origin; // world position of the grid's (0,0) corner
+    float  cell;   // world size of one cell
+} sdf_grid;
+
+static inline bool sdf_grid_init(sdf_grid* g, int w, int h, vec2 origin, float cell)
+{
+    memset(g, 0, sizeof(*g));
+    if (w <= 0 || h <= 0 || cell <= 0.0f) return false;
+    g->values = (float*)malloc((size_t)w * (size_t)h * sizeof(float));
+    if (!g->values) return false;
+    g->w = w; g->h = h; g->origin = origin; g->cell = cell;
+    return true;
+}
+
+static inline void sdf_grid_free(sdf_grid* g)
+{
+    free(g->values);
+    memset(g, 0, sizeof(*g));
+}
+
+static inline vec2 sdf_grid_center(const sdf_grid* g, int x, int y)
+{
+    return (vec2){ g->origin.x + ((float)x + 0.5f) * g->cell,
+                   g->origin.y + ((float)y + 0.5f) * g->cell };
+}
+
+typedef struct {
+    const sdf_grid* g;
+    const vec2*     src;  // nearest boundary point per cell, INFINITY = none
+    vec2*           dst;
+    int             step;
+} sdf_jfa_job;
+
+static inline void sdf_jfa_rows(void* user, size_t begin, size_t end, int worker)
+{
+    (void)worker;
+    const sdf_jfa_job* j = (const sdf_jfa_job*)user;
+    const int w = j->g->w, h = j->g->h, s = j->step;
+    for (int y = (int)begin; y < (int)end; ++y) {
+        for (int x = 0; x < w; ++x) {
+            vec2 c = sdf_grid_center(j->g, x, y);
+            vec2 best = j->src[(size_t)y * w + x];
+            float bd = vec2_dist2(&c, &best);
+            for (int dy = -s; dy <= s; dy += s) {
+                const int yy = y + dy;
+                if (yy < 0 || yy >= h) continue;
+                for (int dx = -s; dx <= s; dx += s) {
+                    const int xx = x + dx;
+                    if (xx < 0 || xx >= w || (dx == 0 && dy == 0)) continue;
+                    vec2 cand = j->src[(size_t)yy * w + xx];
+                    const float d = vec2_dist2(&c, &cand);
+                    if (d < bd) { bd = d; best = cand; }
+                }
+            }
+            j->dst[(size_t)y * w + x] = best;
+        }
+    }
+}
+
+typedef struct {
+    sdf_grid*   g;
+    const vec2* seeds;
+    const vec2* shape;
+    size_t      n;
+    bool        closed;
+    float*      xs;    // per-worker crossing scratch, n floats each
+} sdf_finish_job;
+
+static inline int sdf_cmp_float(const void* a, const void* b)
+{
+    const float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+// Distance from the flooded seed, signed by scanline parity for polygons.
+static inline void sdf_finish_rows(void* user, size_t begin, size_t end, int worker)
+{
+    const sdf_finish_job* j = (const sdf_finish_job*)user;
+    sdf_grid* g = j->g;
+    float* xs = j->xs + (size_t)worker * j->n;
+    for (int y = (int)begin; y < (int)end; ++y) {
+        const float py = g->origin.y + ((float)y + 0.5f) * g->cell;
+        size_t nx = 0;
+        if (j->closed) {
+            for (size_t i = 0, k = j->n - 1; i < j->n; k = i++) {
+                const vec2 a = j->shape[k], b = j->shape[i];
+                if ((a.y > py) != (b.y > py))
+                    xs[nx++] = a.x + (py - a.y) * (b.x - a.x) / (b.y - a.y);
+            }
+            qsort(xs, nx, sizeof(float), sdf_cmp_float);
+        }
+        size_t cross = 0;
+        for (int x = 0; x < g->w; ++x) {
+            vec2 c = sdf_grid_center(g, x, y);
+            vec2 s = j->seeds[(size_t)y * g->w + x];
+            float d = vec2_dist(&c, &s);
+            while (cross < nx && xs[cross] < c.x) cross++;
+            g->values[(size_t)y * g->w + x] = (cross & 1) ? -d : d;
+        }
+    }
+}
+
+/**
+ * @brief Bake a distance grid for a polygon or polyline with jump flooding.
+ *
+ * Cells along the boundary are seeded with their exact closest boundary point,
+ * which is then propagated with log2(max(w,h)) jump-flood passes plus one
+ * refinement pass (JFA+1), each pass parallel over rows. Polygons get their
+ * sign from a per-row scanline parity test, polylines stay unsigned.
+ *
+ * @param g      Grid with values, size, origin and cell already set.
+ * @param shape  Boundary vertices.
+ * @param n      Vertex count (>= 2, >= 3 when closed).
+ * @param closed true for a polygon (signed), false for an open polyline.
+ * @return false on allocation failure or invalid input (grid untouched).
+ * @note A shape that never touches the grid leaves every cell at INFINITY.
+ */
+static inline bool sdf_bake(sdf_grid* g, const vec2* shape, size_t n, bool closed)
+{
+    if (!g->values || n < 2 || (closed && n < 3)) return false;
+    const size_t cells = (size_t)g->w * (size_t)g->h;
+    const int workers = parallel_worker_count();
+    vec2* a = (vec2*)malloc(cells * sizeof(vec2));
+    vec2* b = (vec2*)malloc(cells * sizeof(vec2));
+    float* xs = (float*)malloc((size_t)workers * n * sizeof(float));
+    if (!a || !b || !xs) { free(a); free(b); free(xs); return false; }
+
+    for (size_t i = 0; i < cells; ++i) a[i] = (vec2){ INFINITY, INFINITY };
+
+    // Seed: march along every segment at half-cell steps, offering the exact
+    // closest point to the 3x3 cells around each sample.
+    const size_t segs = closed ? n : n - 1;
+    const float inv_cell = 1.0f / g->cell;
+    for (size_t k = 0; k < segs; ++k) {
+        vec2 p0 = shape[k], p1 = shape[(k + 1) % n];
+        vec2 d = vec2_sub(&p1, &p0);
+        const int steps = 1 + (int)(vec2_length(&d) * inv_cell * 2.0f);
+        for (int s = 0; s <= steps; ++s) {
+            const float t = (float)s / (float)steps;
+            const int cx = (int)floorf((p0.x + d.x * t - g->origin.x) * inv_cell);
+            const int cy = (int)floorf((p0.y + d.y * t - g->origin.y) * inv_cell);
+            for (int yy = cy - 1; yy <= cy + 1; ++yy) {
+                if (yy < 0 || yy >= g->h) continue;
+                for (int xx = cx - 1; xx <= cx + 1; ++xx) {
+                    if (xx < 0 || xx >= g->w) continue;
+                    vec2 c = sdf_grid_center(g, xx, yy);
+                    vec2 q = sdf_closest_on_segment(c, p0, p1);
+                    vec2* cur = &a[(size_t)yy * g->w + xx];
+                    if (vec2_dist2(&c, &q) < vec2_dist2(&c, cur)) *cur = q;
+                }
+            }
+        }
+    }
+
+    int step = 1;
+    while (step * 2 < (g->w > g->h ? g->w : g->h)) step *= 2;
+    sdf_jfa_job job = { g, a, b, step };
+    for (;;) {
+        parallel_for((size_t)g->h, 8, sdf_jfa_rows, &job);
+        vec2* t = (vec2*)job.src; job.src = job.dst; job.dst = t;
+        if (job.step == 1) break;
+        job.step /= 2;
+    }
+    parallel_for((size_t)g->h, 8, sdf_jfa_rows, &job); // JFA+1
+    const vec2* seeds = job.dst;
+
+    sdf_finish_job fin = { g, seeds, shape, n, closed, xs };
+    parallel_for((size_t)g->h, 8, sdf_finish_rows, &fin);
+
+    free(a); free(b); free(xs);
+    return true;
+}
+
+#endif // SDF_H
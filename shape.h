@@ -0,0 +1,365 @@
+﻿//
+// shape.h — convex hulls and extremal shape metrics of 2D point sets.
+//
+// The convex hull (Andrew's monotone chain) is the common input: the minimum
+// enclosing circle only depends on hull vertices, and the rotating-calipers
+// routines walk it once with pointers that only move forward, giving the
+// diameter, the width and the minimum-area bounding rectangle in O(h).
+//
+// The enclosing circle is Welzl's algorithm in its iterative form (randomized
+// incremental with three nested loops instead of recursion), shuffled by a
+// seeded rng so the same input and seed always give the same circle.
+//
+// Batch mode handles many small sets packed back to back (offsets into one
+// point array) on all workers, each with its own reusable scratch; set i uses
+// rng stream i, so results do not depend on the worker count.
+//
+
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+#include "rng.h"
+
+#define SHAPE_CIRCLE_EPS 1e-5f  // relative slack of the in-circle test
+
+typedef struct {
+    vec2  center;
+    float radius;
+} shape_circle;
+
+typedef struct {
+    vec2 center;
+    vec2 axis;   // unit direction of the first half extent
+    vec2 half;   // half extents along axis and its ccw perpendicular
+} shape_rect;
+
+typedef struct {
+    shape_circle circle;
+    shape_rect   rect;       // minimum-area bounding rectangle
+    float        diameter;   // largest point distance
+    float        width;      // smallest distance between parallel supporting lines
+    uint32_t     hull_count;
+} shape_metrics;
+
+// ------------------------------ Convex hull ----------------------------------
+
+// cross(a - o, b - o): > 0 for a counter-clockwise turn.
+static inline float shape_turn(vec2 o, vec2 a, vec2 b)
+{
+    vec2 u = vec2_sub(&a, &o), v = vec2_sub(&b, &o);
+    return vec2_cross(&u, &v);
+}
+
+static inline int shape_point_cmp(const void* pa, const void* pb)
+{
+    const vec2* a = (const vec2*)pa;
+    const vec2* b = (const vec2*)pb;
+    if (a->x != b->x) return a->x < b->x ? -1 : 1;
+    return (a->y > b->y) - (a->y < b->y);
+}
+
+// Hull with caller scratch of 3 * n points (sorted copy + chain stack).
+static inline size_t shape_hull_scratch(const vec2* pts, size_t n, vec2* scratch, vec2* out)
+{
+    vec2* s = scratch;
+    vec2* h = scratch + n;
+    memcpy(s, pts, n * sizeof(vec2));
+    qsort(s, n, sizeof(vec2), shape_point_cmp);
+    size_t m = 0;
+    for (size_t i = 0; i < n; ++i)
+        if (m == 0 || s[i].x != s[m - 1].x || s[i].y != s[m - 1].y) s[m++] = s[i];
+    if (m < 3) {
+        memcpy(out, s, m * sizeof(vec2));
+        return m;
+    }
+    size_t k = 0;
+    for (size_t i = 0; i < m; ++i) { // lower chain
+        while (k >= 2 && shape_turn(h[k - 2], h[k - 1], s[i]) <= 0.0f) k--;
+        h[k++] = s[i];
+    }
+    const size_t lower = k + 1;
+    for (size_t i = m - 1; i-- > 0;) { // upper chain, ends back at s[0]
+        while (k >= lower && shape_turn(h[k - 2], h[k - 1], s[i]) <= 0.0f) k--;
+        h[k++] = s[i];
+    }
+    memcpy(out, h, (k - 1) * sizeof(vec2));
+    return k - 1;
+}
+
+/**
+ * @brief Convex hull, counter-clockwise, without duplicate or collinear points.
+ *
+ * @param pts Points.
+ * @param n   Number of points.
+ * @param out Hull vertices (capacity n).
+ * @return Hull vertex count (0 on allocation failure or n == 0).
+ */
+static inline size_t shape_convex_hull(const vec2* pts, size_t n, vec2* out)
+{
+    if (n == 0) return 0;
+    vec2* scratch = (vec2*)malloc(3 * n * sizeof(vec2));
+    if (!scratch) return 0;
+    const size_t h = shape_hull_scratch(pts, n, scratch, out);
+    free(scratch);
+    return h;
+}
+
+// ------------------------------ Enclosing circle -----------------------------
+
+static inline bool shape_circle_contains(const shape_circle* c, vec2 p)
+{
+    vec2 center = c->center;
+    const float r = c->radius * (1.0f + SHAPE_CIRCLE_EPS);
+    return vec2_dist2(&center, &p) <= r * r;
+}
+
+static inline shape_circle shape_circle2(vec2 a, vec2 b)
+{
+    shape_circle c;
+    c.center = (vec2){ (a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f };
+    c.radius = vec2_dist(&a, &b) * 0.5f;
+    return c;
+}
+
+// Circumcircle, in double; nearly collinear points fall back to the widest pair.
+static inline shape_circle shape_circle3(vec2 a, vec2 b, vec2 p)
+{
+    const double bx = (double)b.x - a.x, by = (double)b.y - a.y;
+    const double cx = (double)p.x - a.x, cy = (double)p.y - a.y;
+    const double d = 2.0 * (bx * cy - by * cx);
+    const double b2 = bx * bx + by * by, c2 = cx * cx + cy * cy;
+    if (fabs(d) <= 1e-12 * (b2 + c2)) {
+        shape_circle c = shape_circle2(a, b);
+        shape_circle e = shape_circle2(a, p);
+        shape_circle f = shape_circle2(b, p);
+        if (e.radius > c.radius) c = e;
+        if (f.radius > c.radius) c = f;
+        return c;
+    }
+    const double ux = (cy * b2 - by * c2) / d, uy = (bx * c2 - cx * b2) / d;
+    shape_circle c;
+    c.center = (vec2){ (float)(a.x + ux), (float)(a.y + uy) };
+    // Largest distance after rounding the center, so all three stay inside.
+    float r2 = vec2_dist2(&c.center, &a);
+    r2 = fmaxf(r2, vec2_dist2(&c.center, &b));
+    r2 = fmaxf(r2, vec2_dist2(&c.center, &p));
+    c.radius = sqrtf(r2);
+    return c;
+}
+
+// Iterative Welzl over p (shuffled in place).
+static inline shape_circle shape_min_circle_inplace(vec2* p, size_t n, rng* r)
+{
+    shape_circle c = { { 0.0f, 0.0f }, 0.0f };
+    if (n == 0) return c;
+    for (size_t i = n - 1; i > 0; --i) { // Fisher-Yates
+        const size_t j = rng_below(r, (uint32_t)(i + 1));
+        const vec2 t = p[i]; p[i] = p[j]; p[j] = t;
+    }
+    c.center = p[0];
+    for (size_t i = 1; i < n; ++i) {
+        if (shape_circle_contains(&c, p[i])) continue;
+        c.center = p[i];
+        c.radius = 0.0f;
+        for (size_t j = 0; j < i; ++j) {
+            if (shape_circle_contains(&c, p[j])) continue;
+            c = shape_circle2(p[i], p[j]);
+            for (size_t k = 0; k < j; ++k)
+                if (!shape_circle_contains(&c, p[k])) c = shape_circle3(p[i], p[j], p[k]);
+        }
+    }
+    return c;
+}
+
+/**
+ * @brief Minimum enclosing circle (Welzl, expected O(n)).
+ *
+ * @param pts  Points (n < 2^32).
+ * @param n    Number of points.
+ * @param seed Shuffle seed.
+ * @param out  Circle; radius 0 around the origin for n == 0.
+ * @return false on allocation failure.
+ */
+static inline bool shape_min_circle(const vec2* pts, size_t n, uint64_t seed, shape_circle* out)
+{
+    vec2* p = (vec2*)malloc((n ? n : 1) * sizeof(vec2));
+    if (!p) return false;
+    memcpy(p, pts, n * sizeof(vec2));
+    rng r;
+    rng_seed(&r, seed, 0);
+    *out = shape_min_circle_inplace(p, n, &r);
+    free(p);
+    return true;
+}
+
+// ------------------------------ Rotating calipers ----------------------------
+
+// dot(p - o, axis)
+static inline float shape_proj(vec2 p, vec2 o, vec2 axis)
+{
+    vec2 d = vec2_sub(&p, &o);
+    return vec2_dot(&d, &axis);
+}
+
+/**
+ * @brief Diameter, width and minimum-area rectangle of a convex polygon.
+ *
+ * @param hull     Counter-clockwise convex polygon without collinear points,
+ *                 as returned by shape_convex_hull.
+ * @param h        Vertex count.
+ * @param diameter Output: largest vertex distance.
+ * @param width    Output: smallest distance between parallel supporting lines.
+ * @param rect     Output: minimum-area bounding rectangle (an edge of it is
+ *                 collinear with a hull edge).
+ */
+static inline void shape_calipers(const vec2* hull, size_t h, float* diameter, float* width, shape_rect* rect)
+{
+    *diameter = 0.0f;
+    *width = 0.0f;
+    rect->center = h ? hull[0] : (vec2){ 0.0f, 0.0f };
+    rect->axis = (vec2){ 1.0f, 0.0f };
+    rect->half = (vec2){ 0.0f, 0.0f };
+    if (h < 2) return;
+    if (h == 2) {
+        vec2 a = hull[0], b = hull[1];
+        vec2 e = vec2_sub(&b, &a);
+        *diameter = vec2_length(&e);
+        rect->center = (vec2){ (a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f };
+        rect->axis = vec2_normalize(&e);
+        rect->half = (vec2){ *diameter * 0.5f, 0.0f };
+        return;
+    }
+
+    float best_d2 = 0.0f, best_w = INFINITY, best_area = INFINITY;
+    size_t far = 1, hi = 1, lo = 0;
+    for (size_t i = 0; i < h; ++i) {
+        vec2 a = hull[i], b = hull[(i + 1) % h];
+        vec2 ab = vec2_sub(&b, &a);
+        vec2 e = vec2_normalize(&ab);
+        vec2 n = vec2_rot90_ccw(&e);
+
+        // Antipodal vertex: farthest from the edge line (the hull lies to its left).
+        while (shape_proj(hull[(far + 1) % h], a, n) > shape_proj(hull[far], a, n)) far = (far + 1) % h;
+        // Extremes along the edge direction.
+        while (shape_proj(hull[(hi + 1) % h], a, e) > shape_proj(hull[hi], a, e)) hi = (hi + 1) % h;
+        if (i == 0) lo = far;
+        while (shape_proj(hull[(lo + 1) % h], a, e) < shape_proj(hull[lo], a, e)) lo = (lo + 1) % h;
+
+        const float height = shape_proj(hull[far], a, n);
+        const float smax = shape_proj(hull[hi], a, e), smin = shape_proj(hull[lo], a, e);
+
+        // Every antipodal pair shows up as (edge endpoint, far vertex).
+        vec2 pf = hull[far];
+        best_d2 = fmaxf(best_d2, fmaxf(vec2_dist2(&pf, &a), vec2_dist2(&pf, &b)));
+        if (height < best_w) best_w = height;
+        const float area = height * (smax - smin);
+        if (area < best_area) {
+            best_area = area;
+            const float s = (smin + smax) * 0.5f, t = height * 0.5f;
+            rect->center = (vec2){ a.x + e.x * s + n.x * t, a.y + e.y * s + n.y * t };
+            rect->axis = e;
+            rect->half = (vec2){ (smax - smin) * 0.5f, t };
+        }
+    }
+    *diameter = sqrtf(best_d2);
+    *width = best_w;
+}
+
+// ------------------------------ Metrics --------------------------------------
+
+// All metrics of one set, with caller scratch of 4 * n points.
+static inline void shape_metrics_scratch(const vec2* pts, size_t n, rng* r, vec2* scratch, shape_metrics* out)
+{
+    vec2* hull = scratch + 3 * n;
+    const size_t h = shape_hull_scratch(pts, n, scratch, hull);
+    out->hull_count = (uint32_t)h;
+    shape_calipers(hull, h, &out->diameter, &out->width, &out->rect);
+    out->circle = shape_min_circle_inplace(hull, h, r); // shuffles the hull last
+}
+
+/**
+ * @brief Hull size, enclosing circle, diameter, width and minimum-area rectangle.
+ *
+ * @param pts  Points (n < 2^32).
+ * @param n    Number of points.
+ * @param seed Enclosing circle shuffle seed.
+ * @param out  Metrics.
+ * @return false on allocation failure.
+ */
+static inline bool shape_metrics_compute(const vec2* pts, size_t n, uint64_t seed, shape_metrics* out)
+{
+    vec2* scratch = (vec2*)malloc((4 * n + 1) * sizeof(vec2));
+    if (!scratch) return false;
+    rng r;
+    rng_seed(&r, seed, 0);
+    shape_metrics_scratch(pts, n, &r, scratch, out);
+    free(scratch);
+    return true;
+}
+
+typedef struct {
+    const vec2*     pts;
+    const uint32_t* offsets;
+    uint64_t        seed;
+    shape_metrics*  out;
+    vec2*           scratch[PARALLEL_MAX_WORKERS];
+    size_t          cap[PARALLEL_MAX_WORKERS];
+    bool            failed[PARALLEL_MAX_WORKERS];
+} shape_batch_job;
+
+static inline void shape_batch_range(void* user, size_t begin, size_t end, int worker)
+{
+    shape_batch_job* j = (shape_batch_job*)user;
+    for (size_t i = begin; i < end; ++i) {
+        const size_t n = j->offsets[i + 1] - j->offsets[i];
+        if (4 * n + 1 > j->cap[worker]) {
+            size_t cap = j->cap[worker] ? j->cap[worker] : 256;
+            while (cap < 4 * n + 1) cap *= 2;
+            vec2* grown = (vec2*)realloc(j->scratch[worker], cap * sizeof(vec2));
+            if (!grown) { j->failed[worker] = true; return; }
+            j->scratch[worker] = grown;
+            j->cap[worker] = cap;
+        }
+        rng r;
+        rng_seed(&r, j->seed, i);
+        shape_metrics_scratch(j->pts + j->offsets[i], n, &r, j->scratch[worker], &j->out[i]);
+    }
+}
+
+/**
+ * @brief shape_metrics_compute for many sets, on all workers.
+ *
+ * @param pts     All points, set after set.
+ * @param offsets count + 1 offsets; set i is pts[offsets[i] .. offsets[i + 1]).
+ * @param count   Number of sets.
+ * @param seed    Shuffle seed (set i uses rng stream i).
+ * @param out     count metrics.
+ * @return false on allocation failure.
+ */
+static inline bool shape_metrics_batch(const vec2* pts, const uint32_t* offsets, size_t count,
+                                       uint64_t seed, shape_metrics* out)
+{
+    shape_batch_job* j = (shape_batch_job*)calloc(1, sizeof(shape_batch_job));
+    if (!j) return false;
+    j->pts = pts;
+    j->offsets = offsets;
+    j->seed = seed;
+    j->out = out;
+    parallel_for(count, 64, shape_batch_range, j);
+    bool ok = true;
+    for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) {
+        ok = ok && !j->failed[w];
+        free(j->scratch[w]);
+    }
+    free(j);
+    return ok;
+}
+
+#endif // SHAPE_H
@@ -0,0 +1,149 @@
+﻿//
+// spatial_grid.h — uniform bucket grid over a static point set.
+//
+// Points are counting-sorted by cell, so each cell is a contiguous run of
+// indices (cell_start[c] .. cell_start[c+1]). Building is O(n), radius queries
+// visit only the cells overlapping the query disc.
+//
+
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+
+#define SPATIAL_GRID_MAX_CELLS_PER_POINT 4 // caps memory for sparse, spread-out sets
+
+typedef struct {
+    vec2      lo;          // lower-left corner of cell (0,0)
+    float     cell;        // cell edge
+    float     inv_cell;
+    int       gw, gh;
+    uint32_t* cell_start;  // gw*gh + 1 offsets into items
+    uint32_t* items;       // point indices grouped by cell
+    uint32_t  count;       // number of points
+} spatial_grid;
+
+static inline void spatial_grid_cell_of(const spatial_grid* g, vec2 p, int* cx, int* cy)
+{
+    // Clamp in float so far-away queries cannot overflow the int conversion.
+    const float fx = fminf(fmaxf(floorf((p.x - g->lo.x) * g->inv_cell), 0.0f), (float)(g->gw - 1));
+    const float fy = fminf(fmaxf(floorf((p.y - g->lo.y) * g->inv_cell), 0.0f), (float)(g->gh - 1));
+    *cx = (int)fx;
+    *cy = (int)fy;
+}
+
+/**
+ * @brief Bucket points into a grid with the given cell size.
+ *
+ * The cell is enlarged when the bounding box would need more than
+ * SPATIAL_GRID_MAX_CELLS_PER_POINT cells per point; queries stay correct, they
+ * just test more candidates.
+ *
+ * @param g    Grid to build (free with spatial_grid_free).
+ * @param pts  Points (must outlive the grid for queries).
+ * @param n    Number of points (< 2^32).
+ * @param cell Desired cell edge (> 0), typically the query radius.
+ * @return false on invalid input or allocation failure.
+ */
+static inline bool spatial_grid_build(spatial_grid* g, const vec2* pts, size_t n, float cell)
+{
+    memset(g, 0, sizeof(*g));
+    if (!(cell > 0.0f) || n >= UINT32_MAX) return false;
+
+    vec2 lo = { INFINITY, INFINITY }, hi = { -INFINITY, -INFINITY };
+    for (size_t i = 0; i < n; ++i) {
+        vec2 p = pts[i];
+        lo = vec2_min(&lo, &p);
+        hi = vec2_max(&hi, &p);
+    }
+    if (n == 0) { lo = (vec2){ 0.0f, 0.0f }; hi = lo; }
+
+    const double ex = (double)hi.x - lo.x, ey = (double)hi.y - lo.y;
+    if (!(ex < INFINITY && ey < INFINITY)) return false; // non-finite input
+    const double max_cells = (double)(n ? n : 1) * SPATIAL_GRID_MAX_CELLS_PER_POINT;
+    double c = cell;
+    while ((floor(ex / c) + 1.0) * (floor(ey / c) + 1.0) > max_cells) c *= 2.0;
+
+    g->lo = lo;
+    g->cell = (float)c;
+    g->inv_cell = (float)(1.0 / c);
+    g->gw = (int)floor(ex / c) + 1;
+    g->gh = (int)floor(ey / c) + 1;
+    g->count = (uint32_t)n;
+
+    const size_t cells = (size_t)g->gw * (size_t)g->gh;
+    g->cell_start = (uint32_t*)calloc(cells + 1, sizeof(uint32_t));
+    g->items = (uint32_t*)malloc((n ? n : 1) * sizeof(uint32_t));
+    uint32_t* key = (uint32_t*)malloc((n ? n : 1) * sizeof(uint32_t));
+    if (!g->cell_start || !g->items || !key) {
+        free(key);
+        free(g->cell_start); free(g->items);
+        memset(g, 0, sizeof(*g));
+        return false;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        int cx, cy;
+        spatial_grid_cell_of(g, pts[i], &cx, &cy);
+        key[i] = (uint32_t)((size_t)cy * g->gw + cx);
+        g->cell_start[key[i] + 1]++;
+    }
+    for (size_t c2 = 0; c2 < cells; ++c2) g->cell_start[c2 + 1] += g->cell_start[c2];
+    // Scatter using cell_start as cursors, then shift them back.
+    for (size_t i = 0; i < n; ++i) g->items[g->cell_start[key[i]]++] = (uint32_t)i;
+    for (size_t c2 = cells; c2 > 0; --c2) g->cell_start[c2] = g->cell_start[c2 - 1];
+    g->cell_start[0] = 0;
+
+    free(key);
+    return true;
+}
+
+static inline void spatial_grid_free(spatial_grid* g)
+{
+    free(g->cell_start);
+    free(g->items);
+    memset(g, 0, sizeof(*g));
+}
+
+/**
+ * @brief Indices of all points within distance r of p (inclusive).
+ *
+ * @param g   Grid built over pts.
+ * @param pts The same points the grid was built from.
+ * @param p   Query point.
+ * @param r   Query radius.
+ * @param out Output indices (may be NULL when cap is 0).
+ * @param cap Capacity of out.
+ * @return Number of points found; only the first cap are written.
+ */
+static inline size_t spatial_grid_query(const spatial_grid* g, const vec2* pts, vec2 p, float r,
+                                        uint32_t* out, size_t cap)
+{
+    if (!g->cell_start) return 0;
+    int x0, y0, x1, y1;
+    spatial_grid_cell_of(g, (vec2){ p.x - r, p.y - r }, &x0, &y0);
+    spatial_grid_cell_of(g, (vec2){ p.x + r, p.y + r }, &x1, &y1);
+    const float r2 = r * r;
+    size_t n = 0;
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            const size_t c = (size_t)y * g->gw + x;
+            for (uint32_t k = g->cell_start[c]; k < g->cell_start[c + 1]; ++k) {
+                const uint32_t i = g->items[k];
+                vec2 q = pts[i];
+                if (vec2_dist2(&p, &q) <= r2) {
+                    if (n < cap) out[n] = i;
+                    n++;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+#endif // SPATIAL_GRID_H
@@ -0,0 +1,235 @@
+﻿//
+// trajectory.h — binary corpus of 2D trajectories, written sequentially and
+// read back through a read-only memory mapping.
+//
+// Layout (little-endian, every section 8-byte aligned):
+//
+//   traj_file_header   magic "J2TR", version, counts, section offsets
+//   points             point_count vec2 (x, y float32), all trajectories back to back
+//   offsets            count + 1 uint64 point indices; trajectory i is
+//                      points[offsets[i] .. offsets[i + 1])
+//
+// Offsets come last so a writer can stream trajectories of unknown count and
+// only patch the header on close. A mapped corpus is used in place: no
+// parsing, no copies, pages load on demand.
+//
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "vector2.h"
+
+#define TRAJ_MAGIC   0x52543248u // "J2TR"
+#define TRAJ_VERSION 1u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;        // trajectories
+    uint64_t point_count;
+    uint64_t points_pos;   // byte offset of the points section
+    uint64_t offsets_pos;  // byte offset of the offsets section
+} traj_file_header;
+
+// ------------------------------ Writer ----------------------------------------
+
+typedef struct {
+    FILE*     f;
+    uint64_t* offsets;     // count + 1 entries, grown on demand
+    size_t    count;
+    size_t    cap;
+    bool      failed;
+} traj_writer;
+
+/**
+ * @brief Start a corpus file; trajectories are appended with traj_writer_add.
+ *
+ * @param w    Writer state.
+ * @param path Output path (overwritten).
+ * @return false if the file cannot be created.
+ */
+static inline bool traj_writer_open(traj_writer* w, const char* path)
+{
+    memset(w, 0, sizeof(*w));
+    w->f = fopen(path, "wb");
+    if (!w->f) return false;
+    w->cap = 1024;
+    w->offsets = (uint64_t*)malloc(w->cap * sizeof(uint64_t));
+    traj_file_header h;
+    memset(&h, 0, sizeof(h)); // placeholder, patched by traj_writer_close
+    if (!w->offsets || fwrite(&h, sizeof(h), 1, w->f) != 1) {
+        fclose(w->f);
+        free(w->offsets);
+        memset(w, 0, sizeof(*w));
+        return false;
+    }
+    w->offsets[0] = 0;
+    return true;
+}
+
+/**
+ * @brief Append one trajectory.
+ *
+ * @return false on a write or allocation failure (the writer then fails on close).
+ */
+static inline bool traj_writer_add(traj_writer* w, const vec2* pts, size_t n)
+{
+    if (w->failed) return false;
+    if (w->count + 2 > w->cap) {
+        uint64_t* grown = (uint64_t*)realloc(w->offsets, w->cap * 2 * sizeof(uint64_t));
+        if (!grown) { w->failed = true; return false; }
+        w->offsets = grown;
+        w->cap *= 2;
+    }
+    if (n && fwrite(pts, sizeof(vec2), n, w->f) != n) { w->failed = true; return false; }
+    w->offsets[w->count + 1] = w->offsets[w->count] + n;
+    w->count++;
+    return true;
+}
+
+/**
+ * @brief Write the offsets and header and close the file.
+ *
+ * @return false if any write failed; the file is then incomplete.
+ */
+static inline bool traj_writer_close(traj_writer* w)
+{
+    bool ok = !w->failed && w->f;
+    if (ok) {
+        traj_file_header h;
+        h.magic = TRAJ_MAGIC;
+        h.version = TRAJ_VERSION;
+        h.count = w->count;
+        h.point_count = w->offsets[w->count];
+        h.points_pos = sizeof(traj_file_header);
+        h.offsets_pos = h.points_pos + h.point_count * sizeof(vec2);
+        ok = fwrite(w->offsets, sizeof(uint64_t), w->count + 1, w->f) == w->count + 1
+          && fseek(w->f, 0, SEEK_SET) == 0
+          && fwrite(&h, sizeof(h), 1, w->f) == 1;
+    }
+    if (w->f && fclose(w->f) != 0) ok = false;
+    free(w->offsets);
+    memset(w, 0, sizeof(*w));
+    return ok;
+}
+
+// ------------------------------ Mapped reader --------------------------------
+
+typedef struct {
+    const vec2*     points;
+    const uint64_t* offsets;
+    size_t          count;
+    const void*     base;
+    size_t          size;
+#ifdef _WIN32
+    HANDLE          file;
+    HANDLE          mapping;
+#endif
+} traj_corpus;
+
+static inline void traj_corpus_close(traj_corpus* c)
+{
+    if (!c->base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(c->base);
+    CloseHandle(c->mapping);
+    CloseHandle(c->file);
+#else
+    munmap((void*)c->base, c->size);
+#endif
+    memset(c, 0, sizeof(*c));
+}
+
+/**
+ * @brief Map a corpus file read-only and validate its header.
+ *
+ * @param c    Corpus (close with traj_corpus_close).
+ * @param path Corpus path.
+ * @return false if the file cannot be mapped or is not a valid corpus.
+ */
+static inline bool traj_corpus_open(traj_corpus* c, const char* path)
+{
+    memset(c, 0, sizeof(*c));
+#ifdef _WIN32
+    c->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                          FILE_ATTRIBUTE_NORMAL, NULL);
+    if (c->file == INVALID_HANDLE_VALUE) { c->file = NULL; return false; }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(c->file, &size) || size.QuadPart < (LONGLONG)sizeof(traj_file_header)) {
+        CloseHandle(c->file);
+        c->file = NULL;
+        return false;
+    }
+    c->size = (size_t)size.QuadPart;
+    c->mapping = CreateFileMappingA(c->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    c->base = c->mapping ? MapViewOfFile(c->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!c->base) {
+        if (c->mapping) CloseHandle(c->mapping);
+        CloseHandle(c->file);
+        memset(c, 0, sizeof(*c));
+        return false;
+    }
+#else
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(traj_file_header)) { close(fd); return false; }
+    c->size = (size_t)st.st_size;
+    void* base = mmap(NULL, c->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if (base == MAP_FAILED) { c->size = 0; return false; }
+    c->base = base;
+#endif
+
+    traj_file_header h;
+    memcpy(&h, c->base, sizeof(h));
+    const uint64_t file_size = c->size;
+    bool ok = h.magic == TRAJ_MAGIC && h.version == TRAJ_VERSION
+           && h.points_pos == sizeof(traj_file_header)
+           && h.point_count <= (file_size - h.points_pos) / sizeof(vec2)
+           && h.offsets_pos == h.points_pos + h.point_count * sizeof(vec2)
+           && h.count < (file_size - h.offsets_pos) / sizeof(uint64_t);
+    if (ok) {
+        c->points = (const vec2*)((const char*)c->base + h.points_pos);
+        c->offsets = (const uint64_t*)((const char*)c->base + h.offsets_pos);
+        c->count = (size_t)h.count;
+        // Offsets must be monotonic and inside the points section.
+        ok = c->offsets[0] == 0 && c->offsets[c->count] == h.point_count;
+        for (size_t i = 0; ok && i < c->count; ++i) ok = c->offsets[i] <= c->offsets[i + 1];
+    }
+    if (!ok) {
+        traj_corpus_close(c);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Points of trajectory i (pointer into the mapping).
+ *
+ * @param c Open corpus.
+ * @param i Trajectory index (< c->count).
+ * @param n Output: number of points.
+ */
+static inline const vec2* traj_corpus_get(const traj_corpus* c, size_t i, size_t* n)
+{
+    *n = (size_t)(c->offsets[i + 1] - c->offsets[i]);
+    return c->points + c->offsets[i];
+}
+
+#endif // TRAJECTORY_H
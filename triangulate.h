@@ -0,0 +1,779 @@
+﻿//
+// triangulate.h — triangulation of simple polygons and polygons with holes.
+//
+// Two triangulators share one input path: rings are copied into a reusable
+// scratch, consecutive duplicates dropped, and linked as circular lists with
+// the interior on the left (outer ring counter-clockwise, holes clockwise),
+// whatever the input winding.
+//
+// Ear clipping (simple polygons, best for small ones): an ear is a convex
+// vertex whose triangle holds no reflex vertex. From TRI_EAR_HASH_MIN vertices
+// on, candidates for that test come from a z-order (Morton) sorted list of the
+// vertices restricted to the triangle's bounding box instead of the whole
+// ring. Worst case O(n²).
+//
+// Monotone decomposition (any size, holes allowed), O(n log n): a top-down
+// sweep classifies vertices (start, end, split, merge, regular) and adds the
+// diagonals that split the polygon into y-monotone pieces; the sweep status is
+// a treap of the edges crossing the sweep line. Pieces are traced from the
+// edges plus diagonals and triangulated with the linear stack algorithm.
+//
+// Output is 3 vertex indices per counter-clockwise triangle into a caller
+// buffer. A polygon with n vertices and h holes gives n + 2h - 2 triangles
+// (fewer when duplicate or collinear vertices are dropped).
+//
+
+#ifndef TRIANGULATE_H
+#define TRIANGULATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+#include "polygon.h"
+
+#define TRI_NONE          UINT32_MAX
+#define TRI_EAR_HASH_MIN  32   // ring size from which ear tests use the z-order list
+#define TRI_EAR_MAX       128  // tri_triangulate: largest ring sent to the ear clipper
+
+typedef struct {
+    const vec2*     verts;
+    const uint32_t* ring_start;  // ring_count + 1 offsets into verts; ring 0 is the outer boundary
+    uint32_t        ring_count;
+} tri_polygon;
+
+enum {
+    TRI_START,
+    TRI_END,
+    TRI_SPLIT,
+    TRI_MERGE,
+    TRI_REGULAR_LEFT,   // interior to the right (left boundary, going down)
+    TRI_REGULAR_RIGHT,
+};
+
+/**
+ * @brief Reusable per-thread memory; grows on demand.
+ */
+typedef struct {
+    vec2*     p;
+    uint32_t* id;        // input index of each loaded vertex
+    uint32_t* next;      // ring links, interior on the left
+    uint32_t* prev;
+    uint32_t* z;         // ear clipping: Morton code, z-ordered links
+    uint32_t* nextz;
+    uint32_t* prevz;
+    uint32_t* order;     // monotone: vertices top to bottom, then a piece in sweep order
+    uint32_t* rank;      // position in the sweep
+    uint32_t* tl;        // treap children and priority, per edge (v, next[v])
+    uint32_t* tr;
+    uint32_t* helper;
+    uint32_t* diag;      // diagonal endpoint pairs
+    uint32_t* adj_start; // n + 1: outgoing half-edges (ring edges and diagonals) per vertex
+    uint32_t* adj;
+    uint32_t* face;
+    uint32_t* stack;
+    uint8_t*  type;
+    uint8_t*  side;      // chain of each piece vertex: 0 left, 1 right
+    uint8_t*  used;      // per half-edge
+    void*     block;
+    size_t    cap;
+    uint32_t* ring_first;
+    uint32_t* ring_len;
+    size_t    ring_cap;
+    uint32_t  n, rings, diag_count;
+} tri_scratch;
+
+static inline void tri_scratch_init(tri_scratch* s)
+{
+    memset(s, 0, sizeof(*s));
+}
+
+static inline void tri_scratch_free(tri_scratch* s)
+{
+    free(s->block);
+    free(s->ring_first);
+    free(s->ring_len);
+    memset(s, 0, sizeof(*s));
+}
+
+// Room for n vertices and `rings` rings; invalidates loaded data on growth.
+static inline bool tri_scratch_reserve(tri_scratch* s, size_t n, size_t rings)
+{
+    if (rings > s->ring_cap) {
+        uint32_t* f = (uint32_t*)realloc(s->ring_first, rings * sizeof(uint32_t));
+        if (f) s->ring_first = f;
+        uint32_t* l = (uint32_t*)realloc(s->ring_len, rings * sizeof(uint32_t));
+        if (l) s->ring_len = l;
+        if (!f || !l) return false;
+        s->ring_cap = rings;
+    }
+    if (n <= s->cap) return true;
+    size_t cap = s->cap ? s->cap : 64;
+    while (cap < n) cap *= 2;
+    if (cap >= (1u << 28)) return false;
+    // vec2 first, then uint32 arrays (13 of cap, diag 4 cap, adj_start cap + 1,
+    // adj 5 cap), then bytes (type, side: cap; used: 5 cap).
+    const size_t words = 13 * cap + 4 * cap + (cap + 1) + 5 * cap;
+    unsigned char* b = (unsigned char*)malloc(cap * sizeof(vec2) + words * sizeof(uint32_t) + 7 * cap);
+    if (!b) return false;
+    free(s->block);
+    s->block = b;
+    s->cap = cap;
+    s->p = (vec2*)b;
+    uint32_t* w = (uint32_t*)(b + cap * sizeof(vec2));
+    uint32_t** arrays[] = { &s->id, &s->next, &s->prev, &s->z, &s->nextz, &s->prevz, &s->order,
+                            &s->rank, &s->tl, &s->tr, &s->helper, &s->face, &s->stack };
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); ++i) { *arrays[i] = w; w += cap; }
+    s->diag = w;      w += 4 * cap;
+    s->adj_start = w; w += cap + 1;
+    s->adj = w;       w += 5 * cap;
+    unsigned char* u = (unsigned char*)w;
+    s->type = u;      u += cap;
+    s->side = u;      u += cap;
+    s->used = u;
+    return true;
+}
+
+// ------------------------------ Loading --------------------------------------
+
+static inline float tri_area2(vec2 a, vec2 b, vec2 c)
+{
+    vec2 u = vec2_sub(&b, &a), v = vec2_sub(&c, &a);
+    return vec2_cross(&u, &v);
+}
+
+// Links the ring loaded at p[first .. s->n): drops consecutive duplicates and
+// orients it (ccw for the outer ring, cw for holes). Rings under 3 vertices are
+// discarded.
+static inline void tri_close_ring(tri_scratch* s, uint32_t first, bool ccw)
+{
+    uint32_t m = first;
+    for (uint32_t k = first; k < s->n; ++k) {
+        if (m > first && s->p[k].x == s->p[m - 1].x && s->p[k].y == s->p[m - 1].y) continue;
+        s->p[m] = s->p[k];
+        s->id[m] = s->id[k];
+        m++;
+    }
+    while (m - first > 1 && s->p[m - 1].x == s->p[first].x && s->p[m - 1].y == s->p[first].y) m--;
+    const uint32_t len = m - first;
+    if (len < 3) {
+        s->n = first;
+        return;
+    }
+    float area = 0.0f;
+    for (uint32_t k = first + 1; k + 1 < m; ++k) area += tri_area2(s->p[first], s->p[k], s->p[k + 1]);
+    const bool flip = (area > 0.0f) != ccw;
+    for (uint32_t k = first; k < m; ++k) {
+        const uint32_t fwd = k + 1 < m ? k + 1 : first, back = k > first ? k - 1 : m - 1;
+        s->next[k] = flip ? back : fwd;
+        s->prev[k] = flip ? fwd : back;
+    }
+    s->ring_first[s->rings] = first;
+    s->ring_len[s->rings] = len;
+    s->rings++;
+    s->n = m;
+}
+
+static inline bool tri_load_polygon(tri_scratch* s, const tri_polygon* poly)
+{
+    const size_t total = poly->ring_count ? poly->ring_start[poly->ring_count] - poly->ring_start[0] : 0;
+    if (!tri_scratch_reserve(s, total, poly->ring_count)) return false;
+    s->n = s->rings = 0;
+    for (uint32_t r = 0; r < poly->ring_count; ++r) {
+        const uint32_t first = s->n;
+        for (uint32_t v = poly->ring_start[r]; v < poly->ring_start[r + 1]; ++v) {
+            s->p[s->n] = poly->verts[v];
+            s->id[s->n++] = v;
+        }
+        tri_close_ring(s, first, r == 0);
+        if (r == 0 && s->rings == 0) return true; // degenerate outer ring: nothing to fill
+    }
+    return true;
+}
+
+static inline bool tri_load_soup(tri_scratch* s, const poly_soup* soup, size_t i)
+{
+    const uint32_t begin = soup->offsets[i], end = soup->offsets[i + 1];
+    if (!tri_scratch_reserve(s, end - begin, 1)) return false;
+    s->n = s->rings = 0;
+    for (uint32_t v = begin; v < end; ++v) {
+        s->p[s->n] = (vec2){ soup->xs[v], soup->ys[v] };
+        s->id[s->n++] = v;
+    }
+    tri_close_ring(s, 0, true);
+    return true;
+}
+
+// Appends triangle (a, b, c) of loaded vertices, counter-clockwise.
+static inline bool tri_emit(const tri_scratch* s, uint32_t a, uint32_t b, uint32_t c,
+                            uint32_t* out, size_t cap, size_t* count)
+{
+    if (*count >= cap) return false;
+    if (tri_area2(s->p[a], s->p[b], s->p[c]) < 0.0f) { const uint32_t t = b; b = c; c = t; }
+    uint32_t* o = out + 3 * *count;
+    o[0] = s->id[a]; o[1] = s->id[b]; o[2] = s->id[c];
+    (*count)++;
+    return true;
+}
+
+// ------------------------------ Ear clipping ---------------------------------
+
+// 16-bit coordinates interleaved.
+static inline uint32_t tri_morton(uint32_t x, uint32_t y)
+{
+    x = (x | (x << 8)) & 0x00FF00FFu; x = (x | (x << 4)) & 0x0F0F0F0Fu;
+    x = (x | (x << 2)) & 0x33333333u; x = (x | (x << 1)) & 0x55555555u;
+    y = (y | (y << 8)) & 0x00FF00FFu; y = (y | (y << 4)) & 0x0F0F0F0Fu;
+    y = (y | (y << 2)) & 0x33333333u; y = (y | (y << 1)) & 0x55555555u;
+    return x | (y << 1);
+}
+
+typedef struct {
+    vec2  lo;
+    float scale;  // world to 16-bit grid
+} tri_zframe;
+
+static inline uint32_t tri_zcode(const tri_zframe* f, vec2 p)
+{
+    return tri_morton((uint32_t)((p.x - f->lo.x) * f->scale), (uint32_t)((p.y - f->lo.y) * f->scale));
+}
+
+typedef struct {
+    uint32_t z, v;
+} tri_zkey;
+
+static inline int tri_zkey_cmp(const void* a, const void* b)
+{
+    const uint32_t x = ((const tri_zkey*)a)->z, y = ((const tri_zkey*)b)->z;
+    return (x > y) - (x < y);
+}
+
+// Vertex q keeps a - b - c from being an ear: it is reflex (or flat) and lies
+// in the triangle. Copies of a or c (touching rings) do not count.
+static inline bool tri_ear_blocked(const tri_scratch* s, uint32_t q, vec2 a, vec2 b, vec2 c)
+{
+    const vec2 p = s->p[q];
+    if ((p.x == a.x && p.y == a.y) || (p.x == c.x && p.y == c.y)) return false;
+    return tri_area2(a, b, p) >= 0.0f && tri_area2(b, c, p) >= 0.0f && tri_area2(c, a, p) >= 0.0f
+        && tri_area2(s->p[s->prev[q]], p, s->p[s->next[q]]) <= 0.0f;
+}
+
+static inline bool tri_is_ear(const tri_scratch* s, uint32_t ear, const tri_zframe* f)
+{
+    const uint32_t ia = s->prev[ear], ic = s->next[ear];
+    vec2 a = s->p[ia], b = s->p[ear], c = s->p[ic];
+    if (tri_area2(a, b, c) <= 0.0f) return false; // reflex or flat
+    if (!f) {
+        for (uint32_t q = s->next[ic]; q != ia; q = s->next[q])
+            if (tri_ear_blocked(s, q, a, b, c)) return false;
+        return true;
+    }
+    // Only vertices whose code lies between the codes of the bounding box corners.
+    vec2 lo = vec2_min(&a, &b), hi = vec2_max(&a, &b);
+    lo = vec2_min(&lo, &c);
+    hi = vec2_max(&hi, &c);
+    const uint32_t zmin = tri_zcode(f, lo), zmax = tri_zcode(f, hi);
+    for (uint32_t q = s->nextz[ear]; q != TRI_NONE && s->z[q] <= zmax; q = s->nextz[q])
+        if (q != ia && q != ic && tri_ear_blocked(s, q, a, b, c)) return false;
+    for (uint32_t q = s->prevz[ear]; q != TRI_NONE && s->z[q] >= zmin; q = s->prevz[q])
+        if (q != ia && q != ic && tri_ear_blocked(s, q, a, b, c)) return false;
+    return true;
+}
+
+static inline void tri_unlink(tri_scratch* s, uint32_t v, bool hashed)
+{
+    s->next[s->prev[v]] = s->next[v];
+    s->prev[s->next[v]] = s->prev[v];
+    if (!hashed) return;
+    if (s->prevz[v] != TRI_NONE) s->nextz[s->prevz[v]] = s->nextz[v];
+    if (s->nextz[v] != TRI_NONE) s->prevz[s->nextz[v]] = s->prevz[v];
+}
+
+// Ear-clips loaded ring 0; returns the triangle count or SIZE_MAX.
+static inline size_t tri_run_earclip(tri_scratch* s, uint32_t* out, size_t cap)
+{
+    if (s->rings == 0) return 0;
+    uint32_t left = s->ring_len[0];
+    const uint32_t first = s->ring_first[0];
+    const bool hashed = left >= TRI_EAR_HASH_MIN;
+    tri_zframe frame;
+    if (hashed) {
+        vec2 lo = s->p[first], hi = lo;
+        for (uint32_t v = first; v < first + left; ++v) {
+            lo = vec2_min(&lo, &s->p[v]);
+            hi = vec2_max(&hi, &s->p[v]);
+        }
+        const float size = fmaxf(hi.x - lo.x, hi.y - lo.y);
+        frame.lo = lo;
+        frame.scale = size > 0.0f ? 32767.0f / size : 0.0f;
+        // Sort by code in the diagonal array, idle while ear clipping.
+        tri_zkey* keys = (tri_zkey*)s->diag;
+        for (uint32_t v = first; v < first + left; ++v) {
+            s->z[v] = tri_zcode(&frame, s->p[v]);
+            keys[v - first] = (tri_zkey){ s->z[v], v };
+        }
+        qsort(keys, left, sizeof(tri_zkey), tri_zkey_cmp);
+        for (uint32_t k = 0; k < left; ++k) {
+            s->prevz[keys[k].v] = k > 0 ? keys[k - 1].v : TRI_NONE;
+            s->nextz[keys[k].v] = k + 1 < left ? keys[k + 1].v : TRI_NONE;
+        }
+    }
+
+    size_t count = 0;
+    uint32_t ear = first, stop = first;
+    while (left > 3) {
+        const uint32_t a = s->prev[ear], c = s->next[ear];
+        if (tri_is_ear(s, ear, hashed ? &frame : NULL)) {
+            if (!tri_emit(s, a, ear, c, out, cap, &count)) return SIZE_MAX;
+            tri_unlink(s, ear, hashed);
+            left--;
+            ear = stop = s->next[c];
+            continue;
+        }
+        ear = c;
+        if (ear != stop) continue;
+        // A full turn without an ear: drop flat vertices, else (self-touching
+        // or numerically degenerate input) clip the current vertex anyway.
+        uint32_t dropped = 0, v = ear;
+        for (uint32_t k = left; k > 0 && left > 3; --k) {
+            const uint32_t nv = s->next[v];
+            if (tri_area2(s->p[s->prev[v]], s->p[v], s->p[nv]) == 0.0f) {
+                tri_unlink(s, v, hashed);
+                left--;
+                dropped++;
+            }
+            v = nv;
+        }
+        if (!dropped) {
+            if (!tri_emit(s, s->prev[v], v, s->next[v], out, cap, &count)) return SIZE_MAX;
+            tri_unlink(s, v, hashed);
+            left--;
+            v = s->next[v];
+        }
+        ear = stop = v;
+    }
+    if (!tri_emit(s, s->prev[ear], ear, s->next[ear], out, cap, &count)) return SIZE_MAX;
+    return count;
+}
+
+// ------------------------------ Monotone decomposition -----------------------
+
+// Sweep order: higher first, then left first.
+static inline bool tri_above(vec2 a, vec2 b)
+{
+    return a.y > b.y || (a.y == b.y && a.x < b.x);
+}
+
+typedef struct {
+    float    y, x;
+    uint32_t v;
+} tri_sweep_key;
+
+static inline int tri_sweep_cmp(const void* pa, const void* pb)
+{
+    const tri_sweep_key* a = (const tri_sweep_key*)pa;
+    const tri_sweep_key* b = (const tri_sweep_key*)pb;
+    if (a->y != b->y) return a->y > b->y ? -1 : 1;
+    return (a->x > b->x) - (a->x < b->x);
+}
+
+// x of edge (e, next[e]) at height y; edges in the status run downward from e.
+static inline float tri_edge_x(const tri_scratch* s, uint32_t e, float y)
+{
+    const vec2 a = s->p[e], b = s->p[s->next[e]];
+    if (a.y == b.y) return a.x < b.x ? a.x : b.x;
+    float t = (a.y - y) / (a.y - b.y);
+    t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+    return a.x + t * (b.x - a.x);
+}
+
+// < 0 if edge e is left of edge f at height y; ties (a shared upper point) by direction.
+static inline int tri_edge_cmp(const tri_scratch* s, uint32_t e, uint32_t f, float y)
+{
+    const float xe = tri_edge_x(s, e, y), xf = tri_edge_x(s, f, y);
+    if (xe != xf) return xe < xf ? -1 : 1;
+    vec2 de = vec2_sub(&s->p[s->next[e]], &s->p[e]);
+    vec2 df = vec2_sub(&s->p[s->next[f]], &s->p[f]);
+    const float c = vec2_cross(&de, &df);
+    if (c != 0.0f) return c > 0.0f ? -1 : 1;
+    return (e > f) - (e < f);
+}
+
+static inline uint32_t tri_prio(uint32_t e)
+{
+    uint32_t h = e * 0x9E3779B9u;
+    h ^= h >> 16;
+    return h * 0x85EBCA6Bu;
+}
+
+static inline uint32_t tri_treap_insert(tri_scratch* s, uint32_t root, uint32_t e, float y)
+{
+    if (root == TRI_NONE) {
+        s->tl[e] = s->tr[e] = TRI_NONE;
+        return e;
+    }
+    if (tri_edge_cmp(s, e, root, y) < 0) {
+        const uint32_t l = s->tl[root] = tri_treap_insert(s, s->tl[root], e, y);
+        if (tri_prio(l) > tri_prio(root)) {
+            s->tl[root] = s->tr[l];
+            s->tr[l] = root;
+            return l;
+        }
+    } else {
+        const uint32_t r = s->tr[root] = tri_treap_insert(s, s->tr[root], e, y);
+        if (tri_prio(r) > tri_prio(root)) {
+            s->tr[root] = s->tl[r];
+            s->tl[r] = root;
+            return r;
+        }
+    }
+    return root;
+}
+
+static inline uint32_t tri_treap_join(tri_scratch* s, uint32_t a, uint32_t b)
+{
+    if (a == TRI_NONE) return b;
+    if (b == TRI_NONE) return a;
+    if (tri_prio(a) > tri_prio(b)) {
+        s->tr[a] = tri_treap_join(s, s->tr[a], b);
+        return a;
+    }
+    s->tl[b] = tri_treap_join(s, a, s->tl[b]);
+    return b;
+}
+
+static inline uint32_t tri_treap_remove(tri_scratch* s, uint32_t root, uint32_t e, float y)
+{
+    if (root == TRI_NONE) return TRI_NONE;
+    if (root == e) return tri_treap_join(s, s->tl[root], s->tr[root]);
+    if (tri_edge_cmp(s, e, root, y) < 0) s->tl[root] = tri_treap_remove(s, s->tl[root], e, y);
+    else s->tr[root] = tri_treap_remove(s, s->tr[root], e, y);
+    return root;
+}
+
+// Status edge directly left of vertex v, or TRI_NONE.
+static inline uint32_t tri_treap_left_of(const tri_scratch* s, uint32_t root, uint32_t v)
+{
+    const vec2 p = s->p[v];
+    uint32_t best = TRI_NONE;
+    while (root != TRI_NONE) {
+        if (tri_edge_x(s, root, p.y) <= p.x) { best = root; root = s->tr[root]; }
+        else root = s->tl[root];
+    }
+    return best;
+}
+
+static inline void tri_add_diag(tri_scratch* s, uint32_t a, uint32_t b)
+{
+    s->diag[2 * s->diag_count] = a;
+    s->diag[2 * s->diag_count + 1] = b;
+    s->diag_count++;
+}
+
+// Sweep: classify vertices and collect the diagonals to monotone pieces.
+static inline bool tri_sweep(tri_scratch* s)
+{
+    const uint32_t n = s->n;
+    // Sorted in the half-edge array, which is only filled after the sweep.
+    tri_sweep_key* keys = (tri_sweep_key*)s->adj;
+    for (uint32_t v = 0; v < n; ++v) keys[v] = (tri_sweep_key){ s->p[v].y, s->p[v].x, v };
+    qsort(keys, n, sizeof(tri_sweep_key), tri_sweep_cmp);
+    for (uint32_t k = 0; k < n; ++k) {
+        s->order[k] = keys[k].v;
+        s->rank[keys[k].v] = k;
+    }
+
+    for (uint32_t v = 0; v < n; ++v) {
+        const uint32_t pv = s->prev[v], nv = s->next[v];
+        const bool prev_below = tri_above(s->p[v], s->p[pv]), next_below = tri_above(s->p[v], s->p[nv]);
+        const bool convex = tri_area2(s->p[pv], s->p[v], s->p[nv]) > 0.0f;
+        if (prev_below && next_below) s->type[v] = convex ? TRI_START : TRI_SPLIT;
+        else if (!prev_below && !next_below) s->type[v] = convex ? TRI_END : TRI_MERGE;
+        else s->type[v] = next_below ? TRI_REGULAR_LEFT : TRI_REGULAR_RIGHT;
+    }
+
+    s->diag_count = 0;
+    uint32_t root = TRI_NONE;
+    for (uint32_t k = 0; k < n; ++k) {
+        const uint32_t v = s->order[k], pv = s->prev[v];
+        const float y = s->p[v].y;
+        uint32_t left;
+        switch (s->type[v]) {
+        case TRI_START:
+            root = tri_treap_insert(s, root, v, y);
+            s->helper[v] = v;
+            break;
+        case TRI_END:
+            if (s->type[s->helper[pv]] == TRI_MERGE) tri_add_diag(s, v, s->helper[pv]);
+            root = tri_treap_remove(s, root, pv, y);
+            break;
+        case TRI_SPLIT:
+            left = tri_treap_left_of(s, root, v);
+            if (left == TRI_NONE) return false; // not a simple polygon
+            tri_add_diag(s, v, s->helper[left]);
+            s->helper[left] = v;
+            root = tri_treap_insert(s, root, v, y);
+            s->helper[v] = v;
+            break;
+        case TRI_MERGE:
+            if (s->type[s->helper[pv]] == TRI_MERGE) tri_add_diag(s, v, s->helper[pv]);
+            root = tri_treap_remove(s, root, pv, y);
+            left = tri_treap_left_of(s, root, v);
+            if (left == TRI_NONE) return false;
+            if (s->type[s->helper[left]] == TRI_MERGE) tri_add_diag(s, v, s->helper[left]);
+            s->helper[left] = v;
+            break;
+        case TRI_REGULAR_LEFT:
+            if (s->type[s->helper[pv]] == TRI_MERGE) tri_add_diag(s, v, s->helper[pv]);
+            root = tri_treap_remove(s, root, pv, y);
+            root = tri_treap_insert(s, root, v, y);
+            s->helper[v] = v;
+            break;
+        default: // TRI_REGULAR_RIGHT
+            left = tri_treap_left_of(s, root, v);
+            if (left == TRI_NONE) return false;
+            if (s->type[s->helper[left]] == TRI_MERGE) tri_add_diag(s, v, s->helper[left]);
+            s->helper[left] = v;
+            break;
+        }
+    }
+    return true;
+}
+
+// Pseudo-angle of b - a in [0, 4), counter-clockwise from +x.
+static inline float tri_dir_angle(vec2 a, vec2 b)
+{
+    const float dx = b.x - a.x, dy = b.y - a.y;
+    const float p = dx / (fabsf(dx) + fabsf(dy));
+    return dy < 0.0f ? 3.0f + p : 1.0f - p;
+}
+
+// Triangulates a y-monotone piece (counter-clockwise in s->face[0 .. k)).
+static inline bool tri_monotone_piece(tri_scratch* s, uint32_t k, uint32_t* out, size_t cap, size_t* count)
+{
+    const uint32_t* f = s->face;
+    if (k == 3) return tri_emit(s, f[0], f[1], f[2], out, cap, count);
+    uint32_t top = 0, bottom = 0;
+    for (uint32_t i = 1; i < k; ++i) {
+        if (s->rank[f[i]] < s->rank[f[top]]) top = i;
+        if (s->rank[f[i]] > s->rank[f[bottom]]) bottom = i;
+    }
+    // Counter-clockwise from the top runs down the left chain; merge both chains.
+    uint32_t* u = s->order;
+    uint32_t i = (top + 1) % k, j = (top + k - 1) % k, m = 0;
+    u[m] = f[top]; s->side[m++] = 0;
+    while (i != bottom || j != bottom) {
+        if (j == bottom || (i != bottom && s->rank[f[i]] < s->rank[f[j]])) {
+            u[m] = f[i]; s->side[m++] = 0; i = (i + 1) % k;
+        } else {
+            u[m] = f[j]; s->side[m++] = 1; j = (j + k - 1) % k;
+        }
+    }
+    u[m] = f[bottom]; s->side[m++] = 1;
+
+    uint32_t* st = s->stack;
+    uint32_t sp = 0;
+    st[sp++] = 0;
+    st[sp++] = 1;
+    for (uint32_t q = 2; q + 1 < m; ++q) {
+        if (s->side[q] != s->side[st[sp - 1]]) {
+            // Opposite chain: fan to every stacked vertex.
+            for (; sp > 1; --sp)
+                if (!tri_emit(s, u[q], u[st[sp - 1]], u[st[sp - 2]], out, cap, count)) return false;
+            sp = 0;
+            st[sp++] = q - 1;
+            st[sp++] = q;
+        } else {
+            // Same chain: cut off while the diagonal stays inside.
+            uint32_t last = st[--sp];
+            while (sp > 0) {
+                vec2 to_top = vec2_sub(&s->p[u[st[sp - 1]]], &s->p[u[q]]);
+                vec2 to_last = vec2_sub(&s->p[u[last]], &s->p[u[q]]);
+                const float c = vec2_cross(&to_top, &to_last);
+                if (s->side[q] == 0 ? c <= 0.0f : c >= 0.0f) break;
+                if (!tri_emit(s, u[q], u[last], u[st[sp - 1]], out, cap, count)) return false;
+                last = st[--sp];
+            }
+            st[sp++] = last;
+            st[sp++] = q;
+        }
+    }
+    for (; sp > 1; --sp)
+        if (!tri_emit(s, u[m - 1], u[st[sp - 1]], u[st[sp - 2]], out, cap, count)) return false;
+    return true;
+}
+
+// Monotone decomposition of all loaded rings; returns the triangle count or SIZE_MAX.
+static inline size_t tri_run_monotone(tri_scratch* s, uint32_t* out, size_t cap)
+{
+    const uint32_t n = s->n;
+    if (s->rings == 0) return 0;
+    if (!tri_sweep(s)) return SIZE_MAX;
+
+    // Half-edges: ring edges (interior on the left) and both directions of each diagonal.
+    memset(s->adj_start, 0, (n + 1) * sizeof(uint32_t));
+    for (uint32_t v = 0; v < n; ++v) s->adj_start[v + 1]++;
+    for (uint32_t d = 0; d < 2 * s->diag_count; ++d) s->adj_start[s->diag[d] + 1]++;
+    for (uint32_t v = 0; v < n; ++v) s->adj_start[v + 1] += s->adj_start[v];
+    uint32_t* fill = s->stack; // per-vertex write cursor
+    for (uint32_t v = 0; v < n; ++v) {
+        fill[v] = s->adj_start[v];
+        s->adj[fill[v]++] = s->next[v];
+    }
+    for (uint32_t d = 0; d < s->diag_count; ++d) {
+        const uint32_t a = s->diag[2 * d], b = s->diag[2 * d + 1];
+        s->adj[fill[a]++] = b;
+        s->adj[fill[b]++] = a;
+    }
+    const uint32_t halves = s->adj_start[n];
+    memset(s->used, 0, halves);
+
+    size_t count = 0;
+    for (uint32_t v = 0; v < n; ++v) {
+        for (uint32_t h = s->adj_start[v]; h < s->adj_start[v + 1]; ++h) {
+            if (s->used[h]) continue;
+            // Trace the piece left of half-edge h: at each vertex continue with
+            // the first half-edge clockwise from the way back.
+            uint32_t k = 0, from = v, cur = h;
+            while (!s->used[cur]) {
+                if (k == n) return SIZE_MAX; // inconsistent input
+                s->used[cur] = 1;
+                s->face[k++] = from;
+                const uint32_t at = s->adj[cur];
+                const float back = tri_dir_angle(s->p[at], s->p[from]);
+                uint32_t best = TRI_NONE;
+                float best_turn = 5.0f;
+                for (uint32_t g = s->adj_start[at]; g < s->adj_start[at + 1]; ++g) {
+                    float turn = back - tri_dir_angle(s->p[at], s->p[s->adj[g]]);
+                    if (turn <= 0.0f) turn += 4.0f;
+                    if (turn < best_turn) { best_turn = turn; best = g; }
+                }
+                from = at;
+                cur = best;
+            }
+            if (k >= 3 && !tri_monotone_piece(s, k, out, cap, &count)) return SIZE_MAX;
+        }
+    }
+    return count;
+}
+
+// ------------------------------ Public API -----------------------------------
+
+/**
+ * @brief Ear-clip the outer ring of a polygon (holes are rejected).
+ *
+ * @param s    Scratch (tri_scratch_init).
+ * @param poly Polygon; ring_count must be 1.
+ * @param out  3 indices into poly->verts per triangle, counter-clockwise.
+ * @param cap  Capacity of out, in triangles.
+ * @return Triangle count, or SIZE_MAX on allocation failure, holes or full output.
+ */
+static inline size_t tri_earclip(tri_scratch* s, const tri_polygon* poly, uint32_t* out, size_t cap)
+{
+    if (poly->ring_count != 1 || !tri_load_polygon(s, poly)) return SIZE_MAX;
+    return tri_run_earclip(s, out, cap);
+}
+
+/**
+ * @brief Triangulate a polygon with holes by monotone decomposition.
+ *
+ * @param s    Scratch (tri_scratch_init).
+ * @param poly Polygon; ring 0 is the boundary, the other rings are holes
+ *             (any winding, no crossings, holes strictly inside).
+ * @param out  3 indices into poly->verts per triangle, counter-clockwise.
+ * @param cap  Capacity of out, in triangles.
+ * @return Triangle count, or SIZE_MAX on allocation failure, invalid input or full output.
+ */
+static inline size_t tri_monotone(tri_scratch* s, const tri_polygon* poly, uint32_t* out, size_t cap)
+{
+    if (!tri_load_polygon(s, poly)) return SIZE_MAX;
+    return tri_run_monotone(s, out, cap);
+}
+
+/**
+ * @brief Triangulate with the ear clipper up to TRI_EAR_MAX vertices without
+ *        holes, by monotone decomposition otherwise (see tri_monotone).
+ */
+static inline size_t tri_triangulate(tri_scratch* s, const tri_polygon* poly, uint32_t* out, size_t cap)
+{
+    if (!tri_load_polygon(s, poly)) return SIZE_MAX;
+    if (s->rings == 1 && s->ring_len[0] <= TRI_EAR_MAX) return tri_run_earclip(s, out, cap);
+    return tri_run_monotone(s, out, cap);
+}
+
+// ------------------------------ Batch ----------------------------------------
+
+/**
+ * @brief Output layout for tri_soup_batch: polygon i may write triangles
+ *        [tri_start[i], tri_start[i + 1]).
+ *
+ * @param soup      Simple polygons (poly_soup from polygon.h).
+ * @param tri_start soup->count + 1 offsets, in triangles.
+ * @return Total triangles to reserve.
+ */
+static inline size_t tri_soup_layout(const poly_soup* soup, size_t* tri_start)
+{
+    tri_start[0] = 0;
+    for (size_t i = 0; i < soup->count; ++i) {
+        const uint32_t n = soup->offsets[i + 1] - soup->offsets[i];
+        tri_start[i + 1] = tri_start[i] + (n >= 3 ? n - 2 : 0);
+    }
+    return tri_start[soup->count];
+}
+
+typedef struct {
+    const poly_soup* soup;
+    const size_t*    tri_start;
+    uint32_t*        out;
+    uint32_t*        tri_count;
+    tri_scratch      scratch[PARALLEL_MAX_WORKERS];
+    bool             failed[PARALLEL_MAX_WORKERS];
+} tri_batch_job;
+
+static inline void tri_batch_range(void* user, size_t begin, size_t end, int worker)
+{
+    tri_batch_job* j = (tri_batch_job*)user;
+    tri_scratch* s = &j->scratch[worker];
+    for (size_t i = begin; i < end; ++i) {
+        const size_t cap = j->tri_start[i + 1] - j->tri_start[i];
+        size_t n = SIZE_MAX;
+        if (tri_load_soup(s, j->soup, i))
+            n = s->rings == 1 && s->ring_len[0] <= TRI_EAR_MAX
+              ? tri_run_earclip(s, j->out + 3 * j->tri_start[i], cap)
+              : tri_run_monotone(s, j->out + 3 * j->tri_start[i], cap);
+        if (n == SIZE_MAX) { j->failed[worker] = true; n = 0; }
+        j->tri_count[i] = (uint32_t)n;
+    }
+}
+
+/**
+ * @brief Triangulate every polygon of a soup on all workers.
+ *
+ * @param soup      Simple polygons.
+ * @param tri_start Layout from tri_soup_layout.
+ * @param out       3 * tri_start[count] indices into the soup's vertex arrays.
+ * @param tri_count Triangles written per polygon (0 for failed polygons).
+ * @return false if any polygon failed (allocation or invalid geometry).
+ */
+static inline bool tri_soup_batch(const poly_soup* soup, const size_t* tri_start, uint32_t* out, uint32_t* tri_count)
+{
+    tri_batch_job* j = (tri_batch_job*)calloc(1, sizeof(tri_batch_job));
+    if (!j) return false;
+    j->soup = soup;
+    j->tri_start = tri_start;
+    j->out = out;
+    j->tri_count = tri_count;
+    parallel_for(soup->count, 64, tri_batch_range, j);
+    bool ok = true;
+    for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) {
+        ok = ok && !j->failed[w];
+        tri_scratch_free(&j->scratch[w]);
+    }
+    free(j);
+    return ok;
+}
+
+#endif // TRIANGULATE_H
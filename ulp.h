@@ -0,0 +1,131 @@
+﻿//
+// ulp.h — error of float results in units in the last place.
+//
+// ulp_error measures a float result against a higher-precision reference:
+// |got - ref| divided by the spacing of floats at |ref| (the spacing of the
+// binade ref falls in, or the smallest subnormal for tiny references). A
+// correctly rounded result is at most 0.5 ULP off; 1 ULP means the neighbour
+// of the correctly rounded value.
+//
+// References beyond the float range count as exact when the result is the
+// matching infinity. Other non-finite results (overflow of an intermediate,
+// NaN) cannot be expressed in ULP; ulp_stats counts them separately instead
+// of letting one infinity swamp the mean.
+//
+
+#ifndef ULP_H
+#define ULP_H
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ULP_BUCKETS 34  // histogram: < 0.5, < 1, < 2, ..., < 2^31, larger
+
+/**
+ * @brief ULP distance of a float result from a reference value.
+ *
+ * @param got Float result.
+ * @param ref Reference (double precision or better).
+ * @return Error in float ULPs at ref, or INFINITY if got is not finite
+ *         where ref is (see above).
+ */
+static inline double ulp_error(float got, double ref)
+{
+    if (isnan(ref)) return isnan(got) ? 0.0 : INFINITY;
+    if (fabs(ref) > (double)FLT_MAX) {
+        // Past FLT_MAX the spacing of the top binade continues.
+        if (isinf(got) && (got > 0.0f) == (ref > 0.0)) return 0.0;
+        if (!isfinite(got)) return INFINITY;
+        return fabs((double)got - ref) / ldexp(1.0, FLT_MAX_EXP - FLT_MANT_DIG);
+    }
+    if (!isfinite(got)) return INFINITY;
+    int e;
+    frexp(ref, &e); // |ref| in [2^(e-1), 2^e)
+    double ulp = ldexp(1.0, e - FLT_MANT_DIG);
+    const double min_ulp = ldexp(1.0, FLT_MIN_EXP - FLT_MANT_DIG);
+    if (ref == 0.0 || ulp < min_ulp) ulp = min_ulp;
+    return fabs((double)got - ref) / ulp;
+}
+
+typedef struct {
+    double   max;         // largest finite error
+    double   sum;
+    uint64_t count;       // finite errors
+    uint64_t nonfinite;   // results not expressible in ULP
+    uint64_t hist[ULP_BUCKETS];
+    double   worst[8];    // inputs of the largest error (caller-defined layout)
+} ulp_stats;
+
+static inline void ulp_stats_init(ulp_stats* s)
+{
+    memset(s, 0, sizeof(*s));
+}
+
+static inline int ulp_bucket(double err)
+{
+    if (err < 0.5) return 0;
+    int b = 1;
+    for (double bound = 1.0; err >= bound && b < ULP_BUCKETS - 1; bound *= 2.0) b++;
+    return b;
+}
+
+/**
+ * @brief Add one error; `inputs` (up to 8 values, may be NULL) is kept if it
+ *        is the worst so far.
+ */
+static inline void ulp_stats_add(ulp_stats* s, double err, const double* inputs, int input_count)
+{
+    if (!isfinite(err)) {
+        s->nonfinite++;
+        return;
+    }
+    if (err > s->max || s->count == 0) {
+        s->max = err;
+        for (int i = 0; inputs && i < input_count && i < 8; ++i) s->worst[i] = inputs[i];
+    }
+    s->sum += err;
+    s->count++;
+    s->hist[ulp_bucket(err)]++;
+}
+
+static inline void ulp_stats_merge(ulp_stats* into, const ulp_stats* s)
+{
+    if (s->count && (s->max > into->max || into->count == 0)) {
+        into->max = s->max;
+        memcpy(into->worst, s->worst, sizeof(into->worst));
+    }
+    into->sum += s->sum;
+    into->count += s->count;
+    into->nonfinite += s->nonfinite;
+    for (int i = 0; i < ULP_BUCKETS; ++i) into->hist[i] += s->hist[i];
+}
+
+static inline double ulp_stats_mean(const ulp_stats* s)
+{
+    return s->count ? s->sum / (double)s->count : 0.0;
+}
+
+/**
+ * @brief Upper bound of the error below which fraction q of the finite errors fall.
+ *
+ * Read from the power-of-two histogram, so the bound is a bucket edge
+ * (0.5, 1, 2, 4, ...), never more than 2x the true quantile, clamped to the
+ * largest error seen.
+ */
+static inline double ulp_stats_quantile(const ulp_stats* s, double q)
+{
+    if (!s->count) return 0.0;
+    const double target = q * (double)s->count;
+    uint64_t seen = 0;
+    for (int b = 0; b < ULP_BUCKETS; ++b) {
+        seen += s->hist[b];
+        if ((double)seen >= target)
+            return b == ULP_BUCKETS - 1 ? s->max : fmin(b == 0 ? 0.5 : ldexp(1.0, b - 1), s->max);
+    }
+    return s->max;
+}
+
+#endif // ULP_H
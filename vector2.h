@@ -341,4 +341,58 @@ static inline vec2 vec2_rot90_cw(const vec2* v)
     return (vec2){  v->y, -v->x };
 }
 
+/**
+ * @brief Rotation stored as cosine/sine, so composing and applying it needs
+ *        no trigonometry.
+ */
+typedef struct {
+    float c, s;
+} rot2;
+
+/**
+ * @brief Rotation by a given angle.
+ *
+ * @param radians Rotation angle in radians (CCW-positive).
+ * @return Rotation {cos, sin}.
+ */
+static inline rot2 rot2_from_angle(float radians)
+{
+    return (rot2){ cosf(radians), sinf(radians) };
+}
+
+/**
+ * @brief Angle of a rotation.
+ *
+ * @param r Pointer to the rotation (read-only).
+ * @return Angle in radians in [-pi, pi].
+ */
+static inline float rot2_angle(const rot2* r)
+{
+    return atan2f(r->s, r->c);
+}
+
+/**
+ * @brief Compose two rotations (apply b, then a).
+ *
+ * @param a Pointer to the outer rotation (read-only).
+ * @param b Pointer to the inner rotation (read-only).
+ * @return Rotation by angle(a) + angle(b).
+ */
+static inline rot2 rot2_mul(const rot2* a, const rot2* b)
+{
+    return (rot2){ a->c * b->c - a->s * b->s, a->s * b->c + a->c * b->s };
+}
+
+/**
+ * @brief Rotate a vector.
+ *
+ * @param r Pointer to the rotation (read-only).
+ * @param v Pointer to the input vector (read-only).
+ * @return Rotated vector.
+ */
+static inline vec2 rot2_apply(const rot2* r, const vec2* v)
+{
+    return (vec2){ r->c * v->x - r->s * v->y, r->s * v->x + r->c * v->y };
+}
+
 #endif // VECTOR2_H
@@ -0,0 +1,689 @@
+﻿//
+// viewer_core.h — platform-independent state, input and rendering of the viewer.
+//
+// The platform layer (platform.h backends, the headless replayer) owns the
+// window or the lack of one: it translates its input into viewer_event values,
+// keeps a framebuffer the size of the client area and shows what viewer_render
+// drew into it. Everything else (camera, vector list, labels, presets, HUD)
+// lives here, so every backend draws the same pixels from the same input.
+//
+// All of that state is in a viewer_ctx. Contexts share nothing but constant
+// tables, so independent contexts can be used on different threads at once
+// (batch rendering, several views); a single context is not thread-safe.
+//
+// Key codes are the Win32 virtual-key codes: uppercase ASCII for letters and
+// digits, VIEWER_KEY_DELETE for Delete.
+//
+
+#ifndef VIEWER_CORE_H
+#define VIEWER_CORE_H
+
+#ifndef _USE_MATH_DEFINES
+#define _USE_MATH_DEFINES
+#endif
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "raster.h"
+#include "font.h"
+#include "arena.h"
+#include "rng.h"
+#include "sampling.h"
+#include "visibility.h"
+#include "profile.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// --------------------------- Input events ------------------------------------
+
+#define VIEWER_KEY_DELETE 0x2E
+
+typedef enum {
+    VIEWER_EV_RESIZE,       // x, y: new client size
+    VIEWER_EV_LBUTTON_DOWN, // x, y: cursor
+    VIEWER_EV_RBUTTON_DOWN,
+    VIEWER_EV_RBUTTON_UP,
+    VIEWER_EV_MOUSE_MOVE,
+    VIEWER_EV_WHEEL,        // x, y: cursor (client coordinates), value: wheel delta
+    VIEWER_EV_KEY,          // value: key code
+    VIEWER_EV_COUNT
+} viewer_event_type;
+
+typedef struct {
+    viewer_event_type type;
+    int x, y;
+    int value;
+} viewer_event;
+
+// --------------------------- Camera & Utils ----------------------------------
+
+typedef struct {
+    float scale;   // pixels per world unit
+    float panX;    // additional pixel offset X
+    float panY;    // additional pixel offset Y
+} Camera;
+
+static inline float clampf(float x, float a, float b) {
+    return x < a ? a : (x > b ? b : x);
+}
+
+static inline double nice_step_for_scale(double target_world_step) {
+    if (target_world_step <= 0.0) return 1.0;
+    double k = floor(log10(target_world_step));
+    double base = pow(10.0, k);
+    double frac = target_world_step / base;
+    double m = (frac < 1.5) ? 1.0 : (frac < 3.0) ? 2.0 : (frac < 7.0) ? 5.0 : 10.0;
+    return m * base;
+}
+
+// --------------------------- Labels (a,b,c,..., aa,ab,...) -------------------
+
+static inline void make_label(size_t idx, char* out, size_t outsz) {
+    // bijective base-26: 1..26 -> a..z, 27 -> aa; idx is 0-based
+    if (outsz == 0) return;
+    char tmp[32];
+    size_t n = 0;
+    size_t x = idx + 1;
+    while (x > 0 && n < sizeof(tmp)) {
+        x--;
+        tmp[n++] = (char)('a' + (x % 26));
+        x /= 26;
+    }
+    size_t m = (n < outsz - 1) ? n : (outsz - 1);
+    for (size_t i = 0; i < m; ++i) out[i] = tmp[n - 1 - i];
+    out[m] = '\0';
+}
+
+// --------------------------- Vector storage ----------------------------------
+
+typedef struct {
+    vec2     v;
+    uint32_t color;   // RASTER_RGB
+    char     label[8];
+} VEntry;
+
+typedef struct {
+    VEntry* data;
+    size_t len;
+    size_t cap;
+    size_t reallocs;  // growth count, shown by the HUD
+} VecList;
+
+static inline void veclist_reserve(VecList* v, size_t want) {
+    if (want <= v->cap) return;
+    size_t newCap = v->cap ? v->cap * 2 : 16;
+    if (newCap < want) newCap = want;
+    VEntry* nd = (VEntry*)realloc(v->data, newCap * sizeof(VEntry));
+    if (!nd) return;
+    v->data = nd;
+    v->cap  = newCap;
+    v->reallocs++;
+}
+static inline bool veclist_push(VecList* v, vec2 value, uint32_t col, size_t label_idx) {
+    if (v->len + 1 > v->cap) veclist_reserve(v, v->len + 1);
+    if (v->len + 1 > v->cap) return false;
+    VEntry* e = &v->data[v->len];
+    e->v = value;
+    e->color = col;
+    make_label(label_idx, e->label, sizeof(e->label));
+    v->len++;
+    return true;
+}
+static inline void veclist_clear(VecList* v) { v->len = 0; }
+static inline void veclist_free (VecList* v) { free(v->data); v->data = NULL; v->len = v->cap = 0; }
+
+// --------------------------- Context -----------------------------------------
+
+#define HUD_FRAMES 240
+
+typedef struct {
+    Camera      cam;
+    int         clientW, clientH;
+    VecList     vecs;
+    size_t      label_counter;     // label of the next added vector
+    // Presets
+    int         preset_index;
+    const char* preset_name;
+    uint64_t    preset_seed;       // seed of the next randomized preset; recorded, so replays match
+    arena       scratch;           // preset scratch memory, reset (blocks kept) per preset
+    bool        scratch_ready;
+    // Input
+    bool        rightDragging;
+    int         lastMouseX, lastMouseY;
+    // Overlays
+    bool        hide_status;       // key help line (off for offline rendering)
+    bool        hide_labels;       // vector names and lengths
+    // HUD
+    bool        hud;
+    float       frame_ms[HUD_FRAMES];  // ring of frame durations
+    size_t      frame_count;
+    uint64_t    frame_calls;
+    size_t      vecs_drawn, vecs_culled;
+} viewer_ctx;
+
+static inline vec2 world_to_screen(const viewer_ctx* v, float x, float y) {
+    return (vec2){ v->clientW * 0.5f + v->cam.panX + x * v->cam.scale,
+                   v->clientH * 0.5f + v->cam.panY - y * v->cam.scale };
+}
+
+static inline vec2 screen_to_world(const viewer_ctx* v, float sx, float sy) {
+    float x = (sx - (v->clientW * 0.5f) - v->cam.panX) / v->cam.scale;
+    float y = ((v->clientH * 0.5f) + v->cam.panY - sy) / v->cam.scale;
+    return (vec2){ x, y };
+}
+
+// ------------------------------ Drawing --------------------------------------
+
+static inline void fb_fill_rect(framebuffer* fb, int x0, int y0, int x1, int y1, uint32_t color) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > fb->width) x1 = fb->width;
+    if (y1 > fb->height) y1 = fb->height;
+    for (int y = y0; y < y1; ++y) {
+        uint32_t* row = fb->pixels + (size_t)y * fb->stride;
+        for (int x = x0; x < x1; ++x) row[x] = color;
+    }
+}
+
+// Axis-aligned lines `width` pixels thick, centered on the world-space position.
+static inline void fb_vline(framebuffer* fb, float x, int width, uint32_t color) {
+    if (!(x > -(float)width && x < (float)fb->width + (float)width)) return;
+    const int x0 = (int)floorf(x + 0.5f) - width / 2;
+    fb_fill_rect(fb, x0, 0, x0 + width, fb->height, color);
+}
+static inline void fb_hline(framebuffer* fb, float y, int width, uint32_t color) {
+    if (!(y > -(float)width && y < (float)fb->height + (float)width)) return;
+    const int y0 = (int)floorf(y + 0.5f) - width / 2;
+    fb_fill_rect(fb, 0, y0, fb->width, y0 + width, color);
+}
+
+#define VIEWER_BACKGROUND RASTER_RGB(15, 16, 20)
+#define VIEWER_GRID       RASTER_RGB(40, 42, 48)
+#define VIEWER_AXES       RASTER_RGB(90, 180, 255)
+#define VIEWER_AXIS_TEXT  RASTER_RGB(170, 170, 170)
+#define VIEWER_LABEL_TEXT RASTER_RGB(240, 240, 240)
+#define VIEWER_STATUS     RASTER_RGB(200, 200, 200)
+
+// World-space grid covering the client area: lines at x0, x0 + step, ... <= x1
+// (likewise y); every second line carries a label.
+typedef struct {
+    double step;
+    double x0, x1;
+    double y0, y1;
+} viewer_grid;
+
+static inline viewer_grid viewer_grid_lines(const viewer_ctx* v) {
+    vec2 wLT = screen_to_world(v, 0.0f, 0.0f);
+    vec2 wRB = screen_to_world(v, (float)v->clientW, (float)v->clientH);
+    double wx0 = wLT.x, wx1 = wRB.x;
+    double wy0 = wRB.y, wy1 = wLT.y;
+    if (wx0 > wx1) { double t=wx0; wx0=wx1; wx1=t; }
+    if (wy0 > wy1) { double t=wy0; wy0=wy1; wy1=t; }
+
+    double target_world_step = 80.0 / (double)v->cam.scale;
+    viewer_grid g;
+    g.step = nice_step_for_scale(target_world_step);
+    g.x0 = floor(wx0 / g.step) * g.step;
+    g.x1 = wx1 + 1e-9;
+    g.y0 = floor(wy0 / g.step) * g.step;
+    g.y1 = wy1 + 1e-9;
+    return g;
+}
+
+static inline void draw_grid_and_axes(const viewer_ctx* v, framebuffer* fb) {
+    fb_clear(fb, VIEWER_BACKGROUND);
+
+    const viewer_grid g = viewer_grid_lines(v);
+    for (double x = g.x0; x <= g.x1; x += g.step)
+        fb_vline(fb, world_to_screen(v, (float)x, 0.0f).x, 1, VIEWER_GRID);
+    for (double y = g.y0; y <= g.y1; y += g.step)
+        fb_hline(fb, world_to_screen(v, 0.0f, (float)y).y, 1, VIEWER_GRID);
+
+    const vec2 origin = world_to_screen(v, 0.0f, 0.0f);
+    fb_hline(fb, origin.y, 2, VIEWER_AXES);
+    fb_vline(fb, origin.x, 2, VIEWER_AXES);
+
+    char buf[64];
+    int labelEvery = 2;
+    // Axis labels; the axis itself may be far off-screen.
+    const int ox = (int)clampf(origin.x, -64.0f, (float)v->clientW + 64.0f);
+    const int oy = (int)clampf(origin.y, -64.0f, (float)v->clientH + 64.0f);
+    for (double x = g.x0; x <= g.x1; x += g.step * labelEvery) {
+        vec2 p = world_to_screen(v, (float)x, 0.0f);
+        snprintf(buf, sizeof(buf), "%.3g", x);
+        font_draw_text(fb, (int)p.x + 2, oy + 4, buf, 1, VIEWER_AXIS_TEXT);
+    }
+    for (double y = g.y0; y <= g.y1; y += g.step * labelEvery) {
+        vec2 p = world_to_screen(v, 0.0f, (float)y);
+        snprintf(buf, sizeof(buf), "%.3g", y);
+        font_draw_text(fb, ox + 4, (int)p.y - 10, buf, 1, VIEWER_AXIS_TEXT);
+    }
+}
+
+// Vectors and labels entirely outside the client area are skipped; counted for the HUD.
+static inline bool screen_box_visible(const viewer_ctx* v, float x0, float y0, float x1, float y1, float margin) {
+    if (x0 > x1) { float t = x0; x0 = x1; x1 = t; }
+    if (y0 > y1) { float t = y0; y0 = y1; y1 = t; }
+    return x1 >= -margin && y1 >= -margin &&
+           x0 <= (float)v->clientW + margin && y0 <= (float)v->clientH + margin;
+}
+
+static inline void draw_vectors(viewer_ctx* v, framebuffer* fb) {
+    const vec2 o = world_to_screen(v, 0.0f, 0.0f);
+    v->vecs_drawn = v->vecs_culled = 0;
+    for (size_t i = 0; i < v->vecs.len; ++i) {
+        const VEntry* e = &v->vecs.data[i];
+        const vec2 tip = world_to_screen(v, e->v.x, e->v.y);
+        // Arrow heads reach 10 px past the segment.
+        if (!screen_box_visible(v, o.x, o.y, tip.x, tip.y, 12.0f)) {
+            v->vecs_culled++;
+            continue;
+        }
+        raster_arrow_aa(fb, o, tip, 1.0f, 10.0f, 6.0f, e->color);
+        v->vecs_drawn++;
+    }
+}
+
+// Label of a vector ("a  |a|=1.000"), placed top-left at *x, *y.
+// Returns the length, or -1 if the label is off-screen.
+static inline int viewer_label_text(const viewer_ctx* v, const VEntry* e, char* txt, size_t size, float* x, float* y) {
+    const vec2 tip = world_to_screen(v, e->v.x, e->v.y);
+    *x = tip.x + 8.0f;
+    *y = tip.y - 12.0f;
+    float len = sqrtf(e->v.x * e->v.x + e->v.y * e->v.y);
+    int n = snprintf(txt, size, "%s  |%s|=%.3f", e->label, e->label, (double)len);
+    if (n < 0) return -1;
+    if (!screen_box_visible(v, *x, *y, *x + (float)(FONT_ADVANCE * n), *y + (float)FONT_GLYPH_H, 0.0f)) return -1;
+    return n;
+}
+
+// Labels go on top of every arrow.
+static inline void draw_labels(const viewer_ctx* v, framebuffer* fb) {
+    for (size_t i = 0; i < v->vecs.len; ++i) {
+        char txt[64];
+        float x, y;
+        if (viewer_label_text(v, &v->vecs.data[i], txt, sizeof(txt), &x, &y) < 0) continue;
+        font_draw_text(fb, (int)x, (int)y, txt, 1, VIEWER_LABEL_TEXT);
+    }
+}
+
+// Key help line drawn at (8, 8).
+static inline void viewer_status_text(const viewer_ctx* v, char* info, size_t size) {
+    snprintf(info, size,
+             "Preset: %s  |  1:Prev  2:Next  |  LMB:Add  RMB:Pan  Wheel:Zoom  R:Reset  Del:Clear  H:HUD  (Vectors: %u)",
+             v->preset_name, (unsigned)v->vecs.len);
+}
+
+// ------------------------------ Presets --------------------------------------
+
+typedef void (*PresetFn)(viewer_ctx* v);
+typedef struct { const char* name; PresetFn fn; } PresetDesc;
+
+static inline arena* scratch_begin(viewer_ctx* v) {
+    if (!v->scratch_ready) { arena_init(&v->scratch, 0); v->scratch_ready = true; }
+    arena_reset(&v->scratch);
+    return &v->scratch;
+}
+
+// helpers
+static inline void add_vec_col(viewer_ctx* v, float x, float y, uint32_t c) {
+    if (veclist_push(&v->vecs, (vec2){x,y}, c, v->label_counter)) v->label_counter++;
+}
+static inline void reset_list_and_labels(viewer_ctx* v) {
+    veclist_clear(&v->vecs);
+    v->label_counter = 0;
+}
+static inline void add_points_col(viewer_ctx* v, const vec2* pts, size_t n, uint32_t c) {
+    for (size_t i = 0; i < n; ++i) add_vec_col(v, pts[i].x, pts[i].y, c);
+}
+
+static void preset_empty(viewer_ctx* v) { reset_list_and_labels(v); }
+
+static void preset_basis(viewer_ctx* v) {
+    reset_list_and_labels(v);
+    add_vec_col(v, 2.0f, 0.0f, RASTER_RGB(230,80,80));   // a
+    add_vec_col(v, 0.0f, 2.0f, RASTER_RGB(80,160,255));  // b
+    add_vec_col(v, -2.0f, 0.0f, RASTER_RGB(160,90,90));   // c
+    add_vec_col(v, 0.0f,-2.0f, RASTER_RGB(90,120,180));  // d
+    add_vec_col(v, 1.5f, 1.5f, RASTER_RGB(90,220,120));  // e
+    add_vec_col(v, -1.5f, 1.5f, RASTER_RGB(220,180,90));  // f
+}
+
+static void preset_spokes(viewer_ctx* v) {
+    reset_list_and_labels(v);
+    const int N = 16;
+    const float R = 3.0f;
+    for (int i = 0; i < N; ++i) {
+        float a = (float)i * (float)(2.0 * M_PI / N);
+        add_vec_col(v, cosf(a) * R, sinf(a) * R, RASTER_RGB(120,210,140));
+    }
+}
+
+static void preset_random(viewer_ctx* v) {
+    reset_list_and_labels(v);
+    rng r;
+    rng_seed(&r, v->preset_seed++, 0);
+    for (int i = 0; i < 40; ++i) {
+        float x = (rng_float(&r) * 10.0f) - 5.0f;
+        float y = (rng_float(&r) *  6.0f) - 3.0f;
+        add_vec_col(v, x, y, RASTER_RGB(80,220,160));
+    }
+}
+
+static void preset_poisson(viewer_ctx* v) {
+    reset_list_and_labels(v);
+    vec2 pts[64];
+    size_t n = sample_poisson((vec2){-5.0f,-3.0f}, (vec2){5.0f,3.0f}, 1.2f, 7, pts, 64);
+    add_points_col(v, pts, n < 64 ? n : 64, RASTER_RGB(120,200,255));
+}
+
+static void preset_halton(viewer_ctx* v) {
+    reset_list_and_labels(v);
+    vec2 pts[40];
+    sample_halton(1, 40, (vec2){-5.0f,-3.0f}, (vec2){5.0f,3.0f}, pts);
+    add_points_col(v, pts, 40, RASTER_RGB(255,190,90));
+}
+
+static void preset_sobol(viewer_ctx* v) {
+    reset_list_and_labels(v);
+    vec2 pts[40];
+    sample_sobol(1, 40, (vec2){-5.0f,-3.0f}, (vec2){5.0f,3.0f}, pts);
+    add_points_col(v, pts, 40, RASTER_RGB(230,120,220));
+}
+
+static void preset_r2(viewer_ctx* v) {
+    reset_list_and_labels(v);
+    vec2 pts[40];
+    sample_r2(0, 40, (vec2){-5.0f,-3.0f}, (vec2){5.0f,3.0f}, pts);
+    add_points_col(v, pts, 40, RASTER_RGB(160,230,90));
+}
+
+static void preset_projection(viewer_ctx* v) {
+    reset_list_and_labels(v);
+    vec2 a = (vec2){ 3.0f, 2.0f };
+    vec2 b = (vec2){ 4.0f, 1.0f };
+    vec2 p = vec2_project(&a, &b);
+    add_vec_col(v, a.x, a.y, RASTER_RGB(90,200,255)); // a
+    add_vec_col(v, b.x, b.y, RASTER_RGB(255,160,60)); // b
+    add_vec_col(v, p.x, p.y, RASTER_RGB(255,220,0));  // c
+}
+
+static void preset_reflection(viewer_ctx* v) {
+    reset_list_and_labels(v);
+    vec2 i = (vec2){ 3.0f,-2.0f };
+    vec2 n = (vec2){ 0.0f, 1.0f };
+    vec2 r = vec2_reflect(&i, &n);
+    add_vec_col(v, i.x, i.y, RASTER_RGB(90,200,255));  // a
+    add_vec_col(v, n.x, n.y, RASTER_RGB(255,160,60));  // b
+    add_vec_col(v, r.x, r.y, RASTER_RGB(255,80,200));  // c
+}
+
+static void preset_rotations(viewer_ctx* v) {
+    reset_list_and_labels(v);
+    vec2 base = (vec2){ 4.0f, 0.0f };
+    for (int k = 0; k < 12; ++k) {
+        float a = (float)k * (float)(2.0 * M_PI / 12.0);
+        vec2 r = vec2_rotate(&base, a);
+        add_vec_col(v, r.x, r.y, RASTER_RGB(100,210,130));
+    }
+}
+
+static void preset_visibility(viewer_ctx* v) {
+    reset_list_and_labels(v);
+    static const vis_segment walls[] = {
+        { { 1.5f,-1.0f }, { 1.5f, 1.0f } },
+        { {-2.0f, 1.5f }, { 0.5f, 2.0f } },
+        { {-3.0f,-2.0f }, {-1.0f,-1.0f } },
+        { { 2.5f,-2.5f }, { 4.0f,-0.5f } },
+    };
+    vis_scene scene;
+    if (!vis_scene_build(&scene, walls, sizeof(walls) / sizeof(walls[0]))) return;
+    vis_polygon poly;
+    if (vis_polygon_compute(&scene, (vec2){ 0.0f, 0.0f }, 4.0f, scratch_begin(v), &poly))
+        add_points_col(v, poly.verts, poly.count, RASTER_RGB(250,220,120));
+    vis_scene_free(&scene);
+}
+
+static const PresetDesc g_presets[] = {
+    {"Empty",                 preset_empty},
+    {"Basis & Diagonals",     preset_basis},
+    {"Spokes Circle",         preset_spokes},
+    {"Random Vectors",        preset_random},
+    {"Poisson Disk",          preset_poisson},
+    {"Halton (2,3)",          preset_halton},
+    {"Sobol",                 preset_sobol},
+    {"R2 Sequence",           preset_r2},
+    {"Projection (a onto b)", preset_projection},
+    {"Reflection (i about n)",preset_reflection},
+    {"Rotations",             preset_rotations},
+    {"Visibility",            preset_visibility},
+};
+static const int g_preset_count = (int)(sizeof(g_presets)/sizeof(g_presets[0]));
+
+static inline void preset_apply_index(viewer_ctx* v, int idx) {
+    if (g_preset_count == 0) return;
+    if (idx < 0) idx = (g_preset_count - 1);
+    if (idx >= g_preset_count) idx = 0;
+    v->preset_index = idx;
+    v->preset_name = g_presets[idx].name;
+    PROFILE_BEGIN(v->preset_name);
+    g_presets[idx].fn(v);
+    PROFILE_END();
+}
+static inline void preset_next(viewer_ctx* v) { preset_apply_index(v, v->preset_index + 1); }
+static inline void preset_prev(viewer_ctx* v) { preset_apply_index(v, v->preset_index - 1); }
+
+// ------------------------------ Performance HUD ------------------------------
+
+// Timings are the profiler's zone statistics (profile_zone_stats) of the
+// rendering thread, so they need a JAML_PROFILE build; counts and memory are
+// always shown. The frame is the "frame" zone the platform layer records
+// around each repaint.
+
+static inline double hud_zone_ms(const char* name) {
+    profile_zone z;
+    return profile_zone_stats(name, &z) ? z.last_ms : 0.0;
+}
+
+// Record the previous frame (its zone has closed by now).
+static inline void hud_sample_frame(viewer_ctx* v) {
+    profile_zone z;
+    if (!profile_zone_stats("frame", &z) || z.calls == v->frame_calls) return;
+    v->frame_calls = z.calls;
+    v->frame_ms[v->frame_count % HUD_FRAMES] = (float)z.last_ms;
+    v->frame_count++;
+}
+
+static inline int cmp_float(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static inline void draw_hud(const viewer_ctx* v, framebuffer* fb) {
+    const size_t n = v->frame_count < HUD_FRAMES ? v->frame_count : HUD_FRAMES;
+    float sorted[HUD_FRAMES];
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) { sorted[i] = v->frame_ms[i]; sum += v->frame_ms[i]; }
+    qsort(sorted, n, sizeof(float), cmp_float);
+
+    char lines[6][160];
+    int count = 0;
+    if (n) {
+        const float cur = v->frame_ms[(v->frame_count - 1) % HUD_FRAMES];
+        snprintf(lines[count++], sizeof(lines[0]), "frame %6.2f ms  avg %6.2f  p99 %6.2f  (%u frames)",
+                 (double)cur, sum / (double)n, (double)sorted[(n * 99) / 100], (unsigned)n);
+        snprintf(lines[count++], sizeof(lines[0]), "grid %.2f  vectors %.2f  labels %.2f  present %.2f ms",
+                 hud_zone_ms("draw_grid_and_axes"), hud_zone_ms("draw_vectors"),
+                 hud_zone_ms("draw_labels"), hud_zone_ms("present"));
+    } else {
+        snprintf(lines[count++], sizeof(lines[0]), "frame timings need a JAML_PROFILE build");
+    }
+    snprintf(lines[count++], sizeof(lines[0]), "vectors drawn %u  culled %u",
+             (unsigned)v->vecs_drawn, (unsigned)v->vecs_culled);
+    snprintf(lines[count++], sizeof(lines[0]), "vecs %u / %u entries, %.1f KiB, %u reallocs",
+             (unsigned)v->vecs.len, (unsigned)v->vecs.cap,
+             (double)(v->vecs.cap * sizeof(VEntry)) / 1024.0, (unsigned)v->vecs.reallocs);
+    snprintf(lines[count++], sizeof(lines[0]), "scratch arena %.1f KiB reserved, %.1f used, %.1f peak",
+             (double)v->scratch.reserved / 1024.0, (double)v->scratch.used / 1024.0,
+             (double)v->scratch.peak / 1024.0);
+
+    const int lineH = 12, graphH = 60, pad = 6;
+    const int w = 2 * HUD_FRAMES + 2 * pad;
+    const int x0 = 8, y0 = 24;
+    const int h = count * lineH + graphH + 3 * pad;
+    fb_fill_rect(fb, x0, y0, x0 + w, y0 + h, RASTER_RGB(28, 30, 36));
+    for (int i = 0; i < count; ++i)
+        font_draw_text(fb, x0 + pad, y0 + pad + i * lineH, lines[i], 1, RASTER_RGB(210, 210, 160));
+
+    // Rolling graph, oldest frame on the left; 16.7 ms line for reference.
+    const int gx = x0 + pad, gy = y0 + h - pad;
+    float top = 33.3f;
+    if (n && sorted[n - 1] > top) top = sorted[n - 1];
+    const int refY = gy - (int)(16.7f / top * (float)graphH);
+    fb_fill_rect(fb, gx, refY, gx + 2 * HUD_FRAMES, refY + 1, RASTER_RGB(90, 90, 100));
+    for (size_t i = 0; i < n; ++i) {
+        const float ms = v->frame_ms[(v->frame_count - n + i) % HUD_FRAMES];
+        const int x = gx + 2 * (int)i;
+        const uint32_t c = ms > 16.7f ? RASTER_RGB(230, 90, 80) : RASTER_RGB(110, 200, 120);
+        fb_fill_rect(fb, x, gy - 1 - (int)(ms / top * (float)graphH), x + 1, gy, c);
+    }
+}
+
+// ------------------------------ Core API -------------------------------------
+
+static inline void handle_zoom_at_cursor(viewer_ctx* v, int wheelDelta, int mx, int my) {
+    vec2 w0 = screen_to_world(v, (float)mx, (float)my);
+    float zoomFactor = (wheelDelta > 0) ? 1.1f : 1.0f / 1.1f;
+    v->cam.scale = clampf(v->cam.scale * zoomFactor, 10.0f, 2000.0f);
+    vec2 s1 = world_to_screen(v, w0.x, w0.y);
+    v->cam.panX += (float)mx - s1.x;
+    v->cam.panY += (float)my - s1.y;
+}
+
+/**
+ * @brief Set up a context for a client area of the given size.
+ *
+ * @param v Context (release with viewer_shutdown).
+ */
+static inline void viewer_init(viewer_ctx* v, int width, int height) {
+    memset(v, 0, sizeof(*v));
+    v->cam = (Camera){ 80.0f, 0.0f, 0.0f };
+    v->clientW = width;
+    v->clientH = height;
+    v->preset_seed = 1;
+    preset_apply_index(v, 0);
+}
+
+static inline void viewer_shutdown(viewer_ctx* v) {
+    veclist_free(&v->vecs);
+    if (v->scratch_ready) { arena_free(&v->scratch); v->scratch_ready = false; }
+}
+
+/**
+ * @brief Apply one input event.
+ *
+ * @return true if the view changed and should be redrawn.
+ */
+static inline bool viewer_handle_event(viewer_ctx* v, const viewer_event* e) {
+    switch (e->type) {
+    case VIEWER_EV_RESIZE:
+        v->clientW = e->x;
+        v->clientH = e->y;
+        return true;
+
+    case VIEWER_EV_LBUTTON_DOWN: {
+        vec2 w = screen_to_world(v, (float)e->x, (float)e->y);
+        add_vec_col(v, w.x, w.y, RASTER_RGB(80,220,160));
+        return true;
+    }
+
+    case VIEWER_EV_RBUTTON_DOWN:
+        v->rightDragging = true;
+        v->lastMouseX = e->x;
+        v->lastMouseY = e->y;
+        return false;
+
+    case VIEWER_EV_MOUSE_MOVE:
+        if (!v->rightDragging) return false;
+        v->cam.panX += (float)(e->x - v->lastMouseX);
+        v->cam.panY += (float)(e->y - v->lastMouseY);
+        v->lastMouseX = e->x;
+        v->lastMouseY = e->y;
+        return true;
+
+    case VIEWER_EV_RBUTTON_UP:
+        v->rightDragging = false;
+        return false;
+
+    case VIEWER_EV_WHEEL:
+        handle_zoom_at_cursor(v, e->value, e->x, e->y);
+        return true;
+
+    case VIEWER_EV_KEY:
+        if (e->value == VIEWER_KEY_DELETE) {
+            reset_list_and_labels(v);
+        } else if (e->value == 'R') {
+            v->cam.scale = 80.0f; v->cam.panX = 0.0f; v->cam.panY = 0.0f;
+        } else if (e->value == '1') {
+            preset_prev(v);
+        } else if (e->value == '2') {
+            preset_next(v);
+        } else if (e->value == 'H') {
+            v->hud = !v->hud;
+        }
+#ifdef PROFILE_ENABLED
+        else if (e->value == 'P') {
+            // Zones recorded so far, for chrome://tracing or ui.perfetto.dev.
+            profile_write_chrome_trace("jaml_trace.json");
+            profile_reset();
+            return false;
+        }
+#endif
+        else {
+            return false;
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Draw the current view.
+ *
+ * @param v  Context.
+ * @param fb Target, v->clientW x v->clientH pixels (the platform layer keeps
+ *           it in sync with VIEWER_EV_RESIZE).
+ */
+static inline void viewer_render(viewer_ctx* v, framebuffer* fb) {
+    hud_sample_frame(v);
+
+    PROFILE_BEGIN("draw_grid_and_axes");
+    draw_grid_and_axes(v, fb);
+    PROFILE_END();
+    PROFILE_BEGIN("draw_vectors");
+    draw_vectors(v, fb);
+    PROFILE_END();
+    if (!v->hide_labels) {
+        PROFILE_BEGIN("draw_labels");
+        draw_labels(v, fb);
+        PROFILE_END();
+    }
+
+    if (!v->hide_status) {
+        char info[256];
+        viewer_status_text(v, info, sizeof(info));
+        font_draw_text(fb, 8, 8, info, 1, VIEWER_STATUS);
+    }
+    if (v->hud) draw_hud(v, fb);
+}
+
+#endif // VIEWER_CORE_H
@@ -0,0 +1,230 @@
+﻿//
+// viewer_record.h — record viewer input and replay it frame by frame.
+//
+// A recording is a text file: a header with the complete viewer state at the
+// moment recording started (client size, camera, preset, seed, every vector
+// with its label), then one line per input event ("e type x y value") and one
+// line per presented frame ("f"). Floats are written as hex (%a), so the
+// restored state is bit-exact and a replay draws the same pixels as the
+// original session, on any backend.
+//
+// Replaying restores the header state and hands back, frame by frame, the
+// events that arrived before each frame; the caller applies them and renders.
+//
+
+#ifndef VIEWER_RECORD_H
+#define VIEWER_RECORD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "viewer_core.h"
+
+#define VIEWER_RECORD_MAGIC "jaml-input 1"
+
+// ------------------------------ Recording ------------------------------------
+
+typedef struct {
+    FILE*  f;
+    size_t frames;
+    size_t events;
+} viewer_recorder;
+
+/**
+ * @brief Start recording into `path`, writing the current state of `v`.
+ *
+ * @return false if the file cannot be created.
+ */
+static inline bool viewer_record_begin(viewer_recorder* r, const viewer_ctx* v, const char* path) {
+    memset(r, 0, sizeof(*r));
+    r->f = fopen(path, "w");
+    if (!r->f) return false;
+    fprintf(r->f, "%s\n", VIEWER_RECORD_MAGIC);
+    fprintf(r->f, "size %d %d\n", v->clientW, v->clientH);
+    fprintf(r->f, "camera %a %a %a\n", (double)v->cam.scale, (double)v->cam.panX, (double)v->cam.panY);
+    fprintf(r->f, "preset %d %llu\n", v->preset_index, (unsigned long long)v->preset_seed);
+    fprintf(r->f, "labels %llu\n", (unsigned long long)v->label_counter);
+    fprintf(r->f, "hud %d\n", v->hud ? 1 : 0);
+    for (size_t i = 0; i < v->vecs.len; ++i) {
+        const VEntry* e = &v->vecs.data[i];
+        fprintf(r->f, "vec %a %a %08x %s\n", (double)e->v.x, (double)e->v.y, (unsigned)e->color, e->label);
+    }
+    fprintf(r->f, "events\n");
+    return true;
+}
+
+static inline void viewer_record_event(viewer_recorder* r, const viewer_event* e) {
+    if (!r->f) return;
+    fprintf(r->f, "e %d %d %d %d\n", (int)e->type, e->x, e->y, e->value);
+    r->events++;
+}
+
+// Mark a presented frame; events recorded after it belong to the next one.
+static inline void viewer_record_frame(viewer_recorder* r) {
+    if (!r->f) return;
+    fputs("f\n", r->f);
+    r->frames++;
+}
+
+/**
+ * @brief Finish the recording.
+ *
+ * @return false if writing failed at any point.
+ */
+static inline bool viewer_record_end(viewer_recorder* r) {
+    if (!r->f) return false;
+    const bool ok = !ferror(r->f);
+    const bool closed = fclose(r->f) == 0;
+    r->f = NULL;
+    return ok && closed;
+}
+
+// ------------------------------ Replay ---------------------------------------
+
+typedef struct {
+    // State at the start of the recording.
+    int      width, height;
+    Camera   cam;
+    int      preset_index;
+    uint64_t preset_seed;
+    size_t   label_counter;
+    bool     hud;
+    VEntry*  vecs;
+    size_t   vec_count;
+    // Events, and for every frame the end of its event range.
+    viewer_event* events;
+    size_t        event_count;
+    size_t*       frame_end;
+    size_t        frame_count;
+} viewer_replay;
+
+static inline void viewer_replay_free(viewer_replay* r) {
+    free(r->vecs);
+    free(r->events);
+    free(r->frame_end);
+    memset(r, 0, sizeof(*r));
+}
+
+// Append one element to a growable array; false on allocation failure.
+static inline bool viewer_replay_grow(void** data, size_t count, size_t* cap, size_t elem) {
+    if (count < *cap) return true;
+    const size_t nc = *cap ? *cap * 2 : 256;
+    void* nd = realloc(*data, nc * elem);
+    if (!nd) return false;
+    *data = nd;
+    *cap = nc;
+    return true;
+}
+
+/**
+ * @brief Read a recording.
+ *
+ * @param r    Replay to fill (freed with viewer_replay_free, also on failure).
+ * @param path Recording written by viewer_record_begin / _end.
+ * @return false if the file is missing or malformed.
+ */
+static inline bool viewer_replay_load(viewer_replay* r, const char* path) {
+    memset(r, 0, sizeof(*r));
+    r->cam = (Camera){ 80.0f, 0.0f, 0.0f };
+    r->width = 800;
+    r->height = 600;
+    r->preset_seed = 1;
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+
+    char line[256];
+    bool ok = fgets(line, sizeof(line), f) && strncmp(line, VIEWER_RECORD_MAGIC, strlen(VIEWER_RECORD_MAGIC)) == 0;
+    bool in_events = false;
+    size_t vec_cap = 0, event_cap = 0, frame_cap = 0;
+    while (ok && fgets(line, sizeof(line), f)) {
+        if (in_events) {
+            if (line[0] == 'f') {
+                ok = viewer_replay_grow((void**)&r->frame_end, r->frame_count, &frame_cap, sizeof(size_t));
+                if (ok) r->frame_end[r->frame_count++] = r->event_count;
+            } else if (line[0] == 'e') {
+                int type = 0;
+                viewer_event e;
+                ok = sscanf(line, "e %d %d %d %d", &type, &e.x, &e.y, &e.value) == 4 &&
+                     type >= 0 && type < VIEWER_EV_COUNT &&
+                     viewer_replay_grow((void**)&r->events, r->event_count, &event_cap, sizeof(viewer_event));
+                if (ok) {
+                    e.type = (viewer_event_type)type;
+                    r->events[r->event_count++] = e;
+                }
+            } else {
+                ok = line[0] == '\n' || line[0] == '\r';
+            }
+            continue;
+        }
+
+        float x, y, z;
+        int a;
+        unsigned long long u;
+        unsigned color;
+        char label[8];
+        if (sscanf(line, "size %d %d", &r->width, &r->height) == 2) {
+            ok = r->width > 0 && r->height > 0;
+        } else if (sscanf(line, "camera %a %a %a", &x, &y, &z) == 3) {
+            r->cam = (Camera){ x, y, z };
+        } else if (sscanf(line, "preset %d %llu", &a, &u) == 2) {
+            ok = a >= 0 && a < g_preset_count;
+            r->preset_index = a;
+            r->preset_seed = u;
+        } else if (sscanf(line, "labels %llu", &u) == 1) {
+            r->label_counter = (size_t)u;
+        } else if (sscanf(line, "hud %d", &a) == 1) {
+            r->hud = a != 0;
+        } else if (sscanf(line, "vec %a %a %x %7s", &x, &y, &color, label) == 4) {
+            ok = viewer_replay_grow((void**)&r->vecs, r->vec_count, &vec_cap, sizeof(VEntry));
+            if (ok) {
+                VEntry* e = &r->vecs[r->vec_count++];
+                e->v = (vec2){ x, y };
+                e->color = color;
+                memcpy(e->label, label, sizeof(e->label));
+            }
+        } else if (strncmp(line, "events", 6) == 0) {
+            in_events = true;
+        } else {
+            ok = false;
+        }
+    }
+    fclose(f);
+    // Events after the last frame marker were never presented.
+    r->event_count = r->frame_count ? r->frame_end[r->frame_count - 1] : 0;
+    if (!ok || !in_events) { viewer_replay_free(r); return false; }
+    return true;
+}
+
+/**
+ * @brief Put context `v` into the state the recording started from.
+ *
+ * Call viewer_init first; the platform layer must size its framebuffer to
+ * r->width x r->height.
+ */
+static inline void viewer_replay_restore(const viewer_replay* r, viewer_ctx* v) {
+    v->clientW = r->width;
+    v->clientH = r->height;
+    v->cam = r->cam;
+    v->preset_index = r->preset_index;
+    v->preset_name = g_presets[r->preset_index].name;
+    v->preset_seed = r->preset_seed;
+    v->hud = r->hud;
+    v->rightDragging = false;
+    veclist_clear(&v->vecs);
+    veclist_reserve(&v->vecs, r->vec_count);
+    for (size_t i = 0; i < r->vec_count && i < v->vecs.cap; ++i) v->vecs.data[v->vecs.len++] = r->vecs[i];
+    v->label_counter = r->label_counter;
+}
+
+/**
+ * @brief Events that arrived before frame `frame`: events[*begin .. *end).
+ */
+static inline void viewer_replay_frame_events(const viewer_replay* r, size_t frame, size_t* begin, size_t* end) {
+    *begin = frame ? r->frame_end[frame - 1] : 0;
+    *end = r->frame_end[frame];
+}
+
+#endif // VIEWER_RECORD_H
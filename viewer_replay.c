@@ -0,0 +1,120 @@
+﻿// viewer_replay.c — headless replay of a recorded viewer session as a render benchmark.
+//
+// usage: jaml_replay <recording> [-o frames.json] [-n repeat] [--ppm last.ppm] [--svg last.svg]
+//
+// Restores the recorded state, applies each frame's input events and times
+// viewer_render for that frame (presentation is not part of the timing). With
+// -n the whole recording is replayed several times from the same state.
+// --ppm and --svg save the last frame as an image and as a vector export.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "viewer_core.h"
+#include "viewer_record.h"
+#include "viewer_svg.h"
+#include "timer.h"
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static bool write_json(const char* path, const char* recording, const viewer_replay* r, int repeat,
+                       const double* ms, size_t n) {
+    FILE* f = path ? fopen(path, "w") : stdout;
+    if (!f) return false;
+    double* sorted = (double*)malloc((n ? n : 1) * sizeof(double));
+    if (!sorted) { if (path) fclose(f); return false; }
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) { sorted[i] = ms[i]; sum += ms[i]; }
+    qsort(sorted, n, sizeof(double), cmp_double);
+
+    fprintf(f, "{\n  \"recording\": \"");
+    for (const char* c = recording; *c; ++c) {
+        if (*c == '"' || *c == '\\') fputc('\\', f);
+        fputc(*c, f);
+    }
+    fprintf(f, "\",\n  \"width\": %d,\n  \"height\": %d,\n", r->width, r->height);
+    fprintf(f, "  \"frames\": %u,\n  \"repeat\": %d,\n", (unsigned)r->frame_count, repeat);
+    if (n) {
+        fprintf(f, "  \"mean_ms\": %.6f,\n  \"median_ms\": %.6f,\n  \"p99_ms\": %.6f,\n",
+                sum / (double)n, sorted[n / 2], sorted[(n * 99) / 100]);
+    }
+    fprintf(f, "  \"frame_ms\": [");
+    for (size_t i = 0; i < n; ++i) fprintf(f, "%s%.6f", i ? ", " : "", ms[i]);
+    fprintf(f, "]\n}\n");
+    free(sorted);
+    return path ? fclose(f) == 0 : true;
+}
+
+int main(int argc, char** argv) {
+    const char* recording = NULL;
+    const char* out = NULL;
+    const char* ppm = NULL;
+    const char* svg = NULL;
+    int repeat = 1;
+    bool usage = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out = argv[++i];
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) repeat = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ppm") == 0 && i + 1 < argc) ppm = argv[++i];
+        else if (strcmp(argv[i], "--svg") == 0 && i + 1 < argc) svg = argv[++i];
+        else if (!recording && argv[i][0] != '-') recording = argv[i];
+        else usage = true;
+    }
+    if (usage || !recording || repeat < 1) {
+        fprintf(stderr, "usage: %s <recording> [-o frames.json] [-n repeat] [--ppm last.ppm] [--svg last.svg]\n", argv[0]);
+        return 2;
+    }
+
+    viewer_replay r;
+    if (!viewer_replay_load(&r, recording)) {
+        fprintf(stderr, "cannot read recording %s\n", recording);
+        return 1;
+    }
+    PROFILE_THREAD_NAME("replay");
+    static viewer_ctx view;
+    viewer_init(&view, r.width, r.height);
+
+    framebuffer fb;
+    double* ms = (double*)malloc((r.frame_count ? r.frame_count : 1) * (size_t)repeat * sizeof(double));
+    if (!ms || !fb_init(&fb, r.width, r.height)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    size_t n = 0;
+    for (int rep = 0; rep < repeat; ++rep) {
+        viewer_replay_restore(&r, &view);
+        if (!fb_resize(&fb, r.width, r.height)) return 1;
+        for (size_t frame = 0; frame < r.frame_count; ++frame) {
+            size_t begin, end;
+            viewer_replay_frame_events(&r, frame, &begin, &end);
+            for (size_t i = begin; i < end; ++i) {
+                const viewer_event* e = &r.events[i];
+                if (e->type == VIEWER_EV_RESIZE && !fb_resize(&fb, e->x, e->y)) continue;
+                viewer_handle_event(&view, e);
+            }
+            PROFILE_BEGIN("frame");
+            const double t0 = timer_now_ms();
+            viewer_render(&view, &fb);
+            ms[n++] = timer_now_ms() - t0;
+            PROFILE_END();
+        }
+    }
+
+    bool ok = write_json(out, recording, &r, repeat, ms, n);
+    if (ppm) ok = fb_write_ppm(&fb, ppm) && ok;
+    if (svg) ok = viewer_export_svg_file(&view, svg) && ok;
+#ifdef PROFILE_ENABLED
+    ok = profile_write_chrome_trace("jaml_replay_trace.json") && ok;
+#endif
+    free(ms);
+    fb_free(&fb);
+    viewer_replay_free(&r);
+    viewer_shutdown(&view);
+    if (!ok) fprintf(stderr, "failed to write output\n");
+    return ok ? 0 : 1;
+}
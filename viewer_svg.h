@@ -0,0 +1,338 @@
+﻿//
+// viewer_svg.h — export the current viewer scene as SVG, streamed to a file descriptor.
+//
+// The document shows what viewer_render draws (background, grid, axes and
+// their labels, vectors, labels, status line; not the HUD) in client-area
+// pixel coordinates. Vectors are culled to the viewport like on screen and
+// written as filled outlines (shaft and head, the shape raster_arrow_aa
+// fills), batched into one <path> per run of equal colors, at most
+// SVG_ARROWS_PER_PATH arrows each, so paint order is kept.
+//
+// Output goes through a fixed buffer straight to the descriptor and numbers
+// are formatted with a small fixed-point routine instead of printf, so
+// exporting millions of arrows takes constant memory and is bound by I/O.
+//
+
+#ifndef VIEWER_SVG_H
+#define VIEWER_SVG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "viewer_core.h"
+
+#define SVG_BUFFER          (64 * 1024)
+#define SVG_ARROWS_PER_PATH 4096
+
+// ------------------------------ Writer ---------------------------------------
+
+typedef struct {
+    int    fd;
+    bool   failed;
+    size_t len;
+    char   buf[SVG_BUFFER];
+} svg_writer;
+
+static inline void svg_flush(svg_writer* w) {
+    size_t done = 0;
+    while (!w->failed && done < w->len) {
+#ifdef _WIN32
+        const int n = _write(w->fd, w->buf + done, (unsigned)(w->len - done));
+        if (n <= 0) w->failed = true;
+#else
+        const ssize_t n = write(w->fd, w->buf + done, w->len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) w->failed = true;
+#endif
+        else done += (size_t)n;
+    }
+    w->len = 0;
+}
+
+// Room for n more bytes (n <= SVG_BUFFER).
+static inline char* svg_reserve(svg_writer* w, size_t n) {
+    if (w->len + n > SVG_BUFFER) svg_flush(w);
+    return w->buf + w->len;
+}
+
+static inline void svg_put(svg_writer* w, const char* s) {
+    for (size_t n = strlen(s); n;) {
+        size_t k = n < SVG_BUFFER / 2 ? n : SVG_BUFFER / 2;
+        memcpy(svg_reserve(w, k), s, k);
+        w->len += k;
+        s += k;
+        n -= k;
+    }
+}
+
+/**
+ * @brief Format v with up to two decimals ("12.5", "-3", "0.07").
+ *
+ * Rounds to hundredths (plenty for pixel coordinates) and clamps to +-1e9;
+ * NaN prints as 0.
+ *
+ * @param out At least 16 bytes; not terminated.
+ * @return Characters written.
+ */
+static inline size_t svg_format_number(char* out, float v) {
+    if (!(v > -1e9f)) v = v != v ? 0.0f : -1e9f;
+    if (v > 1e9f) v = 1e9f;
+    const double scaled = (double)v * 100.0;
+    int64_t q = (int64_t)(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+    size_t n = 0;
+    if (q < 0) { out[n++] = '-'; q = -q; }
+    const unsigned frac = (unsigned)(q % 100);
+    uint64_t whole = (uint64_t)(q / 100);
+    char digits[20];
+    size_t d = 0;
+    do { digits[d++] = (char)('0' + whole % 10); whole /= 10; } while (whole);
+    while (d) out[n++] = digits[--d];
+    if (frac) {
+        out[n++] = '.';
+        out[n++] = (char)('0' + frac / 10);
+        if (frac % 10) out[n++] = (char)('0' + frac % 10);
+    }
+    return n;
+}
+
+static inline void svg_number(svg_writer* w, float v) {
+    w->len += svg_format_number(svg_reserve(w, 16), v);
+}
+
+// "x y" with a leading separator.
+static inline void svg_point(svg_writer* w, char sep, vec2 p) {
+    char* o = svg_reserve(w, 34);
+    size_t n = 0;
+    o[n++] = sep;
+    n += svg_format_number(o + n, p.x);
+    o[n++] = ' ';
+    n += svg_format_number(o + n, p.y);
+    w->len += n;
+}
+
+// ` name="#rrggbb"`, plus ` name-opacity="a"` for translucent colors.
+static inline void svg_color(svg_writer* w, const char* name, uint32_t c) {
+    static const char hex[] = "0123456789abcdef";
+    svg_put(w, " ");
+    svg_put(w, name);
+    char* o = svg_reserve(w, 10);
+    memcpy(o, "=\"#", 3);
+    for (int i = 0; i < 6; ++i) o[3 + i] = hex[(c >> (20 - 4 * i)) & 15u];
+    o[9] = '"';
+    w->len += 10;
+    if ((c >> 24) != 255) {
+        svg_put(w, " ");
+        svg_put(w, name);
+        svg_put(w, "-opacity=\"");
+        svg_number(w, (float)(c >> 24) / 255.0f);
+        svg_put(w, "\"");
+    }
+}
+
+static inline void svg_text(svg_writer* w, float x, float y, const char* text) {
+    svg_put(w, "<text x=\"");
+    svg_number(w, x);
+    svg_put(w, "\" y=\"");
+    // The bitmap font is placed by its top edge, SVG text by the baseline.
+    svg_number(w, y + (float)FONT_GLYPH_H);
+    svg_put(w, "\">");
+    for (const char* c = text; *c; ++c) {
+        if (*c == '<') svg_put(w, "&lt;");
+        else if (*c == '>') svg_put(w, "&gt;");
+        else if (*c == '&') svg_put(w, "&amp;");
+        else { *svg_reserve(w, 1) = *c; w->len++; }
+    }
+    svg_put(w, "</text>\n");
+}
+
+// ------------------------------ Scene ----------------------------------------
+
+// Outline of raster_arrow_aa(from, to, 1, 10, 6): shaft rectangle and head.
+static inline void svg_arrow(svg_writer* w, vec2 from, vec2 to) {
+    const float half_width = 1.0f, head_half_w = 6.0f;
+    vec2 d = vec2_sub(&to, &from);
+    const float len = vec2_length(&d);
+    if (len < 1e-6f) return;
+    const float head_len = len < 10.0f ? len : 10.0f;
+    vec2 dir = vec2_mul(&d, 1.0f / len);
+    vec2 perp = vec2_perp(&dir);
+    vec2 back = vec2_mul(&dir, head_len);
+    vec2 base = vec2_sub(&to, &back);
+    vec2 shaft = vec2_mul(&perp, half_width);
+    vec2 side = vec2_mul(&perp, head_half_w);
+    svg_point(w, 'M', vec2_add(&from, &shaft));
+    svg_point(w, ' ', vec2_add(&base, &shaft));
+    svg_point(w, ' ', vec2_add(&base, &side));
+    svg_point(w, ' ', to);
+    svg_point(w, ' ', vec2_sub(&base, &side));
+    svg_point(w, ' ', vec2_sub(&base, &shaft));
+    svg_point(w, ' ', vec2_sub(&from, &shaft));
+    svg_put(w, "Z\n");
+}
+
+static inline void svg_grid(svg_writer* w, const viewer_ctx* v) {
+    const viewer_grid g = viewer_grid_lines(v);
+    const float W = (float)v->clientW, H = (float)v->clientH;
+    svg_put(w, "<path shape-rendering=\"crispEdges\" fill=\"none\" stroke-width=\"1\"");
+    svg_color(w, "stroke", VIEWER_GRID);
+    svg_put(w, " d=\"");
+    for (double x = g.x0; x <= g.x1; x += g.step) {
+        svg_point(w, 'M', (vec2){ world_to_screen(v, (float)x, 0.0f).x, 0.0f });
+        svg_put(w, "V");
+        svg_number(w, H);
+    }
+    for (double y = g.y0; y <= g.y1; y += g.step) {
+        svg_point(w, 'M', (vec2){ 0.0f, world_to_screen(v, 0.0f, (float)y).y });
+        svg_put(w, "H");
+        svg_number(w, W);
+    }
+    svg_put(w, "\"/>\n");
+
+    const vec2 origin = world_to_screen(v, 0.0f, 0.0f);
+    svg_put(w, "<path shape-rendering=\"crispEdges\" fill=\"none\" stroke-width=\"2\"");
+    svg_color(w, "stroke", VIEWER_AXES);
+    svg_put(w, " d=\"");
+    svg_point(w, 'M', (vec2){ 0.0f, origin.y });
+    svg_put(w, "H");
+    svg_number(w, W);
+    svg_point(w, 'M', (vec2){ origin.x, 0.0f });
+    svg_put(w, "V");
+    svg_number(w, H);
+    svg_put(w, "\"/>\n");
+
+    char buf[64];
+    const float ox = clampf(origin.x, -64.0f, W + 64.0f);
+    const float oy = clampf(origin.y, -64.0f, H + 64.0f);
+    svg_put(w, "<g");
+    svg_color(w, "fill", VIEWER_AXIS_TEXT);
+    svg_put(w, ">\n");
+    for (double x = g.x0; x <= g.x1; x += g.step * 2) {
+        snprintf(buf, sizeof(buf), "%.3g", x);
+        svg_text(w, world_to_screen(v, (float)x, 0.0f).x + 2.0f, oy + 4.0f, buf);
+    }
+    for (double y = g.y0; y <= g.y1; y += g.step * 2) {
+        snprintf(buf, sizeof(buf), "%.3g", y);
+        svg_text(w, ox + 4.0f, world_to_screen(v, 0.0f, (float)y).y - 10.0f, buf);
+    }
+    svg_put(w, "</g>\n");
+}
+
+static inline void svg_vectors(svg_writer* w, const viewer_ctx* v) {
+    const vec2 o = world_to_screen(v, 0.0f, 0.0f);
+    bool open = false;
+    uint32_t color = 0;
+    size_t in_path = 0;
+    for (size_t i = 0; i < v->vecs.len && !w->failed; ++i) {
+        const VEntry* e = &v->vecs.data[i];
+        const vec2 tip = world_to_screen(v, e->v.x, e->v.y);
+        if (!screen_box_visible(v, o.x, o.y, tip.x, tip.y, 12.0f)) continue;
+        if (open && (e->color != color || in_path == SVG_ARROWS_PER_PATH)) {
+            svg_put(w, "\"/>\n");
+            open = false;
+        }
+        if (!open) {
+            svg_put(w, "<path");
+            svg_color(w, "fill", e->color);
+            svg_put(w, " d=\"\n");
+            open = true;
+            color = e->color;
+            in_path = 0;
+        }
+        svg_arrow(w, o, tip);
+        in_path++;
+    }
+    if (open) svg_put(w, "\"/>\n");
+}
+
+static inline void svg_labels(svg_writer* w, const viewer_ctx* v) {
+    svg_put(w, "<g");
+    svg_color(w, "fill", VIEWER_LABEL_TEXT);
+    svg_put(w, ">\n");
+    for (size_t i = 0; i < v->vecs.len && !w->failed; ++i) {
+        char txt[64];
+        float x, y;
+        if (viewer_label_text(v, &v->vecs.data[i], txt, sizeof(txt), &x, &y) < 0) continue;
+        svg_text(w, x, y, txt);
+    }
+    svg_put(w, "</g>\n");
+}
+
+/**
+ * @brief Write the scene of `v` as an SVG document to `fd`.
+ *
+ * @param v  Context, as last rendered.
+ * @param fd Open descriptor (file, pipe, socket); left open.
+ * @return false if a write failed.
+ */
+static inline bool viewer_export_svg(const viewer_ctx* v, int fd) {
+    // The buffer is too large for some thread stacks.
+    svg_writer* w = (svg_writer*)malloc(sizeof(svg_writer));
+    if (!w) return false;
+    w->fd = fd;
+    w->failed = false;
+    w->len = 0;
+
+    svg_put(w, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"");
+    svg_number(w, (float)v->clientW);
+    svg_put(w, "\" height=\"");
+    svg_number(w, (float)v->clientH);
+    svg_put(w, "\" viewBox=\"0 0 ");
+    svg_number(w, (float)v->clientW);
+    svg_put(w, " ");
+    svg_number(w, (float)v->clientH);
+    // 10px monospace has about the 6 px advance of the bitmap font.
+    svg_put(w, "\" font-family=\"monospace\" font-size=\"10\">\n");
+    svg_put(w, "<rect width=\"100%\" height=\"100%\"");
+    svg_color(w, "fill", VIEWER_BACKGROUND);
+    svg_put(w, "/>\n");
+
+    svg_grid(w, v);
+    svg_vectors(w, v);
+    if (!v->hide_labels) svg_labels(w, v);
+    if (!v->hide_status) {
+        char info[256];
+        viewer_status_text(v, info, sizeof(info));
+        svg_put(w, "<g");
+        svg_color(w, "fill", VIEWER_STATUS);
+        svg_put(w, ">\n");
+        svg_text(w, 8.0f, 8.0f, info);
+        svg_put(w, "</g>\n");
+    }
+    svg_put(w, "</svg>\n");
+    svg_flush(w);
+    const bool ok = !w->failed;
+    free(w);
+    return ok;
+}
+
+/**
+ * @brief viewer_export_svg into a new file at `path` (replaced if it exists).
+ */
+static inline bool viewer_export_svg_file(const viewer_ctx* v, const char* path) {
+#ifdef _WIN32
+    const int fd = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if (fd < 0) return false;
+    const bool ok = viewer_export_svg(v, fd);
+    return _close(fd) == 0 && ok;
+#else
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    const bool ok = viewer_export_svg(v, fd);
+    return close(fd) == 0 && ok;
+#endif
+}
+
+#endif // VIEWER_SVG_H
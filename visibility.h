@@ -0,0 +1,458 @@
+﻿//
+// visibility.h — visibility polygons from a viewpoint against line segments.
+//
+// Angular sweep: every segment endpoint near the eye defines a direction;
+// directions are ordered by pseudo-angle (a monotone function of the angle
+// computed from dx / (|dx| + |dy|), no atan2) and three rays are cast per
+// direction, at it and rotated by ±VIS_EPS_ANGLE, so the polygon wraps around
+// corners and continues to whatever lies behind them. Each ray finds its
+// nearest hit through a bounding volume hierarchy over the segments; a square
+// of half-size `radius` around the eye closes the polygon where nothing is hit.
+//
+// Results go into arena buffers. Batch mode sweeps many viewpoints on all
+// workers into per-worker scratch, then copies the polygons into the arena
+// serially, like contour_extract.
+//
+
+#ifndef VISIBILITY_H
+#define VISIBILITY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+#include "arena.h"
+
+#define VIS_LEAF_SIZE   4
+#define VIS_EPS_ANGLE   1e-4f
+#define VIS_STACK_DEPTH 64
+
+typedef struct {
+    vec2 a, b;
+} vis_segment;
+
+typedef struct {
+    vec2     lo, hi;
+    uint32_t first;   // leaf: first index into order; inner: left child (right = first + 1)
+    uint32_t count;   // leaf: segment count; inner: 0
+} vis_node;
+
+typedef struct {
+    const vis_segment* segs;
+    size_t             count;
+    vis_node*          nodes;
+    uint32_t*          order;      // segment indices, leaves are contiguous runs
+    uint32_t           node_count;
+} vis_scene;
+
+typedef struct {
+    vec2*    verts;   // counter-clockwise around the eye
+    uint32_t count;
+} vis_polygon;
+
+typedef struct {
+    vec2*     verts;       // all polygons back to back
+    uint32_t* poly_start;  // poly_count + 1 offsets into verts
+    uint32_t  poly_count;
+} vis_set;
+
+// ------------------------------ BVH ------------------------------------------
+
+typedef struct {
+    float    key;
+    uint32_t idx;
+} vis_key;
+
+static inline int vis_key_cmp(const void* a, const void* b)
+{
+    const float x = ((const vis_key*)a)->key, y = ((const vis_key*)b)->key;
+    return (x > y) - (x < y);
+}
+
+// Fills node `id` over order[begin, end); children are allocated as a pair so
+// the right child is always left + 1.
+static inline void vis_build_node(vis_scene* s, vis_key* keys, uint32_t id, uint32_t begin, uint32_t end)
+{
+    vis_node* n = &s->nodes[id];
+    n->lo = (vec2){ INFINITY, INFINITY };
+    n->hi = (vec2){ -INFINITY, -INFINITY };
+    vec2 clo = n->lo, chi = n->hi; // centroid bounds
+    for (uint32_t i = begin; i < end; ++i) {
+        vis_segment g = s->segs[s->order[i]];
+        n->lo = vec2_min(&n->lo, &g.a); n->lo = vec2_min(&n->lo, &g.b);
+        n->hi = vec2_max(&n->hi, &g.a); n->hi = vec2_max(&n->hi, &g.b);
+        vec2 c = { (g.a.x + g.b.x) * 0.5f, (g.a.y + g.b.y) * 0.5f };
+        clo = vec2_min(&clo, &c);
+        chi = vec2_max(&chi, &c);
+    }
+    if (end - begin <= VIS_LEAF_SIZE) {
+        n->first = begin;
+        n->count = end - begin;
+        return;
+    }
+    // Median split along the wider centroid extent.
+    const bool use_y = chi.y - clo.y > chi.x - clo.x;
+    for (uint32_t i = begin; i < end; ++i) {
+        vis_segment g = s->segs[s->order[i]];
+        keys[i - begin].key = use_y ? g.a.y + g.b.y : g.a.x + g.b.x;
+        keys[i - begin].idx = s->order[i];
+    }
+    qsort(keys, end - begin, sizeof(vis_key), vis_key_cmp);
+    for (uint32_t i = begin; i < end; ++i) s->order[i] = keys[i - begin].idx;
+
+    const uint32_t left = s->node_count;
+    s->node_count += 2;
+    n->first = left;
+    n->count = 0;
+    const uint32_t mid = begin + (end - begin) / 2;
+    vis_build_node(s, keys, left, begin, mid);
+    vis_build_node(s, keys, left + 1, mid, end);
+}
+
+/**
+ * @brief Build the segment hierarchy of a scene.
+ *
+ * @param s     Scene (free with vis_scene_free).
+ * @param segs  Occluding segments (must outlive the scene).
+ * @param count Number of segments (< 2^31).
+ * @return false on allocation failure or invalid input.
+ */
+static inline bool vis_scene_build(vis_scene* s, const vis_segment* segs, size_t count)
+{
+    memset(s, 0, sizeof(*s));
+    if (count >= (1u << 31)) return false;
+    s->segs = segs;
+    s->count = count;
+    if (count == 0) return true;
+    s->nodes = (vis_node*)malloc((2 * count) * sizeof(vis_node));
+    s->order = (uint32_t*)malloc(count * sizeof(uint32_t));
+    vis_key* keys = (vis_key*)malloc(count * sizeof(vis_key));
+    if (!s->nodes || !s->order || !keys) {
+        free(keys); free(s->nodes); free(s->order);
+        memset(s, 0, sizeof(*s));
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) s->order[i] = (uint32_t)i;
+    s->node_count = 1;
+    vis_build_node(s, keys, 0, 0, (uint32_t)count);
+    free(keys);
+    return true;
+}
+
+static inline void vis_scene_free(vis_scene* s)
+{
+    free(s->nodes);
+    free(s->order);
+    memset(s, 0, sizeof(*s));
+}
+
+// ------------------------------ Ray casting ----------------------------------
+
+// Ray parameter t of the hit with segment a-b, or INFINITY.
+static inline float vis_ray_segment(vec2 o, vec2 d, vec2 a, vec2 b)
+{
+    vec2 e = vec2_sub(&b, &a), ao = vec2_sub(&a, &o);
+    const float den = vec2_cross(&d, &e);
+    if (den == 0.0f) return INFINITY; // parallel
+    const float t = vec2_cross(&ao, &e) / den;
+    const float u = vec2_cross(&ao, &d) / den;
+    return t >= 0.0f && u >= 0.0f && u <= 1.0f ? t : INFINITY;
+}
+
+static inline bool vis_ray_box(vec2 o, vec2 inv_d, vec2 lo, vec2 hi, float t_max)
+{
+    float t0x = (lo.x - o.x) * inv_d.x, t1x = (hi.x - o.x) * inv_d.x;
+    float t0y = (lo.y - o.y) * inv_d.y, t1y = (hi.y - o.y) * inv_d.y;
+    const float tmin = fmaxf(fminf(t0x, t1x), fminf(t0y, t1y));
+    const float tmax = fminf(fmaxf(t0x, t1x), fmaxf(t0y, t1y));
+    return tmax >= fmaxf(tmin, 0.0f) && tmin <= t_max;
+}
+
+/**
+ * @brief Nearest hit of the ray o + t d (t >= 0) with the scene.
+ *
+ * @param s     Scene.
+ * @param o     Ray origin.
+ * @param d     Ray direction (any length).
+ * @param t_max Ignore hits beyond this parameter.
+ * @return Ray parameter of the nearest hit, or t_max if none is closer.
+ */
+static inline float vis_raycast(const vis_scene* s, vec2 o, vec2 d, float t_max)
+{
+    if (s->count == 0) return t_max;
+    // 1/0 = inf makes the slab test work for axis-aligned rays; NaN (0 * inf)
+    // only arises on the box boundary and fails the comparisons conservatively.
+    const vec2 inv_d = { 1.0f / d.x, 1.0f / d.y };
+    uint32_t stack[VIS_STACK_DEPTH];
+    int sp = 0;
+    stack[sp++] = 0;
+    while (sp) {
+        const vis_node* n = &s->nodes[stack[--sp]];
+        if (!vis_ray_box(o, inv_d, n->lo, n->hi, t_max)) continue;
+        if (n->count) {
+            for (uint32_t i = n->first; i < n->first + n->count; ++i) {
+                const vis_segment g = s->segs[s->order[i]];
+                t_max = fminf(t_max, vis_ray_segment(o, d, g.a, g.b));
+            }
+        } else if (sp + 2 <= VIS_STACK_DEPTH) {
+            stack[sp++] = n->first + 1;
+            stack[sp++] = n->first;
+        }
+    }
+    return t_max;
+}
+
+// ------------------------------ Sweep ----------------------------------------
+
+// Monotone in the angle of (dx, dy) over [0, 4), counter-clockwise from +x.
+static inline float vis_pseudo_angle(float dx, float dy)
+{
+    const float p = dx / (fabsf(dx) + fabsf(dy));
+    return dy < 0.0f ? 3.0f + p : 1.0f - p;
+}
+
+typedef struct {
+    vis_key* keys;   // endpoint directions
+    vec2*    dirs;
+    vec2*    verts;  // output polygon
+    size_t   cap;    // capacity of keys/dirs (verts holds 3 * cap)
+} vis_scratch;
+
+static inline bool vis_scratch_reserve(vis_scratch* w, size_t n)
+{
+    if (n <= w->cap) return true;
+    vis_key* k = (vis_key*)realloc(w->keys, n * sizeof(vis_key));
+    if (k) w->keys = k;
+    vec2* d = (vec2*)realloc(w->dirs, n * sizeof(vec2));
+    if (d) w->dirs = d;
+    vec2* v = (vec2*)realloc(w->verts, 3 * n * sizeof(vec2));
+    if (v) w->verts = v;
+    if (!k || !d || !v) return false;
+    w->cap = n;
+    return true;
+}
+
+static inline void vis_scratch_free(vis_scratch* w)
+{
+    free(w->keys); free(w->dirs); free(w->verts);
+    memset(w, 0, sizeof(*w));
+}
+
+// Raycast clipped to the bounding square |x - eye.x|, |y - eye.y| <= radius.
+static inline float vis_raycast_bounded(const vis_scene* s, vec2 eye, vec2 d, float radius)
+{
+    const float tx = d.x != 0.0f ? radius / fabsf(d.x) : INFINITY;
+    const float ty = d.y != 0.0f ? radius / fabsf(d.y) : INFINITY;
+    return vis_raycast(s, eye, d, fminf(tx, ty));
+}
+
+static inline vec2 vis_clamp_square(vec2 p, float radius)
+{
+    return (vec2){ fminf(fmaxf(p.x, -radius), radius), fminf(fmaxf(p.y, -radius), radius) };
+}
+
+// Clips a - b (relative to the eye) to the square |x|, |y| <= radius
+// (Liang-Barsky); false if no part of it is inside.
+static inline bool vis_clip_square(vec2 a, vec2 b, float radius, vec2 out[2])
+{
+    const float dx = b.x - a.x, dy = b.y - a.y;
+    const float p[4] = { -dx, dx, -dy, dy };
+    const float q[4] = { radius + a.x, radius - a.x, radius + a.y, radius - a.y };
+    float t0 = 0.0f, t1 = 1.0f;
+    for (int k = 0; k < 4; ++k) {
+        if (p[k] == 0.0f) {
+            if (q[k] < 0.0f) return false; // parallel to this side and outside
+            continue;
+        }
+        const float t = q[k] / p[k];
+        if (p[k] < 0.0f) t0 = fmaxf(t0, t);
+        else             t1 = fminf(t1, t);
+    }
+    if (t0 > t1) return false;
+    // Endpoints inside the square are kept exactly, crossings are pinned to the side.
+    out[0] = t0 > 0.0f ? vis_clamp_square((vec2){ a.x + dx * t0, a.y + dy * t0 }, radius) : a;
+    out[1] = t1 < 1.0f ? vis_clamp_square((vec2){ a.x + dx * t1, a.y + dy * t1 }, radius) : b;
+    return true;
+}
+
+// Visibility polygon into w->verts; returns the vertex count or SIZE_MAX on failure.
+static inline size_t vis_sweep(const vis_scene* s, vec2 eye, float radius, vis_scratch* w)
+{
+    if (!vis_scratch_reserve(w, 2 * s->count + 4)) return SIZE_MAX;
+    size_t n = 0;
+    // Square corners keep the polygon closed where no segment is in view.
+    const float sx[4] = { 1.0f, -1.0f, -1.0f, 1.0f }, sy[4] = { 1.0f, 1.0f, -1.0f, -1.0f };
+    for (int k = 0; k < 4; ++k) {
+        w->dirs[n] = (vec2){ sx[k] * radius, sy[k] * radius };
+        w->keys[n] = (vis_key){ vis_pseudo_angle(w->dirs[n].x, w->dirs[n].y), (uint32_t)n };
+        n++;
+    }
+    // Directions to the ends of each segment's part inside the square: its
+    // endpoints there and the points where it crosses the sides, so a long
+    // wall through the square still gets rays at its visible ends.
+    for (size_t i = 0; i < s->count; ++i) {
+        const vec2 a = { s->segs[i].a.x - eye.x, s->segs[i].a.y - eye.y };
+        const vec2 b = { s->segs[i].b.x - eye.x, s->segs[i].b.y - eye.y };
+        vec2 e[2];
+        if (!vis_clip_square(a, b, radius, e)) continue;
+        for (int k = 0; k < 2; ++k) {
+            const vec2 d = e[k];
+            if (d.x == 0.0f && d.y == 0.0f) continue;
+            w->dirs[n] = d;
+            w->keys[n] = (vis_key){ vis_pseudo_angle(d.x, d.y), (uint32_t)n };
+            n++;
+        }
+    }
+    qsort(w->keys, n, sizeof(vis_key), vis_key_cmp);
+
+    const rot2 ccw = { cosf(VIS_EPS_ANGLE), sinf(VIS_EPS_ANGLE) };
+    const rot2 cw = { ccw.c, -ccw.s };
+    size_t m = 0;
+    float last_key = -1.0f;
+    for (size_t i = 0; i < n; ++i) {
+        if (w->keys[i].key == last_key) continue; // same direction already swept
+        last_key = w->keys[i].key;
+        const vec2 d0 = w->dirs[w->keys[i].idx];
+        const vec2 rays[3] = { rot2_apply(&cw, &d0), d0, rot2_apply(&ccw, &d0) };
+        for (int k = 0; k < 3; ++k) {
+            float t = vis_raycast_bounded(s, eye, rays[k], radius);
+            // The exact ray ends at its endpoint (t = 1) even when rounding
+            // lets it slip past the segment the endpoint belongs to.
+            if (k == 1) t = fminf(t, 1.0f);
+            const vec2 p = { eye.x + rays[k].x * t, eye.y + rays[k].y * t };
+            if (m > 0 && fabsf(p.x - w->verts[m - 1].x) + fabsf(p.y - w->verts[m - 1].y) <= 1e-6f * radius)
+                continue; // coincident with the previous vertex
+            w->verts[m++] = p;
+        }
+    }
+    return m;
+}
+
+/**
+ * @brief Visibility polygon of one viewpoint.
+ *
+ * @param s      Scene.
+ * @param eye    Viewpoint.
+ * @param radius Half-size of the bounding square around eye.
+ * @param a      Arena receiving the vertices.
+ * @param out    Polygon; valid until the arena is reset.
+ * @return false on allocation failure.
+ */
+static inline bool vis_polygon_compute(const vis_scene* s, vec2 eye, float radius, arena* a, vis_polygon* out)
+{
+    vis_scratch w;
+    memset(&w, 0, sizeof(w));
+    out->verts = NULL;
+    out->count = 0;
+    const size_t m = vis_sweep(s, eye, radius, &w);
+    bool ok = m != SIZE_MAX;
+    if (ok) {
+        out->verts = ARENA_ARRAY(a, vec2, m ? m : 1);
+        ok = out->verts != NULL;
+        if (ok) {
+            memcpy(out->verts, w.verts, m * sizeof(vec2));
+            out->count = (uint32_t)m;
+        }
+    }
+    vis_scratch_free(&w);
+    return ok;
+}
+
+// ------------------------------ Batch ----------------------------------------
+
+typedef struct {
+    const vis_scene* scene;
+    const vec2*      eyes;
+    float            radius;
+    vis_scratch      scratch[PARALLEL_MAX_WORKERS];
+    vec2*            buf[PARALLEL_MAX_WORKERS];   // per-worker polygon storage
+    size_t           len[PARALLEL_MAX_WORKERS];
+    size_t           cap[PARALLEL_MAX_WORKERS];
+    bool             failed[PARALLEL_MAX_WORKERS];
+    uint8_t*         worker;   // per eye: worker that computed it
+    size_t*          offset;   // per eye: offset in that worker's buffer
+    uint32_t*        count;
+} vis_batch_job;
+
+static inline void vis_batch_range(void* user, size_t begin, size_t end, int worker)
+{
+    vis_batch_job* j = (vis_batch_job*)user;
+    for (size_t i = begin; i < end && !j->failed[worker]; ++i) {
+        const size_t m = vis_sweep(j->scene, j->eyes[i], j->radius, &j->scratch[worker]);
+        if (m == SIZE_MAX) { j->failed[worker] = true; break; }
+        if (j->len[worker] + m > j->cap[worker]) {
+            size_t cap = j->cap[worker] ? j->cap[worker] * 2 : 4096;
+            while (cap < j->len[worker] + m) cap *= 2;
+            vec2* grown = (vec2*)realloc(j->buf[worker], cap * sizeof(vec2));
+            if (!grown) { j->failed[worker] = true; break; }
+            j->buf[worker] = grown;
+            j->cap[worker] = cap;
+        }
+        memcpy(j->buf[worker] + j->len[worker], j->scratch[worker].verts, m * sizeof(vec2));
+        j->worker[i] = (uint8_t)worker;
+        j->offset[i] = j->len[worker];
+        j->count[i] = (uint32_t)m;
+        j->len[worker] += m;
+    }
+}
+
+/**
+ * @brief Visibility polygons for many viewpoints, computed on all workers.
+ *
+ * @param s      Scene.
+ * @param eyes   Viewpoints.
+ * @param n      Number of viewpoints.
+ * @param radius Half-size of the bounding square around each eye.
+ * @param a      Arena receiving the polygons.
+ * @param out    Polygon i is out->verts[poly_start[i] .. poly_start[i + 1]).
+ * @return false on allocation failure.
+ */
+static inline bool vis_polygon_batch(const vis_scene* s, const vec2* eyes, size_t n, float radius,
+                                     arena* a, vis_set* out)
+{
+    memset(out, 0, sizeof(*out));
+    if (n >= UINT32_MAX) return false;
+    vis_batch_job* j = (vis_batch_job*)calloc(1, sizeof(vis_batch_job));
+    if (!j) return false;
+    j->scene = s;
+    j->eyes = eyes;
+    j->radius = radius;
+    j->worker = (uint8_t*)malloc(n ? n : 1);
+    j->offset = (size_t*)malloc((n ? n : 1) * sizeof(size_t));
+    j->count = (uint32_t*)malloc((n ? n : 1) * sizeof(uint32_t));
+    bool ok = j->worker && j->offset && j->count;
+    if (ok) {
+        parallel_for(n, 8, vis_batch_range, j);
+        for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) ok = ok && !j->failed[w];
+    }
+    if (ok) {
+        size_t total = 0;
+        for (size_t i = 0; i < n; ++i) total += j->count[i];
+        out->poly_start = ARENA_ARRAY(a, uint32_t, n + 1);
+        out->verts = ARENA_ARRAY(a, vec2, total ? total : 1);
+        ok = out->poly_start && out->verts && total < UINT32_MAX;
+        if (ok) {
+            uint32_t pos = 0;
+            for (size_t i = 0; i < n; ++i) {
+                out->poly_start[i] = pos;
+                memcpy(out->verts + pos, j->buf[j->worker[i]] + j->offset[i], j->count[i] * sizeof(vec2));
+                pos += j->count[i];
+            }
+            out->poly_start[n] = pos;
+            out->poly_count = (uint32_t)n;
+        }
+    }
+    for (int w = 0; w < PARALLEL_MAX_WORKERS; ++w) {
+        vis_scratch_free(&j->scratch[w]);
+        free(j->buf[w]);
+    }
+    free(j->worker); free(j->offset); free(j->count);
+    free(j);
+    if (!ok) memset(out, 0, sizeof(*out));
+    return ok;
+}
+
+#endif // VISIBILITY_H
@@ -0,0 +1,243 @@
+﻿//
+// weld.h — near-duplicate point welding with vec2_equal semantics.
+//
+// vec2_equal compares components with a relative tolerance,
+//   |a - b| <= eps * max(|a|, |b|),
+// so two equal components share a sign and their magnitudes differ by at most
+// a factor 1 / (1 - eps). Bucketing every component by sign and by
+// floor(ln|v| / -ln(1 - eps)) therefore puts equal components in the same or
+// an adjacent bucket: candidates for a point are the points in the 3x3
+// neighboring (bucket_x, bucket_y) cells, found by binary search in the
+// entries sorted by cell key. Vectors shorter than eps (which vec2_equal
+// treats as all equal) are handled as one extra class.
+//
+// Points with an infinite or NaN component are never welded: each one stays
+// unique. vec2_equal would call an infinity equal to every finite value (and
+// to the opposite infinity), which no bucketing can follow and no caller wants.
+//
+// Welding is greedy in index order, exactly like the O(N^2) loop
+//   for each point: map to the first earlier unique point it vec2_equal's,
+//                   otherwise become a new unique point,
+// and only earlier unique points can be that target. The sort and the
+// neighbor-cell lookups run on all workers; the greedy pass then walks, for
+// each point, the unique points of its 3x3 cells kept as per-cell lists, so
+// it stays linear even when most points collapse onto a few.
+//
+
+#ifndef WELD_H
+#define WELD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector2.h"
+#include "parallel.h"
+
+#define WELD_GRAIN 4096
+
+typedef struct {
+    int64_t  bx, by; // component buckets
+    uint32_t idx;    // point index
+} weld_entry;
+
+static inline bool weld_finite(vec2 p)
+{
+    return isfinite(p.x) && isfinite(p.y);
+}
+
+static inline int64_t weld_bucket(float v, double inv_width)
+{
+    if (v == 0.0f || !isfinite(v)) return 0; // non-finite points are skipped when matching
+    // log|v| >= log(FLT_TRUE_MIN) ~ -103.3; shift so every nonzero bucket is >= 1.
+    const int64_t m = (int64_t)floor(log(fabs((double)v)) * inv_width) + (int64_t)(110.0 * inv_width) + 1;
+    return v > 0.0f ? m : -m;
+}
+
+static inline int weld_entry_cmp(const weld_entry* a, const weld_entry* b)
+{
+    if (a->bx != b->bx) return a->bx < b->bx ? -1 : 1;
+    if (a->by != b->by) return a->by < b->by ? -1 : 1;
+    return (a->idx > b->idx) - (a->idx < b->idx);
+}
+
+static inline int weld_entry_qsort_cmp(const void* a, const void* b)
+{
+    return weld_entry_cmp((const weld_entry*)a, (const weld_entry*)b);
+}
+
+// ------------------------------ Parallel sort --------------------------------
+
+typedef struct {
+    weld_entry* src;
+    weld_entry* dst;
+    size_t      n;
+    size_t      run;    // sorted run length being merged
+    double      inv_width;
+    const vec2* pts;
+} weld_sort_job;
+
+static inline void weld_keys_range(void* user, size_t begin, size_t end, int worker)
+{
+    (void)worker;
+    weld_sort_job* j = (weld_sort_job*)user;
+    for (size_t i = begin; i < end; ++i) {
+        j->src[i].bx = weld_bucket(j->pts[i].x, j->inv_width);
+        j->src[i].by = weld_bucket(j->pts[i].y, j->inv_width);
+        j->src[i].idx = (uint32_t)i;
+    }
+    qsort(j->src + begin, end - begin, sizeof(weld_entry), weld_entry_qsort_cmp);
+}
+
+static inline void weld_merge_range(void* user, size_t begin, size_t end, int worker)
+{
+    (void)worker;
+    weld_sort_job* j = (weld_sort_job*)user;
+    for (size_t pair = begin; pair < end; ++pair) {
+        const size_t lo = pair * 2 * j->run;
+        const size_t mid = lo + j->run < j->n ? lo + j->run : j->n;
+        const size_t hi = lo + 2 * j->run < j->n ? lo + 2 * j->run : j->n;
+        size_t a = lo, b = mid, o = lo;
+        while (a < mid && b < hi)
+            j->dst[o++] = weld_entry_cmp(&j->src[b], &j->src[a]) < 0 ? j->src[b++] : j->src[a++];
+        while (a < mid) j->dst[o++] = j->src[a++];
+        while (b < hi)  j->dst[o++] = j->src[b++];
+    }
+}
+
+// ------------------------------ Candidates -----------------------------------
+
+typedef struct {
+    const vec2*       pts;
+    const weld_entry* sorted;
+    size_t            n;
+    double            inv_width;
+    uint32_t*         cells; // 9 per point: sorted position of each neighbor cell, or UINT32_MAX
+} weld_cells_job;
+
+static inline size_t weld_lower_bound(const weld_entry* e, size_t n, int64_t bx, int64_t by)
+{
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (e[mid].bx < bx || (e[mid].bx == bx && e[mid].by < by)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// A cell is named by the sorted position of its first entry.
+static inline void weld_cells_range(void* user, size_t begin, size_t end, int worker)
+{
+    (void)worker;
+    weld_cells_job* j = (weld_cells_job*)user;
+    for (size_t i = begin; i < end; ++i) {
+        const vec2 p = j->pts[i];
+        uint32_t* out = j->cells + 9 * i;
+        const int64_t bx = weld_bucket(p.x, j->inv_width);
+        const int64_t by = weld_bucket(p.y, j->inv_width);
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                const size_t k = weld_lower_bound(j->sorted, j->n, bx + dx, by + dy);
+                const bool hit = k < j->n && j->sorted[k].bx == bx + dx && j->sorted[k].by == by + dy;
+                out[(dy + 1) * 3 + dx + 1] = hit ? (uint32_t)k : UINT32_MAX;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Weld near-duplicate points using vec2_equal's tolerance policy.
+ *
+ * @param pts          Input points.
+ * @param n            Number of points (< 2^32).
+ * @param eps          Tolerance as passed to vec2_equal, 0 < eps < 1.
+ * @param remap        Output: for every input point, its index in unique.
+ * @param unique       Output: unique points (first occurrences), up to n.
+ * @param unique_count Output: number of unique points.
+ * @return false on invalid input or allocation failure.
+ */
+static inline bool weld_points(const vec2* pts, size_t n, float eps,
+                               uint32_t* remap, vec2* unique, size_t* unique_count)
+{
+    *unique_count = 0;
+    if (!(eps > 0.0f && eps < 1.0f) || n >= UINT32_MAX / 9) return false;
+    if (n == 0) return true;
+
+    // Slightly wider than -ln(1 - eps) so rounding in log() cannot split a pair
+    // across non-adjacent buckets.
+    const double inv_width = 1.0 / (-log1p(-(double)eps) * 1.0001);
+    weld_entry* a = (weld_entry*)malloc(n * sizeof(weld_entry));
+    weld_entry* b = (weld_entry*)malloc(n * sizeof(weld_entry));
+    uint32_t* cells = (uint32_t*)malloc(9 * n * sizeof(uint32_t));
+    // Unique points of each cell in index order, as lists: head and tail by
+    // cell, next by point.
+    uint32_t* head = (uint32_t*)malloc(n * sizeof(uint32_t));
+    uint32_t* tail = (uint32_t*)malloc(n * sizeof(uint32_t));
+    uint32_t* next = (uint32_t*)malloc(n * sizeof(uint32_t));
+    bool ok = a && b && cells && head && tail && next;
+
+    if (ok) {
+        // Parallel sort: sorted chunks, then pairwise merge rounds.
+        const int workers = parallel_worker_count();
+        size_t chunk = (n + (size_t)workers - 1) / (size_t)workers;
+        if (chunk < WELD_GRAIN) chunk = WELD_GRAIN;
+        weld_sort_job sj = { a, b, n, chunk, inv_width, pts };
+        parallel_for(n, chunk, weld_keys_range, &sj);
+        while (sj.run < n) {
+            const size_t pairs = (n + 2 * sj.run - 1) / (2 * sj.run);
+            parallel_for(pairs, 1, weld_merge_range, &sj);
+            weld_entry* t = sj.src; sj.src = sj.dst; sj.dst = t;
+            sj.run *= 2;
+        }
+
+        weld_cells_job cj = { pts, sj.src, n, inv_width, cells };
+        parallel_for(n, WELD_GRAIN, weld_cells_range, &cj);
+
+        // Greedy pass: first earlier unique point that matches, in index order.
+        // Only unique points are ever compared, and a cell holds few of them
+        // (components in one bucket are already equal), so this stays linear
+        // however many points collapse onto one. Any unique point shorter
+        // than eps matches every other such point.
+        memset(head, 0xFF, n * sizeof(uint32_t));
+        size_t u = 0;
+        uint32_t first_tiny = UINT32_MAX; // input index of the first tiny unique point
+        for (size_t i = 0; i < n; ++i) {
+            vec2 p = pts[i];
+            const bool finite = weld_finite(p);
+            const bool tiny = finite && vec2_length(&p) < eps;
+            uint32_t rep = UINT32_MAX;
+            for (int c = 0; finite && c < 9; ++c) {
+                const uint32_t cell = cells[9 * i + c];
+                if (cell == UINT32_MAX) continue;
+                // Lists are ascending, so the first match is the cell's earliest.
+                for (uint32_t o = head[cell]; o != UINT32_MAX && o < rep; o = next[o]) {
+                    vec2 q = pts[o];
+                    if (vec2_equal(&p, &q, eps)) { rep = o; break; }
+                }
+            }
+            if (tiny && first_tiny < rep) rep = first_tiny;
+
+            if (rep == UINT32_MAX) {
+                remap[i] = (uint32_t)u;
+                unique[u++] = p;
+                if (tiny && first_tiny == UINT32_MAX) first_tiny = (uint32_t)i;
+                if (!finite) continue; // never a candidate
+                const uint32_t cell = cells[9 * i + 4];
+                next[i] = UINT32_MAX;
+                if (head[cell] == UINT32_MAX) head[cell] = (uint32_t)i;
+                else next[tail[cell]] = (uint32_t)i;
+                tail[cell] = (uint32_t)i;
+            } else {
+                remap[i] = remap[rep];
+            }
+        }
+        *unique_count = u;
+    }
+
+    free(a); free(b); free(cells); free(head); free(tail); free(next);
+    return ok;
+}
+
+#endif // WELD_H